@@ -20,6 +20,7 @@
 #include "network/EntityRemoveHandler.h"
 #include "network/EntitySpawnHandler.h"
 #include "network/EntityUpdateHandler.h"
+#include "network/EntitySnapshotHandler.h"
 #include "network/UserSpawnHandler.h"
 #include "network/UserInfoHandler.h"
 #include "network/VarUpdateHandler.h"
@@ -160,6 +161,7 @@ app::AppState Client::onInit() {
 	r->registerHandler(network::ServerMsgType::EntitySpawn, std::make_shared<EntitySpawnHandler>());
 	r->registerHandler(network::ServerMsgType::EntityRemove, std::make_shared<EntityRemoveHandler>());
 	r->registerHandler(network::ServerMsgType::EntityUpdate, std::make_shared<EntityUpdateHandler>());
+	r->registerHandler(network::ServerMsgType::EntitySnapshot, std::make_shared<EntitySnapshotHandler>());
 	r->registerHandler(network::ServerMsgType::UserSpawn, std::make_shared<UserSpawnHandler>());
 	r->registerHandler(network::ServerMsgType::AuthFailed, std::make_shared<AuthFailedHandler>());
 	r->registerHandler(network::ServerMsgType::StartCooldown, std::make_shared<StartCooldownHandler>());
@@ -289,6 +291,12 @@ void Client::beforeUI() {
 		_action.update(_nowSeconds, _player);
 		const double speed = _player->attrib().current(attrib::Type::SPEED);
 		_camera.update(_player->position(), _nowSeconds, _deltaFrameSeconds, speed);
+		const glm::ivec3 playerPos(_player->position());
+		const glm::ivec3& chunkPos = _worldMgr->volumeData()->chunkPos(playerPos);
+		if (chunkPos != _prefetchChunkPos) {
+			_prefetchChunkPos = chunkPos;
+			_clientPager->prefetch(_worldMgr->volumeData(), playerPos);
+		}
 		_worldRenderer.extractMeshes(camera);
 		_worldRenderer.update(camera, _deltaFrameSeconds);
 		_worldRenderer.renderWorld(camera);
@@ -336,6 +344,7 @@ app::AppState Client::onCleanup() {
 	_worldRenderer.shutdown();
 	Log::info("shutting down the world");
 	_worldMgr->shutdown();
+	_clientPager->shutdown();
 	_floorResolver.shutdown();
 	_player = frontend::ClientEntityPtr();
 	Log::info("shutting down the network");
@@ -394,6 +403,17 @@ void Client::entitySpawn(frontend::ClientEntityId id, network::EntityType type,
 	Log::info("Entity %li spawned at pos %f:%f:%f (type %i)", id, pos.x, pos.y, pos.z, (int)type);
 	const frontend::ClientEntityPtr& entity = core::make_shared<frontend::ClientEntity>(_stockDataProvider, _animationCache, id, type, pos, orientation);
 	entity->setAnimation(animation, true);
+	// the unreliable snapshot with the state of this entity might have been received before the spawn
+	const shared::EntityStates* states = _snapshots.get(_lastSnapshot);
+	if (states != nullptr) {
+		for (const shared::EntityState& state : *states) {
+			if (state.id == id) {
+				entity->setPosition(state.position());
+				entity->setOrientation(state.orientation());
+				break;
+			}
+		}
+	}
 	_worldRenderer.entityMgr().addEntity(entity);
 }
 
@@ -401,6 +421,53 @@ void Client::entityRemove(frontend::ClientEntityId id) {
 	_worldRenderer.entityMgr().removeEntity(id);
 }
 
+void Client::entitySnapshot(const network::EntitySnapshot* snapshot) {
+	const uint32_t sequence = snapshot->sequence();
+	if (sequence <= _lastSnapshot) {
+		return;
+	}
+	static const shared::EntityStates empty;
+	const shared::EntityStates* base = &empty;
+	if (snapshot->base() != 0u) {
+		base = _snapshots.get(snapshot->base());
+		if (base == nullptr) {
+			// the server sends a full snapshot once it notices that the acknowledged base is gone
+			Log::debug("Base snapshot %u for snapshot %u is unknown", snapshot->base(), sequence);
+			return;
+		}
+	}
+	_snapshotChanges.clear();
+	const flatbuffers::Vector<uint8_t>* data = snapshot->data();
+	if (!shared::decodeSnapshot(*base, data->data(), data->size(), _snapshotStates, &_snapshotChanges)) {
+		Log::warn("Failed to decode the entity snapshot %u", sequence);
+		return;
+	}
+	_snapshots.put(sequence, _snapshotStates);
+	_lastSnapshot = sequence;
+
+	for (const shared::EntityChange& change : _snapshotChanges) {
+		if (change.flags & shared::EntityStateChange::Removed) {
+			continue;
+		}
+		const frontend::ClientEntityPtr& entity = getEntity(change.state.id);
+		if (!entity) {
+			continue;
+		}
+		if (change.flags & shared::EntityStateChange::Position) {
+			entity->setPosition(change.state.position());
+		}
+		if (change.flags & shared::EntityStateChange::Rotation) {
+			entity->setOrientation(change.state.orientation());
+		}
+		if (change.flags & shared::EntityStateChange::Animation) {
+			entity->setAnimation((animation::Animation)change.state.animation, true);
+		}
+	}
+
+	_messageSender->sendClientMessage(_snapshotAckFbb, network::ClientMsgType::SnapshotAck,
+			network::CreateSnapshotAck(_snapshotAckFbb, sequence).Union(), 0u, shared::SnapshotChannel);
+}
+
 void Client::spawn(frontend::ClientEntityId id, const char *name, const glm::vec3& pos, float orientation) {
 	Log::info("User %li (%s) logged in at pos %f:%f:%f with orientation: %f", id, name, pos.x, pos.y, pos.z, orientation);
 	_camera.setTarget(pos);
@@ -459,7 +526,9 @@ bool Client::connect(uint16_t port, const core::String& hostname) {
 		Log::error("No hostname given");
 		return false;
 	}
-	ENetPeer* peer = _network->connect(port, hostname);
+	_snapshots.clear();
+	_lastSnapshot = 0u;
+	ENetPeer* peer = _network->connect(port, hostname, shared::Channels);
 	if (peer == nullptr) {
 		Log::error("Failed to connect to server %s:%i", hostname.c_str(), port);
 		return false;
@@ -26,6 +26,8 @@
 #include "stock/StockDataProvider.h"
 #include "voxel/ClientPager.h"
 #include "cooldown/CooldownHandler.h"
+#include "shared/EntitySnapshot.h"
+#include <limits>
 
 class Client: public ui::nuklear::LUAUIApp, public core::IEventBusHandler<network::NewConnectionEvent>, public core::IEventBusHandler<
 		network::DisconnectEvent>, public core::IEventBusHandler<voxelworld::WorldCreatedEvent> {
@@ -42,9 +44,17 @@ protected:
 	frontend::PlayerMovement _movement;
 	flatbuffers::FlatBufferBuilder _actionFbb;
 	frontend::PlayerAction _action;
+	// the received entity snapshots - they are the base for the delta encoded snapshots of the server
+	shared::SnapshotHistory _snapshots;
+	uint32_t _lastSnapshot = 0u;
+	shared::EntityStates _snapshotStates;
+	core::DynamicArray<shared::EntityChange> _snapshotChanges;
+	flatbuffers::FlatBufferBuilder _snapshotAckFbb;
 	client::CooldownHandler _cooldownHandler;
 	network::MoveDirection _lastMoveMask = network::MoveDirection::NONE;
 	glm::vec2 _lastMoveAngles {0.0f};
+	// the chunk of the player position of the last prefetch
+	glm::ivec3 _prefetchChunkPos { std::numeric_limits<int>::min() };
 	core::VarPtr _rotationSpeed;
 	core::VarPtr _chunkUrl;
 	core::VarPtr _seed;
@@ -115,6 +125,10 @@ public:
 
 	void entitySpawn(frontend::ClientEntityId id, network::EntityType type, float orientation, const glm::vec3& pos, animation::Animation animation);
 	void entityRemove(frontend::ClientEntityId id);
+	/**
+	 * @brief Applies the changed entity states of the given snapshot and acknowledges it
+	 */
+	void entitySnapshot(const network::EntitySnapshot* snapshot);
 	frontend::ClientEntityPtr getEntity(frontend::ClientEntityId id) const;
 };
 
@@ -0,0 +1,14 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "IClientProtocolHandler.h"
+
+/**
+ * Updates the @c frontend::ClientEntity instances with the states of the entity snapshot
+ */
+CLIENTPROTOHANDLERIMPL(EntitySnapshot) {
+	client->entitySnapshot(message);
+}
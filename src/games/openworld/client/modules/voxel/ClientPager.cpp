@@ -5,9 +5,12 @@
 #include "ClientPager.h"
 #include "app/App.h"
 #include "core/Log.h"
+#include "core/StringUtil.h"
 #include "http/ResponseParser.h"
 #include "http/HttpMimeType.h"
 #include "voxel/Region.h"
+#include "voxel/Constants.h"
+#include "voxelworld/ChunkStream.h"
 
 namespace client {
 
@@ -15,12 +18,125 @@ bool ClientPager::init(const core::String& baseUrl) {
 	if (baseUrl.empty()) {
 		return true;
 	}
-	if (!_httpClient.setBaseUrl(baseUrl)) {
+	if (!_threadPoolStarted) {
+		_threadPool.init();
+		_threadPoolStarted = true;
+	}
+	bool valid;
+	{
+		core::ScopedLock lock(_httpLock);
+		valid = _httpClient.setBaseUrl(baseUrl);
+	}
+	if (!valid) {
 		Log::warn("Invalid client pager url");
-	} else {
-		Log::info("Updated client pager url to '%s'", baseUrl.c_str());
+		return true;
+	}
+	Log::info("Updated client pager url to '%s'", baseUrl.c_str());
+	// the prefetch thread might currently use the client
+	_threadPool.enqueue([this, baseUrl] () {
+		_prefetchClient.setBaseUrl(baseUrl);
+	});
+	return true;
+}
+
+void ClientPager::shutdown() {
+	if (_threadPoolStarted) {
+		_threadPool.abort();
+		_threadPool.shutdown(true);
+		_threadPoolStarted = false;
+	}
+	{
+		core::ScopedLock lock(_prefetchLock);
+		_prefetches.clear();
+	}
+	_prefetchCondition.notify_all();
+	_chunkPersister.shutdown();
+}
+
+void ClientPager::prefetch(const voxel::PagedVolume* volume, const glm::ivec3& worldPos, int radius) {
+	core_trace_scoped(ClientPagerPrefetch);
+	if (!_threadPoolStarted) {
+		return;
+	}
+	const int sideLength = (int)volume->chunkSideLength();
+	const glm::ivec3& center = volume->chunkPos(worldPos);
+	const int chunksY = (voxel::MAX_HEIGHT + sideLength) / sideLength;
+	core::DynamicArray<glm::ivec3> worldPositions;
+	for (int z = center.z - radius; z <= center.z + radius; ++z) {
+		for (int x = center.x - radius; x <= center.x + radius; ++x) {
+			for (int y = 0; y < chunksY; ++y) {
+				const glm::ivec3 chunkPos(x, y, z);
+				if (_chunkPersister.contains(chunkPos, _seed)) {
+					continue;
+				}
+				core::ScopedLock lock(_prefetchLock);
+				if (_prefetches.hasKey(chunkPos)) {
+					continue;
+				}
+				_prefetches.put(chunkPos, true);
+				worldPositions.push_back(chunkPos * sideLength);
+			}
+		}
+	}
+	if (worldPositions.empty()) {
+		return;
 	}
+	auto future = _threadPool.enqueue([this, worldPositions, sideLength] () {
+		streamChunks(worldPositions, sideLength);
+	});
+	if (!future.valid()) {
+		// the pool is already shut down
+		core::ScopedLock lock(_prefetchLock);
+		for (const glm::ivec3& pos : worldPositions) {
+			_prefetches.remove(pos / sideLength);
+		}
+	}
+}
 
+void ClientPager::streamChunks(const core::DynamicArray<glm::ivec3>& worldPositions, int sideLength) {
+	core_trace_scoped(ClientPagerStreamChunks);
+	const int amount = (int)worldPositions.size();
+	const int max = voxelworld::ChunkStream::MaxChunksPerRequest;
+	core::DynamicArray<core::String> paths;
+	for (int i = 0; i < amount; i += max) {
+		const core::String& chunks = voxelworld::ChunkStream::formatPositions(&worldPositions[i], core_min(max, amount - i));
+		paths.push_back(core::string::format("/stream?mapid=%i&chunks=%s", _mapId, chunks.c_str()));
+	}
+	voxelworld::ChunkStream chunkStream;
+	const unsigned int seed = _seed;
+	_prefetchClient.stream(paths.data(), (int)paths.size(), [&] (const uint8_t* data, size_t size) {
+		return chunkStream.feed(data, size, [&] (const glm::ivec3& pos, const uint8_t* chunkData, uint32_t chunkSize) {
+			const glm::ivec3 chunkPos = pos / sideLength;
+			if (chunkSize == 0u) {
+				Log::warn("Server doesn't have the chunk at %i:%i:%i on map %i", pos.x, pos.y, pos.z, _mapId);
+			} else if (!_chunkPersister.save(chunkPos, seed, chunkData, chunkSize)) {
+				Log::error("Failed to save the streamed chunk at %i:%i:%i on map %i", pos.x, pos.y, pos.z, _mapId);
+			}
+			{
+				core::ScopedLock lock(_prefetchLock);
+				_prefetches.remove(chunkPos);
+			}
+			_prefetchCondition.notify_all();
+		});
+	});
+	// the chunks that were not received are downloaded on page in
+	{
+		core::ScopedLock lock(_prefetchLock);
+		for (const glm::ivec3& pos : worldPositions) {
+			_prefetches.remove(pos / sideLength);
+		}
+	}
+	_prefetchCondition.notify_all();
+}
+
+bool ClientPager::waitForPrefetch(const glm::ivec3& chunkPos) {
+	core::ScopedLock lock(_prefetchLock);
+	if (!_prefetches.hasKey(chunkPos)) {
+		return false;
+	}
+	while (_prefetches.hasKey(chunkPos)) {
+		_prefetchCondition.wait(_prefetchLock);
+	}
 	return true;
 }
 
@@ -38,10 +154,14 @@ bool ClientPager::pageIn(voxel::PagedVolume::PagerContext& pctx) {
 	if (pctx.region.getLowerY() < 0) {
 		return false;
 	}
+	if (waitForPrefetch(pctx.chunk->chunkPos()) && _chunkPersister.load(pctx.chunk, _seed)) {
+		return false;
+	}
 	if (!_chunkPersister.load(pctx.chunk, _seed)) {
 		const int x = pctx.region.getLowerX();
 		const int y = pctx.region.getLowerY();
 		const int z = pctx.region.getLowerZ();
+		core::ScopedLock lock(_httpLock);
 		const http::ResponseParser& response = _httpClient.get("?x=%i&y=%i&z=%i&mapid=%i", x, y, z, _mapId);
 		if (response.status != http::HttpStatus::Ok) {
 			Log::error("Failed to download the chunk for position %i:%i:%i and seed %u on map %i",
@@ -8,22 +8,55 @@
 #include "voxel/PagedVolume.h"
 #include "http/HttpClient.h"
 #include "core/SharedPtr.h"
+#include "core/Trace.h"
+#include "core/concurrent/Lock.h"
+#include "core/concurrent/ConditionVariable.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/collection/DynamicMap.h"
 
 namespace client {
 
+/**
+ * @brief Downloads the chunks from the server and caches them in region files.
+ *
+ * The chunks around the player are prefetched in the background over a separate keep-alive connection. A page in
+ * of a chunk that is currently streamed waits for the stream instead of requesting the chunk a second time.
+ */
 class ClientPager : public voxel::PagedVolume::Pager {
 private:
-	http::HttpClient _httpClient;
+	core_trace_mutex(core::Lock, _httpLock, "ClientPagerHttp");
+	http::HttpClient _httpClient core_thread_guarded_by(_httpLock);
+	// only used by the prefetch thread
+	http::HttpClient _prefetchClient;
 	unsigned int _seed = 0u;
 	int _mapId = -1;
 	voxelworld::FilePersister _chunkPersister;
+
+	/**
+	 * @brief The chunk positions that were requested by @c prefetch() but are not yet received
+	 */
+	core::DynamicMap<glm::ivec3, bool, 64, glm::hash<glm::ivec3>> _prefetches core_thread_guarded_by(_prefetchLock);
+	core_trace_mutex(core::Lock, _prefetchLock, "ClientPagerPrefetch");
+	core::ConditionVariable _prefetchCondition;
+	core::ThreadPool _threadPool { 1, "ClientPager" };
+	bool _threadPoolStarted = false;
+
+	void streamChunks(const core::DynamicArray<glm::ivec3>& worldPositions, int sideLength);
+	bool waitForPrefetch(const glm::ivec3& chunkPos);
 public:
 	bool init(const core::String& baseUrl);
+	void shutdown();
 
 	bool pageIn(voxel::PagedVolume::PagerContext& ctx) override;
 	void pageOut(voxel::PagedVolume::Chunk* chunk) override;
 	void setSeed(unsigned int seed);
 	void setMapId(int mapId);
+
+	/**
+	 * @brief Streams the chunks around the given world position from the server that are not yet cached
+	 * @param[in] radius The amount of chunk columns around the chunk column of the given position
+	 */
+	void prefetch(const voxel::PagedVolume* volume, const glm::ivec3& worldPos, int radius = 1);
 };
 
 typedef core::SharedPtr<ClientPager> ClientPagerPtr;
@@ -52,6 +52,8 @@ app::AppState Server::onConstruct() {
 	core::Var::get(cfg::ServerHost, "0.0.0.0");
 	core::Var::get(cfg::ServerMaxClients, "1024");
 	core::Var::get(cfg::ServerHttpPort, HTTP_SERVER_PORT, core::CV_REPLICATE);
+	core::Var::get(cfg::ServerHttpWorkers, "0");
+	core::Var::get(cfg::ServerAIBatchedTick, "false");
 	core::Var::get(cfg::ServerSeed, "1", core::CV_REPLICATE);
 	core::Var::get(cfg::VoxelMeshSize, "16", core::CV_READONLY);
 	core::Var::get(cfg::DatabaseMinConnections, "2");
@@ -4,7 +4,7 @@
 #pragma once
 
 #include "core/String.h"
-#include "core/collection/StringMap.h"
+#include "core/collection/DynamicMap.h"
 
 namespace ai {
 
@@ -27,6 +27,6 @@ const char* const ORIENTATION = "Orientation";
 /**
  * @brief ICharacter attributes for the remote \ref debugger
  */
-typedef core::StringMap<core::String> CharacterMetaAttributes;
+typedef core::DynamicMap<core::String, core::String, 8, core::StringHash> CharacterMetaAttributes;
 
 }
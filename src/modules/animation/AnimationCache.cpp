@@ -82,8 +82,10 @@ bool AnimationCache::getModel(const AnimationSettings& settings, const char *ful
 	}
 	//vertices.resize(mesh.getNoOfVertices());
 
-	indices.reserve(mesh->getNoOfIndices());
-	for (voxel::IndexType idx : mesh->getIndexVector()) {
+	voxel::VertexIndexArray meshIndices;
+	mesh->resolveIndices(meshIndices);
+	indices.reserve(meshIndices.size());
+	for (uint32_t idx : meshIndices) {
 		indices.push_back((IndexType)idx);
 	}
 	//indices.resize(mesh.getNoOfIndices());
@@ -102,6 +104,7 @@ bool AnimationCache::getBoneModel(const AnimationSettings& settings, Vertices& v
 	indices.reserve(5000);
 	IndexType indexOffset = (IndexType)0;
 	int meshCount = 0;
+	voxel::VertexIndexArray meshIndices;
 	// merge everything into one buffer
 	for (size_t i = 0; i < AnimationSettings::MAX_ENTRIES; ++i) {
 		const voxel::Mesh *mesh = meshes[i];
@@ -124,7 +127,7 @@ bool AnimationCache::getBoneModel(const AnimationSettings& settings, Vertices& v
 				vertices.emplace_back(Vertex{v.position, v.colorIndex, (uint8_t)boneIdx, v.ambientOcclusion});
 			}
 
-			const voxel::IndexArray& meshIndices = mesh->getIndexVector();
+			mesh->resolveIndices(meshIndices);
 			if (bids.mirrored[b]) {
 				// if a model is mirrored, this is usually acchieved with negative scaling values
 				// thus we have to reverse the winding order here to make the face culling work again
@@ -136,7 +139,7 @@ bool AnimationCache::getBoneModel(const AnimationSettings& settings, Vertices& v
 					}
 				}
 			} else {
-				for (voxel::IndexType idx : meshIndices) {
+				for (uint32_t idx : meshIndices) {
 					indices.push_back((IndexType)idx + indexOffset);
 				}
 			}
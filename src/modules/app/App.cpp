@@ -30,6 +30,7 @@
 namespace app {
 
 static void catch_function(int signo) {
+	Log::flush();
 	core_stacktrace();
 	abort();
 }
@@ -58,8 +59,8 @@ App::App(const metric::MetricPtr& metric, const io::FilesystemPtr& filesystem, c
 
 App::~App() {
 	core_trace_set(nullptr);
-	_metricSender->shutdown();
 	_metric->shutdown();
+	_metricSender->shutdown();
 	Log::shutdown();
 	_threadPool = core::ThreadPoolPtr();
 }
@@ -174,6 +175,7 @@ void App::onFrame() {
 				core_trace_scoped(AppOnAfterRunning);
 				onAfterRunning();
 			}
+			_metric->update(_timeProvider->tickNow());
 			const double framesPerSecondsCap = _framesPerSecondsCap->floatVal();
 			if (framesPerSecondsCap >= 1.0 && _nextFrameSeconds > now) {
 				const double delay = _nextFrameSeconds - now;
@@ -213,6 +215,8 @@ AppState App::onConstruct() {
 		logVar->setVal(logLevelVal);
 	}
 	core::Var::get(cfg::CoreSysLog, _syslog ? "true" : "false");
+	core::Var::get(cfg::CoreLogAsync, "false", "Write the log messages on a log thread instead of the calling thread");
+	core::Var::get(cfg::CoreLogAsyncBlock, "false", "Block the logging thread instead of dropping the message if the async log queue is full");
 
 	Log::init();
 
@@ -254,6 +258,7 @@ AppState App::onConstruct() {
 	}
 
 	core::Var::get(cfg::MetricFlavor, "telegraf");
+	core::Var::get(cfg::MetricFlushInterval, "1000", "Aggregate the metrics and send them batched every n millis - 0 sends every metric immediately");
 	const core::String& host = core::Var::get(cfg::MetricHost, "127.0.0.1")->strVal();
 	const int port = core::Var::get(cfg::MetricPort, "8125")->intVal();
 	_metricSender = std::make_shared<metric::UDPMetricSender>(host, port);
@@ -648,12 +653,12 @@ AppState App::onCleanup() {
 
 	core_trace_shutdown();
 
-	if (_metricSender) {
-		_metricSender->shutdown();
-	}
 	if (_metric) {
 		_metric->shutdown();
 	}
+	if (_metricSender) {
+		_metricSender->shutdown();
+	}
 
 	SDL_Quit();
 
@@ -0,0 +1,111 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "backend/entity/ai/AI.h"
+#include "backend/entity/ai/AIRegistry.h"
+#include "backend/entity/ai/ICharacter.h"
+#include "backend/entity/ai/condition/ConditionParser.h"
+#include "backend/entity/ai/server/AIStateEncoder.h"
+#include "backend/entity/ai/tree/TreeNodeParser.h"
+#include "backend/entity/ai/zone/Zone.h"
+#include "core/StringUtil.h"
+
+/**
+ * @brief Measures the encoding of the @c ai::StateWorld messages for the ai debugger. Compares the full world state
+ * that is sent if nothing is acknowledged with the delta to the acknowledged state and with a subscribed area
+ * that covers a quarter of the zone.
+ */
+class AIStateEncoderBenchmark : public app::AbstractBenchmark {
+protected:
+	// the samples until the acknowledgement of a message arrives at the server
+	static constexpr uint32_t AckDelay = 3u;
+	static constexpr int Columns = 64;
+	static constexpr float Spacing = 4.0f;
+
+	enum Mode {
+		Full, Delta, Area
+	};
+
+	backend::AIRegistry _registry;
+
+	backend::TreeNodePtr createTree() const {
+		backend::TreeNodeParser parser(_registry, "Idle{100}");
+		const backend::TreeNodePtr& root = parser.getTreeNode("idle");
+		backend::ConditionParser conditionParser(_registry, "True");
+		root->setCondition(conditionParser.getCondition());
+		return root;
+	}
+
+public:
+	/**
+	 * @param[in] state @c range(0) is the amount of npcs, @c range(1) the percentage of moving npcs and
+	 * @c range(2) the @c Mode
+	 */
+	void encode(benchmark::State &state) {
+		const int amount = (int)state.range(0);
+		const int movingPercent = (int)state.range(1);
+		const Mode mode = (Mode)state.range(2);
+		const backend::TreeNodePtr& tree = createTree();
+		backend::Zone zone("benchmark");
+		core::DynamicArray<backend::ICharacterPtr> moving;
+		for (int i = 0; i < amount; ++i) {
+			const backend::AIPtr& ai = std::make_shared<backend::AI>(tree);
+			const backend::ICharacterPtr& chr = core::make_shared<backend::ICharacter>((ai::CharacterId)(i + 1));
+			chr->setPosition(glm::vec3((float)(i % Columns) * Spacing, 0.0f, (float)(i / Columns) * Spacing));
+			chr->setMetaAttribute(ai::attributes::NAME, core::string::format("npc %i", i));
+			chr->setMax(attrib::Type::HEALTH, 100.0);
+			chr->setCurrent(attrib::Type::HEALTH, 100.0);
+			ai->setCharacter(chr);
+			zone.addAI(ai);
+			if ((i * 100) / amount < movingPercent) {
+				moving.push_back(chr);
+			}
+		}
+		// process the scheduled adds
+		zone.update(1);
+
+		backend::AIStateEncoder encoder;
+		if (mode == Area) {
+			const float halfWidth = (float)Columns * Spacing / 2.0f;
+			const float halfDepth = (float)(amount / Columns) * Spacing / 2.0f;
+			encoder.setArea(math::AABB<float>(0.0f, -1.0f, 0.0f, halfWidth, 1.0f, halfDepth));
+		}
+		flatbuffers::FlatBufferBuilder fbb;
+		size_t bytes = 0u;
+		size_t messages = 0u;
+		for (auto _ : state) {
+			for (const backend::ICharacterPtr& chr : moving) {
+				// walking with 5 units per second at 20 samples per second
+				chr->setPosition(chr->getPosition() + glm::vec3(0.25f, 0.0f, 0.0f));
+			}
+			if (mode == Full) {
+				encoder.reset();
+			}
+			fbb.Clear();
+			const flatbuffers::Offset<ai::StateWorld> stateWorld = encoder.encodeStateWorld(fbb, &zone, AI_NOTHING_SELECTED);
+			if (!stateWorld.IsNull()) {
+				ai::FinishAIRootMessageBuffer(fbb, ai::CreateAIRootMessage(fbb, ai::MsgType::StateWorld, stateWorld.Union()));
+				bytes += fbb.GetSize();
+				++messages;
+			}
+			const uint32_t sequence = encoder.stateWorldTracker().sequence();
+			if (sequence > AckDelay) {
+				encoder.ack(sequence - AckDelay, 0u);
+			}
+		}
+		state.counters["bytes/sample"] = (double)bytes / (double)state.iterations();
+		state.counters["messages/sample"] = (double)messages / (double)state.iterations();
+	}
+};
+
+BENCHMARK_DEFINE_F(AIStateEncoderBenchmark, Encode)(benchmark::State &state) {
+	encode(state);
+}
+
+// every character reserves the pool of its meta attribute map - this limits the amount of npcs here
+BENCHMARK_REGISTER_F(AIStateEncoderBenchmark, Encode)
+	->Args({2000, 100, 0})->Args({2000, 100, 1})->Args({2000, 100, 2})
+	->Args({2000, 10, 0})->Args({2000, 10, 1})->Args({2000, 10, 2})
+	->Unit(benchmark::kMicrosecond)->UseRealTime();
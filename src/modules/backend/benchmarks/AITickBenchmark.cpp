@@ -0,0 +1,82 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "backend/entity/ai/AI.h"
+#include "backend/entity/ai/AIRegistry.h"
+#include "backend/entity/ai/ICharacter.h"
+#include "backend/entity/ai/condition/ConditionParser.h"
+#include "backend/entity/ai/tree/TreeNodeParser.h"
+#include "backend/entity/ai/zone/Zone.h"
+
+/**
+ * @brief Measures the zone tick for behaviour trees that look like the trees of the npcs - a priority selector with
+ * some filtered selections, sequences of idle nodes and wandering around as fallback.
+ */
+class AITickBenchmark : public app::AbstractBenchmark {
+protected:
+	backend::AIRegistry _registry;
+
+	backend::TreeNodePtr node(const char *type, const char *condition = "True") const {
+		backend::TreeNodeParser parser(_registry, type);
+		const backend::TreeNodePtr& n = parser.getTreeNode(type);
+		if (!n) {
+			return n;
+		}
+		backend::ConditionParser conditionParser(_registry, condition);
+		n->setCondition(conditionParser.getCondition());
+		return n;
+	}
+
+	backend::TreeNodePtr createHunterTree() const {
+		const backend::TreeNodePtr& root = node("PrioritySelector");
+		root->addChild(node("Idle{100}", "And(Not(HasEnemies),Filter(Union(SelectHighestAggro,SelectAll)))"));
+		root->addChild(node("Idle{100}", "Filter(Intersection(SelectHighestAggro,SelectEmpty))"));
+		const backend::TreeNodePtr& sequence = node("Sequence", "Not(IsInGroup)");
+		sequence->addChild(node("Idle{20}"));
+		sequence->addChild(node("Steer(Wander)"));
+		root->addChild(sequence);
+		root->addChild(node("Steer(Wander)"));
+		return root;
+	}
+
+	backend::TreeNodePtr createWorkerTree() const {
+		const backend::TreeNodePtr& root = node("PrioritySelector");
+		root->addChild(node("Idle{100}", "Filter(Random{1}(SelectHighestAggro))"));
+		const backend::TreeNodePtr& prio = node("PrioritySelector");
+		prio->addChild(node("Steer(WanderAroundHome{100})", "IsGroupLeader{1}"));
+		prio->addChild(node("Steer(Wander)"));
+		root->addChild(prio);
+		return root;
+	}
+
+public:
+	/**
+	 * @param[in] state @c range(0) is the amount of npcs, @c range(1) is @c 1 for the batched tick
+	 */
+	void tick(benchmark::State &state) {
+		const int amount = (int)state.range(0);
+		const backend::TreeNodePtr trees[] = { createHunterTree(), createWorkerTree() };
+		backend::Zone zone("benchmark");
+		zone.setBatchedTick(state.range(1) != 0);
+		for (int i = 0; i < amount; ++i) {
+			const backend::AIPtr& ai = std::make_shared<backend::AI>(trees[i % 2]);
+			ai->setCharacter(core::make_shared<backend::ICharacter>((ai::CharacterId)(i + 1)));
+			zone.addAI(ai);
+		}
+		// process the scheduled adds
+		zone.update(1);
+		for (auto _ : state) {
+			zone.update(1);
+		}
+		state.counters["ais/ms"] = benchmark::Counter((double)amount * (double)state.iterations() / 1000.0, benchmark::Counter::kIsRate);
+	}
+};
+
+BENCHMARK_DEFINE_F(AITickBenchmark, Tick)(benchmark::State &state) {
+	tick(state);
+}
+
+// every character reserves the pool of its meta attribute map - this limits the amount of npcs here
+BENCHMARK_REGISTER_F(AITickBenchmark, Tick)->Args({500, 0})->Args({500, 1})->Args({2000, 0})->Args({2000, 1})->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,141 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "shared/EntitySnapshot.h"
+#include "ServerMessages_generated.h"
+#include "core/collection/DynamicArray.h"
+#include <glm/trigonometric.hpp>
+
+/**
+ * @brief A synthetic crowd of users that all see each other. Compares the single reliable @c network::EntityUpdate
+ * messages per visible entity with one delta encoded @c network::EntitySnapshot per user and tick.
+ */
+class EntitySnapshotBenchmark : public app::AbstractBenchmark {
+protected:
+	// the ticks until the acknowledgement of a snapshot arrives at the server
+	static constexpr uint32_t AckDelay = 3u;
+
+	struct Entity {
+		int64_t id;
+		glm::vec3 pos;
+		float orientation;
+		bool moving;
+	};
+
+	void spawn(core::DynamicArray<Entity>& entities, int amount, int movingPercent) const {
+		entities.resize(amount);
+		for (int i = 0; i < amount; ++i) {
+			Entity& e = entities[i];
+			e.id = i + 1;
+			e.pos = glm::vec3((float)(i % 32) * 3.0f, 10.0f, (float)(i / 32) * 3.0f);
+			e.orientation = (float)i * 0.1f;
+			e.moving = (i * 100) / amount < movingPercent;
+		}
+	}
+
+	static void tick(core::DynamicArray<Entity>& entities) {
+		for (Entity& e : entities) {
+			if (!e.moving) {
+				continue;
+			}
+			// walking with 5 units per second at 20 ticks per second and turning slowly
+			e.orientation += 0.02f;
+			e.pos.x += glm::cos(e.orientation) * 0.25f;
+			e.pos.z += glm::sin(e.orientation) * 0.25f;
+		}
+	}
+
+	static size_t entityUpdateSize(flatbuffers::FlatBufferBuilder& fbb, const Entity& e) {
+		fbb.Clear();
+		const network::Vec3 pos { e.pos.x, e.pos.y, e.pos.z };
+		auto msg = network::CreateServerMessage(fbb, network::ServerMsgType::EntityUpdate,
+				network::CreateEntityUpdate(fbb, e.id, &pos, e.orientation, network::Animation::RUN).Union());
+		network::FinishServerMessageBuffer(fbb, msg);
+		return fbb.GetSize();
+	}
+
+public:
+	/**
+	 * @param[in] state @c range(0) is the amount of users in the crowd, @c range(1) the percentage of moving users
+	 */
+	void entityUpdates(benchmark::State &state) {
+		core::DynamicArray<Entity> entities;
+		spawn(entities, (int)state.range(0), (int)state.range(1));
+		flatbuffers::FlatBufferBuilder fbb;
+		size_t bytes = 0u;
+		size_t packets = 0u;
+		for (auto _ : state) {
+			tick(entities);
+			// every user gets an update for every visible entity and itself
+			for (size_t observer = 0u; observer < entities.size(); ++observer) {
+				for (const Entity& e : entities) {
+					bytes += entityUpdateSize(fbb, e);
+					++packets;
+				}
+			}
+		}
+		state.counters["bytes/tick"] = (double)bytes / (double)state.iterations();
+		state.counters["packets/tick"] = (double)packets / (double)state.iterations();
+	}
+
+	void entitySnapshots(benchmark::State &state) {
+		core::DynamicArray<Entity> entities;
+		spawn(entities, (int)state.range(0), (int)state.range(1));
+		const size_t observers = entities.size();
+		core::DynamicArray<shared::SnapshotHistory*> histories;
+		for (size_t i = 0u; i < observers; ++i) {
+			histories.push_back(new shared::SnapshotHistory());
+		}
+		flatbuffers::FlatBufferBuilder fbb;
+		shared::EntityStates current;
+		core::DynamicArray<uint8_t> buffer;
+		const shared::EntityStates empty;
+		uint32_t sequence = 0u;
+		size_t bytes = 0u;
+		size_t packets = 0u;
+		for (auto _ : state) {
+			tick(entities);
+			++sequence;
+			const uint32_t acked = sequence > AckDelay ? sequence - AckDelay : 0u;
+			for (size_t observer = 0u; observer < observers; ++observer) {
+				current.clear();
+				for (const Entity& e : entities) {
+					current.push_back(shared::EntityState::quantize(e.id, e.pos, e.orientation, (uint8_t)network::Animation::RUN));
+				}
+				shared::SnapshotHistory* history = histories[observer];
+				const shared::EntityStates* base = history->get(acked);
+				buffer.clear();
+				shared::encodeSnapshot(base != nullptr ? *base : empty, current, buffer);
+				history->put(sequence, current);
+
+				fbb.Clear();
+				auto data = fbb.CreateVector(buffer.data(), buffer.size());
+				auto msg = network::CreateServerMessage(fbb, network::ServerMsgType::EntitySnapshot,
+						network::CreateEntitySnapshot(fbb, sequence, base != nullptr ? acked : 0u, data).Union());
+				network::FinishServerMessageBuffer(fbb, msg);
+				bytes += fbb.GetSize();
+				++packets;
+			}
+		}
+		for (shared::SnapshotHistory* history : histories) {
+			delete history;
+		}
+		state.counters["bytes/tick"] = (double)bytes / (double)state.iterations();
+		state.counters["packets/tick"] = (double)packets / (double)state.iterations();
+	}
+};
+
+BENCHMARK_DEFINE_F(EntitySnapshotBenchmark, EntityUpdates)(benchmark::State &state) {
+	entityUpdates(state);
+}
+
+BENCHMARK_DEFINE_F(EntitySnapshotBenchmark, EntitySnapshots)(benchmark::State &state) {
+	entitySnapshots(state);
+}
+
+BENCHMARK_REGISTER_F(EntitySnapshotBenchmark, EntityUpdates)->Args({100, 100})->Args({100, 20})->Args({400, 20});
+BENCHMARK_REGISTER_F(EntitySnapshotBenchmark, EntitySnapshots)->Args({100, 100})->Args({100, 20})->Args({400, 20});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,147 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "backend/world/InterestGrid.h"
+#include "core/collection/DynamicArray.h"
+#include "math/QuadTree.h"
+#include "math/Rect.h"
+#include <glm/vec3.hpp>
+#include <unordered_set>
+
+/**
+ * @brief Compares the per tick visibility updates of the @c backend::InterestGrid with a query of the quad tree for
+ * every entity and the set difference against the previously visible entities.
+ */
+class InterestGridBenchmark : public app::AbstractBenchmark {
+protected:
+	static constexpr float WorldSize = 2048.0f;
+	static constexpr float ViewDistance = 100.0f;
+	// the distance an entity moves per tick
+	static constexpr float Speed = 1.0f;
+
+	struct Entity {
+		backend::EntityId id;
+		glm::vec3 pos;
+		glm::vec3 dir;
+		std::unordered_set<backend::EntityId> visible;
+	};
+
+	struct QuadTreeNode {
+		Entity* entity;
+
+		math::RectFloat getRect() const {
+			return math::RectFloat(entity->pos.x, entity->pos.z, entity->pos.x, entity->pos.z);
+		}
+
+		bool operator==(const QuadTreeNode& rhs) const {
+			return rhs.entity == entity;
+		}
+	};
+
+	uint32_t _seed = 1u;
+
+	float random() {
+		_seed = _seed * 1664525u + 1013904223u;
+		return (float)(_seed >> 8) / (float)(1u << 24);
+	}
+
+	void spawn(core::DynamicArray<Entity>& entities, int amount) {
+		_seed = 1u;
+		entities.resize(amount);
+		for (int i = 0; i < amount; ++i) {
+			Entity& e = entities[i];
+			e.id = (backend::EntityId)(i + 1);
+			e.pos = glm::vec3(random() * WorldSize, 0.0f, random() * WorldSize);
+			e.dir = glm::vec3(random() - 0.5f, 0.0f, random() - 0.5f) * 2.0f * Speed;
+			e.visible.clear();
+		}
+	}
+
+	static void move(Entity& e) {
+		e.pos += e.dir;
+		if (e.pos.x < 0.0f || e.pos.x >= WorldSize) {
+			e.dir.x = -e.dir.x;
+		}
+		if (e.pos.z < 0.0f || e.pos.z >= WorldSize) {
+			e.dir.z = -e.dir.z;
+		}
+	}
+
+public:
+	void interestGrid(benchmark::State &state) {
+		core::DynamicArray<Entity> entities;
+		spawn(entities, (int)state.range(0));
+		backend::InterestGrid grid;
+		for (const Entity& e : entities) {
+			grid.add(e.id, e.pos, ViewDistance);
+		}
+		int64_t changes = 0;
+		const backend::InterestGrid::DeltaFunc func = [&changes] (backend::EntityId, const backend::InterestGrid::EntityIds& added, const backend::InterestGrid::EntityIds& removed) {
+			changes += (int64_t)(added.size() + removed.size());
+		};
+		grid.update(func);
+		changes = 0;
+		for (auto _ : state) {
+			for (Entity& e : entities) {
+				move(e);
+				grid.move(e.id, e.pos, ViewDistance);
+			}
+			grid.update(func);
+		}
+		state.counters["changes/tick"] = (double)changes / (double)state.iterations();
+	}
+
+	void quadTree(benchmark::State &state) {
+		core::DynamicArray<Entity> entities;
+		spawn(entities, (int)state.range(0));
+		math::QuadTree<QuadTreeNode, float> tree(math::RectFloat(0.0f, 0.0f, WorldSize, WorldSize), 100.0f);
+		for (Entity& e : entities) {
+			tree.insert(QuadTreeNode { &e });
+		}
+		int64_t changes = 0;
+		math::QuadTree<QuadTreeNode, float>::Contents contents;
+		std::unordered_set<backend::EntityId> set;
+		for (auto _ : state) {
+			for (Entity& e : entities) {
+				tree.remove(QuadTreeNode { &e });
+				move(e);
+				tree.insert(QuadTreeNode { &e });
+			}
+			for (Entity& e : entities) {
+				contents.clear();
+				tree.query(math::RectFloat(e.pos.x - ViewDistance, e.pos.z - ViewDistance, e.pos.x + ViewDistance, e.pos.z + ViewDistance), contents);
+				set.clear();
+				for (const QuadTreeNode& node : contents) {
+					if (node.entity != &e) {
+						set.insert(node.entity->id);
+					}
+				}
+				for (backend::EntityId id : set) {
+					if (e.visible.find(id) == e.visible.end()) {
+						++changes;
+					}
+				}
+				for (backend::EntityId id : e.visible) {
+					if (set.find(id) == set.end()) {
+						++changes;
+					}
+				}
+				e.visible.swap(set);
+			}
+		}
+		state.counters["changes/tick"] = (double)changes / (double)state.iterations();
+	}
+};
+
+BENCHMARK_DEFINE_F(InterestGridBenchmark, InterestGrid)(benchmark::State &state) {
+	interestGrid(state);
+}
+
+BENCHMARK_DEFINE_F(InterestGridBenchmark, QuadTree)(benchmark::State &state) {
+	quadTree(state);
+}
+
+BENCHMARK_REGISTER_F(InterestGridBenchmark, InterestGrid)->Arg(1000)->Arg(5000)->Arg(20000)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(InterestGridBenchmark, QuadTree)->Arg(1000)->Arg(5000)->Arg(20000)->Unit(benchmark::kMillisecond);
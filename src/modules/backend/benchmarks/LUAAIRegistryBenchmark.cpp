@@ -0,0 +1,104 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "backend/entity/ai/LUAAIRegistry.h"
+#include "backend/entity/ai/AI.h"
+#include "backend/entity/ai/ICharacter.h"
+#include "backend/entity/ai/condition/True.h"
+#include "backend/entity/ai/zone/Zone.h"
+
+/**
+ * @brief Executes a behaviour tree that only consists of a lua node for a lot of entities. The zone executes the
+ * node in parallel - every zone worker is using an own lua state of the registry.
+ */
+class LUAAIRegistryBenchmark : public app::AbstractBenchmark {
+protected:
+	static constexpr int Entities = 10000;
+
+	backend::LUAAIRegistry* _registry = nullptr;
+	backend::TreeNodePtr _root;
+
+	bool onInitApp() override {
+		_registry = new backend::LUAAIRegistry();
+		const char *script = ""
+			"UNKNOWN, CANNOTEXECUTE, RUNNING, FINISHED, FAILED, EXCEPTION = 0, 1, 2, 3, 4, 5\n"
+			"local wander = REGISTRY.createNode(\"BenchmarkWander\")\n"
+			"function wander:execute(ai, deltaMillis)\n"
+			"	local v = ai:id()\n"
+			"	for i = 1, 64 do\n"
+			"		v = (v * 1103515245 + 12345) % 2147483648\n"
+			"	end\n"
+			"	if v % 2 == 0 then\n"
+			"		return RUNNING\n"
+			"	end\n"
+			"	return FINISHED\n"
+			"end\n";
+		if (!_registry->evaluate(script, SDL_strlen(script))) {
+			return false;
+		}
+		const backend::TreeNodeFactoryContext ctx("root", "", backend::True::get());
+		_root = _registry->createNode("BenchmarkWander", ctx);
+		return (bool)_root;
+	}
+
+	void onCleanupApp() override {
+		_root = backend::TreeNodePtr();
+		// the lua states are holding references to the ai instances until they are closed
+		_registry->shutdown();
+		delete _registry;
+		_registry = nullptr;
+	}
+
+	backend::AIPtr createAI(ai::CharacterId id) const {
+		const backend::AIPtr& ai = std::make_shared<backend::AI>(_root);
+		ai->setCharacter(core::make_shared<backend::ICharacter>(id));
+		return ai;
+	}
+
+public:
+	/**
+	 * @brief All lua nodes are executed on the calling thread
+	 */
+	void serial(benchmark::State &state) {
+		core::DynamicArray<backend::AIPtr> ais;
+		ais.reserve(Entities);
+		for (int i = 0; i < Entities; ++i) {
+			ais.push_back(createAI((ai::CharacterId)(i + 1)));
+		}
+		for (auto _ : state) {
+			for (const backend::AIPtr& ai : ais) {
+				ai->update(1, false);
+				ai->getBehaviour()->execute(ai, 1);
+			}
+		}
+	}
+
+	/**
+	 * @param[in] state @c range(0) is the amount of zone worker threads
+	 */
+	void zone(benchmark::State &state) {
+		backend::Zone zone("benchmark", (int)state.range(0));
+		for (int i = 0; i < Entities; ++i) {
+			zone.addAI(createAI((ai::CharacterId)(i + 1)));
+		}
+		// process the scheduled adds
+		zone.update(1);
+		for (auto _ : state) {
+			zone.update(1);
+		}
+	}
+};
+
+BENCHMARK_DEFINE_F(LUAAIRegistryBenchmark, Serial)(benchmark::State &state) {
+	serial(state);
+}
+
+BENCHMARK_DEFINE_F(LUAAIRegistryBenchmark, Zone)(benchmark::State &state) {
+	zone(state);
+}
+
+// the lua states are not garbage collected - limit the iterations to keep the memory usage bounded
+BENCHMARK_REGISTER_F(LUAAIRegistryBenchmark, Serial)->Iterations(50)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_REGISTER_F(LUAAIRegistryBenchmark, Zone)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Iterations(50)->Unit(benchmark::kMillisecond)->UseRealTime();
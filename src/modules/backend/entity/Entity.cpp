@@ -66,21 +66,23 @@ bool Entity::attack(EntityId victimId) {
 
 void Entity::sendToVisible(flatbuffers::FlatBufferBuilder& fbb, network::ServerMsgType type,
 		flatbuffers::Offset<void> data, bool sendToSelf, uint32_t flags) const {
-	const EntitySet& visible = visibleCopy();
 	std::vector<ENetPeer*> peers;
-	peers.reserve(visible.size() + 1);
 	if (sendToSelf) {
 		ENetPeer* p = peer();
 		if (p != nullptr) {
 			peers.push_back(p);
 		}
 	}
-	for (const EntityPtr& e : visible) {
-		ENetPeer* peer = e->peer();
-		if (peer == nullptr) {
-			continue;
+	{
+		core::ScopedReadLock lock(_visibleLock);
+		peers.reserve(_visible.size() + 1);
+		for (const EntityPtr& e : _visible) {
+			ENetPeer* peer = e->peer();
+			if (peer == nullptr) {
+				continue;
+			}
+			peers.push_back(peer);
 		}
-		peers.push_back(peer);
 	}
 	if (peers.empty()) {
 		Log::debug("don't send message of type '%s' - no peers found", network::toString(type, network::EnumNamesServerMsgType()));
@@ -195,18 +197,33 @@ bool Entity::update(long dt) {
 
 void Entity::updateVisible(const EntitySet& set) {
 	core_trace_scoped(UpdateVisible);
-	_visibleLock.lockWrite();
-	const auto& stillVisible = core::setIntersection(set, _visible);
-	const EntitySet& remove = core::setDifference(stillVisible, _visible);
-	const EntitySet& add = core::setDifference(set, stillVisible);
-	_visible = core::setUnion(stillVisible, add);
-	_visibleLock.unlockWrite();
-
+	EntitySet add;
+	EntitySet remove;
 	_visibleLock.lockRead();
-	for (const auto& e : _visible) {
-		sendEntityUpdate(e);
+	for (const EntityPtr& e : set) {
+		if (_visible.find(e) == _visible.end()) {
+			add.insert(e);
+		}
+	}
+	for (const EntityPtr& e : _visible) {
+		if (set.find(e) == set.end()) {
+			remove.insert(e);
+		}
 	}
 	_visibleLock.unlockRead();
+	updateVisible(add, remove);
+}
+
+void Entity::updateVisible(const EntitySet& add, const EntitySet& remove) {
+	core_trace_scoped(UpdateVisibleDelta);
+	_visibleLock.lockWrite();
+	for (const EntityPtr& e : remove) {
+		_visible.erase(e);
+	}
+	for (const EntityPtr& e : add) {
+		_visible.insert(e);
+	}
+	_visibleLock.unlockWrite();
 
 	if (!add.empty()) {
 		visibleAdd(add);
@@ -216,17 +233,6 @@ void Entity::updateVisible(const EntitySet& set) {
 	}
 }
 
-void Entity::sendEntityUpdate(const EntityPtr& entity) const {
-	if (_peer == nullptr) {
-		return;
-	}
-	const glm::vec3& _pos = entity->pos();
-	const network::Vec3 pos { _pos.x, _pos.y, _pos.z };
-	_entityUpdateFBB.Clear();
-	_messageSender->sendServerMessage(_peer, _entityUpdateFBB, network::ServerMsgType::EntityUpdate,
-			network::CreateEntityUpdate(_entityUpdateFBB, entity->id(), &pos, entity->orientation(), entity->animation()).Union());
-}
-
 void Entity::sendEntitySpawn(const EntityPtr& entity) const {
 	if (_peer == nullptr) {
 		return;
@@ -26,10 +26,10 @@ typedef std::unordered_set<EntityPtr> EntitySet;
 /**
  * @brief Every actor in the world is an entity
  *
- * Entities are updated via @c network::ServerMsgType::EntityUpdate
+ * Entities are updated via the @c network::ServerMsgType::EntitySnapshot
  * message for the clients that are seeing the entity
  *
- * @sa EntityUpdateHandler
+ * @sa UserSnapshotMgr
  */
 class Entity {
 private:
@@ -37,7 +37,6 @@ private:
 	EntitySet _visible core_thread_guarded_by(_visibleLock);
 	// they are stored as members to reduce memory allocations
 	mutable flatbuffers::FlatBufferBuilder _attribUpdateFBB;
-	mutable flatbuffers::FlatBufferBuilder _entityUpdateFBB;
 	mutable flatbuffers::FlatBufferBuilder _entitySpawnFBB;
 	mutable flatbuffers::FlatBufferBuilder _entityRemoveFBB;
 
@@ -72,7 +71,6 @@ protected:
 	void visibleRemove(const EntitySet& entities);
 
 	void broadcastAttribUpdate();
-	void sendEntityUpdate(const EntityPtr& entity) const;
 	void sendEntitySpawn(const EntityPtr& entity) const;
 	void sendEntityRemove(const EntityPtr& entity) const;
 
@@ -151,6 +149,13 @@ public:
 	 * @note This is thread safe
 	 */
 	void updateVisible(const EntitySet& set);
+	/**
+	 * @brief Applies the changes of the visible entities - the spawn and remove messages are sent for them.
+	 * @param[in] add The entities that just got visible
+	 * @param[in] remove The entities that are no longer visible
+	 * @note This is thread safe
+	 */
+	void updateVisible(const EntitySet& add, const EntitySet& remove);
 
 	/**
 	 * @brief The tick of the entity
@@ -29,7 +29,8 @@ User::User(ENetPeer* peer, EntityId id,
 		_cooldownMgr(this, timeProvider, cooldownProvider, dbHandler, persistenceMgr),
 		_attribMgr(id, _attribs, dbHandler, persistenceMgr),
 		_logoutMgr(_cooldownMgr),
-		_movementMgr(this) {
+		_movementMgr(this),
+		_snapshotMgr(this, messageSender) {
 	setPeer(peer);
 	_entityType = network::EntityType::PLAYER;
 }
@@ -44,6 +45,7 @@ void User::init() {
 	_attribMgr.init();
 	_logoutMgr.init();
 	_movementMgr.init();
+	_snapshotMgr.init();
 }
 
 void User::sendVars() const {
@@ -73,6 +75,7 @@ void User::shutdown() {
 	_attribMgr.shutdown();
 	_logoutMgr.shutdown();
 	_movementMgr.shutdown();
+	_snapshotMgr.shutdown();
 	Super::shutdown();
 }
 
@@ -82,6 +85,8 @@ ENetPeer* User::setPeer(ENetPeer* peer) {
 	if (_peer) {
 		_peer->data = this;
 	}
+	// the new client doesn't know any of the snapshots
+	_snapshotMgr.reset();
 	return old;
 }
 
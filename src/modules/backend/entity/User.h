@@ -12,6 +12,7 @@
 #include "user/UserCooldownMgr.h"
 #include "user/UserLogoutMgr.h"
 #include "user/UserMovementMgr.h"
+#include "user/UserSnapshotMgr.h"
 #include "persistence/DBHandler.h"
 #include "stock/StockDataProvider.h"
 
@@ -32,6 +33,7 @@ private:
 	UserAttribMgr _attribMgr;
 	UserLogoutMgr _logoutMgr;
 	UserMovementMgr _movementMgr;
+	UserSnapshotMgr _snapshotMgr;
 
 public:
 	User(ENetPeer* peer,
@@ -104,6 +106,9 @@ public:
 
 	UserMovementMgr& movementMgr();
 	const UserMovementMgr& movementMgr() const;
+
+	UserSnapshotMgr& snapshotMgr();
+	const UserSnapshotMgr& snapshotMgr() const;
 };
 
 inline UserLogoutMgr& User::logoutMgr() {
@@ -122,6 +127,14 @@ inline const UserMovementMgr& User::movementMgr() const {
 	return _movementMgr;
 }
 
+inline UserSnapshotMgr& User::snapshotMgr() {
+	return _snapshotMgr;
+}
+
+inline const UserSnapshotMgr& User::snapshotMgr() const {
+	return _snapshotMgr;
+}
+
 inline UserCooldownMgr& User::cooldownMgr() {
 	return _cooldownMgr;
 }
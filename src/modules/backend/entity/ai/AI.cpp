@@ -4,6 +4,8 @@
 
 #include "AI.h"
 #include "tree/TreeNode.h"
+#include "core/Common.h"
+#include <limits.h>
 
 namespace backend {
 
@@ -14,6 +16,73 @@ ai::CharacterId AI::getId() const {
 	return _character->getId();
 }
 
+AI::NodeState& AI::nodeState(int nodeId) {
+	const int size = (int)_nodeStates.size();
+	if (size == 0) {
+		_nodeStateOffset = nodeId;
+		_nodeStates.resize(1);
+		return _nodeStates[0];
+	}
+	if (nodeId < _nodeStateOffset) {
+		// the node ids are usually increasing from the root node on - only happens for nodes that are
+		// added to the behaviour later on
+		const int delta = _nodeStateOffset - nodeId;
+		NodeStates states;
+		states.resize(size + delta);
+		for (int i = 0; i < size; ++i) {
+			states[i + delta] = _nodeStates[i];
+		}
+		_nodeStates = core::move(states);
+		_nodeStateOffset = nodeId;
+		return _nodeStates[0];
+	}
+	const int index = nodeId - _nodeStateOffset;
+	if (index >= size) {
+		_nodeStates.resize(index + 1);
+	}
+	return _nodeStates[index];
+}
+
+const AI::NodeState* AI::findNodeState(int nodeId) const {
+	const int index = nodeId - _nodeStateOffset;
+	if (index < 0 || index >= (int)_nodeStates.size()) {
+		return nullptr;
+	}
+	return &_nodeStates[index];
+}
+
+static void nodeIdRange(const TreeNodePtr& node, int& minId, int& maxId) {
+	minId = core_min(minId, node->getId());
+	maxId = core_max(maxId, node->getId());
+	for (const TreeNodePtr& child : node->getChildren()) {
+		nodeIdRange(child, minId, maxId);
+	}
+}
+
+void AI::rebaseNodeStates() {
+	if (!_behaviour) {
+		_nodeStates.clear();
+		_nodeStateOffset = 0;
+		return;
+	}
+	int minId = INT_MAX;
+	int maxId = INT_MIN;
+	nodeIdRange(_behaviour, minId, maxId);
+	NodeStates states;
+	states.resize(maxId - minId + 1);
+	// the limit states survive a behaviour change
+	const int size = (int)_nodeStates.size();
+	for (int i = 0; i < size; ++i) {
+		const int index = _nodeStateOffset + i - minId;
+		if (index < 0 || index >= (int)states.size()) {
+			continue;
+		}
+		states[index].limit = _nodeStates[i].limit;
+	}
+	_nodeStates = core::move(states);
+	_nodeStateOffset = minId;
+}
+
 TreeNodePtr AI::setBehaviour(const TreeNodePtr& newBehaviour) {
 	TreeNodePtr current = _behaviour;
 	_behaviour = newBehaviour;
@@ -33,10 +102,8 @@ void AI::update(int64_t dt, bool debuggingActive) {
 	if (_reset) {
 		// safe to do it like this, because update is not called from multiple threads
 		_reset = false;
-		_lastStatus.clear();
-		_lastExecMillis.clear();
 		_filteredEntities.clear();
-		_selectorStates.clear();
+		rebaseNodeStates();
 	}
 
 	_debuggingActive = debuggingActive;
@@ -11,6 +11,7 @@
 #include "core/concurrent/Lock.h"
 #include "core/concurrent/Atomic.h"
 #include "core/NonCopyable.h"
+#include "core/collection/DynamicArray.h"
 #include "AIMessages_generated.h"
 
 #include <memory>
@@ -47,35 +48,51 @@ class AI : public core::NonCopyable {
 	friend class Server;
 protected:
 	/**
-	 * This map is only filled if we are in debugging mode for this entity
+	 * @brief The runtime state of one @ai{TreeNode} for this entity
 	 */
-	typedef core::Map<int, ai::TreeNodeStatus> NodeStates;
-	NodeStates _lastStatus;
+	struct NodeState {
+		int selector = AI_NOTHING_SELECTED;
+		int limit = 0;
+		/**
+		 * Only updated if we are in debugging mode for this entity
+		 */
+		ai::TreeNodeStatus lastStatus = ai::TreeNodeStatus::UNKNOWN;
+		/**
+		 * Only updated if we are in debugging mode for this entity
+		 */
+		int64_t lastExecMillis = -1L;
+	};
 	/**
-	 * This map is only filled if we are in debugging mode for this entity
+	 * The node states are stored in a flat array that is indexed by the node id. The ids of the nodes of one
+	 * behaviour tree are assigned in a row - so the array only covers the id range of the executed nodes. The
+	 * node ids are global, so the array is rebased to the id range of the new tree after a behaviour change.
 	 */
-	typedef core::Map<int, uint64_t> LastExecMap;
-	LastExecMap _lastExecMillis;
-
+	typedef core::DynamicArray<NodeState> NodeStates;
+	NodeStates _nodeStates;
 	/**
-	 * @note The filtered entities are kept even over several ticks. The caller should decide
-	 * whether he still needs an old/previous filtered selection
-	 * @sa @ai{IFilter}
+	 * The node id of the first entry in @c _nodeStates
 	 */
-	mutable FilteredEntities _filteredEntities;
+	int _nodeStateOffset = 0;
 
 	/**
-	 * Often @ai{Selector} states must be stored to continue in the next step at a particular
-	 * position in the behaviour tree. This map is doing exactly this.
+	 * @note The returned reference is invalidated by the next call
+	 */
+	NodeState& nodeState(int nodeId);
+	/**
+	 * @return @c nullptr if the node was never executed for this entity
+	 */
+	const NodeState* findNodeState(int nodeId) const;
+	/**
+	 * @brief Moves the node states to the id range of the current behaviour - only the limits are kept
 	 */
-	typedef core::Map<int, int> SelectorStates;
-	SelectorStates _selectorStates;
+	void rebaseNodeStates();
 
 	/**
-	 * This map stores the amount of execution for the @ai{Limit} node. The key is the node id
+	 * @note The filtered entities are kept even over several ticks. The caller should decide
+	 * whether he still needs an old/previous filtered selection
+	 * @sa @ai{IFilter}
 	 */
-	typedef core::Map<int, int> LimitStates;
-	LimitStates _limitStates;
+	mutable FilteredEntities _filteredEntities;
 
 	TreeNodePtr _behaviour;
 	AggroMgr _aggroMgr;
@@ -146,6 +163,10 @@ public:
 	 * @brief Get the current behaviour for this ai
 	 */
 	TreeNodePtr getBehaviour() const;
+	/**
+	 * @return @c true if the given node is the current behaviour - without copying the behaviour pointer
+	 */
+	bool isBehaviour(const TreeNodePtr& behaviour) const;
 	/**
 	 * @brief Set a new behaviour
 	 * @return the old one if there was any
@@ -189,6 +210,10 @@ inline TreeNodePtr AI::getBehaviour() const {
 	return _behaviour;
 }
 
+inline bool AI::isBehaviour(const TreeNodePtr& behaviour) const {
+	return _behaviour == behaviour;
+}
+
 inline void AI::setPause(bool pause) {
 	_pause = pause;
 }
@@ -66,6 +66,21 @@ static LUAAIRegistry* luaAI_toregistry(lua_State * s) {
 	return luaAI_getlightuserdata<LUAAIRegistry>(s, luaAI_metaregistry());
 }
 
+static inline const char* luaAI_metaworker() {
+	return "__meta_registry_worker";
+}
+
+/**
+ * @return @c true if the state is a worker state of the registry - the factories are already registered by the
+ * state of the registry then
+ */
+static bool luaAI_isworker(lua_State * s) {
+	lua_getfield(s, LUA_REGISTRYINDEX, luaAI_metaworker());
+	const bool worker = lua_toboolean(s, -1);
+	lua_pop(s, 1);
+	return worker;
+}
+
 /***
  * Gives you access the the userdata for the LuaNodeFactory instance you are operating on.
  * @return the node factory userdata
@@ -130,13 +145,22 @@ static int luaAI_nodetostring(lua_State* s) {
 static int luaAI_createnode(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUATreeNodeFactoryPtr& factory = std::make_shared<LuaNodeFactory>(s, type);
-	const bool inserted = r->registerNodeFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "tree node %s is already registered", type.c_str());
+	const bool worker = luaAI_isworker(s);
+	LUATreeNodeFactoryPtr factory;
+	if (worker) {
+		LuaNodeFactory* registered = r->treeNodeFactory(type);
+		if (registered == nullptr) {
+			return clua_error(s, "tree node %s is not registered", type.c_str());
+		}
+		clua_newuserdata<LuaNodeFactory*>(s, registered);
+	} else {
+		factory = std::make_shared<LuaNodeFactory>(r, type);
+		const bool inserted = r->registerNodeFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "tree node %s is already registered", type.c_str());
+		}
+		clua_newuserdata<LuaNodeFactory*>(s, factory.get());
 	}
-
-	clua_newuserdata<LuaNodeFactory*>(s, factory.get());
 	const luaL_Reg nodes[] = {
 		{"execute", luaAI_nodeemptyexecute},
 		{"__tostring", luaAI_nodetostring},
@@ -144,7 +168,9 @@ static int luaAI_createnode(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "node");
-	r->addTreeNodeFactory(type, factory);
+	if (!worker) {
+		r->addTreeNodeFactory(type, factory);
+	}
 	return 1;
 }
 
@@ -171,13 +197,22 @@ static int luaAI_conditiontostring(lua_State* s) {
 static int luaAI_createcondition(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUAConditionFactoryPtr& factory = std::make_shared<LuaConditionFactory>(s, type);
-	const bool inserted = r->registerConditionFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "condition %s is already registered", type.c_str());
+	const bool worker = luaAI_isworker(s);
+	LUAConditionFactoryPtr factory;
+	if (worker) {
+		LuaConditionFactory* registered = r->conditionFactory(type);
+		if (registered == nullptr) {
+			return clua_error(s, "condition %s is not registered", type.c_str());
+		}
+		clua_newuserdata<LuaConditionFactory*>(s, registered);
+	} else {
+		factory = std::make_shared<LuaConditionFactory>(r, type);
+		const bool inserted = r->registerConditionFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "condition %s is already registered", type.c_str());
+		}
+		clua_newuserdata<LuaConditionFactory*>(s, factory.get());
 	}
-
-	clua_newuserdata<LuaConditionFactory*>(s, factory.get());
 	const luaL_Reg nodes[] = {
 		{"evaluate", luaAI_conditionemptyevaluate},
 		{"__tostring", luaAI_conditiontostring},
@@ -185,7 +220,9 @@ static int luaAI_createcondition(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "condition");
-	r->addConditionFactory(type, factory);
+	if (!worker) {
+		r->addConditionFactory(type, factory);
+	}
 	return 1;
 }
 
@@ -208,13 +245,22 @@ static int luaAI_filtertostring(lua_State* s) {
 static int luaAI_createfilter(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUAFilterFactoryPtr& factory = std::make_shared<LuaFilterFactory>(s, type);
-	const bool inserted = r->registerFilterFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "filter %s is already registered", type.c_str());
+	const bool worker = luaAI_isworker(s);
+	LUAFilterFactoryPtr factory;
+	if (worker) {
+		LuaFilterFactory* registered = r->filterFactory(type);
+		if (registered == nullptr) {
+			return clua_error(s, "filter %s is not registered", type.c_str());
+		}
+		clua_newuserdata<LuaFilterFactory*>(s, registered);
+	} else {
+		factory = std::make_shared<LuaFilterFactory>(r, type);
+		const bool inserted = r->registerFilterFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "filter %s is already registered", type.c_str());
+		}
+		clua_newuserdata<LuaFilterFactory*>(s, factory.get());
 	}
-
-	clua_newuserdata<LuaFilterFactory*>(s, factory.get());
 	const luaL_Reg nodes[] = {
 		{"filter", luaAI_filteremptyfilter},
 		{"__tostring", luaAI_filtertostring},
@@ -222,7 +268,9 @@ static int luaAI_createfilter(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "filter");
-	r->addFilterFactory(type, factory);
+	if (!worker) {
+		r->addFilterFactory(type, factory);
+	}
 	return 1;
 }
 
@@ -240,13 +288,22 @@ static int luaAI_steeringtostring(lua_State* s) {
 static int luaAI_createsteering(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUASteeringFactoryPtr& factory = std::make_shared<LuaSteeringFactory>(s, type);
-	const bool inserted = r->registerSteeringFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "steering %s is already registered", type.c_str());
+	const bool worker = luaAI_isworker(s);
+	LUASteeringFactoryPtr factory;
+	if (worker) {
+		LuaSteeringFactory* registered = r->steeringFactory(type);
+		if (registered == nullptr) {
+			return clua_error(s, "steering %s is not registered", type.c_str());
+		}
+		clua_newuserdata<LuaSteeringFactory*>(s, registered);
+	} else {
+		factory = std::make_shared<LuaSteeringFactory>(r, type);
+		const bool inserted = r->registerSteeringFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "steering %s is already registered", type.c_str());
+		}
+		clua_newuserdata<LuaSteeringFactory*>(s, factory.get());
 	}
-
-	clua_newuserdata<LuaSteeringFactory*>(s, factory.get());
 	const luaL_Reg nodes[] = {
 		{"filter", luaAI_steeringemptyexecute},
 		{"__tostring", luaAI_steeringtostring},
@@ -254,15 +311,24 @@ static int luaAI_createsteering(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "steering");
-	r->addSteeringFactory(type, factory);
+	if (!worker) {
+		r->addSteeringFactory(type, factory);
+	}
 	return 1;
 }
 
-LUAAIRegistry::LUAAIRegistry() {
+static core::AtomicInt registryIds(1);
+
+LUAAIRegistry::LUAAIRegistry() :
+		_id((uint32_t)registryIds.increment(1)), _thread(SDL_ThreadID()) {
 	_s = _lua.state();
+	setupState(_s, false);
+}
+
+void LUAAIRegistry::setupState(lua_State* s, bool worker) {
 	// TODO: random module
 
-	lua_gc(_s, LUA_GCSTOP, 0);
+	lua_gc(s, LUA_GCSTOP, 0);
 
 	static const luaL_Reg registryFuncs[] = {
 		{"createNode", luaAI_createnode},
@@ -271,16 +337,68 @@ LUAAIRegistry::LUAAIRegistry() {
 		{"createSteering", luaAI_createsteering},
 		{nullptr, nullptr}
 	};
-	clua_registerfuncsglobal(_s, registryFuncs, "META_REGISTRY", "REGISTRY");
+	clua_registerfuncsglobal(s, registryFuncs, "META_REGISTRY", "REGISTRY");
 
-	luaAI_globalpointer(_s, this, luaAI_metaregistry());
-	luaAI_registerAll(_s);
+	luaAI_globalpointer(s, this, luaAI_metaregistry());
+	lua_pushboolean(s, worker ? 1 : 0);
+	lua_setfield(s, LUA_REGISTRYINDEX, luaAI_metaworker());
+	luaAI_registerAll(s);
 }
 
 lua_State* LUAAIRegistry::getLuaState() {
 	return _s;
 }
 
+LUAAIRegistry::WorkerState* LUAAIRegistry::workerState() {
+	struct Cache {
+		uint32_t registryId = 0u;
+		WorkerState* state = nullptr;
+	};
+	// the ids are never reused - a destroyed registry can't be mistaken for a new one at the same address
+	thread_local Cache cache;
+	if (cache.registryId == _id) {
+		return cache.state;
+	}
+	const SDL_threadID thread = SDL_ThreadID();
+	core::ScopedLock scopedLock(_lock);
+	WorkerState* state = nullptr;
+	for (WorkerState* w : _workerStates) {
+		if (w->thread == thread) {
+			state = w;
+			break;
+		}
+	}
+	if (state == nullptr) {
+		state = new WorkerState(thread);
+		setupState(state->lua.state(), true);
+		_workerStates.push_back(state);
+		Log::debug("Created lua ai state %i", (int)_workerStates.size());
+	}
+	cache.registryId = _id;
+	cache.state = state;
+	return state;
+}
+
+lua_State* LUAAIRegistry::luaState() {
+	if (SDL_ThreadID() == _thread) {
+		return _s;
+	}
+	WorkerState* state = workerState();
+	if (state->scripts != (size_t)(int)_scriptCount) {
+		core::DynamicArray<core::String> scripts;
+		{
+			core::ScopedLock scopedLock(_lock);
+			for (size_t i = state->scripts; i < _scripts.size(); ++i) {
+				scripts.push_back(_scripts[i]);
+			}
+			state->scripts = _scripts.size();
+		}
+		for (const core::String& script : scripts) {
+			evaluate(state->lua.state(), script.c_str(), script.size());
+		}
+	}
+	return state->lua.state();
+}
 int LUAAIRegistry::pushAIMetatable() {
 	core_assert_msg(_s != nullptr, "LUA state is not yet initialized");
 	return luaL_getmetatable(_s, luaAI_metaai());
@@ -295,9 +413,7 @@ bool LUAAIRegistry::init(const core::String& file) {
 	const char* script = ""
 		"UNKNOWN, CANNOTEXECUTE, RUNNING, FINISHED, FAILED, EXCEPTION = 0, 1, 2, 3, 4, 5\n";
 
-	if (luaL_loadbufferx(_s, script, SDL_strlen(script), "", nullptr) || lua_pcall(_s, 0, 0, 0)) {
-		Log::error("%s", lua_tostring(_s, -1));
-		lua_pop(_s, 1);
+	if (!evaluate(script, SDL_strlen(script))) {
 		return false;
 	}
 	const core::String& btScript = io::filesystem()->load(file);
@@ -312,6 +428,14 @@ bool LUAAIRegistry::init(const core::String& file) {
 void LUAAIRegistry::shutdown() {
 	{
 		core::ScopedLock scopedLock(_lock);
+		for (WorkerState* state : _workerStates) {
+			delete state;
+		}
+		_workerStates.clear();
+		_scripts.clear();
+		_scriptCount = 0;
+		// invalidate the cached worker states
+		_id = (uint32_t)registryIds.increment(1);
 		_treeNodeFactories.clear();
 		_conditionFactories.clear();
 		_filterFactories.clear();
@@ -324,16 +448,27 @@ LUAAIRegistry::~LUAAIRegistry() {
 	shutdown();
 }
 
+bool LUAAIRegistry::evaluate(lua_State* s, const char* luaBuffer, size_t size) {
+	if (luaL_loadbufferx(s, luaBuffer, size, "", nullptr) || lua_pcall(s, 0, 0, 0)) {
+		Log::error("%s", lua_tostring(s, -1));
+		lua_pop(s, 1);
+		return false;
+	}
+	return true;
+}
+
 bool LUAAIRegistry::evaluate(const char* luaBuffer, size_t size) {
 	if (_s == nullptr) {
 		Log::error("LUA state is not yet initialized");
 		return false;
 	}
-	if (luaL_loadbufferx(_s, luaBuffer, size, "", nullptr) || lua_pcall(_s, 0, 0, 0)) {
-		Log::error("%s", lua_tostring(_s, -1));
-		lua_pop(_s, 1);
+	if (!evaluate(_s, luaBuffer, size)) {
 		return false;
 	}
+	// the worker states are loading the script on their next use
+	core::ScopedLock scopedLock(_lock);
+	_scripts.push_back(core::String(luaBuffer, size));
+	_scriptCount = (int)_scripts.size();
 	return true;
 }
 
@@ -357,4 +492,40 @@ void LUAAIRegistry::addSteeringFactory(const core::String& type, const LUASteeri
 	_steeringFactories.emplace(type, factory);
 }
 
+LuaNodeFactory* LUAAIRegistry::treeNodeFactory(const core::String& type) {
+	core::ScopedLock scopedLock(_lock);
+	auto i = _treeNodeFactories.find(type);
+	if (i == _treeNodeFactories.end()) {
+		return nullptr;
+	}
+	return i->second.get();
+}
+
+LuaConditionFactory* LUAAIRegistry::conditionFactory(const core::String& type) {
+	core::ScopedLock scopedLock(_lock);
+	auto i = _conditionFactories.find(type);
+	if (i == _conditionFactories.end()) {
+		return nullptr;
+	}
+	return i->second.get();
+}
+
+LuaFilterFactory* LUAAIRegistry::filterFactory(const core::String& type) {
+	core::ScopedLock scopedLock(_lock);
+	auto i = _filterFactories.find(type);
+	if (i == _filterFactories.end()) {
+		return nullptr;
+	}
+	return i->second.get();
+}
+
+LuaSteeringFactory* LUAAIRegistry::steeringFactory(const core::String& type) {
+	core::ScopedLock scopedLock(_lock);
+	auto i = _steeringFactories.find(type);
+	if (i == _steeringFactories.end()) {
+		return nullptr;
+	}
+	return i->second.get();
+}
+
 }
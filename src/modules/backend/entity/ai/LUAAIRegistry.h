@@ -7,6 +7,8 @@
 
 #include "AIRegistry.h"
 #include "core/Trace.h"
+#include "core/collection/DynamicArray.h"
+#include "core/concurrent/Atomic.h"
 #include "core/concurrent/Concurrency.h"
 #include "core/concurrent/Lock.h"
 #include "commonlua/LUA.h"
@@ -14,6 +16,7 @@
 #include "backend/entity/ai/condition/LUACondition.h"
 #include "backend/entity/ai/filter/LUAFilter.h"
 #include "backend/entity/ai/movement/LUASteering.h"
+#include <SDL_thread.h>
 #include <map>
 
 namespace backend {
@@ -86,17 +89,46 @@ typedef std::map<core::String, LUASteeringFactoryPtr> SteeringFactoryMap;
  * @par AI metatable
  * There is a metatable that you can modify by calling @ai{LUAAIRegistry::pushAIMetatable()}.
  * This metatable is applied to all @ai{AI} pointers that are forwarded to the lua functions.
+ *
+ * @par Threads
+ * The lua nodes are executed in parallel by the zone workers. Every thread that is executing them gets an own
+ * lua state (see @c luaState()) that is initialized like the state of the registry and that gets all the
+ * scripts that were loaded with @c evaluate().
  */
 class LUAAIRegistry : public AIRegistry {
 protected:
+	/**
+	 * @brief The lua state of one thread that is not the thread that created the registry
+	 */
+	struct WorkerState {
+		lua::LUA lua;
+		const SDL_threadID thread;
+		// the amount of evaluated scripts that were loaded into this state
+		size_t scripts = 0u;
+
+		WorkerState(SDL_threadID _thread) :
+				thread(_thread) {
+		}
+	};
+
 	lua::LUA _lua;
 	lua_State* _s = nullptr;
+	// identifies the registry instance in the thread local cache of the worker states
+	uint32_t _id;
+	const SDL_threadID _thread;
 
 	core_trace_mutex(core::Lock, _lock, "LUAAIRegistry");
 	TreeNodeFactoryMap _treeNodeFactories core_thread_guarded_by(_lock);
 	ConditionFactoryMap _conditionFactories core_thread_guarded_by(_lock);
 	FilterFactoryMap _filterFactories core_thread_guarded_by(_lock);
 	SteeringFactoryMap _steeringFactories core_thread_guarded_by(_lock);
+	core::DynamicArray<core::String> _scripts core_thread_guarded_by(_lock);
+	core::AtomicInt _scriptCount { 0 };
+	core::DynamicArray<WorkerState*> _workerStates core_thread_guarded_by(_lock);
+
+	void setupState(lua_State* s, bool worker);
+	static bool evaluate(lua_State* s, const char* luaBuffer, size_t size);
+	WorkerState* workerState();
 public:
 	LUAAIRegistry();
 
@@ -106,17 +138,34 @@ public:
 	void addSteeringFactory(const core::String& type, const LUASteeringFactoryPtr& factory);
 
 	/**
-	 * @brief Access to the lua state.
+	 * @return The factories that were registered by the lua scripts or @c nullptr if there is none for the given type
+	 */
+	LuaNodeFactory* treeNodeFactory(const core::String& type);
+	LuaConditionFactory* conditionFactory(const core::String& type);
+	LuaFilterFactory* filterFactory(const core::String& type);
+	LuaSteeringFactory* steeringFactory(const core::String& type);
+
+	/**
+	 * @brief Access to the lua state of the thread that created the registry.
 	 * @see pushAIMetatable()
 	 */
 	lua_State* getLuaState();
 
+	/**
+	 * @brief The lua state to execute the lua nodes, conditions, filters and steerings on the calling thread.
+	 * The state is created on the first call of a thread and the scripts that were evaluated since the last call
+	 * are loaded before the state is returned.
+	 */
+	lua_State* luaState();
+
 	/**
 	 * @brief Pushes the AI metatable onto the stack. This allows anyone to modify it
 	 * to provide own functions and data that is applied to the @c ai parameters of the
 	 * lua functions.
 	 * @note lua_ctxai() can be used in your lua c callbacks to get access to the
 	 * @ai{AI} pointer: @code const AI* ai = lua_ctxai(s, 1); @endcode
+	 * @note Only the state of the thread that created the registry is modified - changes that should be visible to
+	 * the worker states must be done in a script that is loaded with @c evaluate()
 	 */
 	int pushAIMetatable();
 
@@ -143,7 +192,7 @@ public:
 	}
 
 	/**
-	 * @brief Load your lua scripts into the lua state of the registry.
+	 * @brief Load your lua scripts into the lua state of the registry and the worker states.
 	 * This can be called multiple times to e.g. load multiple files.
 	 * @return @c true if the lua script was loaded, @c false otherwise
 	 * @note you have to call init() before
@@ -10,23 +10,25 @@
 
 namespace backend {
 
+class LUAAIRegistry;
+
 /**
  * @see @ai{LUAAIRegistry}
  */
 class LUACondition : public ICondition {
 protected:
-	lua_State* _s;
+	LUAAIRegistry* _registry;
 
 	bool evaluateLUA(const AIPtr& entity);
 
 public:
 	class LUAConditionFactory : public IConditionFactory {
 	private:
-		lua_State* _s;
+		LUAAIRegistry* _registry;
 		core::String _type;
 	public:
-		LUAConditionFactory(lua_State* s, const core::String& typeStr) :
-				_s(s), _type(typeStr) {
+		LUAConditionFactory(LUAAIRegistry* registry, const core::String& typeStr) :
+				_registry(registry), _type(typeStr) {
 		}
 
 		inline const core::String& type() const {
@@ -34,12 +36,12 @@ public:
 		}
 
 		ConditionPtr create(const ConditionFactoryContext* ctx) const override {
-			return std::make_shared<LUACondition>(_type, ctx->parameters, _s);
+			return std::make_shared<LUACondition>(_type, ctx->parameters, _registry);
 		}
 	};
 
-	LUACondition(const core::String& name, const core::String& parameters, lua_State* s) :
-			ICondition(name, parameters), _s(s) {
+	LUACondition(const core::String& name, const core::String& parameters, LUAAIRegistry* registry) :
+			ICondition(name, parameters), _registry(registry) {
 	}
 
 	~LUACondition() {
@@ -12,13 +12,11 @@
 
 namespace backend {
 
-static size_t complement(size_t maxSize, core::Array<FilteredEntities, 2>& filteredArray) {
-	FilteredEntities intersection(maxSize);
+static void complement(const FilteredEntities& a, const FilteredEntities& b, FilteredEntities& out) {
+	out.reserve(a.size() + b.size());
 	int outSize = 0;
-	core::sortedDifference(filteredArray[0].data(), filteredArray[0].size(), filteredArray[1].data(), filteredArray[1].size(), intersection.data(), intersection.capacity(), outSize);
-	filteredArray[0].clear();
-	filteredArray[0].append(intersection.data(), outSize);
-	return outSize;
+	core::sortedDifference(a.data(), (int)a.size(), b.data(), (int)b.size(), out.data(), (int)out.capacity(), outSize);
+	out.resize(outSize);
 }
 
 void Complement::filter (const AIPtr& entity) {
@@ -39,7 +37,7 @@ void Complement::filter (const AIPtr& entity) {
 	}
 	core_assert(state.n == 1);
 	core_assert(filtered.empty());
-	filtered.append(state.filteredArray[0].data(), state.filteredArray[0].size());
+	filtered.append(state.result().data(), state.result().size());
 }
 
 }
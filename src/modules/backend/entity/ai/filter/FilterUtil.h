@@ -2,6 +2,8 @@
  * @file
  */
 
+#pragma once
+
 #include "core/Algorithm.h"
 #include "core/Common.h"
 #include "core/collection/Array.h"
@@ -9,20 +11,95 @@
 
 namespace backend {
 
-struct FilterState {
+/**
+ * @brief The buffers that are needed to combine the results of several filters. They are reused for every
+ * filter execution on the same thread to not allocate new buffers with each tick.
+ */
+struct FilterScratch {
+	FilteredEntities alreadyFiltered;
 	core::Array<FilteredEntities, 2> filteredArray;
+	FilteredEntities result;
+};
+
+/**
+ * @brief Combines the sorted results of the sub filters of e.g. @ai{Union} or @ai{Intersection}
+ *
+ * @note The filters can be nested - every nesting level gets its own @c FilterScratch instance.
+ */
+class FilterState {
+public:
+	/**
+	 * @param[out] out Is empty and must get the combined entities of @c a and @c b
+	 */
+	typedef void (*Action)(const FilteredEntities& a, const FilteredEntities& b, FilteredEntities& out);
+
+private:
+	static constexpr int MaxDepth = 8;
+	FilterScratch* _scratch;
+	bool _owned;
+
+	static int& depth() {
+		thread_local int d = 0;
+		return d;
+	}
+
+	static FilterScratch* scratch(int level) {
+		thread_local FilterScratch s[MaxDepth];
+		return &s[level];
+	}
+
+public:
 	int n = 0;
-	size_t max = 0u;
 
-	void add(FilteredEntities& filtered, size_t(*action)(size_t max, core::Array<FilteredEntities, 2>&)) {
-		filteredArray[n] = filtered;
-		core::sort(filteredArray[n].begin(), filteredArray[n].end(), core::Less<ai::CharacterId>());
-		max = core_max(filteredArray[n].size(), max);
+	FilterState() {
+		int& d = depth();
+		if (d < MaxDepth) {
+			_scratch = scratch(d);
+			_owned = false;
+		} else {
+			_scratch = new FilterScratch();
+			_owned = true;
+		}
+		++d;
+		_scratch->alreadyFiltered.clear();
+	}
+
+	~FilterState() {
+		--depth();
+		if (_owned) {
+			delete _scratch;
+		}
+	}
+
+	/**
+	 * @brief Remember the given entities to restore or extend them later
+	 */
+	const FilteredEntities& backup(const FilteredEntities& filtered) {
+		_scratch->alreadyFiltered.append(filtered.data(), filtered.size());
+		return _scratch->alreadyFiltered;
+	}
+
+	/**
+	 * @return The combined result of all the added entities
+	 */
+	const FilteredEntities& result() const {
+		return _scratch->filteredArray[0];
+	}
+
+	void add(FilteredEntities& filtered, Action action) {
+		FilteredEntities& target = _scratch->filteredArray[n];
+		target.clear();
+		target.append(filtered.data(), filtered.size());
+		core::sort(target.begin(), target.end(), core::Less<ai::CharacterId>());
 		++n;
 		filtered.clear();
 
 		if (n >= 2) {
-			max = action(max, filteredArray);
+			FilteredEntities& out = _scratch->result;
+			out.clear();
+			action(_scratch->filteredArray[0], _scratch->filteredArray[1], out);
+			_scratch->filteredArray[0].clear();
+			_scratch->filteredArray[0].append(out.data(), out.size());
 			n = 1;
 		}
 	}
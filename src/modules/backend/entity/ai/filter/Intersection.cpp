@@ -11,23 +11,21 @@
 
 namespace backend {
 
-static size_t intersect(size_t maxSize, core::Array<FilteredEntities, 2>& filteredArray) {
-	FilteredEntities intersection(maxSize);
+static void intersect(const FilteredEntities& a, const FilteredEntities& b, FilteredEntities& out) {
+	out.reserve(a.size() + b.size());
 	int outSize = 0;
-	core::sortedIntersection(filteredArray[0].data(), filteredArray[0].size(), filteredArray[1].data(), filteredArray[1].size(), intersection.data(), intersection.capacity(), outSize);
-	filteredArray[0].clear();
-	filteredArray[0].append(intersection.data(), outSize);
-	return outSize;
+	core::sortedIntersection(a.data(), (int)a.size(), b.data(), (int)b.size(), out.data(), (int)out.capacity(), outSize);
+	out.resize(outSize);
 }
 
 void Intersection::filter (const AIPtr& entity) {
 	FilteredEntities& filtered = getFilteredEntities(entity);
+	FilterState state;
 	// create a copy
-	const FilteredEntities alreadyFiltered = filtered;
+	const FilteredEntities& alreadyFiltered = state.backup(filtered);
 	// now clear the entity list
 	filtered.clear();
 
-	FilterState state;
 	for (auto& f : _filters) {
 		f->filter(entity);
 		if (filtered.empty()) {
@@ -43,9 +41,9 @@ void Intersection::filter (const AIPtr& entity) {
 	}
 
 	core_assert(filtered.empty());
-	filtered.reserve(alreadyFiltered.size() + state.filteredArray[0].size());
+	filtered.reserve(alreadyFiltered.size() + state.result().size());
 	filtered.append(alreadyFiltered.data(), alreadyFiltered.size());
-	filtered.append(state.filteredArray[0].data(), state.filteredArray[0].size());
+	filtered.append(state.result().data(), state.result().size());
 }
 
 }
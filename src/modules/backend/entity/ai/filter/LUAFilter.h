@@ -10,23 +10,25 @@
 
 namespace backend {
 
+class LUAAIRegistry;
+
 /**
  * @see @ai{LUAAIRegistry}
  */
 class LUAFilter : public IFilter {
 protected:
-	lua_State* _s;
+	LUAAIRegistry* _registry;
 
 	void filterLUA(const AIPtr& entity);
 
 public:
 	class LUAFilterFactory : public IFilterFactory {
 	private:
-		lua_State* _s;
+		LUAAIRegistry* _registry;
 		core::String _type;
 	public:
-		LUAFilterFactory(lua_State* s, const core::String& typeStr) :
-				_s(s), _type(typeStr) {
+		LUAFilterFactory(LUAAIRegistry* registry, const core::String& typeStr) :
+				_registry(registry), _type(typeStr) {
 		}
 
 		inline const core::String& type() const {
@@ -34,12 +36,12 @@ public:
 		}
 
 		FilterPtr create(const FilterFactoryContext* ctx) const override {
-			return std::make_shared<LUAFilter>(_type, ctx->parameters, _s);
+			return std::make_shared<LUAFilter>(_type, ctx->parameters, _registry);
 		}
 	};
 
-	LUAFilter(const core::String& name, const core::String& parameters, lua_State* s) :
-			IFilter(name, parameters), _s(s) {
+	LUAFilter(const core::String& name, const core::String& parameters, LUAAIRegistry* registry) :
+			IFilter(name, parameters), _registry(registry) {
 	}
 
 	~LUAFilter() {
@@ -25,7 +25,10 @@ void Random::filter (const AIPtr& entity) {
 		return;
 	}
 
-	FilteredEntities copy = filtered;
+	// the sub filters are already executed - the buffer can be reused by every nesting level
+	thread_local FilteredEntities copy;
+	copy.clear();
+	copy.append(filtered.data(), filtered.size());
 	const int maxFiltered = core_min(_n, (int)copy.size());
 	filtered.clear();
 
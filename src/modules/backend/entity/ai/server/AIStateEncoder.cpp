@@ -0,0 +1,273 @@
+/**
+ * @file
+ */
+
+#include "AIStateEncoder.h"
+#include "backend/entity/ai/ICharacter.h"
+#include "backend/entity/ai/condition/ICondition.h"
+#include "backend/entity/ai/zone/Zone.h"
+#include "attrib/ShadowAttributes.h"
+#include "core/Hash.h"
+#include "core/StandardLib.h"
+#include "core/Trace.h"
+
+namespace backend {
+
+DeltaTracker::DeltaTracker(uint32_t resyncInterval) :
+		_resyncInterval(resyncInterval) {
+}
+
+uint32_t DeltaTracker::begin() {
+	if (_resyncInterval > 0u && _sequence + 1u - _first >= _resyncInterval) {
+		reset();
+	}
+	return ++_sequence;
+}
+
+bool DeltaTracker::update(Entry& e, bool changed) {
+	if (changed || e.removed) {
+		e.changed = _sequence;
+		e.removed = false;
+	}
+	e.seen = _sequence;
+	return e.changed > _acked;
+}
+
+bool DeltaTracker::track(int32_t id, uint32_t hash) {
+	auto i = _entries.find(id);
+	if (i == _entries.end()) {
+		Entry e;
+		e.hash = hash;
+		e.changed = _sequence;
+		e.seen = _sequence;
+		_entries.put(id, e);
+		return true;
+	}
+	Entry& e = i->value;
+	const bool changed = e.hash != hash;
+	e.hash = hash;
+	return update(e, changed);
+}
+
+bool DeltaTracker::track(int32_t id, const void* value, size_t size) {
+	auto i = _entries.find(id);
+	if (i == _entries.end()) {
+		Entry e;
+		e.value.append((const uint8_t*)value, size);
+		e.changed = _sequence;
+		e.seen = _sequence;
+		_entries.put(id, e);
+		return true;
+	}
+	Entry& e = i->value;
+	const bool changed = e.value.size() != size || (size > 0u && core_memcmp(e.value.data(), value, size) != 0);
+	if (changed) {
+		e.value.clear();
+		e.value.append((const uint8_t*)value, size);
+	}
+	return update(e, changed);
+}
+
+void DeltaTracker::ack(uint32_t sequence) {
+	if (sequence < _first || sequence > _sequence || sequence <= _acked) {
+		return;
+	}
+	_acked = sequence;
+}
+
+void DeltaTracker::reset() {
+	_entries.clear();
+	_acked = 0u;
+	_first = _sequence + 1u;
+}
+
+AIStateEncoder::AIStateEncoder() :
+		_world(WorldResyncInterval) {
+	_positionFunc = [] (const AIPtr& ai, glm::vec3& home, glm::vec3& target) {
+		home = target = ai->getCharacter()->getPosition();
+	};
+}
+
+void AIStateEncoder::setArea(const math::AABB<float>& area) {
+	_area = area;
+	_hasArea = true;
+}
+
+void AIStateEncoder::clearArea() {
+	_hasArea = false;
+}
+
+void AIStateEncoder::ack(uint32_t stateWorld, uint32_t characterDetails) {
+	_world.ack(stateWorld);
+	_details.ack(characterDetails);
+}
+
+void AIStateEncoder::reset() {
+	_world.reset();
+	resetCharacterDetails();
+}
+
+void AIStateEncoder::resetCharacterDetails() {
+	_details.reset();
+	_detailsCharacterId = AI_NOTHING_SELECTED;
+}
+
+uint32_t AIStateEncoder::stateHash(const AIPtr& ai, const glm::vec3& home, const glm::vec3& target) const {
+	const ICharacterPtr& chr = ai->getCharacter();
+	const glm::vec3& pos = chr->getPosition();
+	const float orientation = chr->getOrientation();
+	uint32_t hash = core::hash(&pos, (int)sizeof(pos));
+	hash = core::hash(&home, (int)sizeof(home), hash);
+	hash = core::hash(&target, (int)sizeof(target), hash);
+	hash = core::hash(&orientation, (int)sizeof(orientation), hash);
+	const attrib::ShadowAttributes& attributes = chr->shadowAttributes();
+	for (int i = 0; i < (int)attrib::Type::MAX; ++i) {
+		const double values[2] = { attributes.current((attrib::Type)i), attributes.max((attrib::Type)i) };
+		hash = core::hash(values, (int)sizeof(values), hash);
+	}
+	for (const auto& e : chr->getMetaAttributes()) {
+		hash = core::hash(e->first.c_str(), (int)e->first.size(), hash);
+		hash = core::hash(e->second.c_str(), (int)e->second.size(), hash);
+	}
+	return hash;
+}
+
+flatbuffers::Offset<ai::State> AIStateEncoder::createState(flatbuffers::FlatBufferBuilder& fbb, const AIPtr& ai, const glm::vec3& home, const glm::vec3& target) const {
+	const ICharacterPtr& chr = ai->getCharacter();
+	const glm::vec3& chrPosition = chr->getPosition();
+	const ai::Vec3 position(chrPosition.x, chrPosition.y, chrPosition.z);
+	const ai::Vec3 targetPosition(target.x, target.y, target.z);
+	const ai::Vec3 homePosition(home.x, home.y, home.z);
+	const ai::CharacterMetaAttributes& chrMetaAttributes = chr->getMetaAttributes();
+	auto metaAttributeIter = chrMetaAttributes.begin();
+	auto metaAttributes = fbb.CreateVector<flatbuffers::Offset<ai::MapEntry>>(chrMetaAttributes.size(),
+		[&] (size_t i) {
+			const core::String& sname = metaAttributeIter->first;
+			const core::String& svalue = metaAttributeIter->second;
+			auto name = fbb.CreateString(sname.c_str(), sname.size());
+			auto value = fbb.CreateString(svalue.c_str(), svalue.size());
+			++metaAttributeIter;
+			return ai::CreateMapEntry(fbb, name, value);
+		});
+	const attrib::ShadowAttributes& chrShadowAttributes = chr->shadowAttributes();
+	auto attributes = fbb.CreateVector<flatbuffers::Offset<ai::AttribEntry>>((size_t)attrib::Type::MAX,
+		[&] (size_t i) {
+			attrib::Type attribType = (attrib::Type)i;
+			return ai::CreateAttribEntry(fbb, (int)i, chrShadowAttributes.current(attribType), chrShadowAttributes.max(attribType));
+		});
+	return ai::CreateState(fbb, chr->getId(), &position, &homePosition, &targetPosition, chr->getOrientation(), metaAttributes, attributes);
+}
+
+flatbuffers::Offset<ai::StateWorld> AIStateEncoder::encodeStateWorld(flatbuffers::FlatBufferBuilder& fbb, const Zone* zone, ai::CharacterId selected) {
+	core_trace_scoped(AIStateEncoderStateWorld);
+	const uint32_t sequence = _world.begin();
+	_states.clear();
+	_removed.clear();
+	auto func = [&] (const AIPtr& ai) {
+		const ICharacterPtr& chr = ai->getCharacter();
+		if (_hasArea && chr->getId() != selected && !_area.containsPoint(chr->getPosition())) {
+			return;
+		}
+		glm::vec3 home;
+		glm::vec3 target;
+		_positionFunc(ai, home, target);
+		if (!_world.track(chr->getId(), stateHash(ai, home, target))) {
+			return;
+		}
+		_states.push_back(createState(fbb, ai, home, target));
+	};
+	zone->execute(func);
+	_world.end([this] (int32_t id) {
+		_removed.push_back(id);
+	});
+
+	const uint32_t base = _world.base();
+	if (base != 0u && _states.empty() && _removed.empty()) {
+		return flatbuffers::Offset<ai::StateWorld>();
+	}
+	auto states = fbb.CreateVector(_states.data(), _states.size());
+	auto removed = fbb.CreateVector(_removed.data(), _removed.size());
+	return ai::CreateStateWorld(fbb, states, sequence, base, removed);
+}
+
+flatbuffers::Offset<ai::StateNode> AIStateEncoder::addNode(flatbuffers::FlatBufferBuilder& fbb, const TreeNodePtr& node, const AIPtr& ai, bool full) {
+	const int32_t nodeId = node->getId();
+	const ConditionPtr& condition = node->getCondition();
+	const core::String conditionStr = condition ? condition->getNameWithConditions(ai) : "";
+	const bool conditionState = condition ? condition->result() : false;
+	const int64_t lastRun = node->getLastExecMillis(ai);
+	const ai::TreeNodeStatus status = node->getLastStatus(ai);
+
+	_value.clear();
+	_value.append((const uint8_t*)&lastRun, sizeof(lastRun));
+	_value.append((const uint8_t*)&status, sizeof(status));
+	_value.append((const uint8_t*)&conditionState, sizeof(conditionState));
+	_value.append((const uint8_t*)conditionStr.c_str(), conditionStr.size());
+	const bool changed = _details.track(nodeId, _value.data(), _value.size());
+
+	if (!full) {
+		if (changed) {
+			_nodes.push_back(ai::CreateStateNode(fbb, nodeId, fbb.CreateString(conditionStr.c_str(), conditionStr.size()),
+				conditionState, 0, lastRun, status));
+		}
+		for (const TreeNodePtr& childNode : node->getChildren()) {
+			addNode(fbb, childNode, ai, full);
+		}
+		return flatbuffers::Offset<ai::StateNode>();
+	}
+
+	const TreeNodes& children = node->getChildren();
+	core::DynamicArray<flatbuffers::Offset<ai::StateNode>> offsets;
+	offsets.reserve(children.size());
+	for (const TreeNodePtr& childNode : children) {
+		offsets.push_back(addNode(fbb, childNode, ai, full));
+	}
+	auto childOffsets = fbb.CreateVector(offsets.data(), offsets.size());
+	return ai::CreateStateNode(fbb, nodeId, fbb.CreateString(conditionStr.c_str(), conditionStr.size()),
+		conditionState, childOffsets, lastRun, status);
+}
+
+flatbuffers::Offset<ai::CharacterDetails> AIStateEncoder::encodeCharacterDetails(flatbuffers::FlatBufferBuilder& fbb, const AIPtr& ai) {
+	core_trace_scoped(AIStateEncoderCharacterDetails);
+	if (ai->getId() != _detailsCharacterId) {
+		_details.reset();
+		_detailsCharacterId = ai->getId();
+	}
+	const uint32_t sequence = _details.begin();
+	const uint32_t base = _details.base();
+	const bool full = base == 0u;
+	_nodes.clear();
+
+	const AggroMgr::Entries& entries = ai->getAggroMgr().getEntries();
+	_value.clear();
+	for (const Entry& e : entries) {
+		const ai::CharacterId characterId = e.getCharacterId();
+		const float aggro = e.getAggro();
+		_value.append((const uint8_t*)&characterId, sizeof(characterId));
+		_value.append((const uint8_t*)&aggro, sizeof(aggro));
+	}
+	flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<ai::StateAggroEntry>>> aggro;
+	if (_details.track(AggroId, _value.data(), _value.size()) || full) {
+		core::DynamicArray<flatbuffers::Offset<ai::StateAggroEntry>> offsets;
+		offsets.reserve(entries.size());
+		for (const Entry& e : entries) {
+			offsets.push_back(ai::CreateStateAggroEntry(fbb, e.getCharacterId(), e.getAggro()));
+		}
+		aggro = fbb.CreateVector(offsets.data(), offsets.size());
+	}
+
+	const flatbuffers::Offset<ai::StateNode> root = addNode(fbb, ai->getBehaviour(), ai, full);
+	// the tree doesn't lose nodes without a reset - but the removed entries must be cleaned up
+	_details.end([] (int32_t) {});
+
+	if (!full && aggro.IsNull() && _nodes.empty()) {
+		return flatbuffers::Offset<ai::CharacterDetails>();
+	}
+	flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<ai::StateNode>>> nodes;
+	if (!full) {
+		nodes = fbb.CreateVector(_nodes.data(), _nodes.size());
+	}
+	return ai::CreateCharacterDetails(fbb, ai->getId(), aggro, root, sequence, base, nodes);
+}
+
+}
@@ -0,0 +1,205 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "backend/entity/ai/AI.h"
+#include "backend/entity/ai/tree/TreeNode.h"
+#include "core/collection/Buffer.h"
+#include "core/collection/DynamicArray.h"
+#include "core/collection/DynamicMap.h"
+#include "math/AABB.h"
+#include "AIMessages_generated.h"
+#include <functional>
+
+namespace backend {
+
+class Zone;
+
+/**
+ * @brief Remembers the sequence in which the state of an object changed the last time.
+ *
+ * Together with the last sequence that was acknowledged by the debugger this tells which objects have to be sent.
+ * Every sample starts with @c begin(), calls @c track() for every object and ends with @c end() to find the objects
+ * that are gone. An object is sent until a sequence that includes its last change is acknowledged - so the
+ * messages can be applied on top of any state the debugger has acknowledged.
+ *
+ * The state of an object is either compared by value or by a 32 bit hash. A hash collision hides a change - the
+ * debugger keeps the stale state until the object changes again. If hashes are tracked, a resync interval should
+ * be given: the whole state is sent again (base @c 0) after that amount of samples.
+ */
+class DeltaTracker {
+private:
+	struct Entry {
+		uint32_t hash = 0u;
+		// the tracked state itself if it is compared by value
+		core::Buffer<uint8_t> value;
+		uint32_t changed = 0u;
+		uint32_t seen = 0u;
+		bool removed = false;
+	};
+	core::DynamicMap<int32_t, Entry, 256> _entries;
+	core::DynamicArray<int32_t> _obsolete;
+	uint32_t _sequence = 0u;
+	// acks for sequences before this one belong to a state that was reset
+	uint32_t _first = 1u;
+	uint32_t _acked = 0u;
+	const uint32_t _resyncInterval;
+
+	bool update(Entry& e, bool changed);
+
+public:
+	/**
+	 * @param[in] resyncInterval The amount of samples after which the whole state is sent again - @c 0 to never
+	 * do this
+	 */
+	DeltaTracker(uint32_t resyncInterval = 0u);
+
+	/**
+	 * @brief Starts a new sample
+	 * @return The sequence of the new sample
+	 */
+	uint32_t begin();
+	/**
+	 * @return @c true if the object changed after the acknowledged sequence and must be sent
+	 */
+	bool track(int32_t id, uint32_t hash);
+	/**
+	 * @brief Compares the given state byte by byte with the tracked one
+	 * @return @c true if the object changed after the acknowledged sequence and must be sent
+	 */
+	bool track(int32_t id, const void* value, size_t size);
+	/**
+	 * @brief Calls the given functor for every object that was removed after the acknowledged sequence
+	 */
+	template<class FUNC>
+	void end(FUNC&& removed) {
+		for (auto i = _entries.begin(); i != _entries.end(); ++i) {
+			Entry& e = i->value;
+			if (!e.removed && e.seen != _sequence) {
+				e.removed = true;
+				e.changed = _sequence;
+			}
+			if (!e.removed) {
+				continue;
+			}
+			if (e.changed > _acked) {
+				removed(i->key);
+			} else {
+				_obsolete.push_back(i->key);
+			}
+		}
+		for (int32_t id : _obsolete) {
+			_entries.remove(id);
+		}
+		_obsolete.clear();
+	}
+
+	void ack(uint32_t sequence);
+	/**
+	 * @brief Forget everything - the next sample is sent as a whole
+	 */
+	void reset();
+	/**
+	 * @return The acknowledged sequence the current sample is based on - @c 0 means that the whole state is sent
+	 */
+	uint32_t base() const;
+	uint32_t sequence() const;
+	size_t size() const;
+};
+
+inline uint32_t DeltaTracker::base() const {
+	return _acked;
+}
+
+inline uint32_t DeltaTracker::sequence() const {
+	return _sequence;
+}
+
+inline size_t DeltaTracker::size() const {
+	return _entries.size();
+}
+
+/**
+ * @brief Encodes the @c ai::StateWorld and @c ai::CharacterDetails messages for the debugger as deltas to the last
+ * state that was acknowledged by the debugger with an @c ai::Ack message.
+ *
+ * Only the entities in the subscribed area are part of the world state - the selected character is always included.
+ */
+class AIStateEncoder {
+public:
+	/**
+	 * @brief Resolves the home and the target position of the given ai
+	 */
+	typedef std::function<void(const AIPtr& ai, glm::vec3& home, glm::vec3& target)> PositionFunc;
+private:
+	// the key of the aggro list in the character details tracker - node ids are never negative
+	static constexpr int32_t AggroId = -1;
+	// the world states are tracked by hash - send the whole world again after this amount of samples
+	static constexpr uint32_t WorldResyncInterval = 1000u;
+
+	DeltaTracker _world;
+	DeltaTracker _details;
+	ai::CharacterId _detailsCharacterId = AI_NOTHING_SELECTED;
+	math::AABB<float> _area;
+	bool _hasArea = false;
+	PositionFunc _positionFunc;
+
+	core::DynamicArray<flatbuffers::Offset<ai::State>> _states;
+	core::DynamicArray<int32_t> _removed;
+	core::DynamicArray<flatbuffers::Offset<ai::StateNode>> _nodes;
+	// the state of an aggro list or a node that is compared by value
+	core::Buffer<uint8_t> _value;
+
+	flatbuffers::Offset<ai::State> createState(flatbuffers::FlatBufferBuilder& fbb, const AIPtr& ai, const glm::vec3& home, const glm::vec3& target) const;
+	uint32_t stateHash(const AIPtr& ai, const glm::vec3& home, const glm::vec3& target) const;
+	flatbuffers::Offset<ai::StateNode> addNode(flatbuffers::FlatBufferBuilder& fbb, const TreeNodePtr& node, const AIPtr& ai, bool full);
+
+public:
+	AIStateEncoder();
+
+	void setPositionFunc(const PositionFunc& func);
+	/**
+	 * @brief Only the entities inside of the given area are sent
+	 */
+	void setArea(const math::AABB<float>& area);
+	void clearArea();
+
+	void ack(uint32_t stateWorld, uint32_t characterDetails);
+	/**
+	 * @brief The next messages contain the whole state again. Call this for a new debugging session.
+	 */
+	void reset();
+	/**
+	 * @brief The next character details contain the whole behaviour tree again - e.g. after the tree was modified
+	 */
+	void resetCharacterDetails();
+
+	/**
+	 * @param[in] selected The selected character is sent even if it is not inside of the subscribed area
+	 * @return A null offset if nothing changed
+	 */
+	flatbuffers::Offset<ai::StateWorld> encodeStateWorld(flatbuffers::FlatBufferBuilder& fbb, const Zone* zone, ai::CharacterId selected);
+	/**
+	 * @return A null offset if nothing changed
+	 */
+	flatbuffers::Offset<ai::CharacterDetails> encodeCharacterDetails(flatbuffers::FlatBufferBuilder& fbb, const AIPtr& ai);
+
+	const DeltaTracker& stateWorldTracker() const;
+	const DeltaTracker& characterDetailsTracker() const;
+};
+
+inline void AIStateEncoder::setPositionFunc(const PositionFunc& func) {
+	_positionFunc = func;
+}
+
+inline const DeltaTracker& AIStateEncoder::stateWorldTracker() const {
+	return _world;
+}
+
+inline const DeltaTracker& AIStateEncoder::characterDetailsTracker() const {
+	return _details;
+}
+
+}
@@ -0,0 +1,17 @@
+/**
+ * @file
+ */
+
+#include "AckHandler.h"
+#include "Server.h"
+
+namespace backend {
+
+AckHandler::AckHandler(Server& server) : _server(server) {
+}
+
+void AckHandler::executeWithRaw(void* attachment, const ai::Ack* message, const uint8_t* rawData, size_t rawDataSize) {
+	_server.ack(message->state_world(), message->character_details());
+}
+
+}
@@ -0,0 +1,22 @@
+/**
+ * @file
+ */
+#pragma once
+
+#include "network/IMsgProtocolHandler.h"
+#include "AIMessages_generated.h"
+
+namespace backend {
+
+class Server;
+
+class AckHandler: public network::IMsgProtocolHandler<ai::Ack, void> {
+private:
+	Server& _server;
+public:
+	explicit AckHandler(Server& server);
+
+	void executeWithRaw(void* attachment, const ai::Ack* message, const uint8_t* rawData, size_t rawDataSize) override;
+};
+
+}
@@ -7,6 +7,8 @@
 #include "AIMessages_generated.h"
 #include "Npc.h"
 #include "SelectHandler.h"
+#include "SubscribeHandler.h"
+#include "AckHandler.h"
 #include "PauseHandler.h"
 #include "ResetHandler.h"
 #include "StepHandler.h"
@@ -52,6 +54,14 @@ Server::Server(AIRegistry& aiRegistry, const metric::MetricPtr& metric,
 	r->registerHandler(ai::MsgType::DeleteNode, std::make_shared<DeleteNodeHandler>(*this));
 	r->registerHandler(ai::MsgType::UpdateNode, std::make_shared<UpdateNodeHandler>(*this));
 	r->registerHandler(ai::MsgType::ExecuteCommand, std::make_shared<ExecuteCommandHandler>());
+	r->registerHandler(ai::MsgType::Subscribe, std::make_shared<SubscribeHandler>(*this));
+	r->registerHandler(ai::MsgType::Ack, std::make_shared<AckHandler>(*this));
+
+	_stateEncoder.setPositionFunc([] (const AIPtr& ai, glm::vec3& home, glm::vec3& target) {
+		const backend::Npc& npc = getNpc(ai);
+		home = npc.homePosition();
+		target = npc.targetPosition();
+	});
 
 	_eventBus = std::make_shared<core::EventBus>(2);
 	_eventBus->subscribe<network::NewConnectionEvent>(*this);
@@ -108,40 +118,12 @@ bool Server::start() {
 void Server::broadcastState(const Zone* zone) {
 	core_trace_scoped(AIServerBroadcastState);
 	_broadcastMask |= SV_BROADCAST_STATE;
-	core::DynamicArray<flatbuffers::Offset<ai::State>> offsets;
-	offsets.reserve(zone->size());
-	auto func = [&] (const AIPtr& ai) {
-		const ICharacterPtr& chr = ai->getCharacter();
-		const glm::vec3& chrPosition = chr->getPosition();
-		const backend::Npc& npc = getNpc(ai);
-		const glm::vec3& chrHomePosition = npc.homePosition();
-		const glm::vec3& chrTargetPosition = npc.targetPosition();
-		const ai::Vec3 position(chrPosition.x, chrPosition.y, chrPosition.z);
-		const ai::Vec3 targetPosition(chrTargetPosition.x, chrTargetPosition.y, chrTargetPosition.z);
-		const ai::Vec3 homePosition(chrHomePosition.x, chrHomePosition.y, chrHomePosition.z);
-		const ai::CharacterMetaAttributes& chrMetaAttributes = chr->getMetaAttributes();
-		auto metaAttributeIter = chrMetaAttributes.begin();
-		auto metaAttributes = _stateFBB.CreateVector<flatbuffers::Offset<ai::MapEntry>>(chrMetaAttributes.size(),
-			[&] (size_t i) {
-				const core::String& sname = metaAttributeIter->first;
-				const core::String& svalue = metaAttributeIter->second;
-				auto name = _stateFBB.CreateString(sname.c_str(), sname.size());
-				auto value = _stateFBB.CreateString(svalue.c_str(), svalue.size());
-				++metaAttributeIter;
-				return ai::CreateMapEntry(_stateFBB, name, value);
-			});
-		const attrib::ShadowAttributes& chrShadowAttributes = chr->shadowAttributes();
-		auto attributes = _stateFBB.CreateVector<flatbuffers::Offset<ai::AttribEntry>>((size_t)attrib::Type::MAX,
-			[&] (size_t i) {
-				attrib::Type attribType = (attrib::Type)i;
-				return ai::CreateAttribEntry(_stateFBB, (int)i, chrShadowAttributes.current(attribType), chrShadowAttributes.max(attribType));
-			});
-		offsets.push_back(ai::CreateState(_stateFBB, chr->getId(), &position, &homePosition, &targetPosition, chr->getOrientation(), metaAttributes, attributes));
-	};
-	zone->execute(func);
-	auto states = _stateFBB.CreateVector(offsets.data(), offsets.size());
-	_messageSender->broadcastServerMessage(_stateFBB, ai::MsgType::StateWorld,
-		ai::CreateStateWorld(_stateFBB, states).Union());
+	const flatbuffers::Offset<ai::StateWorld> stateWorld = _stateEncoder.encodeStateWorld(_stateFBB, zone, _selectedCharacterId);
+	if (stateWorld.IsNull()) {
+		_stateFBB.Clear();
+		return;
+	}
+	_messageSender->broadcastServerMessage(_stateFBB, ai::MsgType::StateWorld, stateWorld.Union());
 }
 
 void Server::addChildren(const TreeNodePtr& node, core::DynamicArray<flatbuffers::Offset<ai::StateNodeStatic>>& offsets) const {
@@ -200,30 +182,6 @@ void Server::broadcastStaticCharacterDetails(const Zone* zone) {
 	}
 }
 
-flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<ai::StateNode>>> Server::addChildren(const TreeNodePtr& node, const AIPtr& ai) const {
-	const TreeNodes& children = node->getChildren();
-	std::vector<bool> currentlyRunning(children.size());
-	node->getRunningChildren(ai, currentlyRunning);
-	const size_t length = children.size();
-	core::DynamicArray<flatbuffers::Offset<ai::StateNode>> offsets;
-	offsets.reserve(length);
-	for (size_t i = 0u; i < length; ++i) {
-		const TreeNodePtr& childNode = children[i];
-		const int32_t nodeId = childNode->getId();
-		const ConditionPtr& condition = childNode->getCondition();
-		const core::String conditionStr = condition ? condition->getNameWithConditions(ai) : "";
-		const bool conditionState = condition ? condition->result() : false;
-		const int64_t lastRun = childNode->getLastExecMillis(ai);
-		ai::TreeNodeStatus status = childNode->getLastStatus(ai);
-		flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<ai::StateNode>>> childNodeChildren = addChildren(childNode, ai);
-		flatbuffers::Offset<ai::StateNode> child = ai::CreateStateNode(_characterDetailsFBB,
-			nodeId, _characterDetailsFBB.CreateString(conditionStr.c_str(), conditionStr.size()), conditionState,
-			childNodeChildren, lastRun, status);
-		offsets.push_back(child);
-	}
-	return _characterDetailsFBB.CreateVector(offsets.data(), offsets.size());
-}
-
 void Server::broadcastCharacterDetails(const Zone* zone) {
 	core_trace_scoped(AIServerBroadcastCharacterDetails);
 	_broadcastMask |= SV_BROADCAST_CHRDETAILS;
@@ -231,32 +189,16 @@ void Server::broadcastCharacterDetails(const Zone* zone) {
 	if (id == AI_NOTHING_SELECTED) {
 		return;
 	}
-	static const auto func = [&] (const AIPtr& ai) {
+	auto func = [this] (const AIPtr& ai) {
 		if (!ai) {
 			return false;
 		}
-		const TreeNodePtr& node = ai->getBehaviour();
-		const int32_t nodeId = node->getId();
-		const ConditionPtr& condition = node->getCondition();
-		const core::String conditionStr = condition ? condition->getNameWithConditions(ai) : "";
-		const bool conditionState = condition ? condition->result() : false;
-		ai::TreeNodeStatus status = node->getLastStatus(ai);
-		const int64_t lastRun = node->getLastExecMillis(ai);
-		flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<ai::StateNode>>> children = addChildren(node, ai);
-		flatbuffers::Offset<ai::StateNode> rootnode = ai::CreateStateNode(_characterDetailsFBB, nodeId,
-			_characterDetailsFBB.CreateString(conditionStr.c_str(), conditionStr.size()), conditionState, children, lastRun, status);
-
-		flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<ai::StateAggroEntry>>> aggro;
-		const AggroMgr::Entries& entries = ai->getAggroMgr().getEntries();
-		core::DynamicArray<flatbuffers::Offset<ai::StateAggroEntry>> offsets;
-		offsets.reserve(entries.size());
-		for (const Entry& e : entries) {
-			offsets.push_back(ai::CreateStateAggroEntry(_characterDetailsFBB, e.getCharacterId(), e.getAggro()));
+		const flatbuffers::Offset<ai::CharacterDetails> details = _stateEncoder.encodeCharacterDetails(_characterDetailsFBB, ai);
+		if (details.IsNull()) {
+			_characterDetailsFBB.Clear();
+			return true;
 		}
-
-		_messageSender->broadcastServerMessage(_characterDetailsFBB, ai::MsgType::CharacterDetails,
-			ai::CreateCharacterDetails(_characterDetailsFBB, ai->getId(),
-				_characterDetailsFBB.CreateVector(offsets.data(), offsets.size()), rootnode).Union());
+		_messageSender->broadcastServerMessage(_characterDetailsFBB, ai::MsgType::CharacterDetails, details.Union());
 		return true;
 	};
 	if (!zone->execute(id, func)) {
@@ -279,6 +221,7 @@ void Server::handleEvents(Zone* zone, bool pauseState) {
 				resetSelection();
 			} else {
 				_selectedCharacterId = event.data.characterId;
+				_stateEncoder.resetCharacterDetails();
 				broadcastStaticCharacterDetails(zone);
 				if (pauseState) {
 					broadcastState(zone);
@@ -330,6 +273,7 @@ void Server::handleEvents(Zone* zone, bool pauseState) {
 			break;
 		}
 		case EV_UPDATESTATICCHRDETAILS: {
+			_stateEncoder.resetCharacterDetails();
 			broadcastStaticCharacterDetails(event.data.zone);
 			break;
 		}
@@ -337,6 +281,9 @@ void Server::handleEvents(Zone* zone, bool pauseState) {
 			_messageSender->broadcastServerMessage(_pauseFBB, ai::MsgType::Pause,
 				ai::CreatePause(_pauseFBB, pauseState).Union());
 
+			_stateEncoder.reset();
+			_stateEncoder.clearArea();
+			_sampleRateMillis = 0u;
 			sendNames = true;
 			Log::info("new remote debugger connection");
 			break;
@@ -372,6 +319,7 @@ void Server::handleEvents(Zone* zone, bool pauseState) {
 			Zone* nullzone = nullptr;
 			_zone = nullzone;
 			resetSelection();
+			_stateEncoder.reset();
 
 			for (const auto& iter : _zones) {
 				Zone* z = iter->first;
@@ -386,6 +334,21 @@ void Server::handleEvents(Zone* zone, bool pauseState) {
 
 			break;
 		}
+		case EV_SUBSCRIBE: {
+			_sampleRateMillis = event.data.subscribe.sampleRateMillis;
+			if (event.data.subscribe.area) {
+				const float* mins = event.data.subscribe.mins;
+				const float* maxs = event.data.subscribe.maxs;
+				_stateEncoder.setArea(math::AABB<float>(mins[0], mins[1], mins[2], maxs[0], maxs[1], maxs[2]));
+			} else {
+				_stateEncoder.clearArea();
+			}
+			break;
+		}
+		case EV_ACK: {
+			_stateEncoder.ack(event.data.ack.stateWorld, event.data.ack.characterDetails);
+			break;
+		}
 		case EV_MAX:
 			break;
 		}
@@ -566,6 +529,30 @@ void Server::step(int64_t stepMillis) {
 	enqueueEvent(event);
 }
 
+void Server::subscribe(uint32_t sampleRateMillis, const math::AABB<float>* area) {
+	Event event;
+	event.type = EV_SUBSCRIBE;
+	event.data.subscribe.sampleRateMillis = sampleRateMillis;
+	event.data.subscribe.area = area != nullptr;
+	if (area != nullptr) {
+		const glm::vec3& mins = area->getLowerCorner();
+		const glm::vec3& maxs = area->getUpperCorner();
+		for (int i = 0; i < 3; ++i) {
+			event.data.subscribe.mins[i] = mins[i];
+			event.data.subscribe.maxs[i] = maxs[i];
+		}
+	}
+	enqueueEvent(event);
+}
+
+void Server::ack(uint32_t stateWorld, uint32_t characterDetails) {
+	Event event;
+	event.type = EV_ACK;
+	event.data.ack.stateWorld = stateWorld;
+	event.data.ack.characterDetails = characterDetails;
+	enqueueEvent(event);
+}
+
 void Server::update(int64_t deltaTime) {
 	_eventBus->update();
 	core_trace_scoped(AIServerUpdate);
@@ -577,7 +564,8 @@ void Server::update(int64_t deltaTime) {
 	handleEvents(zone, pauseState);
 
 	if (zone != nullptr) {
-		if (!pauseState) {
+		if (!pauseState && _time - _lastSampleMillis >= (int64_t)_sampleRateMillis) {
+			_lastSampleMillis = _time;
 			if ((_broadcastMask & SV_BROADCAST_STATE) == 0) {
 				broadcastState(zone);
 			}
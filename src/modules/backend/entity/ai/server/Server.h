@@ -8,6 +8,7 @@
 #include "backend/entity/ai/AIRegistry.h"
 #include "backend/entity/ai/tree/TreeNode.h"
 #include "backend/entity/ai/server/AIMessageSender.h"
+#include "backend/entity/ai/server/AIStateEncoder.h"
 #include "core/EventBus.h"
 #include "core/Trace.h"
 #include "core/collection/DynamicArray.h"
@@ -15,6 +16,7 @@
 #include "core/concurrent/Concurrency.h"
 #include "core/concurrent/Lock.h"
 #include "core/concurrent/Atomic.h"
+#include "math/AABB.h"
 #include "AIServerNetwork.h"
 #include "network/NetworkEvents.h"
 #include "AIMessages_generated.h"
@@ -34,6 +36,10 @@ class Zone;
  * clients. If someone selected a particular @ai{AI} instance by sending @ai{AISelectMessage} to the server, it
  * will also broadcast an @ai{AICharacterDetailsMessage} to all connected clients.
  *
+ * Both messages only contain the entities and tree nodes that changed after the state that was acknowledged
+ * by the debugger (@c ai::Ack). The debugger can restrict the world state to an area and lower the sample rate
+ * with an @c ai::Subscribe message.
+ *
  * You can only debug one @ai{Zone} at the same time. The debugging session is shared between all connected clients.
  */
 class Server : public core::IEventBusHandler<network::NewConnectionEvent>,
@@ -58,6 +64,10 @@ protected:
 	core::AtomicBool _pause;
 	// the current active debugging zone
 	core::AtomicPtr<Zone> _zone;
+	AIStateEncoder _stateEncoder;
+	// 0 means that the state is sent with every update
+	uint32_t _sampleRateMillis = 0u;
+	int64_t _lastSampleMillis = 0;
 	core::DynamicArray<core::String> _names;
 	uint32_t _broadcastMask = 0u;
 	short _port;
@@ -73,6 +83,8 @@ protected:
 		EV_PAUSE,
 		EV_RESET,
 		EV_SETDEBUG,
+		EV_SUBSCRIBE,
+		EV_ACK,
 
 		EV_MAX
 	};
@@ -84,6 +96,16 @@ protected:
 			Zone* zone;
 			ENetPeer* peer;
 			bool pauseState;
+			struct {
+				float mins[3];
+				float maxs[3];
+				uint32_t sampleRateMillis;
+				bool area;
+			} subscribe;
+			struct {
+				uint32_t stateWorld;
+				uint32_t characterDetails;
+			} ack;
 		} data;
 		core::String strData = "";
 		EventType type;
@@ -94,7 +116,6 @@ protected:
 	void resetSelection();
 
 	void addChildren(const TreeNodePtr& node, core::DynamicArray<flatbuffers::Offset<ai::StateNodeStatic>>& offsets) const;
-	flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<ai::StateNode>>> addChildren(const TreeNodePtr& node, const AIPtr& ai) const;
 
 	// only call these from the Server::update method
 	void broadcastState(const Zone* zone);
@@ -200,6 +221,19 @@ public:
 	 */
 	void step(int64_t stepMillis = 1L);
 
+	/**
+	 * @brief Restrict the world state to the given area and send it only every @c sampleRateMillis
+	 *
+	 * @param[in] sampleRateMillis @c 0 sends the state with every update
+	 * @param[in] area The area to send the entities for - @c nullptr for the whole zone
+	 */
+	void subscribe(uint32_t sampleRateMillis, const math::AABB<float>* area = nullptr);
+
+	/**
+	 * @brief The debugger applied the given sequences - the following states are sent as delta to them
+	 */
+	void ack(uint32_t stateWorld, uint32_t characterDetails);
+
 	/**
 	 * @brief call this to update the server - should get called somewhere from your game tick
 	 */
@@ -0,0 +1,24 @@
+/**
+ * @file
+ */
+
+#include "SubscribeHandler.h"
+#include "Server.h"
+
+namespace backend {
+
+SubscribeHandler::SubscribeHandler(Server& server) : _server(server) {
+}
+
+void SubscribeHandler::executeWithRaw(void* attachment, const ai::Subscribe* message, const uint8_t* rawData, size_t rawDataSize) {
+	const ai::Vec3* mins = message->mins();
+	const ai::Vec3* maxs = message->maxs();
+	if (mins == nullptr || maxs == nullptr) {
+		_server.subscribe(message->sample_rate_millis());
+		return;
+	}
+	const math::AABB<float> area(mins->x(), mins->y(), mins->z(), maxs->x(), maxs->y(), maxs->z());
+	_server.subscribe(message->sample_rate_millis(), &area);
+}
+
+}
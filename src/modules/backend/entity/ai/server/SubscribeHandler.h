@@ -0,0 +1,22 @@
+/**
+ * @file
+ */
+#pragma once
+
+#include "network/IMsgProtocolHandler.h"
+#include "AIMessages_generated.h"
+
+namespace backend {
+
+class Server;
+
+class SubscribeHandler: public network::IMsgProtocolHandler<ai::Subscribe, void> {
+private:
+	Server& _server;
+public:
+	explicit SubscribeHandler(Server& server);
+
+	void executeWithRaw(void* attachment, const ai::Subscribe* message, const uint8_t* rawData, size_t rawDataSize) override;
+};
+
+}
@@ -71,38 +71,38 @@ void TreeNode::setLastExecMillis(const AIPtr& entity) {
 	if (!entity->_debuggingActive) {
 		return;
 	}
-	entity->_lastExecMillis.put(getId(), entity->_time);
+	entity->nodeState(getId()).lastExecMillis = entity->_time;
 }
 
 int TreeNode::getSelectorState(const AIPtr& entity) const {
-	auto i = entity->_selectorStates.find(getId());
-	if (i == entity->_selectorStates.end()) {
+	const AI::NodeState* nodeState = entity->findNodeState(getId());
+	if (nodeState == nullptr) {
 		return AI_NOTHING_SELECTED;
 	}
-	return i->second;
+	return nodeState->selector;
 }
 
 void TreeNode::setSelectorState(const AIPtr& entity, int selected) {
-	entity->_selectorStates.put(getId(), selected);
+	entity->nodeState(getId()).selector = selected;
 }
 
 int TreeNode::getLimitState(const AIPtr& entity) const {
-	auto i = entity->_limitStates.find(getId());
-	if (i == entity->_limitStates.end()) {
+	const AI::NodeState* nodeState = entity->findNodeState(getId());
+	if (nodeState == nullptr) {
 		return 0;
 	}
-	return i->second;
+	return nodeState->limit;
 }
 
 void TreeNode::setLimitState(const AIPtr& entity, int amount) {
-	entity->_limitStates.put(getId(), amount);
+	entity->nodeState(getId()).limit = amount;
 }
 
 ai::TreeNodeStatus TreeNode::state(const AIPtr& entity, ai::TreeNodeStatus treeNodeState) {
 	if (!entity->_debuggingActive) {
 		return treeNodeState;
 	}
-	entity->_lastStatus.put(getId(), treeNodeState);
+	entity->nodeState(getId()).lastStatus = treeNodeState;
 	return treeNodeState;
 }
 
@@ -110,22 +110,22 @@ int64_t TreeNode::getLastExecMillis(const AIPtr& entity) const {
 	if (!entity->_debuggingActive) {
 		return -1L;
 	}
-	auto i = entity->_lastExecMillis.find(getId());
-	if (i == entity->_lastExecMillis.end()) {
+	const AI::NodeState* nodeState = entity->findNodeState(getId());
+	if (nodeState == nullptr) {
 		return -1L;
 	}
-	return i->second;
+	return nodeState->lastExecMillis;
 }
 
 ai::TreeNodeStatus TreeNode::getLastStatus(const AIPtr& entity) const {
 	if (!entity->_debuggingActive) {
 		return ai::TreeNodeStatus::UNKNOWN;
 	}
-	auto i = entity->_lastStatus.find(getId());
-	if (i == entity->_lastStatus.end()) {
+	const AI::NodeState* nodeState = entity->findNodeState(getId());
+	if (nodeState == nullptr) {
 		return ai::TreeNodeStatus::UNKNOWN;
 	}
-	return i->second;
+	return nodeState->lastStatus;
 }
 
 TreeNodePtr TreeNode::getChild(int id) const {
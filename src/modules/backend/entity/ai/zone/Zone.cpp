@@ -5,6 +5,8 @@
 #include "Zone.h"
 #include "core/Trace.h"
 #include "backend/entity/ai/tree/TreeNode.h"
+#include "backend/entity/ai/AI.h"
+#include <algorithm>
 
 namespace backend {
 
@@ -22,6 +24,8 @@ Zone::~Zone() {
 		doRemoveAI(ai);
 	}
 	_ais.clear();
+	_tickAIs.clear();
+	_tickBatches.clear();
 }
 
 AIPtr Zone::getAI(ai::CharacterId id) const {
@@ -93,6 +97,53 @@ bool Zone::removeAI(const ai::CharacterId& id) {
 	return true;
 }
 
+void Zone::updateTickBatches() {
+	core_trace_scoped(ZoneUpdateTickBatches);
+	std::vector<std::pair<TreeNodePtr, AIPtr>> sorted;
+	sorted.reserve(_ais.size());
+	for (const auto& e : _ais) {
+		sorted.emplace_back(e.second->getBehaviour(), e.second);
+	}
+	std::sort(sorted.begin(), sorted.end(), [] (const std::pair<TreeNodePtr, AIPtr>& lhs, const std::pair<TreeNodePtr, AIPtr>& rhs) {
+		return lhs.first.get() < rhs.first.get();
+	});
+	_tickAIs.clear();
+	_tickBatches.clear();
+	_tickAIs.reserve(sorted.size());
+	for (const auto& e : sorted) {
+		const int index = (int)_tickAIs.size();
+		_tickAIs.push_back(e.second);
+		if (_tickBatches.empty() || _tickBatches.back().behaviour != e.first
+				|| _tickBatches.back().end - _tickBatches.back().begin >= TickBatchSize) {
+			_tickBatches.push_back(TickBatch{e.first, index, index + 1});
+		} else {
+			_tickBatches.back().end = index + 1;
+		}
+	}
+}
+
+void Zone::tickBatched(int64_t dt) {
+	core_trace_scoped(ZoneTickBatched);
+	const bool debug = _debug;
+	_threadPool.parallelFor(0, (int)_tickBatches.size(), [this, dt, debug] (int i) {
+		const TickBatch& batch = _tickBatches[i];
+		for (int j = batch.begin; j < batch.end; ++j) {
+			const AIPtr& ai = _tickAIs[j];
+			if (ai->isPause()) {
+				continue;
+			}
+			ai->update(dt, debug);
+			if (ai->isBehaviour(batch.behaviour)) {
+				batch.behaviour->execute(ai, dt);
+				continue;
+			}
+			// the behaviour was changed - regroup with the next tick
+			_tickBatchesDirty = true;
+			ai->getBehaviour()->execute(ai, dt);
+		}
+	});
+}
+
 void Zone::update(int64_t dt) {
 	core_trace_scoped(ZoneUpdate);
 	{
@@ -106,6 +157,9 @@ void Zone::update(int64_t dt) {
 			scheduledDestroy.swap(_scheduledDestroy);
 		}
 		core::ScopedLock scopedLock(_lock);
+		if (!scheduledAdd.empty() || !scheduledRemove.empty() || !scheduledDestroy.empty()) {
+			_tickBatchesDirty = true;
+		}
 		for (const AIPtr& ai : scheduledAdd) {
 			doAddAI(ai);
 		}
@@ -118,6 +172,15 @@ void Zone::update(int64_t dt) {
 			doDestroyAI(id);
 		}
 		scheduledDestroy.clear();
+		if (_batchedTick && _tickBatchesDirty.exchange(false)) {
+			updateTickBatches();
+		}
+	}
+
+	if (_batchedTick) {
+		tickBatched(dt);
+		_groupManager.update(dt);
+		return;
 	}
 
 	auto func = [&] (const AIPtr& ai) {
@@ -17,6 +17,7 @@
 #include "backend/entity/ai/group/GroupMgr.h"
 #include "core/concurrent/ThreadPool.h"
 #include "core/concurrent/Lock.h"
+#include "core/concurrent/Atomic.h"
 #include "core/Trace.h"
 #include "ai-shared/common/CharacterId.h"
 
@@ -28,6 +29,8 @@ namespace backend {
 
 class AI;
 typedef std::shared_ptr<AI> AIPtr;
+class TreeNode;
+typedef std::shared_ptr<TreeNode> TreeNodePtr;
 
 /**
  * @brief A zone represents one logical zone that groups AI instances.
@@ -58,6 +61,28 @@ protected:
 	GroupMgr _groupManager;
 	mutable core::ThreadPool _threadPool;
 
+	/**
+	 * @brief A chunk of @c AI instances that share the same behaviour tree
+	 */
+	struct TickBatch {
+		TreeNodePtr behaviour;
+		int begin;
+		int end;
+	};
+	bool _batchedTick = false;
+	/**
+	 * The @c AI instances of the batched tick - ordered by their behaviour tree
+	 */
+	std::vector<AIPtr> _tickAIs;
+	std::vector<TickBatch> _tickBatches;
+	core::AtomicBool _tickBatchesDirty { true };
+
+	/**
+	 * @note This doesn't lock the zone - because @c Zone::update already does it
+	 */
+	void updateTickBatches();
+	void tickBatched(int64_t dt);
+
 	/**
 	 * @brief called in the zone update to add new @c AI instances.
 	 *
@@ -79,6 +104,11 @@ protected:
 	bool doDestroyAI(const ai::CharacterId& id);
 
 public:
+	/**
+	 * The max amount of @c AI instances that are updated in one task of the batched tick
+	 */
+	static constexpr int TickBatchSize = 64;
+
 	Zone(const core::String& name, int threadCount = 1) :
 			_name(name), _debug(false), _threadPool(threadCount) {
 		_threadPool.init();
@@ -159,6 +189,13 @@ public:
 	void setDebug(bool debug);
 	bool isDebug () const;
 
+	/**
+	 * @brief The batched tick groups the @c AI instances by their behaviour tree and updates them in chunks of
+	 * @c TickBatchSize instances on the zone workers - instead of scheduling every single instance on its own.
+	 */
+	void setBatchedTick(bool batchedTick);
+	bool isBatchedTick() const;
+
 	GroupMgr& getGroupMgr();
 
 	const GroupMgr& getGroupMgr() const;
@@ -251,17 +288,16 @@ public:
 	template<typename Func>
 	void executeParallel(Func& func) {
 		core_trace_scoped(ZoneExecuteParallel);
-		std::vector<std::future<void> > results;
+		std::vector<AIPtr> ais;
 		_lock.lock();
-		AIMap copy(_ais);
-		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
-			results.emplace_back(executeAsync(ai, func));
-		}
-		for (auto & result: results) {
-			result.wait();
+		ais.reserve(_ais.size());
+		for (auto i = _ais.begin(); i != _ais.end(); ++i) {
+			ais.push_back(i->second);
 		}
+		_lock.unlock();
+		_threadPool.parallelFor(0, (int)ais.size(), [&ais, &func] (int i) {
+			func(ais[i]);
+		});
 	}
 
 	/**
@@ -274,17 +310,16 @@ public:
 	template<typename Func>
 	void executeParallel(const Func& func) const {
 		core_trace_scoped(ZoneExecuteParallel);
-		std::vector<std::future<void> > results;
+		std::vector<AIPtr> ais;
 		_lock.lock();
-		AIMap copy(_ais);
-		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
-			results.emplace_back(executeAsync(ai, func));
-		}
-		for (auto & result: results) {
-			result.wait();
+		ais.reserve(_ais.size());
+		for (auto i = _ais.begin(); i != _ais.end(); ++i) {
+			ais.push_back(i->second);
 		}
+		_lock.unlock();
+		_threadPool.parallelFor(0, (int)ais.size(), [&ais, &func] (int i) {
+			func(ais[i]);
+		});
 	}
 
 	/**
@@ -334,6 +369,14 @@ inline bool Zone::isDebug () const {
 	return _debug;
 }
 
+inline void Zone::setBatchedTick(bool batchedTick) {
+	_batchedTick = batchedTick;
+}
+
+inline bool Zone::isBatchedTick() const {
+	return _batchedTick;
+}
+
 inline const core::String& Zone::getName() const {
 	return _name;
 }
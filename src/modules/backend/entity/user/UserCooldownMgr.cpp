@@ -53,12 +53,16 @@ void UserCooldownMgr::shutdown() {
 }
 
 cooldown::CooldownTriggerState UserCooldownMgr::triggerCooldown(cooldown::Type type, const cooldown::CooldownCallback& callback) {
-	return Super::triggerCooldown(type, [this, type, callback] (cooldown::CallbackType callbackType) {
+	const cooldown::CooldownTriggerState state = Super::triggerCooldown(type, [this, type, callback] (cooldown::CallbackType callbackType) {
 		if (callback) {
 			callback(callbackType);
 		}
 		sendCooldown(type, callbackType == cooldown::CallbackType::Started);
 	});
+	if (state == cooldown::CooldownTriggerState::SUCCESS) {
+		_dirtyCooldowns.insert(type);
+	}
+	return state;
 }
 
 void UserCooldownMgr::sendCooldown(cooldown::Type type, bool started) const {
@@ -78,10 +82,19 @@ void UserCooldownMgr::sendCooldown(cooldown::Type type, bool started) const {
 
 bool UserCooldownMgr::getDirtyModels(Models& models) {
 	// TODO: what about deleting...
+	DirtyCooldowns::underlying_type dirty;
+	_dirtyCooldowns.swap(dirty);
+	if (dirty.empty()) {
+		return false;
+	}
 	core::ScopedReadLock lock(_lock);
-	models.reserve(models.size() + _cooldowns.size());
-	for (const auto& e : _cooldowns) {
-		const cooldown::CooldownPtr& c = e->value;
+	models.reserve(models.size() + dirty.size());
+	for (cooldown::Type type : dirty) {
+		auto i = _cooldowns.find(type);
+		if (i == _cooldowns.end()) {
+			continue;
+		}
+		const cooldown::CooldownPtr& c = i->value;
 		const int index = (int)c->type();
 		core_assert_msg(index >= core::enumVal(cooldown::Type::MIN),
 				"invalid index given: %i", index);
@@ -8,6 +8,7 @@
 #include "persistence/ForwardDecl.h"
 #include "persistence/ISavable.h"
 #include "core/FourCC.h"
+#include "core/collection/ConcurrentSet.h"
 #include "backend/entity/EntityId.h"
 #include "CooldownModel.h"
 #include <vector>
@@ -29,6 +30,9 @@ private:
 	User* _user;
 	mutable flatbuffers::FlatBufferBuilder _cooldownFBB;
 	std::vector<db::CooldownModel> _dirtyModels;
+	using DirtyCooldowns = collection::ConcurrentSet<cooldown::Type>;
+	// the cooldowns that were triggered since the last call of getDirtyModels()
+	DirtyCooldowns _dirtyCooldowns;
 public:
 	UserCooldownMgr(User* user,
 			const core::TimeProviderPtr& timeProvider,
@@ -0,0 +1,71 @@
+/**
+ * @file
+ */
+
+#include "UserSnapshotMgr.h"
+#include "backend/entity/User.h"
+#include "backend/network/ServerMessageSender.h"
+#include "core/Algorithm.h"
+#include "core/Trace.h"
+
+namespace backend {
+
+const shared::EntityStates UserSnapshotMgr::Empty;
+
+UserSnapshotMgr::UserSnapshotMgr(User* user, const network::ServerMessageSenderPtr& messageSender) :
+		_user(user), _messageSender(messageSender) {
+}
+
+void UserSnapshotMgr::ack(uint32_t sequence) {
+	if (sequence > _acked && sequence <= _sequence) {
+		_acked = sequence;
+	}
+}
+
+void UserSnapshotMgr::sendSnapshot() {
+	core_trace_scoped(UserSnapshotMgrSendSnapshot);
+	ENetPeer* peer = _user->peer();
+	if (peer == nullptr) {
+		return;
+	}
+	_current.clear();
+	_current.push_back(shared::EntityState::quantize(_user->id(), _user->pos(), _user->orientation(), (uint8_t)_user->animation()));
+	_user->visitVisible([this] (const EntityPtr& e) {
+		_current.push_back(shared::EntityState::quantize(e->id(), e->pos(), e->orientation(), (uint8_t)e->animation()));
+	});
+	core::sort(_current.begin(), _current.end(), [] (const shared::EntityState& a, const shared::EntityState& b) {
+		return a.id < b.id;
+	});
+
+	const shared::EntityStates* base = _history.get(_acked);
+	_buffer.clear();
+	const int changes = shared::encodeSnapshot(base != nullptr ? *base : Empty, _current, _buffer);
+	if (changes == 0 && base != nullptr && _acked == _sequence) {
+		// the client already has this state
+		return;
+	}
+	++_sequence;
+	_history.put(_sequence, _current);
+
+	_fbb.Clear();
+	auto data = _fbb.CreateVector(_buffer.data(), _buffer.size());
+	const uint32_t baseSequence = base != nullptr ? _acked : 0u;
+	_messageSender->sendServerMessage(peer, _fbb, network::ServerMsgType::EntitySnapshot,
+			network::CreateEntitySnapshot(_fbb, _sequence, baseSequence, data).Union(), 0u, shared::SnapshotChannel);
+}
+
+void UserSnapshotMgr::reset() {
+	_history.clear();
+	_acked = 0u;
+}
+
+bool UserSnapshotMgr::init() {
+	reset();
+	return true;
+}
+
+void UserSnapshotMgr::shutdown() {
+	reset();
+}
+
+}
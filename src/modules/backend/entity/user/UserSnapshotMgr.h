@@ -0,0 +1,63 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/IComponent.h"
+#include "backend/ForwardDecl.h"
+#include "shared/EntitySnapshot.h"
+#include "ServerMessages_generated.h"
+
+namespace backend {
+
+class User;
+
+/**
+ * @brief Collects the state of the user and all visible entities once per tick and sends it as one unreliable
+ * @c network::EntitySnapshot message.
+ *
+ * The snapshot is delta encoded against the last snapshot the client acknowledged with a @c network::SnapshotAck.
+ * If there is no such snapshot anymore, a full snapshot is sent.
+ */
+class UserSnapshotMgr : public core::IComponent {
+private:
+	User* _user;
+	network::ServerMessageSenderPtr _messageSender;
+	shared::SnapshotHistory _history;
+	uint32_t _sequence = 0u;
+	uint32_t _acked = 0u;
+	shared::EntityStates _current;
+	core::DynamicArray<uint8_t> _buffer;
+	flatbuffers::FlatBufferBuilder _fbb;
+
+	static const shared::EntityStates Empty;
+
+public:
+	UserSnapshotMgr(User* user, const network::ServerMessageSenderPtr& messageSender);
+
+	/**
+	 * @brief The client received the snapshot with the given sequence
+	 */
+	void ack(uint32_t sequence);
+	/**
+	 * @brief Sends the snapshot of this tick if the client doesn't already know the state
+	 * @note Must be called after all entities were updated
+	 */
+	void sendSnapshot();
+	/**
+	 * @brief Forget about the snapshots the client knows - e.g. for a reconnect
+	 */
+	void reset();
+
+	uint32_t sequence() const;
+
+	bool init() override;
+	void shutdown() override;
+};
+
+inline uint32_t UserSnapshotMgr::sequence() const {
+	return _sequence;
+}
+
+}
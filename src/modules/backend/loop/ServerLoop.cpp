@@ -27,6 +27,7 @@
 #include "backend/network/MoveHandler.h"
 #include "backend/network/SignupHandler.h"
 #include "backend/network/SignupValidateHandler.h"
+#include "backend/network/SnapshotAckHandler.h"
 #include "persistence/PersistenceMgr.h"
 #include "backend/world/World.h"
 #include "command/CommandHandler.h"
@@ -234,6 +235,7 @@ bool ServerLoop::init() {
 	}
 
 	const int httpPort = core::Var::getSafe(cfg::ServerHttpPort)->intVal();
+	_httpServer->setWorkers(core_max(0, core::Var::getSafe(cfg::ServerHttpWorkers)->intVal()));
 	if (!_httpServer->init(httpPort)) {
 		Log::error("Failed to initialize the HTTP server on port %i", httpPort);
 		return false;
@@ -333,6 +335,7 @@ bool ServerLoop::init() {
 	r->registerHandler(network::ClientMsgType::TriggerAction, std::make_shared<TriggerActionHandler>());
 	r->registerHandler(network::ClientMsgType::Move, std::make_shared<MoveHandler>());
 	r->registerHandler(network::ClientMsgType::VarUpdate, std::make_shared<VarUpdateHandler>());
+	r->registerHandler(network::ClientMsgType::SnapshotAck, std::make_shared<SnapshotAckHandler>());
 
 	Log::info("Init material");
 	if (!voxel::initDefaultMaterialColors()) {
@@ -360,11 +363,15 @@ bool ServerLoop::init() {
 	addTimer(_persistenceMgrTimer, [] (uv_timer_t* handle) {
 		core_trace_scoped(PersistenceTimer);
 		const ServerLoop* loop = (const ServerLoop*)handle->data;
-		const long dt = handle->repeat;
 		const persistence::PersistenceMgrPtr& persistenceMgr = loop->_persistenceMgr;
-		app::App::getInstance()->threadPool().enqueue([=] () {
-			persistenceMgr->update(dt);
-		});
+		// only copies the dirty models - the database is written by the writer thread of the persistence manager
+		persistenceMgr->update(handle->repeat);
+		const persistence::PersistenceStats& stats = persistenceMgr->stats();
+		const metric::MetricPtr& metric = loop->_metricMgr->metric();
+		metric->gauge("persistence.dirty", stats.dirtyModels);
+		metric->gauge("persistence.queue", stats.queueDepth);
+		metric->gauge("persistence.skipped", stats.skippedUpdates);
+		metric->timing("persistence.flush", stats.flushMillis);
 	}, 10000);
 
 	_idleTimer = new uv_idle_t;
@@ -391,7 +398,7 @@ bool ServerLoop::init() {
 	const core::VarPtr& port = core::Var::getSafe(cfg::ServerPort);
 	const core::VarPtr& host = core::Var::getSafe(cfg::ServerHost);
 	const core::VarPtr& maxclients = core::Var::getSafe(cfg::ServerMaxClients);
-	if (!_network->bind(port->intVal(), host->strVal(), maxclients->intVal(), 2)) {
+	if (!_network->bind(port->intVal(), host->strVal(), maxclients->intVal(), shared::Channels)) {
 		Log::error("Failed to bind the server socket on %s:%i", host->strVal().c_str(), port->intVal());
 		return false;
 	}
@@ -30,12 +30,12 @@ ServerMessageSender::ServerMessageSender(const ServerNetworkPtr& network, const
 		_network(network), _metric(metric) {
 }
 
-bool ServerMessageSender::sendServerMessage(ENetPeer* peer, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags) {
+bool ServerMessageSender::sendServerMessage(ENetPeer* peer, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags, int channel) {
 	core_assert(peer != nullptr);
-	return sendServerMessage(&peer, 1, fbb, type, data, flags);
+	return sendServerMessage(&peer, 1, fbb, type, data, flags, channel);
 }
 
-bool ServerMessageSender::sendServerMessage(ENetPeer** peers, int numPeers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags) {
+bool ServerMessageSender::sendServerMessage(ENetPeer** peers, int numPeers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags, int channel) {
 	const char *msgType = network::EnumNameServerMsgType(type);
 	Log::debug(logid, "Send %s to %i peers", msgType, numPeers);
 	core_assert(numPeers > 0);
@@ -46,7 +46,7 @@ bool ServerMessageSender::sendServerMessage(ENetPeer** peers, int numPeers, Flat
 	{
 		// TODO: lock
 		for (int i = 0; i < numPeers; ++i) {
-			if (!_network->sendMessage(peers[i], packet)) {
+			if (!_network->sendMessage(peers[i], packet, channel)) {
 				++notsent;
 				Log::trace(logid, "Could not send message of type %s to peer %i", msgType, i);
 			} else {
@@ -0,0 +1,19 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "network/Network.h"
+#include "IUserProtocolHandler.h"
+
+namespace backend {
+
+/**
+ * The client received the entity snapshot - the following snapshots are encoded against it.
+ */
+USERPROTOHANDLERIMPL(SnapshotAck) {
+	user->snapshotMgr().ack(message->sequence());
+}
+
+}
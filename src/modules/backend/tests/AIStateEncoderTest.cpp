@@ -0,0 +1,142 @@
+/**
+ * @file
+ */
+
+#include <gtest/gtest.h>
+#include "backend/entity/ai/server/AIStateEncoder.h"
+
+namespace backend {
+
+class AIStateEncoderTest: public testing::Test {
+protected:
+	core::DynamicArray<int32_t> _removed;
+
+	void end(DeltaTracker& tracker) {
+		_removed.clear();
+		tracker.end([this] (int32_t id) {
+			_removed.push_back(id);
+		});
+	}
+};
+
+TEST_F(AIStateEncoderTest, testUnchangedAfterAck) {
+	DeltaTracker tracker;
+	const uint32_t sequence = tracker.begin();
+	EXPECT_TRUE(tracker.track(1, 42u));
+	EXPECT_TRUE(tracker.track(2, 43u));
+	end(tracker);
+	EXPECT_EQ(0u, tracker.base());
+
+	// not yet acknowledged - still sent
+	tracker.begin();
+	EXPECT_TRUE(tracker.track(1, 42u));
+	EXPECT_TRUE(tracker.track(2, 43u));
+	end(tracker);
+
+	tracker.ack(sequence);
+	tracker.begin();
+	EXPECT_EQ(sequence, tracker.base());
+	EXPECT_FALSE(tracker.track(1, 42u));
+	EXPECT_TRUE(tracker.track(2, 44u)) << "Changed object must be sent";
+	end(tracker);
+	EXPECT_TRUE(_removed.empty());
+}
+
+TEST_F(AIStateEncoderTest, testChangedUntilAcked) {
+	DeltaTracker tracker;
+	tracker.begin();
+	tracker.track(1, 1u);
+	end(tracker);
+	tracker.ack(tracker.sequence());
+
+	const uint32_t changed = tracker.begin();
+	EXPECT_TRUE(tracker.track(1, 2u));
+	end(tracker);
+	// the change is not acknowledged yet - even if the state doesn't change anymore it must be sent
+	tracker.begin();
+	EXPECT_TRUE(tracker.track(1, 2u));
+	end(tracker);
+	tracker.ack(changed);
+	tracker.begin();
+	EXPECT_FALSE(tracker.track(1, 2u));
+	end(tracker);
+}
+
+TEST_F(AIStateEncoderTest, testRemoved) {
+	DeltaTracker tracker;
+	tracker.begin();
+	tracker.track(1, 1u);
+	tracker.track(2, 2u);
+	end(tracker);
+	tracker.ack(tracker.sequence());
+
+	const uint32_t removed = tracker.begin();
+	tracker.track(1, 1u);
+	end(tracker);
+	ASSERT_EQ(1u, _removed.size());
+	EXPECT_EQ(2, _removed[0]);
+
+	tracker.begin();
+	tracker.track(1, 1u);
+	end(tracker);
+	ASSERT_EQ(1u, _removed.size()) << "Removal must be sent until it is acknowledged";
+
+	tracker.ack(removed);
+	tracker.begin();
+	tracker.track(1, 1u);
+	end(tracker);
+	EXPECT_TRUE(_removed.empty());
+	EXPECT_EQ(1u, tracker.size());
+}
+
+TEST_F(AIStateEncoderTest, testReset) {
+	DeltaTracker tracker;
+	const uint32_t sequence = tracker.begin();
+	tracker.track(1, 1u);
+	end(tracker);
+	tracker.reset();
+	// an ack for a message before the reset
+	tracker.ack(sequence);
+	EXPECT_EQ(0u, tracker.base());
+	tracker.begin();
+	EXPECT_TRUE(tracker.track(1, 1u));
+	end(tracker);
+	tracker.ack(tracker.sequence());
+	EXPECT_EQ(tracker.sequence(), tracker.base());
+}
+
+TEST_F(AIStateEncoderTest, testTrackValue) {
+	DeltaTracker tracker;
+	const char state1[] = "state 1";
+	const char state2[] = "state 2";
+	tracker.begin();
+	EXPECT_TRUE(tracker.track(1, state1, sizeof(state1)));
+	end(tracker);
+	tracker.ack(tracker.sequence());
+	tracker.begin();
+	EXPECT_FALSE(tracker.track(1, state1, sizeof(state1)));
+	end(tracker);
+	tracker.begin();
+	EXPECT_TRUE(tracker.track(1, state2, sizeof(state2))) << "Changed value must be sent";
+	end(tracker);
+	tracker.begin();
+	EXPECT_TRUE(tracker.track(1, state2, sizeof(state2) - 1)) << "Changed size must be sent";
+	end(tracker);
+}
+
+TEST_F(AIStateEncoderTest, testResyncInterval) {
+	DeltaTracker tracker(3u);
+	for (int i = 0; i < 3; ++i) {
+		tracker.begin();
+		tracker.track(1, 1u);
+		end(tracker);
+		tracker.ack(tracker.sequence());
+	}
+	EXPECT_NE(0u, tracker.base());
+	tracker.begin();
+	EXPECT_EQ(0u, tracker.base()) << "The whole state must be sent after the resync interval";
+	EXPECT_TRUE(tracker.track(1, 1u)) << "An unchanged object must be sent with the resync";
+	end(tracker);
+}
+
+}
@@ -137,6 +137,20 @@ TEST_F(AITest, testActionSpawn) {
 	EXPECT_EQ(before + 1, after) << "NPC wasn't spawned as expected";
 }
 
+TEST_F(AITest, testBatchedTick) {
+	map->zone()->setBatchedTick(true);
+	const NpcPtr& rabbit = create();
+	const NpcPtr& wolf = create(network::EntityType::ANIMAL_WOLF);
+	const int64_t rabbitTime = rabbit->ai()->getTime();
+	const int64_t wolfTime = wolf->ai()->getTime();
+	map->zone()->update(10L);
+	EXPECT_EQ(rabbitTime + 10, rabbit->ai()->getTime()) << "The rabbit wasn't ticked";
+	EXPECT_EQ(wolfTime + 10, wolf->ai()->getTime()) << "The wolf wasn't ticked";
+	ASSERT_TRUE(map->removeNpc(rabbit->id()));
+	map->zone()->update(10L);
+	EXPECT_EQ(wolfTime + 20, wolf->ai()->getTime());
+}
+
 TEST_F(AITest, testActionSetPointOfInterest) {
 	const NpcPtr& npc = create();
 	const size_t before = map->poiProvider().count();
@@ -0,0 +1,128 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "backend/world/DBChunkPersister.h"
+#include "persistence/tests/Mocks.h"
+#include "voxel/PagedVolume.h"
+#include <future>
+#include <thread>
+#include <chrono>
+
+namespace backend {
+
+class DBChunkPersisterTest: public app::AbstractTest {
+protected:
+	class Pager: public voxel::PagedVolume::Pager {
+	public:
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			ctx.chunk->setVoxel(0, 0, 0, voxel::createVoxel(voxel::VoxelType::Grass, 1));
+			return true;
+		}
+
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+	static constexpr uint16_t ChunkSideLength = 32u;
+	static constexpr unsigned int Seed = 1u;
+};
+
+TEST_F(DBChunkPersisterTest, testWriteBehind) {
+	const std::shared_ptr<persistence::DBHandlerMock>& dbHandler = persistence::createDbHandlerMock();
+	// block the write thread in the first insert
+	std::promise<void> entered;
+	std::promise<void> unblock;
+	std::shared_future<void> unblocked = unblock.get_future().share();
+	bool first = true;
+	EXPECT_CALL(*dbHandler, connection()).WillRepeatedly(testing::Invoke([&] () -> persistence::Connection* {
+		if (first) {
+			first = false;
+			entered.set_value();
+			unblocked.wait();
+		}
+		return nullptr;
+	}));
+
+	Pager pager;
+	voxel::PagedVolume volume(&pager, 16 * 1024 * 1024, ChunkSideLength);
+	const voxel::PagedVolume::ChunkPtr& writing = volume.chunk(glm::ivec3(0));
+	const voxel::PagedVolume::ChunkPtr& pending = volume.chunk(glm::ivec3(ChunkSideLength, 0, 0));
+	{
+		DBChunkPersister persister(dbHandler, 1);
+		ASSERT_TRUE(persister.save(writing, Seed));
+		ASSERT_EQ(std::future_status::ready, entered.get_future().wait_for(std::chrono::seconds(10))) << "The write thread didn't pick up the chunk";
+		ASSERT_TRUE(persister.save(pending, Seed));
+		ASSERT_TRUE(persister.save(pending, Seed));
+		DBChunkPersister::Metrics metrics = persister.metrics();
+		EXPECT_EQ(2, metrics.queued);
+		EXPECT_EQ(1, metrics.coalesced);
+
+		// queued chunks are served from the queue - no matter whether they are currently written
+		writing->setVoxel(0, 0, 0, voxel::Voxel());
+		pending->setVoxel(0, 0, 0, voxel::Voxel());
+		EXPECT_TRUE(persister.load(writing, Seed));
+		EXPECT_TRUE(persister.load(pending, Seed));
+		EXPECT_TRUE(writing->voxel(0, 0, 0).isSame(voxel::createVoxel(voxel::VoxelType::Grass, 1)));
+		EXPECT_TRUE(pending->voxel(0, 0, 0).isSame(voxel::createVoxel(voxel::VoxelType::Grass, 1)));
+
+		unblock.set_value();
+		persister.flush();
+		metrics = persister.metrics();
+		EXPECT_EQ(0, metrics.queued);
+		EXPECT_EQ(2, metrics.flushes);
+		// the mock doesn't provide a connection
+		EXPECT_EQ(2, metrics.failed);
+	}
+}
+
+TEST_F(DBChunkPersisterTest, testEraseQueued) {
+	const std::shared_ptr<persistence::DBHandlerMock>& dbHandler = persistence::createDbHandlerMock();
+	// block the write thread in the first insert
+	std::promise<void> entered;
+	std::promise<void> unblock;
+	std::shared_future<void> unblocked = unblock.get_future().share();
+	bool first = true;
+	EXPECT_CALL(*dbHandler, connection()).WillRepeatedly(testing::Invoke([&] () -> persistence::Connection* {
+		if (first) {
+			first = false;
+			entered.set_value();
+			unblocked.wait();
+		}
+		return nullptr;
+	}));
+
+	Pager pager;
+	voxel::PagedVolume volume(&pager, 16 * 1024 * 1024, ChunkSideLength);
+	const voxel::PagedVolume::ChunkPtr& writing = volume.chunk(glm::ivec3(0));
+	const voxel::PagedVolume::ChunkPtr& erased = volume.chunk(glm::ivec3(ChunkSideLength, 0, 0));
+	{
+		DBChunkPersister persister(dbHandler, 1);
+		ASSERT_TRUE(persister.save(writing, Seed));
+		ASSERT_EQ(std::future_status::ready, entered.get_future().wait_for(std::chrono::seconds(10))) << "The write thread didn't pick up the chunk";
+		ASSERT_TRUE(persister.save(erased, Seed));
+		EXPECT_EQ(2, persister.metrics().queued);
+
+		// the erase waits for the batch that is currently written
+		const voxel::Region region(glm::ivec3(ChunkSideLength, 0, 0), glm::ivec3(ChunkSideLength * 2 - 1, ChunkSideLength - 1, ChunkSideLength - 1));
+		std::future<void> erase = std::async(std::launch::async, [&] () {
+			persister.erase(region, Seed);
+		});
+		for (int i = 0; i < 1000 && persister.metrics().queued != 1; ++i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		EXPECT_EQ(1, persister.metrics().queued) << "The erased chunk is still queued";
+		unblock.set_value();
+		erase.wait();
+		persister.flush();
+
+		erased->setVoxel(0, 0, 0, voxel::Voxel());
+		EXPECT_FALSE(persister.load(erased, Seed));
+		EXPECT_TRUE(erased->voxel(0, 0, 0).isSame(voxel::Voxel()));
+		const DBChunkPersister::Metrics& metrics = persister.metrics();
+		EXPECT_EQ(0, metrics.queued);
+		EXPECT_EQ(1, metrics.flushes) << "The erased chunk was written";
+	}
+}
+
+}
@@ -71,6 +71,7 @@ protected:
 	void SetUp() override {
 		Super::SetUp();
 		core::Var::get(cfg::ServerSeed, "1");
+		core::Var::get(cfg::ServerAIBatchedTick, "false");
 		core::Var::get(cfg::VoxelMeshSize, "16", core::CV_READONLY);
 		core::Var::get(cfg::DatabaseMinConnections, "0");
 		core::Var::get(cfg::DatabaseMaxConnections, "0");
@@ -0,0 +1,149 @@
+/**
+ * @file
+ */
+
+#include <gtest/gtest.h>
+#include "backend/world/InterestGrid.h"
+#include <map>
+
+namespace backend {
+
+class InterestGridTest: public testing::Test {
+protected:
+	struct Delta {
+		int added = 0;
+		int removed = 0;
+	};
+	std::map<EntityId, Delta> _deltas;
+	InterestGrid::DeltaFunc _func;
+
+	void SetUp() override {
+		_func = [this] (EntityId observer, const InterestGrid::EntityIds& added, const InterestGrid::EntityIds& removed) {
+			Delta& delta = _deltas[observer];
+			delta.added += (int)added.size();
+			delta.removed += (int)removed.size();
+		};
+	}
+
+	void update(InterestGrid& grid) {
+		_deltas.clear();
+		grid.update(_func);
+	}
+};
+
+TEST_F(InterestGridTest, testVisible) {
+	InterestGrid grid(10.0f, 1.0f);
+	grid.add(1, glm::vec3(5.0f, 0.0f, 5.0f), 20.0f);
+	grid.add(2, glm::vec3(15.0f, 0.0f, 5.0f), 20.0f);
+	grid.add(3, glm::vec3(105.0f, 0.0f, 5.0f), 20.0f);
+	update(grid);
+	EXPECT_TRUE(grid.visible(1, 2));
+	EXPECT_TRUE(grid.visible(2, 1));
+	EXPECT_FALSE(grid.visible(1, 3));
+	EXPECT_FALSE(grid.visible(3, 1));
+	EXPECT_EQ(1, _deltas[1].added);
+	EXPECT_EQ(1, _deltas[2].added);
+	EXPECT_EQ(0u, _deltas.count(3));
+}
+
+TEST_F(InterestGridTest, testAsymmetricViewDistance) {
+	InterestGrid grid(10.0f, 1.0f);
+	grid.add(1, glm::vec3(5.0f, 0.0f, 5.0f), 50.0f);
+	grid.add(2, glm::vec3(45.0f, 0.0f, 5.0f), 10.0f);
+	update(grid);
+	EXPECT_TRUE(grid.visible(1, 2));
+	EXPECT_FALSE(grid.visible(2, 1));
+}
+
+TEST_F(InterestGridTest, testNoUpdateWithoutCellChange) {
+	InterestGrid grid(10.0f, 1.0f);
+	grid.add(1, glm::vec3(5.0f, 0.0f, 5.0f), 20.0f);
+	grid.add(2, glm::vec3(15.0f, 0.0f, 5.0f), 20.0f);
+	update(grid);
+	grid.move(1, glm::vec3(9.0f, 0.0f, 1.0f), 20.0f);
+	// inside of the hysteresis
+	grid.move(2, glm::vec3(9.5f, 0.0f, 5.0f), 20.0f);
+	update(grid);
+	EXPECT_TRUE(_deltas.empty());
+	EXPECT_TRUE(grid.visible(1, 2));
+}
+
+TEST_F(InterestGridTest, testMoveOutOfView) {
+	InterestGrid grid(10.0f, 1.0f);
+	grid.add(1, glm::vec3(5.0f, 0.0f, 5.0f), 20.0f);
+	grid.add(2, glm::vec3(15.0f, 0.0f, 5.0f), 20.0f);
+	update(grid);
+	grid.move(2, glm::vec3(35.0f, 0.0f, 5.0f), 20.0f);
+	update(grid);
+	// still visible - the visible entities are kept for one more cell
+	EXPECT_TRUE(grid.visible(1, 2));
+	EXPECT_TRUE(_deltas.empty());
+	grid.move(2, glm::vec3(505.0f, 0.0f, 5.0f), 20.0f);
+	update(grid);
+	EXPECT_FALSE(grid.visible(1, 2));
+	EXPECT_FALSE(grid.visible(2, 1));
+	EXPECT_EQ(1, _deltas[1].removed);
+	EXPECT_EQ(1, _deltas[2].removed);
+	grid.move(2, glm::vec3(15.0f, 0.0f, 5.0f), 20.0f);
+	update(grid);
+	EXPECT_TRUE(grid.visible(1, 2));
+	EXPECT_EQ(1, _deltas[1].added);
+	EXPECT_EQ(1, _deltas[2].added);
+}
+
+TEST_F(InterestGridTest, testNegativeCoordinates) {
+	InterestGrid grid(10.0f, 1.0f);
+	grid.add(1, glm::vec3(-5.0f, 0.0f, -5.0f), 10.0f);
+	grid.add(2, glm::vec3(5.0f, 0.0f, 5.0f), 10.0f);
+	grid.add(3, glm::vec3(-55.0f, 0.0f, -5.0f), 10.0f);
+	update(grid);
+	EXPECT_FALSE(grid.visible(1, 2)) << "diagonal cells are sqrt(2) cells away";
+	grid.move(2, glm::vec3(-15.0f, 0.0f, -5.0f), 10.0f);
+	update(grid);
+	EXPECT_TRUE(grid.visible(1, 2));
+	EXPECT_FALSE(grid.visible(1, 3));
+}
+
+TEST_F(InterestGridTest, testViewDistanceChange) {
+	InterestGrid grid(10.0f, 1.0f);
+	grid.add(1, glm::vec3(5.0f, 0.0f, 5.0f), 10.0f);
+	grid.add(2, glm::vec3(55.0f, 0.0f, 5.0f), 10.0f);
+	update(grid);
+	EXPECT_FALSE(grid.visible(1, 2));
+	grid.move(1, glm::vec3(5.0f, 0.0f, 5.0f), 100.0f);
+	update(grid);
+	EXPECT_TRUE(grid.visible(1, 2));
+	EXPECT_FALSE(grid.visible(2, 1));
+}
+
+TEST_F(InterestGridTest, testRemove) {
+	InterestGrid grid(10.0f, 1.0f);
+	grid.add(1, glm::vec3(5.0f, 0.0f, 5.0f), 20.0f);
+	grid.add(2, glm::vec3(15.0f, 0.0f, 5.0f), 20.0f);
+	grid.add(3, glm::vec3(25.0f, 0.0f, 5.0f), 20.0f);
+	update(grid);
+	EXPECT_EQ(2, grid.visibleCount(2));
+	_deltas.clear();
+	EXPECT_TRUE(grid.remove(2, _func));
+	EXPECT_FALSE(grid.remove(2, _func));
+	EXPECT_EQ(2u, grid.size());
+	EXPECT_EQ(1, _deltas[1].removed);
+	EXPECT_EQ(1, _deltas[3].removed);
+	EXPECT_EQ(0u, _deltas.count(2));
+	EXPECT_EQ(1, grid.visibleCount(1));
+	EXPECT_EQ(1, grid.visibleCount(3));
+	update(grid);
+	EXPECT_TRUE(_deltas.empty());
+}
+
+TEST_F(InterestGridTest, testRemoveBeforeUpdate) {
+	InterestGrid grid(10.0f, 1.0f);
+	grid.add(1, glm::vec3(5.0f, 0.0f, 5.0f), 20.0f);
+	grid.add(2, glm::vec3(15.0f, 0.0f, 5.0f), 20.0f);
+	EXPECT_TRUE(grid.remove(2, _func));
+	update(grid);
+	EXPECT_TRUE(_deltas.empty());
+	EXPECT_EQ(0, grid.visibleCount(1));
+}
+
+}
@@ -3,12 +3,16 @@
  */
 
 #include "TestShared.h"
+#include "core/ArrayLength.h"
 #include "core/String.h"
 #include "io/Filesystem.h"
 #include "backend/entity/ai/zone/Zone.h"
 #include "backend/entity/ai/condition/True.h"
+#include <SDL_atomic.h>
+#include <SDL_timer.h>
 #include <fstream>
 #include <streambuf>
+#include <thread>
 
 namespace backend {
 
@@ -158,4 +162,79 @@ TEST_F(LUAAIRegistryTest, testSteeringEmpty) {
 	testSteering("LuaSteeringTest");
 }
 
+TEST_F(LUAAIRegistryTest, testLuaNodeThreads) {
+	const TreeNodeFactoryContext ctx = TreeNodeFactoryContext("TreeNodeName", "", True::get());
+	const TreeNodePtr& node = _registry.createNode("LuaTest2", ctx);
+	ASSERT_TRUE((bool)node);
+	const ConditionPtr& condition = _registry.createCondition("LuaTestFalse", ctxCondition);
+	ASSERT_TRUE((bool)condition);
+	SDL_atomic_t failures;
+	SDL_AtomicSet(&failures, 0);
+	std::thread threads[4];
+	AIPtr ais[lengthof(threads)];
+	for (int t = 0; t < lengthof(threads); ++t) {
+		ais[t] = std::make_shared<AI>(TreeNodePtr());
+		ais[t]->setCharacter(_chr);
+		const AIPtr& ai = ais[t];
+		threads[t] = std::thread([&, ai] () {
+			for (int i = 0; i < 100; ++i) {
+				if (node->execute(ai, 1L) != ai::TreeNodeStatus::RUNNING || condition->evaluate(ai)) {
+					SDL_AtomicIncRef(&failures);
+				}
+			}
+			EXPECT_NE(_registry.getLuaState(), _registry.luaState()) << "Each thread should use an own lua state";
+			lua_gc(_registry.luaState(), LUA_GCCOLLECT, 0);
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(0, SDL_AtomicGet(&failures));
+	EXPECT_EQ(_registry.getLuaState(), _registry.luaState());
+	for (const AIPtr& ai : ais) {
+		EXPECT_EQ(1, ai.use_count()) << "Someone is still referencing the AI instance";
+	}
+}
+
+TEST_F(LUAAIRegistryTest, testLuaNodeThreadsLateScript) {
+	const TreeNodeFactoryContext ctx = TreeNodeFactoryContext("TreeNodeName", "", True::get());
+	const TreeNodePtr& node = _registry.createNode("LuaTest2", ctx);
+	ASSERT_TRUE((bool)node);
+	const AIPtr& ai = std::make_shared<AI>(TreeNodePtr());
+	ai->setCharacter(_chr);
+	TreeNodePtr lateNode;
+	SDL_atomic_t step;
+	SDL_AtomicSet(&step, 0);
+	ai::TreeNodeStatus status = ai::TreeNodeStatus::UNKNOWN;
+	ai::TreeNodeStatus lateStatus = ai::TreeNodeStatus::UNKNOWN;
+	std::thread thread([&] () {
+		// the worker state is created before the script is evaluated
+		status = node->execute(ai, 1L);
+		SDL_AtomicSet(&step, 1);
+		while (SDL_AtomicGet(&step) != 2) {
+			SDL_Delay(1);
+		}
+		if (lateNode) {
+			lateStatus = lateNode->execute(ai, 1L);
+		}
+		lua_gc(_registry.luaState(), LUA_GCCOLLECT, 0);
+	});
+	while (SDL_AtomicGet(&step) != 1) {
+		SDL_Delay(1);
+	}
+	const char *lateScript = "local late = REGISTRY.createNode(\"LuaLate\")\n"
+		"function late:execute(ai, deltaMillis)\n"
+		"	return FAILED\n"
+		"end\n";
+	EXPECT_TRUE(_registry.evaluate(lateScript, SDL_strlen(lateScript)));
+	lateNode = _registry.createNode("LuaLate", ctx);
+	SDL_AtomicSet(&step, 2);
+	thread.join();
+	ASSERT_TRUE((bool)lateNode);
+	EXPECT_EQ(ai::TreeNodeStatus::RUNNING, status);
+	EXPECT_EQ(ai::TreeNodeStatus::FAILED, lateStatus) << "The late script wasn't loaded into the worker state";
+	lateNode = TreeNodePtr();
+	EXPECT_EQ(1, ai.use_count()) << "Someone is still referencing the AI instance";
+}
+
 }
@@ -38,6 +38,7 @@ public:
 	void SetUp() override {
 		app::AbstractTest::SetUp();
 		core::Var::get(cfg::ServerSeed, "1");
+		core::Var::get(cfg::ServerAIBatchedTick, "false");
 		core::Var::get(cfg::VoxelMeshSize, "16", core::CV_READONLY);
 		voxel::initDefaultMaterialColors();
 		_entityStorage = std::make_shared<EntityStorage>(_testApp->eventBus());
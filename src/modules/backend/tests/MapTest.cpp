@@ -11,6 +11,7 @@
 #include "attrib/ContainerProvider.h"
 #include "backend/entity/ai/AIRegistry.h"
 #include "backend/entity/ai/AILoader.h"
+#include "backend/entity/ai/zone/Zone.h"
 #include "backend/entity/EntityStorage.h"
 #include "voxel/MaterialColor.h"
 #include "voxelformat/VolumeCache.h"
@@ -34,6 +35,7 @@ public:
 	void SetUp() override {
 		app::AbstractTest::SetUp();
 		core::Var::get(cfg::ServerSeed, "1");
+		core::Var::get(cfg::ServerAIBatchedTick, "false");
 		core::Var::get(cfg::VoxelMeshSize, "16", core::CV_READONLY);
 		voxel::initDefaultMaterialColors();
 		_entityStorage = std::make_shared<EntityStorage>(_testApp->eventBus());
@@ -87,6 +89,16 @@ TEST_F(MapTest, testInitShutdown) {
 TEST_F(MapTest, testUpdate) {
 	create(map, 1);
 	EXPECT_TRUE(map.init()) << "Failed to initialize the map " << map.id();
+	EXPECT_FALSE(map.zone()->isBatchedTick());
+	map.update(0ul);
+	map.shutdown();
+}
+
+TEST_F(MapTest, testUpdateBatchedTick) {
+	core::Var::getSafe(cfg::ServerAIBatchedTick)->setVal(true);
+	create(map, 1);
+	EXPECT_TRUE(map.init()) << "Failed to initialize the map " << map.id();
+	EXPECT_TRUE(map.zone()->isBatchedTick());
 	map.update(0ul);
 	map.shutdown();
 }
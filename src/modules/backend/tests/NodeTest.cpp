@@ -74,6 +74,46 @@ TEST_F(NodeTest, testSequence) {
 	ASSERT_EQ(ai::TreeNodeStatus::FINISHED, idle2->getLastStatus(ai));
 }
 
+TEST_F(NodeTest, testSequenceChildrenCreatedFirst) {
+	// the children have lower node ids than the sequence - the states of the children are added in front of the
+	// state of the sequence
+	backend::Idle::Factory idleFac;
+	backend::TreeNodeFactoryContext idleCtx1("testidle", "2", backend::True::get());
+	TreeNodePtr idle1 = idleFac.create(&idleCtx1);
+	backend::TreeNodeFactoryContext idleCtx2("testidle2", "2", backend::True::get());
+	TreeNodePtr idle2 = idleFac.create(&idleCtx2);
+
+	backend::Sequence::Factory f;
+	backend::TreeNodeFactoryContext ctx("testsequence", "", backend::True::get());
+	TreeNodePtr node = f.create(&ctx);
+	ASSERT_LT(idle2->getId(), node->getId());
+	node->addChild(idle1);
+	node->addChild(idle2);
+
+	AIPtr ai = std::make_shared<AI>(node);
+	ICharacterPtr chr = core::make_shared<ICharacter>(1);
+	ai->setCharacter(chr);
+	ai->update(1, true);
+	ai->getBehaviour()->execute(ai, 1);
+	ASSERT_EQ(ai::TreeNodeStatus::RUNNING, node->getLastStatus(ai));
+	ASSERT_EQ(ai::TreeNodeStatus::RUNNING, idle1->getLastStatus(ai));
+	ASSERT_EQ(ai::TreeNodeStatus::UNKNOWN, idle2->getLastStatus(ai));
+	ai->update(1, true);
+	ai->getBehaviour()->execute(ai, 1);
+	ai->update(1, true);
+	ai->getBehaviour()->execute(ai, 1);
+	ASSERT_EQ(ai::TreeNodeStatus::FINISHED, idle1->getLastStatus(ai));
+	ASSERT_EQ(ai::TreeNodeStatus::RUNNING, idle2->getLastStatus(ai));
+	ASSERT_EQ(ai::TreeNodeStatus::RUNNING, node->getLastStatus(ai));
+	ai->update(1, true);
+	ai->getBehaviour()->execute(ai, 1);
+	ai->update(1, true);
+	ai->getBehaviour()->execute(ai, 1);
+	ASSERT_EQ(ai::TreeNodeStatus::FINISHED, idle2->getLastStatus(ai));
+	ASSERT_EQ(ai::TreeNodeStatus::FINISHED, node->getLastStatus(ai));
+	ASSERT_EQ(5, node->getLastExecMillis(ai));
+}
+
 TEST_F(NodeTest, testIdle) {
 	backend::Idle::Factory f;
 	backend::TreeNodeFactoryContext ctx("testidle", "1000", backend::True::get());
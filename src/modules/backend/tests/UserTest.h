@@ -70,6 +70,13 @@ protected:
 		ASSERT_TRUE(cooldownProvider->init(COOLDOWNS)) << cooldownProvider->error();
 	}
 
+	void TearDown() override {
+		// stops the writer thread
+		persistenceMgr->shutdown();
+		dbHandler->shutdown();
+		Super::TearDown();
+	}
+
 	inline UserPtr create(EntityId id, const char* name = "noname") {
 		const UserPtr& u = std::make_shared<User>(nullptr, id, name, map, messageSender, timeProvider,
 				containerProvider, cooldownProvider, dbHandler, persistenceMgr, stockDataProvider);
@@ -6,6 +6,7 @@
 #include "backend/entity/ai/tree/PrioritySelector.h"
 #include "backend/entity/ai/zone/Zone.h"
 #include "backend/entity/ai/condition/True.h"
+#include <vector>
 
 namespace backend {
 
@@ -52,4 +53,40 @@ TEST_F(ZoneTest, testAdd100) {
 	ASSERT_EQ(n, (int)zone.size());
 }
 
+TEST_F(ZoneTest, testBatchedTick) {
+	Zone zone("test1", 2);
+	zone.setBatchedTick(true);
+	zone.setDebug(true);
+	const TreeNodePtr roots[] = {
+		std::make_shared<TreeNode>("root1", "", True::get()),
+		std::make_shared<TreeNode>("root2", "", True::get())
+	};
+	const int n = Zone::TickBatchSize * 3 + 1;
+	std::vector<AIPtr> ais;
+	for (int i = 0; i < n; ++i) {
+		AIPtr ai = std::make_shared<AI>(roots[i % 2]);
+		ai->setCharacter(core::make_shared<TestEntity>(i));
+		ASSERT_TRUE(zone.addAI(ai)) << "Could not add ai to the zone";
+		ais.push_back(ai);
+	}
+	zone.update(1);
+	ASSERT_EQ(n, (int)zone.size());
+	for (int i = 0; i < n; ++i) {
+		EXPECT_EQ(1, roots[i % 2]->getLastExecMillis(ais[i])) << "ai " << i << " wasn't updated";
+		EXPECT_EQ(-1, roots[(i + 1) % 2]->getLastExecMillis(ais[i])) << "ai " << i << " executed the wrong behaviour";
+	}
+
+	ais[0]->setBehaviour(roots[1]);
+	zone.update(1);
+	EXPECT_EQ(2, roots[1]->getLastExecMillis(ais[0])) << "The changed behaviour wasn't executed";
+	EXPECT_EQ(-1, roots[0]->getLastExecMillis(ais[0]));
+
+	ASSERT_TRUE(zone.removeAI(0)) << "Could not remove ai from zone";
+	zone.update(1);
+	EXPECT_EQ(n - 1, (int)zone.size());
+	EXPECT_FALSE(ais[0]->hasZone());
+	EXPECT_EQ(1, ais[0].use_count()) << "The zone is still referencing the removed ai";
+	EXPECT_EQ(3, roots[1]->getLastExecMillis(ais[1]));
+}
+
 }
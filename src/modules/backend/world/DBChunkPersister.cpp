@@ -6,11 +6,22 @@
 #include "BackendModels.h"
 #include "voxel/PagedVolume.h"
 #include "voxel/Region.h"
+#include "core/StandardLib.h"
+#include "core/TimeProvider.h"
+#include "core/collection/DynamicArray.h"
+#include <vector>
 
 namespace backend {
 
 DBChunkPersister::DBChunkPersister(const persistence::DBHandlerPtr &dbHandler, MapId mapId) :
 		_dbHandler(dbHandler), _mapId(mapId) {
+	_writeThread.init();
+}
+
+DBChunkPersister::~DBChunkPersister() {
+	shutdown();
+	core::ScopedLock lock(_lock);
+	freeEntries(_pending);
 }
 
 bool DBChunkPersister::init() {
@@ -20,24 +31,87 @@ bool DBChunkPersister::init() {
 	return true;
 }
 
+void DBChunkPersister::shutdown() {
+	flush();
+	_writeThread.shutdown(true);
+	// chunks that were queued while the write thread was stopped
+	while (writeBatch()) {
+	}
+}
+
+glm::ivec4 DBChunkPersister::key(const glm::ivec3& chunkPos, unsigned int seed) {
+	return glm::ivec4(chunkPos, (int)seed);
+}
+
+void DBChunkPersister::freeEntries(Entries& entries) {
+	for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
+		core_free(iter->value.data);
+	}
+	entries.clear();
+}
+
+bool DBChunkPersister::isQueued(const glm::ivec4& k) const {
+	core::ScopedLock lock(_lock);
+	return _pending.hasKey(k) || _writing.hasKey(k);
+}
+
 void DBChunkPersister::erase(const voxel::Region& region, unsigned int seed) {
+	// the region lower corner is always a multiple of the chunk size
+	const glm::ivec3& chunkPos = region.getLowerCorner() / region.getDimensionsInVoxels();
+	const glm::ivec4& k = key(chunkPos, seed);
+	{
+		core::ScopedLock lock(_lock);
+		Entry entry;
+		if (_pending.get(k, entry)) {
+			core_free(entry.data);
+			_pending.remove(k);
+		}
+	}
 	db::ChunkModel model;
 	model.setMapid(_mapId);
-	model.setX(region.getLowerX());
-	model.setY(region.getLowerY());
-	model.setZ(region.getLowerZ());
+	model.setX(chunkPos.x);
+	model.setY(chunkPos.y);
+	model.setZ(chunkPos.z);
 	model.setSeed(seed);
+	// a batch that is currently written might still contain the chunk - the delete must come after it
+	core::ScopedLock writeLock(_writeLock);
+	{
+		// the write thread clears its batch before it releases the write lock - load() must not serve a stale entry anyway
+		core::ScopedLock lock(_lock);
+		Entry entry;
+		if (_writing.get(k, entry)) {
+			core_free(entry.data);
+			_writing.remove(k);
+		}
+	}
 	_dbHandler->deleteModel(model);
 }
 
 bool DBChunkPersister::truncate(unsigned int seed) {
+	{
+		core::ScopedLock lock(_lock);
+		core::DynamicArray<glm::ivec4> keys;
+		for (auto iter = _pending.begin(); iter != _pending.end(); ++iter) {
+			if (iter->key.w == (int)seed) {
+				core_free(iter->value.data);
+				keys.push_back(iter->key);
+			}
+		}
+		for (const glm::ivec4& k : keys) {
+			_pending.remove(k);
+		}
+	}
 	db::ChunkModel model;
 	model.setMapid(_mapId);
 	model.setSeed(seed);
+	core::ScopedLock lock(_writeLock);
 	return _dbHandler->truncate(model);
 }
 
-persistence::Blob DBChunkPersister::load(int x, int y, int z, MapId mapId, unsigned int seed) const {
+persistence::Blob DBChunkPersister::load(int x, int y, int z, MapId mapId, unsigned int seed) {
+	if (mapId == _mapId && isQueued(key(glm::ivec3(x, y, z), seed))) {
+		flush();
+	}
 	db::ChunkModel model;
 	model.setMapid(mapId);
 	model.setX(x);
@@ -53,6 +127,15 @@ persistence::Blob DBChunkPersister::load(int x, int y, int z, MapId mapId, unsig
 bool DBChunkPersister::load(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) {
 	core_trace_scoped(DBChunkPersisterLoad);
 	const glm::ivec3& region = chunk->chunkPos();
+	{
+		// the database doesn't know about the queued chunks yet
+		core::ScopedLock lock(_lock);
+		const glm::ivec4& k = key(region, seed);
+		Entry entry;
+		if (_pending.get(k, entry) || _writing.get(k, entry)) {
+			return loadCompressed(chunk, entry.data, entry.size);
+		}
+	}
 	persistence::Blob blob = load(region.x, region.y, region.z, _mapId, seed);
 	if (blob.length <= 0) {
 		Log::debug("No chunk found in database");
@@ -68,27 +151,135 @@ bool DBChunkPersister::load(const voxel::PagedVolume::ChunkPtr& chunk, unsigned
 	return true;
 }
 
-// TODO: this must be done async
 bool DBChunkPersister::save(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) {
 	core_trace_scoped(DBChunkPersisterSave);
 	core::ByteStream out;
 	if (!saveCompressed(chunk, out)) {
 		return false;
 	}
+	Log::debug("Queue compressed chunk with size %i", (int)out.getSize());
+	Entry entry;
+	entry.size = (uint32_t)out.getSize();
+	entry.data = (uint8_t*)core_malloc(entry.size);
+	core_memcpy(entry.data, out.getBuffer(), entry.size);
+	{
+		core::ScopedLock lock(_lock);
+		const glm::ivec4& k = key(chunk->chunkPos(), seed);
+		Entry queued;
+		if (_pending.get(k, queued)) {
+			core_free(queued.data);
+			++_coalesced;
+		}
+		_pending.put(k, entry);
+	}
+	if (!scheduleFlush()) {
+		// the write thread is already shut down
+		while (writeBatch()) {
+		}
+	}
+	return true;
+}
 
-	persistence::Blob data;
-	data.data = (uint8_t*)out.getBuffer();
-	data.length = out.getSize();
-	Log::info("Store compressed chunk with size %i", (int)data.length);
-	db::ChunkModel model;
-	model.setMapid(_mapId);
-	const glm::ivec3& chunkPos = chunk->chunkPos();
-	model.setX(chunkPos.x);
-	model.setY(chunkPos.y);
-	model.setZ(chunkPos.z);
-	model.setSeed(seed);
-	model.setData(data);
-	return _dbHandler->insert(model);
+bool DBChunkPersister::scheduleFlush() {
+	core::ScopedLock lock(_flushLock);
+	if (_flushRunning) {
+		// the running flush checks the queue again before it finishes
+		return true;
+	}
+	std::future<void> flush = _writeThread.enqueue([this] () {
+		for (;;) {
+			writeBatch();
+			core::ScopedLock lock(_flushLock);
+			bool empty;
+			{
+				core::ScopedLock queueLock(_lock);
+				empty = _pending.empty();
+			}
+			// chunks that are queued after this check will schedule a new flush
+			if (empty) {
+				_flushRunning = false;
+				break;
+			}
+		}
+	});
+	if (!flush.valid()) {
+		return false;
+	}
+	_flushRunning = true;
+	_flush = flush.share();
+	return true;
+}
+
+bool DBChunkPersister::writeBatch() {
+	core_trace_scoped(DBChunkPersisterWriteBatch);
+	core::ScopedLock writeLock(_writeLock);
+	std::vector<db::ChunkModel> models;
+	{
+		core::ScopedLock lock(_lock);
+		if (_pending.empty()) {
+			return false;
+		}
+		for (auto iter = _pending.begin(); iter != _pending.end() && (int)_writing.size() < BatchSize; ++iter) {
+			_writing.put(iter->key, iter->value);
+		}
+		models.reserve(_writing.size());
+		for (auto iter = _writing.begin(); iter != _writing.end(); ++iter) {
+			const glm::ivec4& k = iter->key;
+			_pending.remove(k);
+			db::ChunkModel model;
+			model.setMapid(_mapId);
+			model.setX(k.x);
+			model.setY(k.y);
+			model.setZ(k.z);
+			model.setSeed((unsigned int)k.w);
+			model.setData(persistence::Blob(iter->value.data, iter->value.size));
+			models.emplace_back(core::move(model));
+		}
+	}
+	const uint64_t start = core::TimeProvider::systemMillis();
+	const bool success = _dbHandler->insert(models);
+	const uint64_t millis = core::TimeProvider::systemMillis() - start;
+	if (!success) {
+		Log::error("Failed to store %i chunks", (int)models.size());
+	}
+	core::ScopedLock lock(_lock);
+	if (success) {
+		_written += (int)models.size();
+	} else {
+		_failed += (int)models.size();
+	}
+	++_flushes;
+	_flushMillis = millis;
+	_maxFlushMillis = core_max(_maxFlushMillis, millis);
+	freeEntries(_writing);
+	return true;
+}
+
+void DBChunkPersister::flush() {
+	for (;;) {
+		std::shared_future<void> flush;
+		{
+			core::ScopedLock lock(_flushLock);
+			if (!_flushRunning) {
+				return;
+			}
+			flush = _flush;
+		}
+		flush.wait();
+	}
+}
+
+DBChunkPersister::Metrics DBChunkPersister::metrics() const {
+	core::ScopedLock lock(_lock);
+	Metrics metrics;
+	metrics.queued = (int)(_pending.size() + _writing.size());
+	metrics.written = _written;
+	metrics.coalesced = _coalesced;
+	metrics.failed = _failed;
+	metrics.flushes = _flushes;
+	metrics.lastFlushMillis = (int)_flushMillis;
+	metrics.maxFlushMillis = (int)_maxFlushMillis;
+	return metrics;
 }
 
 }
@@ -9,29 +9,127 @@
 #include "persistence/Blob.h"
 #include "voxel/PagedVolume.h"
 #include "voxel/Region.h"
+#include "core/GLM.h"
+#include "core/Trace.h"
+#include "core/concurrent/Lock.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/collection/DynamicMap.h"
 #include "MapId.h"
+#include <future>
 
 namespace backend {
 
+/**
+ * @brief Persists the chunks of a map in the database.
+ *
+ * Saving a chunk only compresses it - the database insert is done by a write behind queue on its own
+ * thread. Saves of the same chunk that are still queued are coalesced and the queued chunks are written
+ * with multi row inserts. Loading a queued chunk is served from the queue.
+ */
 class DBChunkPersister : public voxelworld::ChunkPersister {
+private:
+	struct Entry {
+		uint8_t* data;
+		uint32_t size;
+	};
+	// chunk position and seed
+	typedef core::DynamicMap<glm::ivec4, Entry, 64, glm::hash<glm::ivec4>> Entries;
+
+	/**
+	 * @brief The max amount of chunks that are written with one insert statement
+	 */
+	static constexpr int BatchSize = 32;
+
+	Entries _pending core_thread_guarded_by(_lock);
+	// the chunks of the insert that is currently executed
+	Entries _writing core_thread_guarded_by(_lock);
+	int _written core_thread_guarded_by(_lock) = 0;
+	int _coalesced core_thread_guarded_by(_lock) = 0;
+	int _failed core_thread_guarded_by(_lock) = 0;
+	int _flushes core_thread_guarded_by(_lock) = 0;
+	uint64_t _flushMillis core_thread_guarded_by(_lock) = 0u;
+	uint64_t _maxFlushMillis core_thread_guarded_by(_lock) = 0u;
+	mutable core_trace_mutex(core::Lock, _lock, "DBChunkPersister");
+
+	std::shared_future<void> _flush core_thread_guarded_by(_flushLock);
+	bool _flushRunning core_thread_guarded_by(_flushLock) = false;
+	core_trace_mutex(core::Lock, _flushLock, "DBChunkPersisterFlush");
+	// serializes the database writes of the queue with the deletes
+	core_trace_mutex(core::Lock, _writeLock, "DBChunkPersisterWrite");
+	core::ThreadPool _writeThread { 1, "ChunkWriter" };
+
+	static glm::ivec4 key(const glm::ivec3& chunkPos, unsigned int seed);
+	void freeEntries(Entries& entries);
+	/**
+	 * @brief Schedules the write of the queued chunks on the write thread
+	 * @return @c false if the write thread is not running
+	 */
+	bool scheduleFlush();
+	/**
+	 * @brief Writes the next batch of queued chunks
+	 * @return @c false if the queue is empty
+	 */
+	bool writeBatch();
+	bool isQueued(const glm::ivec4& k) const;
+
 protected:
 	persistence::DBHandlerPtr _dbHandler;
 	const MapId _mapId;
 public:
 	DBChunkPersister(const persistence::DBHandlerPtr& dbHandler, MapId mapId);
-	virtual ~DBChunkPersister() {}
+	virtual ~DBChunkPersister();
 
 	bool init() override;
+	/**
+	 * @brief Writes all queued chunks and stops the write thread. Chunks that are saved after this are
+	 * written directly.
+	 */
+	void shutdown() override;
 
-	persistence::Blob load(int x, int y, int z, MapId mapId, unsigned int seed) const;
+	/**
+	 * @note Blocks until the chunk was written if it is still queued
+	 */
+	persistence::Blob load(int x, int y, int z, MapId mapId, unsigned int seed);
 	/**
 	 * @brief Removes all persisted chunks from the database for the given parameters
 	 */
 	bool truncate(unsigned int seed);
 
 	bool load(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) override;
+	/**
+	 * @brief Compresses the chunk and puts it into the write queue
+	 */
 	bool save(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) override;
 	void erase(const voxel::Region& region, unsigned int seed) override;
+
+	/**
+	 * @brief Blocks until the write queue is empty
+	 */
+	void flush();
+
+	/**
+	 * @brief Counters about the write queue. Except for @c queued and @c lastFlushMillis the values are
+	 * accumulated over the lifetime of the persister.
+	 */
+	struct Metrics {
+		/**
+		 * @brief Chunks that are not yet written to the database
+		 */
+		int queued = 0;
+		int written = 0;
+		/**
+		 * @brief Saves that replaced a queued save of the same chunk
+		 */
+		int coalesced = 0;
+		int failed = 0;
+		/**
+		 * @brief The amount of insert statements
+		 */
+		int flushes = 0;
+		int lastFlushMillis = 0;
+		int maxFlushMillis = 0;
+	};
+	Metrics metrics() const;
 };
 
 typedef std::shared_ptr<DBChunkPersister> DBChunkPersisterPtr;
@@ -0,0 +1,256 @@
+/**
+ * @file
+ */
+
+#include "InterestGrid.h"
+#include "core/Assert.h"
+#include "core/Common.h"
+#include "core/Trace.h"
+#include <glm/common.hpp>
+
+namespace backend {
+
+InterestGrid::InterestGrid(float cellSize, float hysteresis) :
+		_cellSize(cellSize), _hysteresis(hysteresis) {
+	core_assert(_cellSize > 0.0f);
+}
+
+uint64_t InterestGrid::key(const glm::ivec2& cell) {
+	return ((uint64_t)(uint32_t)cell.x << 32) | (uint64_t)(uint32_t)cell.y;
+}
+
+glm::ivec2 InterestGrid::cell(const glm::vec3& pos) const {
+	return glm::ivec2((int)glm::floor(pos.x / _cellSize), (int)glm::floor(pos.z / _cellSize));
+}
+
+void InterestGrid::insertIntoCell(Entry& entry) {
+	Cell& cell = _cells[key(entry.cell)];
+	entry.cellIndex = cell.size();
+	cell.push_back(&entry);
+}
+
+void InterestGrid::removeFromCell(Entry& entry) {
+	auto i = _cells.find(key(entry.cell));
+	core_assert(i != _cells.end());
+	Cell& cell = i->second;
+	core_assert(cell[entry.cellIndex] == &entry);
+	Entry* last = cell[cell.size() - 1];
+	last->cellIndex = entry.cellIndex;
+	cell[entry.cellIndex] = last;
+	cell.pop();
+	if (cell.empty()) {
+		_cells.erase(i);
+	}
+}
+
+void InterestGrid::markMoved(Entry& entry) {
+	if (entry.moved) {
+		return;
+	}
+	entry.moved = true;
+	_moved.push_back(&entry);
+}
+
+void InterestGrid::markChanged(Entry& entry) {
+	// the first change of this update
+	if (entry.added.size() + entry.removed.size() == 1u) {
+		_changed.push_back(&entry);
+	}
+}
+
+void InterestGrid::forget(core::DynamicArray<Entry*>& list, const Entry* entry) {
+	for (size_t i = 0u; i < list.size(); ++i) {
+		if (list[i] == entry) {
+			list.erase(i);
+			return;
+		}
+	}
+}
+
+void InterestGrid::add(EntityId id, const glm::vec3& pos, float viewDistance) {
+	auto i = _entries.emplace(id, Entry());
+	if (!i.second) {
+		move(id, pos, viewDistance);
+		return;
+	}
+	Entry& entry = i.first->second;
+	entry.id = id;
+	entry.cell = cell(pos);
+	entry.viewDistance = viewDistance;
+	_maxViewDistance = core_max(_maxViewDistance, viewDistance);
+	insertIntoCell(entry);
+	_moved.push_back(&entry);
+}
+
+bool InterestGrid::remove(EntityId id, const DeltaFunc& func) {
+	auto i = _entries.find(id);
+	if (i == _entries.end()) {
+		return false;
+	}
+	Entry& entry = i->second;
+	for (Entry* observer : entry.observers) {
+		observer->visible.erase(&entry);
+		observer->removed.push_back(id);
+		markChanged(*observer);
+	}
+	for (Entry* target : entry.visible) {
+		target->observers.erase(&entry);
+	}
+	removeFromCell(entry);
+	if (entry.moved) {
+		forget(_moved, &entry);
+	}
+	_entries.erase(i);
+	report(func);
+	return true;
+}
+
+void InterestGrid::move(EntityId id, const glm::vec3& pos, float viewDistance) {
+	auto i = _entries.find(id);
+	if (i == _entries.end()) {
+		return;
+	}
+	Entry& entry = i->second;
+	if (entry.viewDistance != viewDistance) {
+		entry.viewDistance = viewDistance;
+		_maxViewDistance = core_max(_maxViewDistance, viewDistance);
+		markMoved(entry);
+	}
+	const float minX = (float)entry.cell.x * _cellSize - _hysteresis;
+	const float minZ = (float)entry.cell.y * _cellSize - _hysteresis;
+	const float maxX = (float)(entry.cell.x + 1) * _cellSize + _hysteresis;
+	const float maxZ = (float)(entry.cell.y + 1) * _cellSize + _hysteresis;
+	if (pos.x >= minX && pos.x < maxX && pos.z >= minZ && pos.z < maxZ) {
+		return;
+	}
+	removeFromCell(entry);
+	entry.cell = cell(pos);
+	insertIntoCell(entry);
+	markMoved(entry);
+}
+
+bool InterestGrid::inView(const Entry& observer, const Entry& target, bool visible) const {
+	// the cells are compared - not the positions. So the visibility only changes if one of them changed the cell.
+	const glm::ivec2 d = observer.cell - target.cell;
+	const float distance2 = (float)(d.x * d.x + d.y * d.y) * _cellSize * _cellSize;
+	const float radius = visible ? observer.viewDistance + _cellSize : observer.viewDistance;
+	return distance2 <= radius * radius;
+}
+
+void InterestGrid::evaluate(Entry& observer, Entry& target) {
+	auto i = observer.visible.find(&target);
+	const bool visible = i != observer.visible.end();
+	if (inView(observer, target, visible) == visible) {
+		return;
+	}
+	if (visible) {
+		observer.visible.erase(i);
+		target.observers.erase(&observer);
+		observer.removed.push_back(target.id);
+	} else {
+		observer.visible.insert(&target);
+		target.observers.insert(&observer);
+		observer.added.push_back(target.id);
+	}
+	markChanged(observer);
+}
+
+void InterestGrid::evaluate(Entry& entry) {
+	// no entity beyond this amount of cells can see this entity or can be seen by it
+	const int range = (int)glm::ceil((_maxViewDistance + _cellSize) / _cellSize);
+	const int range2 = range * range;
+	for (int dx = -range; dx <= range; ++dx) {
+		for (int dz = -range; dz <= range; ++dz) {
+			if (dx * dx + dz * dz > range2) {
+				continue;
+			}
+			auto i = _cells.find(key(entry.cell + glm::ivec2(dx, dz)));
+			if (i == _cells.end()) {
+				continue;
+			}
+			const Cell& cell = i->second;
+			for (Entry* other : cell) {
+				if (other == &entry) {
+					continue;
+				}
+				evaluate(entry, *other);
+				evaluate(*other, entry);
+			}
+		}
+	}
+
+	// the entities that are out of range now - the sets are modified while they are evaluated
+	_scratch.clear();
+	for (Entry* target : entry.visible) {
+		const glm::ivec2 d = target->cell - entry.cell;
+		if (d.x * d.x + d.y * d.y > range2) {
+			_scratch.push_back(target);
+		}
+	}
+	for (Entry* target : _scratch) {
+		evaluate(entry, *target);
+	}
+	_scratch.clear();
+	for (Entry* observer : entry.observers) {
+		const glm::ivec2 d = observer->cell - entry.cell;
+		if (d.x * d.x + d.y * d.y > range2) {
+			_scratch.push_back(observer);
+		}
+	}
+	for (Entry* observer : _scratch) {
+		evaluate(*observer, entry);
+	}
+}
+
+void InterestGrid::report(const DeltaFunc& func) {
+	for (Entry* entry : _changed) {
+		func(entry->id, entry->added, entry->removed);
+		entry->added.clear();
+		entry->removed.clear();
+	}
+	_changed.clear();
+}
+
+void InterestGrid::update(const DeltaFunc& func) {
+	core_trace_scoped(InterestGridUpdate);
+	for (Entry* entry : _moved) {
+		evaluate(*entry);
+	}
+	for (Entry* entry : _moved) {
+		entry->moved = false;
+	}
+	_moved.clear();
+	report(func);
+}
+
+void InterestGrid::clear() {
+	_moved.clear();
+	_changed.clear();
+	_scratch.clear();
+	_entries.clear();
+	_cells.clear();
+	_maxViewDistance = 0.0f;
+}
+
+bool InterestGrid::visible(EntityId observer, EntityId target) const {
+	auto o = _entries.find(observer);
+	if (o == _entries.end()) {
+		return false;
+	}
+	auto t = _entries.find(target);
+	if (t == _entries.end()) {
+		return false;
+	}
+	Entry* entry = const_cast<Entry*>(&t->second);
+	return o->second.visible.find(entry) != o->second.visible.end();
+}
+
+int InterestGrid::visibleCount(EntityId observer) const {
+	auto o = _entries.find(observer);
+	if (o == _entries.end()) {
+		return 0;
+	}
+	return (int)o->second.visible.size();
+}
+
+}
@@ -0,0 +1,126 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "backend/entity/EntityId.h"
+#include "core/collection/DynamicArray.h"
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace backend {
+
+/**
+ * @brief Interest management on a uniform grid of cells in the x/z plane.
+ *
+ * An entity sees the entities whose cells are inside of its view radius. The visibility is only evaluated for the
+ * entities that changed their cell or their view distance since the last @c update() - all other entities keep
+ * their visible sets.
+ *
+ * There are two kinds of hysteresis to prevent entities from flipping between visible and invisible:
+ * - an entity only changes its cell after it moved more than the hysteresis over the border of its cell
+ * - a visible entity stays visible until it is one cell further away than the view radius
+ */
+class InterestGrid {
+public:
+	using EntityIds = core::DynamicArray<EntityId>;
+	/**
+	 * @brief Called for every entity whose set of visible entities changed
+	 */
+	using DeltaFunc = std::function<void(EntityId observer, const EntityIds& added, const EntityIds& removed)>;
+
+private:
+	struct Entry {
+		EntityId id;
+		glm::ivec2 cell;
+		float viewDistance;
+		// the index of the entry in its cell
+		size_t cellIndex = 0u;
+		// the entity changed its cell or its view distance since the last update
+		bool moved = true;
+		// the entities this entity sees and the entities that see this entity
+		std::unordered_set<Entry*> visible;
+		std::unordered_set<Entry*> observers;
+		// the changes of the visible set that are not yet reported
+		EntityIds added;
+		EntityIds removed;
+	};
+
+	using Cell = core::DynamicArray<Entry*>;
+	std::unordered_map<uint64_t, Cell> _cells;
+	std::unordered_map<EntityId, Entry> _entries;
+	core::DynamicArray<Entry*> _moved;
+	core::DynamicArray<Entry*> _changed;
+	core::DynamicArray<Entry*> _scratch;
+	const float _cellSize;
+	const float _hysteresis;
+	float _maxViewDistance = 0.0f;
+
+	static uint64_t key(const glm::ivec2& cell);
+	glm::ivec2 cell(const glm::vec3& pos) const;
+
+	void insertIntoCell(Entry& entry);
+	void removeFromCell(Entry& entry);
+	void markMoved(Entry& entry);
+	void markChanged(Entry& entry);
+	/**
+	 * @brief Drops the given entry from the list of pending entries
+	 */
+	static void forget(core::DynamicArray<Entry*>& list, const Entry* entry);
+
+	bool inView(const Entry& observer, const Entry& target, bool visible) const;
+	/**
+	 * @brief Checks whether the observer sees the target and records the change
+	 */
+	void evaluate(Entry& observer, Entry& target);
+	/**
+	 * @brief Evaluates the visibility between the given entity and all the entities that might see it or that it
+	 * might see
+	 */
+	void evaluate(Entry& entry);
+	void report(const DeltaFunc& func);
+
+public:
+	/**
+	 * @param[in] cellSize The size of the cells in world units - should be a fraction of the view distance
+	 * @param[in] hysteresis The distance in world units an entity must move over the border of its cell before it
+	 * changes the cell
+	 */
+	InterestGrid(float cellSize = 64.0f, float hysteresis = 4.0f);
+
+	/**
+	 * @brief The visibility of the entity is evaluated in the next @c update()
+	 */
+	void add(EntityId id, const glm::vec3& pos, float viewDistance);
+	/**
+	 * @brief Removes the entity and reports it as removed from the visible sets of its observers
+	 * @return @c false if the entity is not known
+	 */
+	bool remove(EntityId id, const DeltaFunc& func);
+	/**
+	 * @brief Tracks the position of the entity - this is cheap as long as the entity stays in its cell
+	 */
+	void move(EntityId id, const glm::vec3& pos, float viewDistance);
+	/**
+	 * @brief Evaluates the visibility for the entities that changed their cells and reports the changes
+	 */
+	void update(const DeltaFunc& func);
+	void clear();
+
+	/**
+	 * @return @c true if the observer sees the target after the last @c update()
+	 */
+	bool visible(EntityId observer, EntityId target) const;
+	int visibleCount(EntityId observer) const;
+	size_t size() const;
+};
+
+inline size_t InterestGrid::size() const {
+	return _entries.size();
+}
+
+}
@@ -9,7 +9,6 @@
 #include "core/EventBus.h"
 #include "app/App.h"
 #include "core/Trace.h"
-#include "math/QuadTree.h"
 #include "io/Filesystem.h"
 #include "backend/entity/Npc.h"
 #include "backend/entity/User.h"
@@ -22,14 +21,6 @@
 
 namespace backend {
 
-math::RectFloat Map::QuadTreeNode::getRect() const {
-	return entity->rect();
-}
-
-bool Map::QuadTreeNode::operator==(const QuadTreeNode& rhs) const {
-	return rhs.entity == entity;
-}
-
 Map::Map(MapId mapId,
 		const core::EventBusPtr& eventBus,
 		const core::TimeProviderPtr& timeProvider,
@@ -46,7 +37,10 @@ Map::Map(MapId mapId,
 		_eventBus(eventBus), _filesystem(filesystem), _persistenceMgr(persistenceMgr),
 		_volumeCache(volumeCache), _attackMgr(this), _poiProvider(timeProvider), _spawnMgr(this, filesystem, entityStorage, messageSender,
 			timeProvider, loader, containerProvider, cooldownProvider),
-		_quadTree(math::RectFloat::getMaxRect(), 100.0f), _chunkPersister(chunkPersister) {
+		_chunkPersister(chunkPersister) {
+	_visibleDeltaFunc = [this] (EntityId observer, const InterestGrid::EntityIds& added, const InterestGrid::EntityIds& removed) {
+		applyVisibleDelta(observer, added, removed);
+	};
 }
 
 Map::~Map() {
@@ -62,20 +56,44 @@ bool Map::updateEntity(const EntityPtr& entity, long dt) {
 	if (!entity->update(dt)) {
 		return false;
 	}
-	const math::RectFloat& rect = entity->viewRect();
-	// TODO: maybe move into the entity instance to reduce memory allocations.
-	math::QuadTree<QuadTreeNode, float>::Contents contents;
-	_quadTree.query(rect, contents);
-	EntitySet set;
-	set.reserve(contents.size());
-	for (const QuadTreeNode& node : contents) {
-		// TODO: check the distance - the rect might contain more than the circle would...
-		if (node.entity->id() != entity->id()) {
-			set.insert(node.entity);
+	_interest.move(entity->id(), entity->pos(), (float)entity->current(attrib::Type::VIEWDISTANCE));
+	return true;
+}
+
+EntityPtr Map::entity(EntityId id) const {
+	auto npc = _npcs.find(id);
+	if (npc != _npcs.end()) {
+		return npc->second;
+	}
+	auto user = _users.find(id);
+	if (user != _users.end()) {
+		return user->second;
+	}
+	return EntityPtr();
+}
+
+void Map::applyVisibleDelta(EntityId observer, const InterestGrid::EntityIds& added, const InterestGrid::EntityIds& removed) {
+	const EntityPtr& entity = this->entity(observer);
+	if (!entity) {
+		return;
+	}
+	EntitySet add;
+	add.reserve(added.size());
+	for (EntityId id : added) {
+		const EntityPtr& e = this->entity(id);
+		if (e) {
+			add.insert(e);
 		}
 	}
-	entity->updateVisible(set);
-	return true;
+	EntitySet remove;
+	remove.reserve(removed.size());
+	for (EntityId id : removed) {
+		const EntityPtr& e = this->entity(id);
+		if (e) {
+			remove.insert(e);
+		}
+	}
+	entity->updateVisible(add, remove);
 }
 
 void Map::update(long dt) {
@@ -92,7 +110,7 @@ void Map::update(long dt) {
 			continue;
 		}
 		Log::debug("remove user " PRIEntId, user->id());
-		_quadTree.remove(QuadTreeNode { user });
+		_interest.remove(user->id(), _visibleDeltaFunc);
 		i = _users.erase(i);
 		_eventBus->enqueue(std::make_shared<EntityDeleteEvent>(user->id(), user->entityType()));
 	}
@@ -103,11 +121,61 @@ void Map::update(long dt) {
 			continue;
 		}
 		Log::debug("remove npc " PRIEntId, npc->id());
-		_quadTree.remove(QuadTreeNode { npc });
+		_interest.remove(npc->id(), _visibleDeltaFunc);
 		i = _npcs.erase(i);
 		_zone->removeAI(npc->id());
 		_eventBus->enqueue(std::make_shared<EntityDeleteEvent>(npc->id(), npc->entityType()));
 	}
+
+	_interest.update(_visibleDeltaFunc);
+	for (const auto& e : _users) {
+		e.second->snapshotMgr().sendSnapshot();
+	}
+
+	_prefetchDelta += dt;
+	if (_prefetchDelta >= PrefetchIntervalMillis) {
+		_prefetchDelta = 0l;
+		prefetchChunks();
+	}
+
+	_volumeMetricsDelta += dt;
+	if (_volumeMetricsDelta >= VolumeMetricsIntervalMillis) {
+		_volumeMetricsDelta = 0l;
+		sendVolumeMetrics();
+	}
+}
+
+void Map::prefetchChunks() {
+	core_trace_scoped(MapPrefetchChunks);
+	for (const auto& e : _users) {
+		_pager->prefetch(glm::ivec3(e.second->pos()));
+	}
+}
+
+void Map::sendVolumeMetrics() {
+	const voxel::PagedVolume::Metrics& metrics = _voxelWorldMgr->volumeData()->metrics();
+	const metric::TagMap& tags {{"map", _mapIdStr}};
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("volume_chunks", metrics.chunks, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("volume_pending_pageouts", metrics.pendingPageOuts, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::count("volume_pageins", metrics.pagedIn - _volumeMetrics.pagedIn, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::count("volume_evictions", metrics.evicted - _volumeMetrics.evicted, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::count("volume_pageouts", metrics.pagedOut - _volumeMetrics.pagedOut, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::count("volume_reclaimed", metrics.reclaimed - _volumeMetrics.reclaimed, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("volume_compressed_chunks", metrics.compressedChunks, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("volume_compressed_memory_kb", metrics.compressedMemoryKb, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::count("volume_compressed_hits", metrics.compressedHits - _volumeMetrics.compressedHits, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::count("volume_compressed_misses", metrics.compressedMisses - _volumeMetrics.compressedMisses, tags)));
+	_volumeMetrics = metrics;
+
+	const DBChunkPersister::Metrics& persisterMetrics = _chunkPersister->metrics();
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("chunk_persister_queued", persisterMetrics.queued, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::count("chunk_persister_written", persisterMetrics.written - _persisterMetrics.written, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::count("chunk_persister_coalesced", persisterMetrics.coalesced - _persisterMetrics.coalesced, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::count("chunk_persister_failed", persisterMetrics.failed - _persisterMetrics.failed, tags)));
+	if (persisterMetrics.flushes != _persisterMetrics.flushes) {
+		_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::timing("chunk_persister_flush", persisterMetrics.lastFlushMillis, tags)));
+	}
+	_persisterMetrics = persisterMetrics;
 }
 
 bool Map::init() {
@@ -137,6 +205,7 @@ bool Map::init() {
 
 	_voxelWorldMgr->setSeed(seed->uintVal());
 	_zone = new Zone(core::string::format("Zone %i", _mapId));
+	_zone->setBatchedTick(core::Var::getSafe(cfg::ServerAIBatchedTick)->boolVal());
 
 	if (!_spawnMgr.init()) {
 		Log::error("Failed to init the spawn manager");
@@ -157,9 +226,11 @@ void Map::shutdown() {
 		delete _voxelWorldMgr;
 		_voxelWorldMgr = nullptr;
 	}
+	// write the queued chunks
+	_chunkPersister->shutdown();
 	delete _zone;
 	_zone = nullptr;
-	_quadTree.clear();
+	_interest.clear();
 	_npcs.clear();
 	_users.clear();
 	_persistenceMgr->unregisterSavable(FOURCC, this);
@@ -180,7 +251,7 @@ void Map::addUser(const UserPtr& user) {
 	}
 	const glm::vec3& pos = findStartPosition(user);
 	user->setMap(ptr(), pos);
-	_quadTree.insert(QuadTreeNode { user });
+	_interest.add(user->id(), pos, (float)user->current(attrib::Type::VIEWDISTANCE));
 	_eventBus->enqueue(std::make_shared<EntityAddToMapEvent>(user));
 	_poiProvider.add(pos, poi::Type::SPAWN);
 }
@@ -191,7 +262,7 @@ bool Map::removeUser(EntityId id) {
 		return false;
 	}
 	UserPtr user = i->second;
-	_quadTree.remove(QuadTreeNode { user });
+	_interest.remove(id, _visibleDeltaFunc);
 	_users.erase(i);
 	_eventBus->enqueue(std::make_shared<EntityRemoveFromMapEvent>(user));
 	return true;
@@ -214,7 +285,7 @@ bool Map::addNpc(const NpcPtr& npc) {
 	const glm::vec3& pos = findStartPosition(npc);
 	npc->setMap(ptr(), pos);
 	_zone->addAI(npc->ai());
-	_quadTree.insert(QuadTreeNode { npc });
+	_interest.add(npc->id(), pos, (float)npc->current(attrib::Type::VIEWDISTANCE));
 	_eventBus->enqueue(std::make_shared<EntityAddToMapEvent>(npc));
 	_poiProvider.add(pos, poi::Type::SPAWN);
 	return true;
@@ -226,7 +297,7 @@ bool Map::removeNpc(EntityId id) {
 		return false;
 	}
 	NpcPtr npc = i->second;
-	_quadTree.remove(QuadTreeNode { npc });
+	_interest.remove(id, _visibleDeltaFunc);
 	_npcs.erase(i);
 	_zone->removeAI(npc->id());
 	_eventBus->enqueue(std::make_shared<EntityRemoveFromMapEvent>(npc));
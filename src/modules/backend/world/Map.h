@@ -5,8 +5,6 @@
 #pragma once
 
 #include "backend/ForwardDecl.h"
-#include "math/QuadTree.h"
-#include "math/Rect.h"
 #include "core/Common.h"
 #include "core/FourCC.h"
 #include "ai-shared/common/CharacterId.h"
@@ -18,7 +16,9 @@
 #include "poi/PoiProvider.h"
 #include "backend/spawn/SpawnMgr.h"
 #include "voxel/Constants.h"
+#include "voxel/PagedVolume.h"
 #include "DBChunkPersister.h"
+#include "InterestGrid.h"
 #include "MapId.h"
 #include <memory>
 #include <unordered_map>
@@ -57,15 +57,29 @@ private:
 	poi::PoiProvider _poiProvider;
 	SpawnMgr _spawnMgr;
 
-	struct QuadTreeNode {
-		EntityPtr entity;
+	/**
+	 * @brief Tracks which entities are visible for each other - only the entities that changed their cell are
+	 * evaluated in a tick.
+	 */
+	InterestGrid _interest;
+	InterestGrid::DeltaFunc _visibleDeltaFunc;
+	void applyVisibleDelta(EntityId observer, const InterestGrid::EntityIds& added, const InterestGrid::EntityIds& removed);
+	EntityPtr entity(EntityId id) const;
+	DBChunkPersisterPtr _chunkPersister;
 
-		math::RectFloat getRect() const;
-		bool operator==(const QuadTreeNode& rhs) const;
-	};
+	static constexpr long VolumeMetricsIntervalMillis = 10000l;
+	long _volumeMetricsDelta = 0l;
+	// the last reported values to only send the deltas of the counters
+	voxel::PagedVolume::Metrics _volumeMetrics;
+	DBChunkPersister::Metrics _persisterMetrics;
+	void sendVolumeMetrics();
 
-	math::QuadTree<QuadTreeNode, float> _quadTree;
-	DBChunkPersisterPtr _chunkPersister;
+	/**
+	 * @brief The chunks around the users are generated in the background before they are needed
+	 */
+	static constexpr long PrefetchIntervalMillis = 1000l;
+	long _prefetchDelta = 0l;
+	void prefetchChunks();
 	/**
 	 * @return @c false if the entity should be removed from the server.
 	 */
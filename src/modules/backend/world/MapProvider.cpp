@@ -14,6 +14,7 @@
 #include "attrib/ContainerProvider.h"
 #include "voxel/PagedVolume.h"
 #include "voxelworld/WorldMgr.h"
+#include "voxelworld/ChunkStream.h"
 #include <glm/vec3.hpp>
 
 namespace backend {
@@ -39,6 +40,21 @@ MapProvider::MapProvider(
 		_chunkPersisterFactory(chunkPersisterFactory), _dbHandler(dbHandler) {
 }
 
+/**
+ * @brief Loads the compressed chunk at the given world position - the chunk is generated if it wasn't persisted yet
+ */
+static persistence::Blob loadChunk(const MapPtr& map, int x, int y, int z, unsigned int seed) {
+	const DBChunkPersisterPtr& persister = map->chunkPersister();
+	voxel::PagedVolume* volume = map->worldMgr()->volumeData();
+	const glm::ivec3& chunkPos = volume->chunkPos(x, y, z);
+	persistence::Blob blob = persister->load(chunkPos.x, chunkPos.y, chunkPos.z, map->id(), seed);
+	if (blob.length <= 0) {
+		(void)volume->voxel(x, y, z);
+		blob = persister->load(chunkPos.x, chunkPos.y, chunkPos.z, map->id(), seed);
+	}
+	return blob;
+}
+
 MapProvider::~MapProvider() {
 	shutdown();
 }
@@ -86,28 +102,49 @@ bool MapProvider::init() {
 			response->setText("Map with given id not found");
 			return;
 		}
-		const DBChunkPersisterPtr& persister = m->chunkPersister();
-		voxelworld::WorldMgr* worldMgr = m->worldMgr();
-		voxel::PagedVolume* volume = worldMgr->volumeData();
-		const glm::ivec3& chunkPos = volume->chunkPos(x, y, z);
-		const core::VarPtr& seed = core::Var::getSafe(cfg::ServerSeed);
-		persistence::Blob blob = persister->load(chunkPos.x, chunkPos.y, chunkPos.z, mapid, seed->uintVal());
+		const unsigned int seed = core::Var::getSafe(cfg::ServerSeed)->uintVal();
+		persistence::Blob blob = loadChunk(m, x, y, z, seed);
 		if (blob.length <= 0) {
-			(void)volume->voxel(x, y, z);
-			blob = persister->load(chunkPos.x, chunkPos.y, chunkPos.z, mapid, seed->uintVal());
-			if (blob.length <= 0) {
-				response->status = http::HttpStatus::NotFound;
-				response->setText(core::string::format("Chunk not found at %i:%i:%i on map %i with seed %u",
-						chunkPos.x, chunkPos.y, chunkPos.z, mapid, seed->uintVal()));
-				return;
-			}
+			response->status = http::HttpStatus::NotFound;
+			response->setText(core::string::format("Chunk not found at %i:%i:%i on map %i with seed %u",
+					x, y, z, mapid, seed));
+			return;
 		}
-		response->body = (char*)core_malloc(blob.length);
-		core_memcpy((void*)response->body, blob.data, blob.length);
-		response->freeBody = true;
-		response->contentLength(blob.length);
+		// the blob is sent from the memory of the database result and released after it was sent
+		response->setBody((const char*)blob.data, blob.length, [blob] (const char *body) mutable {
+			blob.release();
+		});
 		response->headers.put(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_CHUNK);
-		blob.release();
+	});
+
+	// the chunks are given as list of world positions and streamed back one by one as soon as they are loaded
+	_httpServer->registerRoute(http::HttpMethod::GET, "/chunk/stream", [&] (const http::RequestParser& request, http::HttpResponse* response) {
+		core_trace_scoped(ChunkStream);
+		HTTP_QUERY_GET_INT(mapid);
+		const char *chunks;
+		core::DynamicArray<glm::ivec3> positions;
+		if (!request.query.get("chunks", chunks) || !voxelworld::ChunkStream::parsePositions(chunks, positions)) {
+			response->status = http::HttpStatus::BadRequest;
+			response->setText("Invalid chunks parameter");
+			return;
+		}
+		const MapPtr& m = map(mapid);
+		if (!m) {
+			response->status = http::HttpStatus::NotFound;
+			response->setText("Map with given id not found");
+			return;
+		}
+		const unsigned int seed = core::Var::getSafe(cfg::ServerSeed)->uintVal();
+		size_t index = 0u;
+		response->headers.put(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_CHUNK_STREAM);
+		response->stream = [m, positions, seed, index] (core::ByteStream& out) mutable {
+			core_trace_scoped(ChunkStreamFrame);
+			const glm::ivec3& pos = positions[index++];
+			persistence::Blob blob = loadChunk(m, pos.x, pos.y, pos.z, seed);
+			voxelworld::ChunkStream::writeFrame(out, pos, blob.data, (uint32_t)blob.length);
+			blob.release();
+			return index < positions.size();
+		};
 	});
 
 	const MapId mapId = 1;
@@ -126,6 +163,7 @@ bool MapProvider::init() {
 
 void MapProvider::shutdown() {
 	_httpServer->unregisterRoute(http::HttpMethod::GET, "/chunk");
+	_httpServer->unregisterRoute(http::HttpMethod::GET, "/chunk/stream");
 	for (const auto& map : _maps) {
 		map->value->shutdown();
 	}
@@ -54,14 +54,20 @@ constexpr const char *ServerPort = "sv_port";
 constexpr const char *ServerMaxClients = "sv_maxclients";
 constexpr const char *ServerPostgresLib = "sv_postgreslib";
 constexpr const char *ServerHttpPort = "sv_httpport";
+// the amount of threads the http route handlers run on - 0 to run them in the server loop
+constexpr const char *ServerHttpWorkers = "sv_httpworkers";
 // the download urls for the chunks
 constexpr const char *ServerChunkBaseUrl = "sv_httpchunkurl";
+// update the npcs of a map in batches that share the behaviour tree
+constexpr const char *ServerAIBatchedTick = "sv_aibatchedtick";
 
 constexpr const char *ConsoleCurses = "con_curses";
 
 constexpr const char *CoreMaxFPS = "core_maxfps";
 constexpr const char *CoreLogLevel = "core_loglevel";
 constexpr const char *CoreSysLog = "core_syslog";
+constexpr const char *CoreLogAsync = "core_logasync";
+constexpr const char *CoreLogAsyncBlock = "core_logasyncblock";
 constexpr const char *CorePath = "core_path";
 
 // The size of the chunk that is extracted with each step
@@ -81,5 +87,6 @@ constexpr const char *AppBasePath = "app_basepath";
 constexpr const char *MetricPort = "metric_port";
 constexpr const char *MetricHost = "metric_host";
 constexpr const char *MetricFlavor = "metric_flavor";
+constexpr const char *MetricFlushInterval = "metric_flushinterval";
 
 }
@@ -10,8 +10,13 @@
 #include "core/Enum.h"
 #include "core/ArrayLength.h"
 #include "core/Assert.h"
+#include "core/concurrent/Semaphore.h"
+#include "core/concurrent/Thread.h"
+#include <SDL_atomic.h>
+#include <SDL_timer.h>
 #include <string.h>
 #include <stdio.h>
+#include <atomic>
 #include <unordered_map>
 
 #ifdef HAVE_SYSLOG_H
@@ -34,9 +39,10 @@
 #define ANSI_COLOR_CYAN ""
 #endif
 
-static bool _syslog = false;
+// read by the log thread and the logging threads - Log::init() might be called while they are running
+static std::atomic<bool> _syslog { false };
 static constexpr int bufSize = 4096;
-static SDL_LogPriority _logLevel = SDL_LOG_PRIORITY_INFO;
+static std::atomic<SDL_LogPriority> _logLevel { SDL_LOG_PRIORITY_INFO };
 static std::unordered_map<uint32_t, int> _logActive;
 
 #ifdef HAVE_SYSLOG_H
@@ -62,6 +68,269 @@ static void sysLogOutputFunction(void *userdata, int category, SDL_LogPriority p
 }
 #endif
 
+static const char* logColor(SDL_LogPriority priority) {
+	switch (priority) {
+	case SDL_LOG_PRIORITY_VERBOSE:
+	case SDL_LOG_PRIORITY_INFO:
+		return ANSI_COLOR_GREEN;
+	case SDL_LOG_PRIORITY_DEBUG:
+		return ANSI_COLOR_BLUE;
+	case SDL_LOG_PRIORITY_WARN:
+		return ANSI_COLOR_YELLOW;
+	default:
+		return ANSI_COLOR_RED;
+	}
+}
+
+/**
+ * @param[in] timestamp The time of the log call - only added for the messages of the asynchronous sink
+ */
+static void output(SDL_LogPriority priority, uint32_t id, const char *buf, const char *timestamp) {
+	if (_syslog) {
+		SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, priority, "(%u) %s%s\n", id, timestamp, buf);
+	} else {
+		SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, priority, "(%u) %s%s%s" ANSI_COLOR_RESET "\n", id, timestamp, logColor(priority), buf);
+	}
+}
+
+/**
+ * The asynchronous log sink: the calling thread formats the message into a slot of a bounded lock free queue
+ * (multiple producers and consumers, see http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue)
+ * and the log thread writes them. @c Log::flush() can drain the queue from any thread - e.g. a crash handler.
+ * Messages that don't fit into a slot are queued with a heap allocated copy.
+ */
+static constexpr int asyncMessageSize = 512;
+
+struct LogRecord {
+	uint32_t ticks;
+	uint32_t id;
+	SDL_LogPriority priority;
+	// the message if it doesn't fit into the record - released after it was written
+	char *payload;
+	char message[asyncMessageSize];
+};
+
+struct LogCell {
+	SDL_atomic_t sequence;
+	LogRecord record;
+};
+
+static LogCell _logCells[Log::AsyncQueueSize];
+static SDL_atomic_t _enqueuePos;
+static SDL_atomic_t _dequeuePos;
+static SDL_atomic_t _droppedMessages;
+static SDL_atomic_t _reportedDroppedMessages;
+static std::atomic<bool> _async { false };
+static std::atomic<bool> _asyncBlock { false };
+// the threads that are currently putting a message into the queue
+static std::atomic<int> _asyncProducers { 0 };
+static SDL_atomic_t _logThreadRunning;
+static core::Thread* _logThread = nullptr;
+static core::Semaphore* _logThreadSemaphore = nullptr;
+
+static_assert((Log::AsyncQueueSize & (Log::AsyncQueueSize - 1)) == 0, "The queue size must be a power of two");
+
+static inline int sequenceDiff(int sequence, int pos) {
+	return (int)((unsigned int)sequence - (unsigned int)pos);
+}
+
+/**
+ * @param[in] payload The heap allocated message if it doesn't fit into the record - @c nullptr otherwise
+ */
+static bool enqueue(SDL_LogPriority priority, uint32_t id, const char *buf, size_t len, char *payload) {
+	int pos = SDL_AtomicGet(&_enqueuePos);
+	LogCell* cell;
+	for (;;) {
+		cell = &_logCells[pos & (Log::AsyncQueueSize - 1)];
+		const int diff = sequenceDiff(SDL_AtomicGet(&cell->sequence), pos);
+		if (diff == 0) {
+			if (SDL_AtomicCAS(&_enqueuePos, pos, (int)((unsigned int)pos + 1u))) {
+				break;
+			}
+			pos = SDL_AtomicGet(&_enqueuePos);
+		} else if (diff < 0) {
+			// full
+			return false;
+		} else {
+			pos = SDL_AtomicGet(&_enqueuePos);
+		}
+	}
+	LogRecord& record = cell->record;
+	record.ticks = SDL_GetTicks();
+	record.id = id;
+	record.priority = priority;
+	record.payload = payload;
+	if (payload == nullptr) {
+		SDL_memcpy(record.message, buf, len + 1);
+	} else {
+		record.message[0] = '\0';
+	}
+	SDL_AtomicSet(&cell->sequence, (int)((unsigned int)pos + 1u));
+	return true;
+}
+
+static bool dequeue(LogRecord& record) {
+	int pos = SDL_AtomicGet(&_dequeuePos);
+	LogCell* cell;
+	for (;;) {
+		cell = &_logCells[pos & (Log::AsyncQueueSize - 1)];
+		const int diff = sequenceDiff(SDL_AtomicGet(&cell->sequence), (int)((unsigned int)pos + 1u));
+		if (diff == 0) {
+			if (SDL_AtomicCAS(&_dequeuePos, pos, (int)((unsigned int)pos + 1u))) {
+				break;
+			}
+			pos = SDL_AtomicGet(&_dequeuePos);
+		} else if (diff < 0) {
+			// empty
+			return false;
+		} else {
+			pos = SDL_AtomicGet(&_dequeuePos);
+		}
+	}
+	const size_t len = SDL_strlen(cell->record.message);
+	record.ticks = cell->record.ticks;
+	record.id = cell->record.id;
+	record.priority = cell->record.priority;
+	record.payload = cell->record.payload;
+	SDL_memcpy(record.message, cell->record.message, len + 1);
+	SDL_AtomicSet(&cell->sequence, (int)((unsigned int)pos + (unsigned int)Log::AsyncQueueSize));
+	return true;
+}
+
+/**
+ * @return The amount of written messages
+ */
+static int drain() {
+	LogRecord record;
+	char timestamp[32];
+	int written = 0;
+	while (dequeue(record)) {
+		SDL_snprintf(timestamp, sizeof(timestamp), "[%u.%03u] ", record.ticks / 1000u, record.ticks % 1000u);
+		if (record.payload != nullptr) {
+			output(record.priority, record.id, record.payload, timestamp);
+			SDL_free(record.payload);
+		} else {
+			output(record.priority, record.id, record.message, timestamp);
+		}
+		++written;
+	}
+	const int dropped = SDL_AtomicGet(&_droppedMessages);
+	const int reported = SDL_AtomicGet(&_reportedDroppedMessages);
+	if (dropped != reported && SDL_AtomicCAS(&_reportedDroppedMessages, reported, dropped)) {
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Dropped %i log messages - the log queue was full\n", dropped - reported);
+	}
+	return written;
+}
+
+static int logThread(void *) {
+	while (SDL_AtomicGet(&_logThreadRunning)) {
+		if (drain() == 0) {
+			_logThreadSemaphore->waitTimeout(5);
+		}
+	}
+	return 0;
+}
+
+static void initAsync() {
+	if (_logThread != nullptr) {
+		return;
+	}
+	static bool cellsInitialized = false;
+	if (!cellsInitialized) {
+		for (int i = 0; i < Log::AsyncQueueSize; ++i) {
+			SDL_AtomicSet(&_logCells[i].sequence, i);
+		}
+		SDL_AtomicSet(&_enqueuePos, 0);
+		SDL_AtomicSet(&_dequeuePos, 0);
+		cellsInitialized = true;
+	}
+	SDL_AtomicSet(&_logThreadRunning, 1);
+	_logThreadSemaphore = new core::Semaphore(0);
+	_logThread = new core::Thread("Log", logThread);
+	_async = true;
+}
+
+static void shutdownAsync() {
+	if (_logThread == nullptr) {
+		return;
+	}
+	// stop the producers first - the ones that already saw the sink enabled are still served by the log thread
+	_async = false;
+	while (_asyncProducers > 0) {
+		SDL_Delay(0);
+	}
+	SDL_AtomicSet(&_logThreadRunning, 0);
+	_logThreadSemaphore->increase();
+	_logThread->join();
+	delete _logThread;
+	_logThread = nullptr;
+	delete _logThreadSemaphore;
+	_logThreadSemaphore = nullptr;
+	drain();
+}
+
+/**
+ * @return @c false if the message must be written synchronously
+ */
+static bool logAsync(SDL_LogPriority priority, uint32_t id, const char *buf) {
+	const size_t len = SDL_strlen(buf);
+	char *payload = nullptr;
+	if (len >= (size_t)asyncMessageSize) {
+		payload = (char*)SDL_malloc(len + 1);
+		SDL_memcpy(payload, buf, len + 1);
+	}
+	while (!enqueue(priority, id, buf, len, payload)) {
+		if (!_asyncBlock) {
+			SDL_free(payload);
+			SDL_AtomicIncRef(&_droppedMessages);
+			return true;
+		}
+		if (!SDL_AtomicGet(&_logThreadRunning)) {
+			SDL_free(payload);
+			return false;
+		}
+		SDL_Delay(1);
+	}
+	return true;
+}
+
+static void logVA(SDL_LogPriority priority, uint32_t id, const char *msg, va_list args) {
+	char buf[bufSize];
+	SDL_vsnprintf(buf, sizeof(buf), msg, args);
+	buf[sizeof(buf) - 1] = '\0';
+	va_end(args);
+	if (_async) {
+		// shutdownAsync() waits for the producers - check the sink again after being counted
+		++_asyncProducers;
+		const bool queued = _async && logAsync(priority, id, buf);
+		--_asyncProducers;
+		if (queued) {
+			return;
+		}
+	}
+	output(priority, id, buf, "");
+}
+
+static inline void traceVA(uint32_t id, const char *msg, va_list args) {
+	logVA(SDL_LOG_PRIORITY_VERBOSE, id, msg, args);
+}
+
+static inline void debugVA(uint32_t id, const char *msg, va_list args) {
+	logVA(SDL_LOG_PRIORITY_DEBUG, id, msg, args);
+}
+
+static inline void infoVA(uint32_t id, const char *msg, va_list args) {
+	logVA(SDL_LOG_PRIORITY_INFO, id, msg, args);
+}
+
+static inline void warnVA(uint32_t id, const char *msg, va_list args) {
+	logVA(SDL_LOG_PRIORITY_WARN, id, msg, args);
+}
+
+static inline void errorVA(uint32_t id, const char *msg, va_list args) {
+	logVA(SDL_LOG_PRIORITY_ERROR, id, msg, args);
+}
+
 Log::Level Log::toLogLevel(const char* level) {
 	const core::String string(level);
 	if (core::string::iequals(string, "trace")) {
@@ -132,11 +401,27 @@ void Log::init() {
 #endif
 		_syslog = false;
 	}
+
+	_asyncBlock = core::Var::get(cfg::CoreLogAsyncBlock, "false")->boolVal();
+	if (core::Var::get(cfg::CoreLogAsync, "false")->boolVal()) {
+		initAsync();
+	} else {
+		shutdownAsync();
+	}
+}
+
+void Log::flush() {
+	drain();
+}
+
+int Log::dropped() {
+	return SDL_AtomicGet(&_droppedMessages);
 }
 
 void Log::shutdown() {
 	// this is one of the last methods that is executed - so don't rely on anything
 	// still being available here - it won't
+	shutdownAsync();
 #ifdef HAVE_SYSLOG_H
 	if (_syslog) {
 		SDL_LogSetOutputFunction(_sdlCallback, _sdlCallbackUserData);
@@ -150,66 +435,6 @@ void Log::shutdown() {
 	_syslog = false;
 }
 
-static void traceVA(uint32_t id, const char *msg, va_list args) {
-	char buf[bufSize];
-	SDL_vsnprintf(buf, sizeof(buf), msg, args);
-	buf[sizeof(buf) - 1] = '\0';
-	if (_syslog) {
-		SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "(%u) %s\n", id, buf);
-	} else {
-		SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "(%u) " ANSI_COLOR_GREEN "%s" ANSI_COLOR_RESET "\n", id, buf);
-	}
-	va_end(args);
-}
-
-static void debugVA(uint32_t id, const char *msg, va_list args) {
-	char buf[bufSize];
-	SDL_vsnprintf(buf, sizeof(buf), msg, args);
-	buf[sizeof(buf) - 1] = '\0';
-	if (_syslog) {
-		SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "(%u) %s\n", id, buf);
-	} else {
-		SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "(%u) " ANSI_COLOR_BLUE "%s" ANSI_COLOR_RESET "\n", id, buf);
-	}
-	va_end(args);
-}
-
-static void infoVA(uint32_t id, const char *msg, va_list args) {
-	char buf[bufSize];
-	SDL_vsnprintf(buf, sizeof(buf), msg, args);
-	buf[sizeof(buf) - 1] = '\0';
-	if (_syslog) {
-		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "(%u) %s\n", id, buf);
-	} else {
-		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "(%u) " ANSI_COLOR_GREEN "%s" ANSI_COLOR_RESET "\n", id, buf);
-	}
-	va_end(args);
-}
-
-static void warnVA(uint32_t id, const char *msg, va_list args) {
-	char buf[bufSize];
-	SDL_vsnprintf(buf, sizeof(buf), msg, args);
-	buf[sizeof(buf) - 1] = '\0';
-	if (_syslog) {
-		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "(%u) %s\n", id, buf);
-	} else {
-		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "(%u) " ANSI_COLOR_YELLOW "%s" ANSI_COLOR_RESET "\n", id, buf);
-	}
-	va_end(args);
-}
-
-static void errorVA(uint32_t id, const char *msg, va_list args) {
-	char buf[bufSize];
-	SDL_vsnprintf(buf, sizeof(buf), msg, args);
-	buf[sizeof(buf) - 1] = '\0';
-	if (_syslog) {
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "(%u) %s\n", id, buf);
-	} else {
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "(%u) " ANSI_COLOR_RED "%s" ANSI_COLOR_RESET "\n", id, buf);
-	}
-	va_end(args);
-}
-
 void Log::trace(const char* msg, ...) {
 	if (_logLevel > SDL_LOG_PRIORITY_VERBOSE) {
 		return;
@@ -25,8 +25,26 @@ public:
 	static Level toLogLevel(const char* level);
 	static const char* toLogLevel(Level level);
 
+	/**
+	 * @brief The amount of messages the asynchronous log sink can queue
+	 */
+	static constexpr int AsyncQueueSize = 1024;
+
+	/**
+	 * @note Reads the @c core_logasync cvar to write the messages on a log thread instead of the calling thread and
+	 * @c core_logasyncblock to block the calling thread instead of dropping the message if the queue is full
+	 */
 	static void init();
 	static void shutdown();
+	/**
+	 * @brief Writes the queued messages of the asynchronous log sink on the calling thread
+	 * @note Doesn't wait for the log thread - can be used in a crash handler
+	 */
+	static void flush();
+	/**
+	 * @return The amount of messages that were dropped because the asynchronous log queue was full
+	 */
+	static int dropped();
 	static void trace(CORE_FORMAT_STRING const char* msg, ...) CORE_PRINTF_VARARG_FUNC(1);
 	static void debug(CORE_FORMAT_STRING const char* msg, ...) CORE_PRINTF_VARARG_FUNC(1);
 	static void info(CORE_FORMAT_STRING const char* msg, ...) CORE_PRINTF_VARARG_FUNC(1);
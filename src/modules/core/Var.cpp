@@ -83,13 +83,16 @@ glm::vec3 Var::vec3Val() const {
 }
 
 VarPtr Var::get(const core::String& name, const char* value, int32_t flags, const char *help, ValidatorFunc validatorFunc) {
-	VarMap::iterator i;
-	bool missing;
+	VarPtr v;
 	{
+		// copy the var - the iterator is invalidated as soon as another thread adds a var
 		ScopedReadLock lock(_lock);
-		i = _vars.find(name);
-		missing = i == _vars.end();
+		auto i = _vars.find(name);
+		if (i != _vars.end()) {
+			v = i->second;
+		}
 	}
+	const bool missing = !v;
 
 	uint32_t flagsMask = flags < 0 ? 0u : static_cast<uint32_t>(flags);
 	if (missing) {
@@ -119,7 +122,6 @@ VarPtr Var::get(const core::String& name, const char* value, int32_t flags, cons
 		_vars.put(name, p);
 		return p;
 	}
-	const VarPtr& v = i->second;
 	if (flags >= 0) {
 		if ((flagsMask & CV_FROMFILE) == CV_FROMFILE && (v->_flags & (CV_FROMCOMMANDLINE | CV_FROMENV)) == 0u) {
 			Log::debug("Look for env var to resolve value of %s", name.c_str());
@@ -8,7 +8,7 @@
 #include "core/GameConfig.h"
 #include "core/SharedPtr.h"
 #include "core/String.h"
-#include "core/collection/Map.h"
+#include "core/collection/DynamicMap.h"
 #include "core/collection/DynamicArray.h"
 #include <string.h>
 #include <glm/fwd.hpp>
@@ -62,7 +62,7 @@ public:
 	typedef bool (*ValidatorFunc)(const core::String& value);
 protected:
 	friend class SharedPtr<Var>;
-	typedef Map<core::String, VarPtr, 64, core::StringHash> VarMap;
+	typedef DynamicMap<core::String, VarPtr, 64, core::StringHash> VarMap;
 	static VarMap _vars;
 	static ReadWriteLock _lock;
 
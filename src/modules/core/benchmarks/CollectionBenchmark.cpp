@@ -1,6 +1,11 @@
 #include "app/benchmark/AbstractBenchmark.h"
 #include "core/collection/Map.h"
+#include "core/collection/DynamicMap.h"
 #include "core/Assert.h"
+#include "core/GLM.h"
+#include "core/String.h"
+#include <glm/gtx/hash.hpp>
+#include <vector>
 #include <unordered_map>
 #include <map>
 
@@ -53,6 +58,130 @@ BENCHMARK_DEFINE_F(MapBenchmark, compareToMapCore) (benchmark::State& state) {
 	}
 }
 
+BENCHMARK_DEFINE_F(MapBenchmark, compareToDynamicMapCore) (benchmark::State& state) {
+	core::DynamicMap<int64_t, int64_t, 4096, std::hash<int64_t>> map;
+	for (auto _ : state) {
+		const int64_t n = state.range(0);
+		for (int64_t i = 0; i < n; ++i) {
+			map.put(i, i);
+			int64_t value;
+			const bool found = map.get(i, value);
+			if (!found || value != i) {
+				state.SkipWithError("Failed!");
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Fills the map with the given amount of entries and looks all of them up again
+ */
+class MapEntriesBenchmark: public app::AbstractBenchmark {
+protected:
+	std::vector<glm::ivec3> _positions;
+	std::vector<core::String> _strings;
+
+	void fillKeys(int64_t n) {
+		_positions.clear();
+		_strings.clear();
+		_positions.reserve(n);
+		_strings.reserve(n);
+		// chunk positions of a world that grows around the origin
+		const int sideLength = (int)glm::ceil(glm::sqrt((double)n));
+		for (int64_t i = 0; i < n; ++i) {
+			_positions.emplace_back((int)(i % sideLength) - sideLength / 2, (int)(i & 7), (int)(i / sideLength) - sideLength / 2);
+			_strings.emplace_back(core::String::format("cl_var_%i", (int)i));
+		}
+	}
+
+	template<class MAP, class KEY>
+	void run(benchmark::State& state, MAP& map, const std::vector<KEY>& keys) {
+		for (auto _ : state) {
+			map.clear();
+			int64_t value = 0;
+			for (size_t i = 0; i < keys.size(); ++i) {
+				map.put(keys[i], (int64_t)i);
+			}
+			for (size_t i = 0; i < keys.size(); ++i) {
+				if (!map.get(keys[i], value) || value != (int64_t)i) {
+					state.SkipWithError("Failed!");
+					return;
+				}
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * (int64_t)keys.size());
+	}
+
+	template<class KEY, class HASH>
+	void runStd(benchmark::State& state, const std::vector<KEY>& keys) {
+		std::unordered_map<KEY, int64_t, HASH> map;
+		for (auto _ : state) {
+			map.clear();
+			for (size_t i = 0; i < keys.size(); ++i) {
+				map[keys[i]] = (int64_t)i;
+			}
+			for (size_t i = 0; i < keys.size(); ++i) {
+				auto iter = map.find(keys[i]);
+				if (iter == map.end() || iter->second != (int64_t)i) {
+					state.SkipWithError("Failed!");
+					return;
+				}
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * (int64_t)keys.size());
+	}
+};
+
+struct StdStringHash {
+	inline size_t operator()(const core::String& s) const {
+		return core::StringHash()(s);
+	}
+};
+
+BENCHMARK_DEFINE_F(MapEntriesBenchmark, ivec3MapCore) (benchmark::State& state) {
+	fillKeys(state.range(0));
+	core::Map<glm::ivec3, int64_t, 64, glm::hash<glm::ivec3>> map((int)state.range(0));
+	run(state, map, _positions);
+}
+
+BENCHMARK_DEFINE_F(MapEntriesBenchmark, ivec3DynamicMapCore) (benchmark::State& state) {
+	fillKeys(state.range(0));
+	core::DynamicMap<glm::ivec3, int64_t, 64, glm::hash<glm::ivec3>> map;
+	run(state, map, _positions);
+}
+
+BENCHMARK_DEFINE_F(MapEntriesBenchmark, ivec3UnorderedMapStd) (benchmark::State& state) {
+	fillKeys(state.range(0));
+	runStd<glm::ivec3, glm::hash<glm::ivec3>>(state, _positions);
+}
+
+BENCHMARK_DEFINE_F(MapEntriesBenchmark, stringMapCore) (benchmark::State& state) {
+	fillKeys(state.range(0));
+	core::Map<core::String, int64_t, 64, core::StringHash> map((int)state.range(0));
+	run(state, map, _strings);
+}
+
+BENCHMARK_DEFINE_F(MapEntriesBenchmark, stringDynamicMapCore) (benchmark::State& state) {
+	fillKeys(state.range(0));
+	core::DynamicMap<core::String, int64_t, 64, core::StringHash> map;
+	run(state, map, _strings);
+}
+
+BENCHMARK_DEFINE_F(MapEntriesBenchmark, stringUnorderedMapStd) (benchmark::State& state) {
+	fillKeys(state.range(0));
+	runStd<core::String, StdStringHash>(state, _strings);
+}
+
+BENCHMARK_REGISTER_F(MapEntriesBenchmark, ivec3DynamicMapCore)->RangeMultiplier(10)->Range(10000, 1000000);
+BENCHMARK_REGISTER_F(MapEntriesBenchmark, ivec3UnorderedMapStd)->RangeMultiplier(10)->Range(10000, 1000000);
+BENCHMARK_REGISTER_F(MapEntriesBenchmark, stringDynamicMapCore)->RangeMultiplier(10)->Range(10000, 1000000);
+BENCHMARK_REGISTER_F(MapEntriesBenchmark, stringUnorderedMapStd)->RangeMultiplier(10)->Range(10000, 1000000);
+// the fixed bucket map degrades to a linked list walk - 1m entries would take ages
+BENCHMARK_REGISTER_F(MapEntriesBenchmark, ivec3MapCore)->RangeMultiplier(10)->Range(10000, 100000);
+BENCHMARK_REGISTER_F(MapEntriesBenchmark, stringMapCore)->RangeMultiplier(10)->Range(10000, 100000);
+
+BENCHMARK_REGISTER_F(MapBenchmark, compareToDynamicMapCore)->RangeMultiplier(2)->Range(8, 512);
 BENCHMARK_REGISTER_F(MapBenchmark, compareToMapCore)->RangeMultiplier(2)->Range(8, 512);
 BENCHMARK_REGISTER_F(MapBenchmark, compareToMapStd)->RangeMultiplier(2)->Range(8, 512);
 BENCHMARK_REGISTER_F(MapBenchmark, compareToUnorderedMapStd)->RangeMultiplier(2)->Range(8, 512);
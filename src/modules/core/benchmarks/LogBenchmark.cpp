@@ -0,0 +1,92 @@
+/**
+ * @file
+ */
+
+#include <benchmark/benchmark.h>
+#include "core/Log.h"
+#include "core/GameConfig.h"
+#include "core/Var.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+static FILE* _devNull = nullptr;
+static SDL_LogOutputFunction _outputFunction = nullptr;
+static void *_outputUserData = nullptr;
+
+static void devNullOutput(void *, int, SDL_LogPriority, const char *message) {
+	if (_devNull == nullptr) {
+		return;
+	}
+	fputs(message, _devNull);
+	fflush(_devNull);
+}
+
+static void setUp(benchmark::State& state, bool async, bool block) {
+	if (state.thread_index != 0) {
+		return;
+	}
+	_devNull = fopen(NULL_DEVICE, "w");
+	if (_devNull == nullptr) {
+		state.SkipWithError("Could not open " NULL_DEVICE);
+	}
+	SDL_LogGetOutputFunction(&_outputFunction, &_outputUserData);
+	SDL_LogSetOutputFunction(devNullOutput, nullptr);
+	core::Var::get(cfg::CoreLogLevel, SDL_LOG_PRIORITY_INFO)->setVal(SDL_LOG_PRIORITY_INFO);
+	core::Var::get(cfg::CoreSysLog, "false")->setVal(false);
+	core::Var::get(cfg::CoreLogAsync, "false")->setVal(async);
+	core::Var::get(cfg::CoreLogAsyncBlock, "false")->setVal(block);
+	Log::init();
+}
+
+static void tearDown(benchmark::State& state, int droppedBefore) {
+	if (state.thread_index != 0) {
+		return;
+	}
+	core::Var::get(cfg::CoreLogAsync, "false")->setVal(false);
+	Log::init();
+	state.counters["dropped"] = Log::dropped() - droppedBefore;
+	SDL_LogSetOutputFunction(_outputFunction, _outputUserData);
+	if (_devNull != nullptr) {
+		fclose(_devNull);
+		_devNull = nullptr;
+	}
+}
+
+/**
+ * @brief Measures the latency of a log call while multiple threads are logging. The messages are written to
+ * the null device like they would be written to a terminal - with the locking of the c library streams.
+ */
+static void run(benchmark::State& state, bool async, bool block) {
+	setUp(state, async, block);
+	const int droppedBefore = Log::dropped();
+	int i = 0;
+	for (auto _ : state) {
+		Log::info("benchmark message %i from thread %i with some more text", ++i, state.thread_index);
+	}
+	tearDown(state, droppedBefore);
+}
+
+static void BM_LogSync(benchmark::State& state) {
+	run(state, false, false);
+}
+
+static void BM_LogAsyncBlock(benchmark::State& state) {
+	run(state, true, true);
+}
+
+static void BM_LogAsyncDrop(benchmark::State& state) {
+	run(state, true, false);
+}
+
+// sustained logging - the async sink can't be faster than the output it is writing to
+BENCHMARK(BM_LogSync)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_LogAsyncBlock)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_LogAsyncDrop)->ThreadRange(1, 8)->UseRealTime();
+// bursts that fit into the async log queue
+BENCHMARK(BM_LogSync)->ThreadRange(1, 8)->Iterations(Log::AsyncQueueSize / 8)->UseRealTime();
+BENCHMARK(BM_LogAsyncBlock)->ThreadRange(1, 8)->Iterations(Log::AsyncQueueSize / 8)->UseRealTime();
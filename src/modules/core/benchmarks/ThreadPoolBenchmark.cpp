@@ -0,0 +1,161 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/Atomic.h"
+#include <queue>
+
+/**
+ * @brief The thread pool before the work stealing scheduler - one queue behind one mutex
+ */
+class SingleQueueThreadPool {
+private:
+	std::vector<std::thread> _workers;
+	std::queue<std::function<void()> > _tasks;
+	core_trace_mutex(core::Lock, _queueMutex, "SingleQueueThreadPool");
+	core::ConditionVariable _queueCondition;
+	bool _stop = false;
+public:
+	explicit SingleQueueThreadPool(size_t threads) {
+		for (size_t i = 0; i < threads; ++i) {
+			_workers.emplace_back([this] {
+				for (;;) {
+					std::function<void()> task;
+					{
+						core::ScopedLock lock(_queueMutex);
+						_queueCondition.wait(_queueMutex, [this] {
+							return _stop || !_tasks.empty();
+						});
+						if (_stop && _tasks.empty()) {
+							break;
+						}
+						task = core::move(_tasks.front());
+						_tasks.pop();
+					}
+					task();
+				}
+			});
+		}
+	}
+
+	~SingleQueueThreadPool() {
+		{
+			core::ScopedLock lock(_queueMutex);
+			_stop = true;
+		}
+		_queueCondition.notify_all();
+		for (std::thread &worker : _workers) {
+			worker.join();
+		}
+	}
+
+	template<class F>
+	std::future<void> enqueue(F&& f) {
+		auto task = std::make_shared<std::packaged_task<void()> >(std::forward<F>(f));
+		std::future<void> res = task->get_future();
+		{
+			core::ScopedLock lock(_queueMutex);
+			_tasks.emplace([task]() {(*task)();});
+		}
+		_queueCondition.notify_one();
+		return res;
+	}
+};
+
+class ThreadPoolBenchmark: public app::AbstractBenchmark {
+protected:
+	static constexpr int Tasks = 10000;
+	core::AtomicInt _done { 0 };
+
+	// some work that doesn't get optimized away
+	static void work(int iterations) {
+		uint32_t value = 0u;
+		for (int i = 0; i < iterations; ++i) {
+			value = value * 1664525u + 1013904223u;
+			benchmark::DoNotOptimize(value);
+		}
+	}
+
+	void wait(int tasks) {
+		while (_done < tasks) {
+			std::this_thread::yield();
+		}
+		_done = 0;
+	}
+};
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, enqueueSingleQueue) (benchmark::State& state) {
+	SingleQueueThreadPool pool((size_t)state.range(0));
+	for (auto _ : state) {
+		for (int i = 0; i < Tasks; ++i) {
+			pool.enqueue([this] () { ++_done; });
+		}
+		wait(Tasks);
+	}
+	state.SetItemsProcessed(state.iterations() * Tasks);
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, enqueue) (benchmark::State& state) {
+	core::ThreadPool pool((size_t)state.range(0));
+	pool.init();
+	for (auto _ : state) {
+		for (int i = 0; i < Tasks; ++i) {
+			pool.enqueue([this] () { ++_done; });
+		}
+		wait(Tasks);
+	}
+	state.SetItemsProcessed(state.iterations() * Tasks);
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, schedule) (benchmark::State& state) {
+	core::ThreadPool pool((size_t)state.range(0));
+	pool.init();
+	for (auto _ : state) {
+		for (int i = 0; i < Tasks; ++i) {
+			pool.schedule([this] () { ++_done; });
+		}
+		wait(Tasks);
+	}
+	state.SetItemsProcessed(state.iterations() * Tasks);
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, workSingleQueue) (benchmark::State& state) {
+	SingleQueueThreadPool pool((size_t)state.range(0));
+	for (auto _ : state) {
+		for (int i = 0; i < Tasks; ++i) {
+			pool.enqueue([this] () { work(1000); ++_done; });
+		}
+		wait(Tasks);
+	}
+	state.SetItemsProcessed(state.iterations() * Tasks);
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, work) (benchmark::State& state) {
+	core::ThreadPool pool((size_t)state.range(0));
+	pool.init();
+	for (auto _ : state) {
+		for (int i = 0; i < Tasks; ++i) {
+			pool.schedule([this] () { work(1000); ++_done; });
+		}
+		wait(Tasks);
+	}
+	state.SetItemsProcessed(state.iterations() * Tasks);
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, parallelFor) (benchmark::State& state) {
+	core::ThreadPool pool((size_t)state.range(0));
+	pool.init();
+	for (auto _ : state) {
+		pool.parallelFor(0, Tasks, [] (int) { work(1000); }, 64);
+	}
+	state.SetItemsProcessed(state.iterations() * Tasks);
+}
+
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, enqueueSingleQueue)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, enqueue)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, schedule)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, workSingleQueue)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, work)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, parallelFor)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
@@ -221,6 +221,15 @@ public:
 		checkBufferSize(size);
 	}
 
+	/**
+	 * @brief Changes the size without initializing new elements - e.g. after the data was written to the reserved
+	 * memory of @c data()
+	 */
+	void resize(size_t size) {
+		checkBufferSize(size);
+		_size = size;
+	}
+
 	void clear() {
 		_size = 0u;
 	}
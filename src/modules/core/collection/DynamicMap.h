@@ -0,0 +1,403 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/collection/Map.h"
+#include "core/Assert.h"
+#include "core/StandardLib.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <initializer_list>
+
+namespace core {
+
+/**
+ * @brief Growable hash map with open addressing and linear probing.
+ *
+ * The hashes of the keys are stored in their own array - probing only touches this array until a slot with a
+ * matching hash is found. The capacity is always a power of two and doubles once the load factor would exceed
+ * 75%. Removing entries shifts the following entries of the probe sequence back, no tombstones are needed.
+ *
+ * The api is the same as for @c core::Map - the @c INITIALCAPACITY template parameter and the constructor
+ * parameter are only the initial capacity though and not an upper limit.
+ *
+ * @note Unlike @c core::Map inserting a new key might move the other entries - iterators and pointers to keys or
+ * values are invalidated by @c put(), @c emplace() and @c remove().
+ *
+ * @sa core::Map
+ * @ingroup Collections
+ */
+template<typename KEYTYPE, typename VALUETYPE, size_t INITIALCAPACITY = 16, typename HASHER = priv::DefaultHasher, typename COMPARE = priv::EqualCompare>
+class DynamicMap {
+public:
+	using value_type = VALUETYPE;
+	using key_type = KEYTYPE;
+
+	struct KeyValue {
+		inline KeyValue(const KEYTYPE& _key, const VALUETYPE& _value) :
+				key(_key), value(_value), first(key), second(value) {
+		}
+
+		inline KeyValue(const KEYTYPE& _key, VALUETYPE&& _value) :
+				key(_key), value(core::move(_value)), first(key), second(value) {
+		}
+
+		inline KeyValue(const KeyValue &other) :
+				key(other.key), value(other.value), first(key), second(value) {
+		}
+
+		inline KeyValue(KeyValue &&other) noexcept :
+				key(core::move(other.key)), value(core::move(other.value)), first(key), second(value) {
+		}
+
+		KEYTYPE key;
+		VALUETYPE value;
+		const KEYTYPE &first;
+		const VALUETYPE &second;
+	};
+private:
+	KeyValue *_slots = nullptr;
+	// 0 marks an empty slot - otherwise this is the hash of the key in the slot
+	uint32_t *_hashes = nullptr;
+	size_t _capacity = 0u;
+	size_t _size = 0u;
+	size_t _initialCapacity;
+	HASHER _hasher;
+
+	static inline size_t powerOfTwo(size_t n) {
+		size_t capacity = 8u;
+		while (capacity < n) {
+			capacity <<= 1;
+		}
+		return capacity;
+	}
+
+	inline uint32_t hash(const KEYTYPE& key) const {
+		// the hashers are often just returning the value of the key - mix the bits to
+		// not end up with long probe sequences for consecutive keys (murmur3 finalizer)
+		const uint64_t h64 = (uint64_t)_hasher(key);
+		uint32_t h = (uint32_t)(h64 ^ (h64 >> 32));
+		h ^= h >> 16;
+		h *= 0x85ebca6bu;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35u;
+		h ^= h >> 16;
+		return h == 0u ? 1u : h;
+	}
+
+	size_t findIndex(const KEYTYPE& key, uint32_t hashValue) const {
+		if (_size == 0u) {
+			return _capacity;
+		}
+		const size_t mask = _capacity - 1u;
+		for (size_t i = hashValue & mask;; i = (i + 1u) & mask) {
+			const uint32_t slotHash = _hashes[i];
+			if (slotHash == 0u) {
+				return _capacity;
+			}
+			if (slotHash == hashValue && COMPARE()(_slots[i].key, key)) {
+				return i;
+			}
+		}
+	}
+
+	/**
+	 * @return The index of the first free slot for the given hash. The key must not be part of the map.
+	 */
+	size_t freeIndex(uint32_t hashValue) const {
+		const size_t mask = _capacity - 1u;
+		size_t i = hashValue & mask;
+		while (_hashes[i] != 0u) {
+			i = (i + 1u) & mask;
+		}
+		return i;
+	}
+
+	void rehash(size_t newCapacity) {
+		KeyValue *oldSlots = _slots;
+		uint32_t *oldHashes = _hashes;
+		const size_t oldCapacity = _capacity;
+		_capacity = newCapacity;
+		_slots = (KeyValue*)core_malloc(_capacity * sizeof(KeyValue));
+		_hashes = (uint32_t*)core_malloc(_capacity * sizeof(uint32_t));
+		core_memset(_hashes, 0, _capacity * sizeof(uint32_t));
+		for (size_t i = 0u; i < oldCapacity; ++i) {
+			const uint32_t hashValue = oldHashes[i];
+			if (hashValue == 0u) {
+				continue;
+			}
+			const size_t idx = freeIndex(hashValue);
+			new ((void*)&_slots[idx]) KeyValue(core::move(oldSlots[i]));
+			_hashes[idx] = hashValue;
+			oldSlots[i].~KeyValue();
+		}
+		core_free(oldSlots);
+		core_free(oldHashes);
+	}
+
+	/**
+	 * @return The index of the slot that the caller must construct the new entry in.
+	 */
+	size_t prepareInsert(uint32_t hashValue) {
+		if (_capacity == 0u) {
+			rehash(powerOfTwo(_initialCapacity));
+		} else if ((_size + 1u) * 4u > _capacity * 3u) {
+			rehash(_capacity * 2u);
+		}
+		const size_t idx = freeIndex(hashValue);
+		_hashes[idx] = hashValue;
+		++_size;
+		return idx;
+	}
+
+	void removeIndex(size_t idx) {
+		const size_t mask = _capacity - 1u;
+		_slots[idx].~KeyValue();
+		_hashes[idx] = 0u;
+		--_size;
+		// backward shift: move the following entries of the probe sequence into the
+		// hole if their ideal slot isn't between the hole and their current slot
+		size_t hole = idx;
+		for (size_t i = (idx + 1u) & mask; _hashes[i] != 0u; i = (i + 1u) & mask) {
+			const size_t ideal = _hashes[i] & mask;
+			const bool stays = hole <= i ? (hole < ideal && ideal <= i) : (hole < ideal || ideal <= i);
+			if (stays) {
+				continue;
+			}
+			new ((void*)&_slots[hole]) KeyValue(core::move(_slots[i]));
+			_hashes[hole] = _hashes[i];
+			_slots[i].~KeyValue();
+			_hashes[i] = 0u;
+			hole = i;
+		}
+	}
+
+	void copyFrom(const DynamicMap& other) {
+		if (other._size == 0u) {
+			return;
+		}
+		_capacity = other._capacity;
+		_size = other._size;
+		_slots = (KeyValue*)core_malloc(_capacity * sizeof(KeyValue));
+		_hashes = (uint32_t*)core_malloc(_capacity * sizeof(uint32_t));
+		core_memcpy(_hashes, other._hashes, _capacity * sizeof(uint32_t));
+		for (size_t i = 0u; i < _capacity; ++i) {
+			if (_hashes[i] != 0u) {
+				new ((void*)&_slots[i]) KeyValue(other._slots[i]);
+			}
+		}
+	}
+
+public:
+	DynamicMap(std::initializer_list<KeyValue> other, size_t initialCapacity = INITIALCAPACITY) :
+			_initialCapacity(initialCapacity) {
+		for (auto i = other.begin(); i != other.end(); ++i) {
+			put(i->key, i->value);
+		}
+	}
+
+	DynamicMap(size_t initialCapacity = INITIALCAPACITY) :
+			_initialCapacity(initialCapacity) {
+	}
+
+	DynamicMap(const DynamicMap& other) :
+			_initialCapacity(other._initialCapacity) {
+		copyFrom(other);
+	}
+
+	DynamicMap(DynamicMap&& other) noexcept :
+			_slots(other._slots), _hashes(other._hashes), _capacity(other._capacity), _size(other._size),
+			_initialCapacity(other._initialCapacity) {
+		other._slots = nullptr;
+		other._hashes = nullptr;
+		other._capacity = 0u;
+		other._size = 0u;
+	}
+
+	~DynamicMap() {
+		release();
+	}
+
+	DynamicMap& operator=(const DynamicMap& other) {
+		if (&other == this) {
+			return *this;
+		}
+		release();
+		_initialCapacity = other._initialCapacity;
+		copyFrom(other);
+		return *this;
+	}
+
+	DynamicMap& operator=(DynamicMap&& other) noexcept {
+		if (&other == this) {
+			return *this;
+		}
+		release();
+		_slots = other._slots;
+		_hashes = other._hashes;
+		_capacity = other._capacity;
+		_size = other._size;
+		_initialCapacity = other._initialCapacity;
+		other._slots = nullptr;
+		other._hashes = nullptr;
+		other._capacity = 0u;
+		other._size = 0u;
+		return *this;
+	}
+
+	class iterator {
+	private:
+		const DynamicMap* _map;
+		size_t _idx;
+	public:
+		constexpr iterator() :
+			_map(nullptr), _idx(0u) {
+		}
+
+		iterator(const DynamicMap* map, size_t idx) :
+				_map(map), _idx(idx) {
+		}
+
+		inline KeyValue* operator*() const {
+			return &_map->_slots[_idx];
+		}
+
+		iterator& operator++() {
+			for (++_idx; _idx < _map->_capacity; ++_idx) {
+				if (_map->_hashes[_idx] != 0u) {
+					break;
+				}
+			}
+			return *this;
+		}
+
+		inline KeyValue* operator->() const {
+			return &_map->_slots[_idx];
+		}
+
+		inline bool operator!=(const iterator& rhs) const {
+			return _idx != rhs._idx || _map != rhs._map;
+		}
+
+		inline bool operator==(const iterator& rhs) const {
+			return _idx == rhs._idx && _map == rhs._map;
+		}
+	};
+
+	inline size_t size() const {
+		return _size;
+	}
+
+	inline bool empty() const {
+		return _size == 0u;
+	}
+
+	inline size_t capacity() const {
+		return _capacity;
+	}
+
+	/**
+	 * @brief Makes sure that the given amount of entries can be stored without rehashing
+	 */
+	void reserve(size_t entries) {
+		const size_t capacity = powerOfTwo(entries + entries / 3u + 1u);
+		if (capacity > _capacity) {
+			rehash(capacity);
+		}
+	}
+
+	bool get(const KEYTYPE& key, VALUETYPE& value) const {
+		const size_t idx = findIndex(key, hash(key));
+		if (idx == _capacity) {
+			return false;
+		}
+		value = _slots[idx].value;
+		return true;
+	}
+
+	bool hasKey(const KEYTYPE& key) const {
+		return findIndex(key, hash(key)) != _capacity;
+	}
+
+	iterator find(const KEYTYPE& key) const {
+		return iterator(this, findIndex(key, hash(key)));
+	}
+
+	void emplace(const KEYTYPE& key, VALUETYPE&& value) {
+		const uint32_t hashValue = hash(key);
+		const size_t idx = findIndex(key, hashValue);
+		if (idx != _capacity) {
+			_slots[idx].value = core::move(value);
+			return;
+		}
+		// prepareInsert() might reallocate the slots
+		const size_t freeIdx = prepareInsert(hashValue);
+		new ((void*)&_slots[freeIdx]) KeyValue(key, core::move(value));
+	}
+
+	void put(const KEYTYPE& key, const VALUETYPE& value) {
+		const uint32_t hashValue = hash(key);
+		const size_t idx = findIndex(key, hashValue);
+		if (idx != _capacity) {
+			_slots[idx].value = value;
+			return;
+		}
+		const size_t freeIdx = prepareInsert(hashValue);
+		new ((void*)&_slots[freeIdx]) KeyValue(key, value);
+	}
+
+	iterator begin() const {
+		iterator i(this, 0u);
+		if (_capacity > 0u && _hashes[0] == 0u) {
+			++i;
+		}
+		return i;
+	}
+
+	iterator end() const {
+		return iterator(this, _capacity);
+	}
+
+	/**
+	 * @brief Removes all entries but keeps the memory
+	 */
+	void clear() {
+		for (size_t i = 0u; i < _capacity; ++i) {
+			if (_hashes[i] != 0u) {
+				_slots[i].~KeyValue();
+				_hashes[i] = 0u;
+			}
+		}
+		_size = 0u;
+	}
+
+	/**
+	 * @brief Removes all entries and frees the memory
+	 */
+	void release() {
+		clear();
+		core_free(_slots);
+		core_free(_hashes);
+		_slots = nullptr;
+		_hashes = nullptr;
+		_capacity = 0u;
+	}
+
+	inline void erase(const iterator& iter) {
+		remove(iter->key);
+	}
+
+	bool remove(const KEYTYPE& key) {
+		const size_t idx = findIndex(key, hash(key));
+		if (idx == _capacity) {
+			return false;
+		}
+		removeIndex(idx);
+		return true;
+	}
+};
+
+}
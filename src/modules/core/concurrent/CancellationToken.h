@@ -0,0 +1,49 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/SharedPtr.h"
+#include "core/concurrent/Atomic.h"
+
+namespace core {
+
+/**
+ * @brief Shared flag to cancel tasks that were handed to the @c ThreadPool.
+ *
+ * Queued tasks of a cancelled token are dropped by the pool, running tasks have to check @c cancelled() on their own.
+ * A default constructed token is empty and can't be cancelled - this doesn't allocate.
+ */
+class CancellationToken {
+private:
+	core::SharedPtr<core::AtomicBool> _cancelled;
+public:
+	CancellationToken() {
+	}
+
+	/**
+	 * @brief Creates a token that can be cancelled - all copies share the state
+	 */
+	static CancellationToken create() {
+		CancellationToken token;
+		token._cancelled = core::make_shared<core::AtomicBool>(false);
+		return token;
+	}
+
+	inline bool valid() const {
+		return _cancelled;
+	}
+
+	inline void cancel() {
+		if (_cancelled) {
+			*_cancelled.get() = true;
+		}
+	}
+
+	inline bool cancelled() const {
+		return _cancelled && *_cancelled.get();
+	}
+};
+
+}
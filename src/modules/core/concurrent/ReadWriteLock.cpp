@@ -31,4 +31,81 @@ void ReadWriteLock::unlockWrite() {
 	SDL_UnlockMutex(_mutex);
 }
 
+SharedReadWriteLock::SharedReadWriteLock(const core::String& name) :
+		_name(name), _mutex(SDL_CreateMutex()), _condition(SDL_CreateCond()) {
+	SDL_AtomicSet(&_state, 0);
+	SDL_AtomicSet(&_waiters, 0);
+}
+
+SharedReadWriteLock::~SharedReadWriteLock() {
+	SDL_DestroyCond(_condition);
+	SDL_DestroyMutex(_mutex);
+}
+
+bool SharedReadWriteLock::tryLockRead() const {
+	int state = SDL_AtomicGet(&_state);
+	// only fail if a writer owns the lock - a failed exchange because of
+	// another reader is just retried
+	while (state >= 0) {
+		if (SDL_AtomicCAS(&_state, state, state + 1)) {
+			return true;
+		}
+		state = SDL_AtomicGet(&_state);
+	}
+	return false;
+}
+
+bool SharedReadWriteLock::tryLockWrite() const {
+	return SDL_AtomicCAS(&_state, 0, -1);
+}
+
+void SharedReadWriteLock::wakeWaiters() const {
+	if (SDL_AtomicGet(&_waiters) <= 0) {
+		return;
+	}
+	// the waiters are registered while holding the mutex - locking it here
+	// ensures that nobody is between checking the state and going to sleep
+	SDL_LockMutex(_mutex);
+	SDL_CondBroadcast(_condition);
+	SDL_UnlockMutex(_mutex);
+}
+
+void SharedReadWriteLock::lockRead() const {
+	if (tryLockRead()) {
+		return;
+	}
+	SDL_LockMutex(_mutex);
+	SDL_AtomicAdd(&_waiters, 1);
+	while (!tryLockRead()) {
+		SDL_CondWait(_condition, _mutex);
+	}
+	SDL_AtomicAdd(&_waiters, -1);
+	SDL_UnlockMutex(_mutex);
+}
+
+void SharedReadWriteLock::unlockRead() const {
+	// SDL_AtomicAdd returns the previous value - we were the last reader
+	if (SDL_AtomicAdd(&_state, -1) == 1) {
+		wakeWaiters();
+	}
+}
+
+void SharedReadWriteLock::lockWrite() {
+	if (tryLockWrite()) {
+		return;
+	}
+	SDL_LockMutex(_mutex);
+	SDL_AtomicAdd(&_waiters, 1);
+	while (!tryLockWrite()) {
+		SDL_CondWait(_condition, _mutex);
+	}
+	SDL_AtomicAdd(&_waiters, -1);
+	SDL_UnlockMutex(_mutex);
+}
+
+void SharedReadWriteLock::unlockWrite() {
+	SDL_AtomicSet(&_state, 0);
+	wakeWaiters();
+}
+
 }
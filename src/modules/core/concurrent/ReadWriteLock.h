@@ -6,8 +6,10 @@
 
 #include "core/String.h"
 #include "core/concurrent/Concurrency.h"
+#include <SDL_atomic.h>
 
 struct SDL_mutex;
+struct SDL_cond;
 
 namespace core {
 
@@ -28,11 +30,48 @@ public:
 	void unlockWrite() core_thread_release();
 };
 
+/**
+ * @brief Reader-writer lock that allows any amount of concurrent readers.
+ *
+ * Readers and writers only touch an atomic state value as long as there is no contention. Waiting
+ * threads are put to sleep on a condition variable.
+ *
+ * @note Unlike @c ReadWriteLock this lock is not recursive. Don't acquire it again on the same thread
+ * while holding it - and especially don't upgrade a read lock to a write lock.
+ */
+class core_thread_capability("mutex") SharedReadWriteLock {
+private:
+	const core::String _name;
+	/**
+	 * @brief Amount of active readers, or @c -1 if a writer owns the lock
+	 */
+	mutable SDL_atomic_t _state;
+	mutable SDL_atomic_t _waiters;
+	mutable SDL_mutex* _mutex;
+	mutable SDL_cond* _condition;
+
+	bool tryLockRead() const;
+	bool tryLockWrite() const;
+	void wakeWaiters() const;
+public:
+	SharedReadWriteLock(const core::String& name);
+	~SharedReadWriteLock();
+
+	void lockRead() const core_thread_acquire_shared();
+
+	void unlockRead() const core_thread_release();
+
+	void lockWrite() core_thread_acquire();
+
+	void unlockWrite() core_thread_release();
+};
+
+template<class LOCK = ReadWriteLock>
 class core_thread_scoped_capability ScopedReadLock {
 private:
-	const ReadWriteLock& _lock;
+	const LOCK& _lock;
 public:
-	inline ScopedReadLock(const ReadWriteLock& lock) core_thread_acquire_shared(lock) : _lock(lock) {
+	inline ScopedReadLock(const LOCK& lock) core_thread_acquire_shared(lock) : _lock(lock) {
 		_lock.lockRead();
 	}
 	inline ~ScopedReadLock() core_thread_release() {
@@ -40,11 +79,12 @@ public:
 	}
 };
 
+template<class LOCK = ReadWriteLock>
 class core_thread_scoped_capability ScopedWriteLock {
 private:
-	ReadWriteLock& _lock;
+	LOCK& _lock;
 public:
-	inline ScopedWriteLock(ReadWriteLock& lock) core_thread_acquire(lock): _lock(lock) {
+	inline ScopedWriteLock(LOCK& lock) core_thread_acquire(lock): _lock(lock) {
 		_lock.lockWrite();
 	}
 	inline ~ScopedWriteLock() core_thread_release() {
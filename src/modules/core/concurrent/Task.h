@@ -0,0 +1,134 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/Assert.h"
+#include <cstddef>
+#include <stdint.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace core {
+
+/**
+ * @brief Move only type erased @c void() callable.
+ *
+ * Callables up to @c InlineSize bytes are stored in place - only bigger ones are allocated on the heap. Unlike
+ * @c std::function this also accepts move only callables like @c std::packaged_task.
+ */
+class Task {
+public:
+	static constexpr size_t InlineSize = 6 * sizeof(void*);
+private:
+	// moves the callable from @c src into @c dst and destroys @c src - just destroys @c src if @c dst is @c nullptr
+	using ManageFunc = void (*)(void* dst, void* src);
+	using InvokeFunc = void (*)(void* storage);
+
+	template<class F>
+	struct Inline {
+		static void invoke(void* storage) {
+			(*(F*)storage)();
+		}
+		static void manage(void* dst, void* src) {
+			F* f = (F*)src;
+			if (dst != nullptr) {
+				new (dst) F(std::move(*f));
+			}
+			f->~F();
+		}
+	};
+
+	template<class F>
+	struct Heap {
+		static void invoke(void* storage) {
+			(**(F**)storage)();
+		}
+		static void manage(void* dst, void* src) {
+			if (dst != nullptr) {
+				*(F**)dst = *(F**)src;
+			} else {
+				delete *(F**)src;
+			}
+		}
+	};
+
+	template<class F>
+	static constexpr bool fitsInline() {
+		return sizeof(F) <= InlineSize && alignof(F) <= alignof(std::max_align_t)
+				&& std::is_nothrow_move_constructible<F>::value;
+	}
+
+	alignas(std::max_align_t) uint8_t _storage[InlineSize];
+	InvokeFunc _invoke = nullptr;
+	ManageFunc _manage = nullptr;
+
+	void reset() {
+		if (_manage != nullptr) {
+			_manage(nullptr, _storage);
+			_manage = nullptr;
+			_invoke = nullptr;
+		}
+	}
+
+	void moveFrom(Task& other) {
+		if (other._manage == nullptr) {
+			return;
+		}
+		other._manage(_storage, other._storage);
+		_invoke = other._invoke;
+		_manage = other._manage;
+		other._invoke = nullptr;
+		other._manage = nullptr;
+	}
+
+public:
+	Task() {
+	}
+
+	template<class F, class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Task>::value>::type>
+	Task(F&& f) {
+		using Func = typename std::decay<F>::type;
+		if constexpr (fitsInline<Func>()) {
+			new (_storage) Func(std::forward<F>(f));
+			_invoke = &Inline<Func>::invoke;
+			_manage = &Inline<Func>::manage;
+		} else {
+			*(Func**)_storage = new Func(std::forward<F>(f));
+			_invoke = &Heap<Func>::invoke;
+			_manage = &Heap<Func>::manage;
+		}
+	}
+
+	Task(Task&& other) noexcept {
+		moveFrom(other);
+	}
+
+	Task& operator=(Task&& other) noexcept {
+		if (this != &other) {
+			reset();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	~Task() {
+		reset();
+	}
+
+	inline bool valid() const {
+		return _invoke != nullptr;
+	}
+
+	inline void operator()() {
+		core_assert(_invoke != nullptr);
+		_invoke(_storage);
+	}
+};
+
+}
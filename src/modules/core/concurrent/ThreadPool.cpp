@@ -9,62 +9,142 @@
 
 namespace core {
 
+// the pool and the index of the worker that runs on the current thread
+static thread_local const ThreadPool* t_pool = nullptr;
+static thread_local size_t t_worker = 0u;
+
 ThreadPool::ThreadPool(size_t threads, const char *name) :
 		_threads(threads), _name(name) {
 	if (_name == nullptr) {
 		_name = "ThreadPool";
 	}
+	_queues.reserve(_threads);
+	for (size_t i = 0; i < _threads; ++i) {
+		_queues.emplace_back(new Queue());
+	}
 }
 
 void ThreadPool::abort() {
-	core::ScopedLock lock(_queueMutex);
-	while (!_tasks.empty()) {
-		_tasks.pop();
+	for (const std::unique_ptr<Queue>& queue : _queues) {
+		core::ScopedLock lock(queue->lock);
+		for (int priority = 0; priority < (int)TaskPriority::Max; ++priority) {
+			std::deque<QueuedTask>& lane = queue->lanes[priority];
+			_lanePending[priority].decrement((int)lane.size());
+			_pending.decrement((int)lane.size());
+			lane.clear();
+		}
 	}
 }
 
+bool ThreadPool::push(TaskPriority priority, core::Task&& task, const CancellationToken& token) {
+	if (_threads == 0u) {
+		return false;
+	}
+	size_t index;
+	if (t_pool == this) {
+		index = t_worker;
+	} else {
+		index = (size_t)(uint32_t)_nextQueue.increment(1) % _threads;
+	}
+	Queue& queue = *_queues[index];
+	{
+		core::ScopedLock lock(queue.lock);
+		if (_stop) {
+			return false;
+		}
+		queue.lanes[(int)priority].push_back(QueuedTask{core::move(task), token});
+	}
+	// the counters are increased after the task is visible to the workers - see run()
+	_lanePending[(int)priority].increment(1);
+	_pending.increment(1);
+	if (_sleeping > 0) {
+		{
+			core::ScopedLock lock(_sleepMutex);
+		}
+		_sleepCondition.notify_one();
+	}
+	return true;
+}
+
+bool ThreadPool::pop(size_t worker, QueuedTask& task) {
+	for (int priority = 0; priority < (int)TaskPriority::Max; ++priority) {
+		if (_lanePending[priority] <= 0 && !_stop) {
+			continue;
+		}
+		for (size_t i = 0u; i < _threads; ++i) {
+			Queue& queue = *_queues[(worker + i) % _threads];
+			core::ScopedLock lock(queue.lock);
+			std::deque<QueuedTask>& lane = queue.lanes[priority];
+			while (!lane.empty()) {
+				if (i == 0u) {
+					task = core::move(lane.front());
+					lane.pop_front();
+				} else {
+					task = core::move(lane.back());
+					lane.pop_back();
+				}
+				_lanePending[priority].decrement(1);
+				_pending.decrement(1);
+				if (!task.token.cancelled()) {
+					return true;
+				}
+			}
+		}
+	}
+	task.task = core::Task();
+	return false;
+}
+
+void ThreadPool::run(size_t worker) {
+	const core::String n = core::string::format("%s-%i", _name, (int)worker);
+	if (!setThreadName(n.c_str())) {
+		Log::error("Failed to set thread name for pool thread %i", (int)worker);
+	}
+	core_trace_thread(n.c_str());
+	t_pool = this;
+	t_worker = worker;
+	QueuedTask task;
+	for (;;) {
+		// read the flag before looking for tasks - tasks that are queued after this check see the flag, too
+		const bool stop = _stop;
+		if (stop && _force) {
+			break;
+		}
+		if ((stop || _pending > 0) && pop(worker, task)) {
+			core_trace_begin_frame(n.c_str());
+			core_trace_scoped(ThreadPoolWorker);
+			Log::trace(logid, "Execute task in %i", (int)getThreadId());
+			task.task();
+			task.task = core::Task();
+			task.token = CancellationToken();
+			Log::trace(logid, "End of task in %i", (int)getThreadId());
+			core_trace_end_frame(n.c_str());
+			continue;
+		}
+		if (stop) {
+			break;
+		}
+		// the pushing thread increases _pending before it checks _sleeping - so either we see the new task here
+		// or the pushing thread sees us sleeping and wakes us up
+		core::ScopedLock lock(_sleepMutex);
+		_sleeping.increment(1);
+		_sleepCondition.wait(_sleepMutex, [this] {
+			// predicate must return false if the waiting should continue
+			return _stop || _pending > 0;
+		});
+		_sleeping.decrement(1);
+	}
+	Log::debug(logid, "Shutdown worker thread for %i", (int)getThreadId());
+	t_pool = nullptr;
+}
+
 void ThreadPool::init() {
 	_force = false;
 	_stop = false;
 	_workers.reserve(_threads);
 	for (size_t i = 0; i < _threads; ++i) {
 		_workers.emplace_back([this, i] {
-			const core::String n = core::string::format("%s-%i", this->_name, (int)i);
-			if (!setThreadName(n.c_str())) {
-				Log::error("Failed to set thread name for pool thread %i", (int)i);
-			}
-			core_trace_thread(n.c_str());
-			for (;;) {
-				std::function<void()> task;
-				{
-					core::ScopedLock lock(this->_queueMutex);
-					if (!this->_stop) {
-						this->_queueCondition.wait(this->_queueMutex, [this] {
-							// predicate must return false if the waiting should continue
-							if (this->_stop) {
-								return true;
-							}
-							if (!this->_tasks.empty()) {
-								return true;
-							}
-							return false;
-						});
-					}
-					if (this->_stop && (this->_force || this->_tasks.empty())) {
-						Log::debug(logid, "Shutdown worker thread for %i", (int)getThreadId());
-						break;
-					}
-					task = core::move(this->_tasks.front());
-					this->_tasks.pop();
-				}
-
-				core_trace_begin_frame(n.c_str());
-				core_trace_scoped(ThreadPoolWorker);
-				Log::trace(logid, "Execute task in %i", (int)getThreadId());
-				task();
-				Log::trace(logid, "End of task in %i", (int)getThreadId());
-				core_trace_end_frame(n.c_str());
-			}
+			run(i);
 		});
 	}
 }
@@ -79,11 +159,16 @@ void ThreadPool::shutdown(bool wait) {
 	}
 	_force = !wait;
 	_stop = true;
-	_queueCondition.notify_all();
+	{
+		core::ScopedLock lock(_sleepMutex);
+	}
+	_sleepCondition.notify_all();
 	for (std::thread &worker : _workers) {
 		worker.join();
 	}
 	_workers.clear();
+	// drop the tasks that were not executed
+	abort();
 }
 
 }
@@ -28,22 +28,56 @@
 #pragma once
 
 #include <vector>
-#include <queue>
+#include <deque>
 #include <memory>
 #include <thread>
 #include <future>
 #include <functional>
+#include "core/Common.h"
+#include "core/SharedPtr.h"
 #include "core/concurrent/Atomic.h"
 #include "core/concurrent/Lock.h"
 #include "core/concurrent/ConditionVariable.h"
+#include "core/concurrent/CancellationToken.h"
+#include "core/concurrent/Task.h"
 #include "core/Trace.h"
 #include "core/Log.h"
 
 namespace core {
 
+/**
+ * @brief Tasks of a higher priority are executed before any queued task of a lower priority
+ */
+enum class TaskPriority : uint8_t { High, Normal, Low, Max };
+
+/**
+ * @brief Work stealing thread pool.
+ *
+ * Every worker has its own queue with one lane per @c TaskPriority. Tasks that are queued by a worker end up in the
+ * queue of that worker - tasks from other threads are distributed over the workers. Idle workers steal from the
+ * queues of the other workers.
+ */
 class ThreadPool final {
 private:
 	static constexpr auto logid = Log::logid("ThreadPool");
+
+	struct QueuedTask {
+		core::Task task;
+		core::CancellationToken token;
+	};
+	/**
+	 * @brief The queue of one worker. The owner takes the tasks from the front, other workers steal from the back.
+	 */
+	struct Queue {
+		core_trace_mutex(core::Lock, lock, "ThreadPoolQueue");
+		std::deque<QueuedTask> lanes[(int)TaskPriority::Max];
+	};
+	struct ParallelForState {
+		core::AtomicInt next { 0 };
+		core::AtomicInt done { 0 };
+		core_trace_mutex(core::Lock, lock, "ThreadPoolParallelFor");
+		core::ConditionVariable finished;
+	};
 public:
 	explicit ThreadPool(size_t, const char *name = nullptr);
 	~ThreadPool();
@@ -53,6 +87,26 @@ public:
 	 */
 	template<class F, class ... Args>
 	auto enqueue(F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type>;
+	template<class F, class ... Args>
+	auto enqueue(TaskPriority priority, F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type>;
+
+	/**
+	 * @brief Fire and forget version of @c enqueue() - callables that fit into @c Task::InlineSize are queued without
+	 * any allocation.
+	 * @param[in] token If the token is cancelled before the task was started, the task is dropped
+	 * @return @c false if the pool was already shut down
+	 */
+	template<class F>
+	bool schedule(F&& f, TaskPriority priority = TaskPriority::Normal, const CancellationToken& token = CancellationToken());
+
+	/**
+	 * @brief Calls @c func(i) for every @c i in @c [begin,end) and returns when all calls are done.
+	 *
+	 * The range is split into parts of @c grainSize indices. The calling thread works on the parts, too - so this
+	 * can also be called from within a task of this pool.
+	 */
+	template<class F>
+	void parallelFor(int begin, int end, const F& func, int grainSize = 1);
 
 	size_t size() const;
 	void init();
@@ -67,37 +121,102 @@ private:
 	const char *_name;
 	// need to keep track of threads so we can join them
 	std::vector<std::thread> _workers;
-	// the task queue
-	std::queue<std::function<void()> > _tasks core_thread_guarded_by(_queueMutex);
-
-	// synchronization
-	core_trace_mutex(core::Lock, _queueMutex, "ThreadPoolQueue");
-	core::ConditionVariable _queueCondition;
+	// one queue per worker
+	std::vector<std::unique_ptr<Queue>> _queues;
+	// the queue of the next task that is queued by a thread that is not part of this pool
+	core::AtomicInt _nextQueue { 0 };
+	// the amount of queued tasks - in total and per priority
+	core::AtomicInt _pending { 0 };
+	core::AtomicInt _lanePending[(int)TaskPriority::Max];
+
+	// synchronization for the idle workers
+	core::AtomicInt _sleeping { 0 };
+	core_trace_mutex(core::Lock, _sleepMutex, "ThreadPoolSleep");
+	core::ConditionVariable _sleepCondition;
 	core::AtomicBool _stop { false };
 	core::AtomicBool _force { false };
+
+	bool push(TaskPriority priority, core::Task&& task, const CancellationToken& token);
+	/**
+	 * @brief Takes the task with the highest priority - from the own queue or stolen from another worker
+	 */
+	bool pop(size_t worker, QueuedTask& task);
+	void run(size_t worker);
 };
 
-// add new work item to the pool
 template<class F, class ... Args>
 auto ThreadPool::enqueue(F&& f, Args&&... args)
+-> std::future<typename std::result_of<F(Args...)>::type> {
+	return enqueue(TaskPriority::Normal, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+// add new work item to the pool
+template<class F, class ... Args>
+auto ThreadPool::enqueue(TaskPriority priority, F&& f, Args&&... args)
 -> std::future<typename std::result_of<F(Args...)>::type> {
 	using return_type = typename std::result_of<F(Args...)>::type;
 	if (_stop) {
 		return std::future<return_type>();
 	}
 
-	auto task = std::make_shared<std::packaged_task<return_type()> >(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+	std::packaged_task<return_type()> task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+	std::future<return_type> res = task.get_future();
+	if (!push(priority, core::Task(core::move(task)), CancellationToken())) {
+		return std::future<return_type>();
+	}
+	return res;
+}
+
+template<class F>
+bool ThreadPool::schedule(F&& f, TaskPriority priority, const CancellationToken& token) {
+	if (_stop) {
+		return false;
+	}
+	return push(priority, core::Task(std::forward<F>(f)), token);
+}
 
-	std::future<return_type> res = task->get_future();
-	{
-		core::ScopedLock lock(_queueMutex);
-		if (_stop) {
-			return std::future<return_type>();
+template<class F>
+void ThreadPool::parallelFor(int begin, int end, const F& func, int grainSize) {
+	core_trace_scoped(ThreadPoolParallelFor);
+	const int amount = end - begin;
+	if (amount <= 0) {
+		return;
+	}
+	grainSize = core_max(1, grainSize);
+	const int parts = (amount + grainSize - 1) / grainSize;
+	// the state is shared with the helper tasks - they might start after this call returned, but they won't find
+	// any part to work on then and don't touch the function anymore
+	const core::SharedPtr<ParallelForState>& state = core::make_shared<ParallelForState>();
+	const F* f = &func;
+	auto work = [state, f, begin, end, grainSize, parts] () {
+		int finishedParts = 0;
+		for (;;) {
+			const int part = state->next.increment(1);
+			if (part >= parts) {
+				break;
+			}
+			const int from = begin + part * grainSize;
+			const int to = core_min(end, from + grainSize);
+			for (int i = from; i < to; ++i) {
+				(*f)(i);
+			}
+			++finishedParts;
 		}
-		_tasks.emplace([task]() {(*task)();});
+		if (finishedParts > 0 && state->done.increment(finishedParts) + finishedParts == parts) {
+			core::ScopedLock lock(state->lock);
+			state->finished.notify_all();
+		}
+	};
+	const int helpers = core_min((int)_threads, parts - 1);
+	for (int i = 0; i < helpers; ++i) {
+		// the caller is blocked until all parts are done
+		schedule(work, TaskPriority::High);
 	}
-	_queueCondition.notify_one();
-	return res;
+	work();
+	core::ScopedLock lock(state->lock);
+	state->finished.wait(state->lock, [&state, parts] () {
+		return state->done >= parts;
+	});
 }
 
 inline size_t ThreadPool::size() const {
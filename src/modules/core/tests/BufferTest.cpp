@@ -109,6 +109,23 @@ TEST(BufferTest, testTriggerResize) {
 	EXPECT_EQ(4u, array.capacity()) << array;
 }
 
+TEST(BufferTest, testResize) {
+	Buffer<uint8_t, 2> array;
+	array.push_back(1);
+	array.reserve(8);
+	EXPECT_EQ(1u, array.size()) << array;
+	EXPECT_EQ(8u, array.capacity()) << array;
+	array.data()[1] = 2;
+	array.resize(2);
+	EXPECT_EQ(2u, array.size()) << array;
+	EXPECT_EQ(1, array[0]);
+	EXPECT_EQ(2, array[1]);
+	array.resize(9);
+	EXPECT_EQ(9u, array.size()) << array;
+	EXPECT_EQ(10u, array.capacity()) << array;
+	EXPECT_EQ(2, array[1]);
+}
+
 TEST(BufferTest, testErase) {
 	Buffer<uint8_t, 32> array;
 	for (uint8_t i = 0; i < 128; ++i) {
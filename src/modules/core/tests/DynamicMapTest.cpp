@@ -0,0 +1,106 @@
+/**
+ * @file
+ */
+
+#include <gtest/gtest.h>
+#include "core/collection/DynamicMap.h"
+#include "core/String.h"
+#include "core/SharedPtr.h"
+
+namespace core {
+
+TEST(DynamicMapTest, testPutGet) {
+	core::DynamicMap<int64_t, int64_t, 11, std::hash<int64_t>> map;
+	map.put(1, 1);
+	map.put(1, 2);
+	map.put(2, 1);
+	map.put(3, 1337);
+	int64_t value;
+	EXPECT_TRUE(map.get(1, value));
+	EXPECT_EQ(2, value);
+	EXPECT_TRUE(map.get(2, value));
+	EXPECT_EQ(1, value);
+	EXPECT_TRUE(map.get(3, value));
+	EXPECT_EQ(1337, value);
+	EXPECT_FALSE(map.get(4, value));
+	EXPECT_EQ(3u, map.size());
+}
+
+TEST(DynamicMapTest, testGrow) {
+	core::DynamicMap<int64_t, int64_t, 4, std::hash<int64_t>> map;
+	for (int64_t i = 0; i < 100000; ++i) {
+		map.put(i, i * 2);
+	}
+	EXPECT_EQ(100000u, map.size());
+	EXPECT_GE(map.capacity(), map.size());
+	int64_t value;
+	for (int64_t i = 0; i < 100000; ++i) {
+		ASSERT_TRUE(map.get(i, value)) << "key " << i;
+		EXPECT_EQ(i * 2, value);
+	}
+}
+
+TEST(DynamicMapTest, testRemove) {
+	core::DynamicMap<int64_t, int64_t, 11, std::hash<int64_t>> map;
+	for (int64_t i = 0; i < 1024; ++i) {
+		map.put(i, i);
+	}
+	for (int64_t i = 0; i < 1024; i += 2) {
+		EXPECT_TRUE(map.remove(i));
+	}
+	EXPECT_FALSE(map.remove(0));
+	EXPECT_EQ(512u, map.size());
+	// the remaining entries must still be reachable after the backward shifts
+	for (int64_t i = 0; i < 1024; ++i) {
+		EXPECT_EQ(i % 2 == 1, map.hasKey(i)) << "key " << i;
+	}
+}
+
+TEST(DynamicMapTest, testIterate) {
+	core::DynamicMap<int64_t, int64_t, 11, std::hash<int64_t>> map;
+	EXPECT_EQ(map.begin(), map.end());
+	for (int64_t i = 0; i < 1024; i += 2) {
+		map.put(i, i);
+	}
+	int cnt = 0;
+	for (auto iter : map) {
+		EXPECT_EQ(iter->key, iter->value);
+		EXPECT_EQ(iter->first, iter->second);
+		++cnt;
+	}
+	EXPECT_EQ(512, cnt);
+}
+
+TEST(DynamicMapTest, testFindErase) {
+	core::DynamicMap<core::String, core::SharedPtr<core::String>, 4, core::StringHash> map;
+	map.put("foobar", core::SharedPtr<core::String>::create("barfoo"));
+	map.put("barfoo", core::SharedPtr<core::String>::create("foobar"));
+	auto iter = map.find("foobar");
+	ASSERT_NE(iter, map.end());
+	EXPECT_EQ("barfoo", *iter->value.get());
+	map.erase(iter);
+	EXPECT_EQ(1u, map.size());
+	EXPECT_EQ(map.end(), map.find("foobar"));
+	EXPECT_NE(map.end(), map.find("barfoo"));
+}
+
+TEST(DynamicMapTest, testCopyAssign) {
+	core::DynamicMap<core::String, core::String, 4, core::StringHash> map;
+	for (int i = 0; i < 64; ++i) {
+		map.put(core::String::format("key%i", i), core::String::format("value%i", i));
+	}
+	core::DynamicMap<core::String, core::String, 4, core::StringHash> map2(map);
+	core::DynamicMap<core::String, core::String, 4, core::StringHash> map3;
+	map3 = map;
+	map.clear();
+	EXPECT_EQ(0u, map.size());
+	EXPECT_EQ(64u, map2.size());
+	EXPECT_EQ(64u, map3.size());
+	core::String value;
+	EXPECT_TRUE(map2.get("key42", value));
+	EXPECT_EQ("value42", value);
+	EXPECT_TRUE(map3.get("key23", value));
+	EXPECT_EQ("value23", value);
+}
+
+}
@@ -4,6 +4,13 @@
 
 #include <gtest/gtest.h>
 #include "core/Log.h"
+#include "core/GameConfig.h"
+#include "core/Var.h"
+#include "core/collection/DynamicArray.h"
+#include "core/concurrent/Lock.h"
+#include <SDL_atomic.h>
+#include <SDL_timer.h>
+#include <thread>
 
 namespace core {
 
@@ -13,4 +20,146 @@ TEST(LogTest, testLogId) {
 	ASSERT_NE(logid1, logid2);
 }
 
+class LogAsyncTest : public testing::Test {
+protected:
+	static core::Lock _lock;
+	static core::DynamicArray<core::String> _messages;
+	static SDL_atomic_t _blockOutput;
+	SDL_LogOutputFunction _outputFunction = nullptr;
+	void *_outputUserData = nullptr;
+
+	static void capture(void *, int, SDL_LogPriority, const char *message) {
+		while (SDL_AtomicGet(&_blockOutput)) {
+			SDL_Delay(1);
+		}
+		core::ScopedLock lock(_lock);
+		_messages.push_back(message);
+	}
+
+	void SetUp() override {
+		core::Var::get(cfg::CoreLogLevel, SDL_LOG_PRIORITY_INFO)->setVal(SDL_LOG_PRIORITY_INFO);
+		core::Var::get(cfg::CoreSysLog, "false")->setVal(false);
+		core::Var::get(cfg::CoreLogAsync, "false")->setVal(true);
+		core::Var::get(cfg::CoreLogAsyncBlock, "false")->setVal(false);
+		_messages.clear();
+		SDL_AtomicSet(&_blockOutput, 0);
+		SDL_LogGetOutputFunction(&_outputFunction, &_outputUserData);
+		SDL_LogSetOutputFunction(capture, nullptr);
+	}
+
+	void TearDown() override {
+		SDL_AtomicSet(&_blockOutput, 0);
+		core::Var::get(cfg::CoreLogAsync, "false")->setVal(false);
+		Log::init();
+		SDL_LogSetOutputFunction(_outputFunction, _outputUserData);
+	}
+
+	int messages(const char *substring) const {
+		core::ScopedLock lock(_lock);
+		int n = 0;
+		for (const core::String& message : _messages) {
+			if (message.contains(substring)) {
+				++n;
+			}
+		}
+		return n;
+	}
+};
+
+core::Lock LogAsyncTest::_lock;
+core::DynamicArray<core::String> LogAsyncTest::_messages;
+SDL_atomic_t LogAsyncTest::_blockOutput;
+
+TEST_F(LogAsyncTest, testThreads) {
+	core::Var::get(cfg::CoreLogAsyncBlock, "false")->setVal(true);
+	Log::init();
+	std::thread threads[4];
+	for (int t = 0; t < 4; ++t) {
+		threads[t] = std::thread([t] () {
+			for (int i = 0; i < 1000; ++i) {
+				Log::info("thread %i message %i", t, i);
+			}
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	core::Var::get(cfg::CoreLogAsync, "false")->setVal(false);
+	Log::init();
+	EXPECT_EQ(4000, messages(" message ")) << "Blocking the calling threads must not lose messages";
+	// the messages of one thread must keep their order
+	core::ScopedLock lock(_lock);
+	int last[4] = {-1, -1, -1, -1};
+	for (const core::String& message : _messages) {
+		int t;
+		int i;
+		const char *start = SDL_strstr(message.c_str(), "thread ");
+		if (start == nullptr || SDL_sscanf(start, "thread %i message %i", &t, &i) != 2) {
+			continue;
+		}
+		ASSERT_GE(t, 0);
+		ASSERT_LT(t, 4);
+		EXPECT_EQ(last[t] + 1, i);
+		last[t] = i;
+	}
+}
+
+TEST_F(LogAsyncTest, testDropOnOverflow) {
+	Log::init();
+	const int droppedBefore = Log::dropped();
+	// the log thread blocks in the output of the first message - the queue runs full
+	SDL_AtomicSet(&_blockOutput, 1);
+	const int amount = Log::AsyncQueueSize + 10;
+	for (int i = 0; i < amount; ++i) {
+		Log::info("overflow %i", i);
+	}
+	const int dropped = Log::dropped() - droppedBefore;
+	EXPECT_GE(dropped, 9);
+	EXPECT_LE(dropped, 10);
+	SDL_AtomicSet(&_blockOutput, 0);
+	core::Var::get(cfg::CoreLogAsync, "false")->setVal(false);
+	Log::init();
+	EXPECT_EQ(amount - dropped, messages("overflow "));
+	EXPECT_EQ(1, messages("Dropped")) << "The dropped messages should get reported";
+}
+
+TEST_F(LogAsyncTest, testLongMessage) {
+	Log::init();
+	Log::info("short message");
+	char buf[1024];
+	SDL_memset(buf, 'a', sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = '\0';
+	Log::info("%s", buf);
+	Log::info("last message");
+	core::Var::get(cfg::CoreLogAsync, "false")->setVal(false);
+	Log::init();
+	EXPECT_EQ(1, messages(buf));
+	// the long message is queued, too - and keeps its order
+	core::ScopedLock lock(_lock);
+	ASSERT_EQ(3u, _messages.size());
+	EXPECT_TRUE(_messages[0].contains("short message"));
+	EXPECT_TRUE(_messages[1].contains(buf));
+	EXPECT_TRUE(_messages[2].contains("last message"));
+}
+
+TEST_F(LogAsyncTest, testShutdownWhileLogging) {
+	core::Var::get(cfg::CoreLogAsyncBlock, "false")->setVal(true);
+	Log::init();
+	std::thread threads[4];
+	for (int t = 0; t < 4; ++t) {
+		threads[t] = std::thread([t] () {
+			for (int i = 0; i < 1000; ++i) {
+				Log::info("thread %i message %i", t, i);
+			}
+		});
+	}
+	// the producers that are still queueing must not lose their messages
+	core::Var::get(cfg::CoreLogAsync, "false")->setVal(false);
+	Log::init();
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(4000, messages(" message "));
+}
+
 }
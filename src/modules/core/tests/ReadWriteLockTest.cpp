@@ -4,20 +4,23 @@
 
 #include <gtest/gtest.h>
 #include "core/concurrent/ReadWriteLock.h"
+#include "core/concurrent/Atomic.h"
+#include <chrono>
 #include <future>
 
 namespace core {
 
+template<class LOCK>
 class ReadWriteLockTest: public testing::Test {
 protected:
-	core::ReadWriteLock _rwLock {"test"};
+	LOCK _rwLock {"test"};
 	int _value = 0;
 	const int limit { 100000 };
 
 	int read(int loopLimit) {
 		int n = 0;
 		for (int i = 0; i < loopLimit; ++i) {
-			core::ScopedReadLock scoped(_rwLock);
+			core::ScopedReadLock<LOCK> scoped(_rwLock);
 			if (_value >= 0) {
 				++n;
 			}
@@ -27,54 +30,85 @@ protected:
 
 	void write(int limit) {
 		for (int i = 0; i < limit; ++i) {
-			core::ScopedWriteLock scoped(_rwLock);
+			core::ScopedWriteLock<LOCK> scoped(_rwLock);
 			++_value;
 		}
 	}
 };
 
-TEST_F(ReadWriteLockTest, testSameReadersThanWriters) {
+using LockTypes = testing::Types<core::ReadWriteLock, core::SharedReadWriteLock>;
+TYPED_TEST_SUITE(ReadWriteLockTest, LockTypes);
+
+TYPED_TEST(ReadWriteLockTest, testSameReadersThanWriters) {
 	int n1 = 0, n2 = 0;
-	auto futureRead1 = std::async(std::launch::async, [&] {n1 += read(limit);});
-	auto futureRead2 = std::async(std::launch::async, [&] {n2 += read(limit);});
-	auto futureWrite1 = std::async(std::launch::async, [=] {write(limit);});
-	auto futureWrite2 = std::async(std::launch::async, [=] {write(limit);});
+	auto futureRead1 = std::async(std::launch::async, [&] {n1 += this->read(this->limit);});
+	auto futureRead2 = std::async(std::launch::async, [&] {n2 += this->read(this->limit);});
+	auto futureWrite1 = std::async(std::launch::async, [=] {this->write(this->limit);});
+	auto futureWrite2 = std::async(std::launch::async, [=] {this->write(this->limit);});
 	futureRead1.wait();
 	futureRead2.wait();
 	futureWrite1.wait();
 	futureWrite2.wait();
-	EXPECT_EQ(_value, limit * 2);
-	EXPECT_EQ(n1, limit);
-	EXPECT_EQ(n2, limit);
+	EXPECT_EQ(this->_value, this->limit * 2);
+	EXPECT_EQ(n1, this->limit);
+	EXPECT_EQ(n2, this->limit);
 }
 
-TEST_F(ReadWriteLockTest, testMoreReadersThanWriters) {
+TYPED_TEST(ReadWriteLockTest, testMoreReadersThanWriters) {
 	int n1 = 0, n2 = 0, n3 = 0;
-	auto futureRead1 = std::async(std::launch::async, [&] {n1 += read(limit);});
-	auto futureRead2 = std::async(std::launch::async, [&] {n2 += read(limit);});
-	auto futureRead3 = std::async(std::launch::async, [&] {n3 += read(limit);});
-	auto futureWrite = std::async(std::launch::async, [=] {write(limit);});
+	auto futureRead1 = std::async(std::launch::async, [&] {n1 += this->read(this->limit);});
+	auto futureRead2 = std::async(std::launch::async, [&] {n2 += this->read(this->limit);});
+	auto futureRead3 = std::async(std::launch::async, [&] {n3 += this->read(this->limit);});
+	auto futureWrite = std::async(std::launch::async, [=] {this->write(this->limit);});
 	futureRead1.wait();
 	futureRead2.wait();
 	futureRead3.wait();
 	futureWrite.wait();
-	EXPECT_EQ(_value, limit);
-	EXPECT_EQ(n1, limit);
-	EXPECT_EQ(n2, limit);
-	EXPECT_EQ(n3, limit);
+	EXPECT_EQ(this->_value, this->limit);
+	EXPECT_EQ(n1, this->limit);
+	EXPECT_EQ(n2, this->limit);
+	EXPECT_EQ(n3, this->limit);
 }
 
-TEST_F(ReadWriteLockTest, testMoreWritersThanReaders) {
+TYPED_TEST(ReadWriteLockTest, testMoreWritersThanReaders) {
 	int n1 = 0;
-	auto futureRead1 = std::async(std::launch::async, [&] {n1 += read(limit);});
-	auto futureWrite1 = std::async(std::launch::async, [=] {write(limit);});
-	auto futureWrite2 = std::async(std::launch::async, [=] {write(limit);});
-	auto futureWrite3 = std::async(std::launch::async, [=] {write(limit);});
+	auto futureRead1 = std::async(std::launch::async, [&] {n1 += this->read(this->limit);});
+	auto futureWrite1 = std::async(std::launch::async, [=] {this->write(this->limit);});
+	auto futureWrite2 = std::async(std::launch::async, [=] {this->write(this->limit);});
+	auto futureWrite3 = std::async(std::launch::async, [=] {this->write(this->limit);});
 	futureRead1.wait();
 	futureWrite1.wait();
 	futureWrite2.wait();
 	futureWrite3.wait();
-	EXPECT_EQ(n1, limit);
+	EXPECT_EQ(n1, this->limit);
+}
+
+TEST(SharedReadWriteLockTest, testConcurrentReaders) {
+	core::SharedReadWriteLock lock("test");
+	lock.lockRead();
+	// a second reader must not be blocked by the first one
+	auto futureRead = std::async(std::launch::async, [&] {
+		core::ScopedReadLock<core::SharedReadWriteLock> scoped(lock);
+		return true;
+	});
+	EXPECT_EQ(std::future_status::ready, futureRead.wait_for(std::chrono::seconds(5)));
+	lock.unlockRead();
+	EXPECT_TRUE(futureRead.get());
+}
+
+TEST(SharedReadWriteLockTest, testWriterWaitsForReader) {
+	core::SharedReadWriteLock lock("test");
+	core::AtomicBool written(false);
+	lock.lockRead();
+	auto futureWrite = std::async(std::launch::async, [&] {
+		core::ScopedWriteLock<core::SharedReadWriteLock> scoped(lock);
+		written = true;
+	});
+	EXPECT_EQ(std::future_status::timeout, futureWrite.wait_for(std::chrono::milliseconds(50)));
+	EXPECT_FALSE(written);
+	lock.unlockRead();
+	futureWrite.wait();
+	EXPECT_TRUE(written);
 }
 
 }
@@ -5,6 +5,11 @@
 #include <gtest/gtest.h>
 #include "core/concurrent/ThreadPool.h"
 #include "core/concurrent/Atomic.h"
+#include "core/concurrent/Task.h"
+#include "core/ArrayLength.h"
+#include "core/collection/DynamicArray.h"
+#include <memory>
+#include <thread>
 
 namespace core {
 
@@ -42,4 +47,122 @@ TEST_F(ThreadPoolTest, testMultiplePush) {
 	ASSERT_EQ(x, _count) << "Not all threads were executed";
 }
 
+TEST_F(ThreadPoolTest, testSchedule) {
+	const int x = 1000;
+	core::ThreadPool pool(4);
+	pool.init();
+	for (int i = 0; i < x; ++i) {
+		ASSERT_TRUE(pool.schedule([this] () {
+			++_count;
+		}));
+	}
+	pool.shutdown(true);
+	ASSERT_EQ(x, _count) << "Not all tasks were executed";
+	EXPECT_FALSE(pool.schedule([] () {})) << "The pool is already shut down";
+}
+
+TEST_F(ThreadPoolTest, testTaskStorage) {
+	std::unique_ptr<int> moveOnly(new int(42));
+	int value = 0;
+	core::Task task([&value, ptr = core::move(moveOnly)] () {
+		value = *ptr;
+	});
+	core::Task moved(core::move(task));
+	EXPECT_FALSE(task.valid());
+	ASSERT_TRUE(moved.valid());
+	moved();
+	EXPECT_EQ(42, value);
+
+	// doesn't fit into the inline storage
+	uint8_t big[Task::InlineSize * 2] = { 1 };
+	core::Task heap([&value, big] () {
+		value = big[0];
+	});
+	core::Task movedHeap;
+	movedHeap = core::move(heap);
+	movedHeap();
+	EXPECT_EQ(1, value);
+}
+
+TEST_F(ThreadPoolTest, testPriority) {
+	core::ThreadPool pool(1);
+	pool.init();
+	core::AtomicBool started { false };
+	core::AtomicBool release { false };
+	// block the only worker until all tasks are queued
+	pool.schedule([&] () {
+		started = true;
+		while (!release) {
+			std::this_thread::yield();
+		}
+	});
+	while (!started) {
+		std::this_thread::yield();
+	}
+	core::DynamicArray<int> order;
+	pool.schedule([&order] () { order.push_back(3); }, TaskPriority::Low);
+	pool.schedule([&order] () { order.push_back(2); }, TaskPriority::Normal);
+	pool.schedule([&order] () { order.push_back(1); }, TaskPriority::High);
+	release = true;
+	pool.shutdown(true);
+	ASSERT_EQ(3u, order.size());
+	EXPECT_EQ(1, order[0]);
+	EXPECT_EQ(2, order[1]);
+	EXPECT_EQ(3, order[2]);
+}
+
+TEST_F(ThreadPoolTest, testCancel) {
+	core::ThreadPool pool(1);
+	pool.init();
+	core::AtomicBool started { false };
+	core::AtomicBool release { false };
+	pool.schedule([&] () {
+		started = true;
+		while (!release) {
+			std::this_thread::yield();
+		}
+	});
+	while (!started) {
+		std::this_thread::yield();
+	}
+	core::CancellationToken token = core::CancellationToken::create();
+	for (int i = 0; i < 10; ++i) {
+		pool.schedule([this] () { ++_count; }, TaskPriority::Normal, token);
+	}
+	pool.schedule([this] () { _executed = true; });
+	token.cancel();
+	EXPECT_TRUE(token.cancelled());
+	release = true;
+	pool.shutdown(true);
+	EXPECT_EQ(0, _count) << "Cancelled tasks were executed";
+	EXPECT_TRUE(_executed) << "Task without token wasn't executed";
+}
+
+TEST_F(ThreadPoolTest, testParallelFor) {
+	core::ThreadPool pool(4);
+	pool.init();
+	core::AtomicInt values[1000];
+	pool.parallelFor(0, lengthof(values), [&values] (int i) {
+		values[i].increment(i);
+	}, 16);
+	for (int i = 0; i < lengthof(values); ++i) {
+		ASSERT_EQ(i, values[i]) << "Index " << i << " wasn't processed exactly once";
+	}
+}
+
+TEST_F(ThreadPoolTest, testParallelForNested) {
+	core::ThreadPool pool(2);
+	pool.init();
+	// every task of the pool blocks in its own parallelFor - the calling threads have to do the work
+	for (int i = 0; i < 4; ++i) {
+		pool.schedule([this, &pool] () {
+			pool.parallelFor(0, 100, [this] (int) {
+				++_count;
+			});
+		});
+	}
+	pool.shutdown(true);
+	EXPECT_EQ(400, _count);
+}
+
 }
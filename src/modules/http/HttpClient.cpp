@@ -3,13 +3,14 @@
  */
 
 #include "HttpClient.h"
-#include "Request.h"
+#include "core/Trace.h"
 #include "core/Log.h"
 #include "core/StandardLib.h"
 
 namespace http {
 
 HttpClient::HttpClient(const core::String &baseUrl) : _baseUrl(baseUrl) {
+	_connection.setTimeout(_requestTimeOut);
 }
 
 bool HttpClient::setBaseUrl(const core::String &baseUrl) {
@@ -18,27 +19,91 @@ bool HttpClient::setBaseUrl(const core::String &baseUrl) {
 	return u.valid();
 }
 
-ResponseParser HttpClient::get(const char *msg, ...) {
-	va_list ap;
+core::String HttpClient::url(const char *msg, va_list ap) const {
 	const size_t bufSize = 2048;
 	char text[bufSize];
-
-	va_start(ap, msg);
 	SDL_snprintf(text, bufSize, "%s", _baseUrl.c_str());
 	SDL_vsnprintf(text + _baseUrl.size(), bufSize - _baseUrl.size(), msg, ap);
 	text[sizeof(text) - 1] = '\0';
+	return text;
+}
+
+ResponseParser HttpClient::get(const char *msg, ...) {
+	va_list ap;
+	va_start(ap, msg);
+	const core::String& text = url(msg, ap);
 	va_end(ap);
 
 	Url u(text);
 	if (!u.valid()) {
-		Log::error("Invalid url given: '%s'", text);
+		Log::error("Invalid url given: '%s'", text.c_str());
 		return ResponseParser(nullptr, 0u);
 	}
-	Request request(u, HttpMethod::GET);
-	for (const auto& e : _headers) {
-		request.header(e->key, e->value);
+	// the server might have closed a reused connection in the meantime - retry once with a new connection
+	const int attempts = _connection.isConnected() ? 2 : 1;
+	for (int i = 0; i < attempts; ++i) {
+		if (!_connection.get(u, _headers)) {
+			continue;
+		}
+		ResponseParser response = _connection.read();
+		if (response.status != HttpStatus::Unknown) {
+			return response;
+		}
+	}
+	return ResponseParser(nullptr, 0u);
+}
+
+int HttpClient::stream(const core::String* paths, int amount, const HttpConnection::BodyCallback& callback) {
+	core_trace_scoped(HttpClientStream);
+	int successful = 0;
+	int next = 0;
+	bool mayRetry = _connection.isConnected();
+	bool received = false;
+	const HttpConnection::BodyCallback& bodyCallback = [&] (const uint8_t* data, size_t size) {
+		received = true;
+		return callback(data, size);
+	};
+	while (next < amount) {
+		int sent = 0;
+		for (int i = next; i < amount; ++i) {
+			const Url u(_baseUrl + paths[i]);
+			if (!u.valid()) {
+				Log::error("Invalid url given: '%s'", u.url.c_str());
+				break;
+			}
+			if (!_connection.get(u, _headers)) {
+				break;
+			}
+			++sent;
+		}
+		if (sent == 0) {
+			break;
+		}
+		int answered = 0;
+		for (; answered < sent; ++answered) {
+			const ResponseParser& response = _connection.read(bodyCallback);
+			if (response.status == HttpStatus::Unknown) {
+				break;
+			}
+			if (response.status == HttpStatus::Ok) {
+				++successful;
+			} else {
+				Log::warn("Request for '%s' failed with status %i", paths[next + answered].c_str(), (int)response.status);
+			}
+		}
+		next += answered;
+		if (answered == sent) {
+			continue;
+		}
+		// the connection was lost - the pipelined requests are sent again on a new connection if the server
+		// closed the reused connection before it answered anything
+		_connection.close();
+		if (!mayRetry || answered > 0 || received) {
+			break;
+		}
+		mayRetry = false;
 	}
-	return request.execute(_requestTimeOut);
+	return successful;
 }
 
 }
@@ -5,18 +5,29 @@
 #pragma once
 
 #include "ResponseParser.h"
+#include "HttpConnection.h"
 #include "core/Common.h"
 #include "core/String.h"
+#include "core/NonCopyable.h"
 #include "http/HttpHeader.h"
 #include "http/HttpResponse.h"
+#include <stdarg.h>
 
 namespace http {
 
-class HttpClient {
+/**
+ * @brief Http client that keeps the connection to the server alive between the requests.
+ *
+ * @note Not thread safe
+ */
+class HttpClient : public core::NonCopyable {
 private:
 	core::String _baseUrl;
 	int _requestTimeOut = 0;
 	http::HeaderMap _headers;
+	HttpConnection _connection;
+
+	core::String url(const char *msg, va_list ap) const;
 
 public:
 	HttpClient(const core::String &baseUrl = "");
@@ -37,6 +48,14 @@ public:
 	http::HeaderMap& headers();
 
 	ResponseParser get(CORE_FORMAT_STRING const char *msg, ...) CORE_PRINTF_VARARG_FUNC(2);
+
+	/**
+	 * @brief Sends the GET requests for all the given paths (relative to the base url) at once and hands the bodies
+	 * of the successful responses to the callback as they are received. The responses are read in the order of the
+	 * paths.
+	 * @return The amount of successful responses
+	 */
+	int stream(const core::String* paths, int amount, const HttpConnection::BodyCallback& callback);
 };
 
 inline http::HeaderMap& HttpClient::headers() {
@@ -45,6 +64,7 @@ inline http::HeaderMap& HttpClient::headers() {
 
 inline void HttpClient::setRequestTimeout(int seconds) {
 	_requestTimeOut = seconds;
+	_connection.setTimeout(seconds);
 }
 
 inline int HttpClient::requestTimeout() const {
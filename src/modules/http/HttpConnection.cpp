@@ -0,0 +1,311 @@
+/**
+ * @file
+ */
+
+#include "HttpConnection.h"
+#include "app/App.h"
+#include "core/Log.h"
+#include "core/Trace.h"
+#include "core/StringUtil.h"
+#include "core/ArrayLength.h"
+#include <SDL_stdinc.h>
+#include "Network.cpp.h"
+
+namespace http {
+
+HttpConnection::HttpConnection() :
+		_socket(INVALID_SOCKET) {
+}
+
+HttpConnection::~HttpConnection() {
+	close();
+}
+
+bool HttpConnection::isConnected() const {
+	return _socket != INVALID_SOCKET;
+}
+
+void HttpConnection::close() {
+	if (_socket == INVALID_SOCKET) {
+		return;
+	}
+	::closesocket(_socket);
+	_socket = INVALID_SOCKET;
+	_recvBuf.clear();
+	_recvPos = 0u;
+	_pendingResponses = 0;
+	network_cleanup();
+}
+
+bool HttpConnection::connect(const Url& url) {
+	if (_socket != INVALID_SOCKET) {
+		if (_hostname == url.hostname && _port == url.port) {
+			return true;
+		}
+		close();
+	}
+	if (!networkInit()) {
+		Log::error("Failed to initialize the network");
+		return false;
+	}
+	_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (_socket == INVALID_SOCKET) {
+		Log::error("Failed to initialize the socket");
+		network_cleanup();
+		return false;
+	}
+
+	struct addrinfo hints;
+	SDL_memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	struct addrinfo* results = nullptr;
+	if (getaddrinfo(url.hostname.c_str(), nullptr, &hints, &results) != 0) {
+		Log::error("Failed to resolve host for %s", url.hostname.c_str());
+		close();
+		return false;
+	}
+	const struct sockaddr_in* host_addr = (const struct sockaddr_in*) results->ai_addr;
+	struct sockaddr_in sin;
+	SDL_memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(url.port);
+	SDL_memcpy(&sin.sin_addr, &host_addr->sin_addr, sizeof(sin.sin_addr));
+	freeaddrinfo(results);
+	if (::connect(_socket, (const struct sockaddr *)&sin, sizeof(sin)) == -1) {
+		Log::error("Failed to connect to %s:%i", url.hostname.c_str(), url.port);
+		close();
+		return false;
+	}
+
+	if (_timeoutSeconds > 0) {
+#ifdef __WINDOWS__
+		DWORD timeout = _timeoutSeconds * 1000;
+		setsockopt(_socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+#else
+		struct timeval tv;
+		tv.tv_sec = _timeoutSeconds;
+		tv.tv_usec = 0;
+		setsockopt(_socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
+#endif
+	}
+	_hostname = url.hostname;
+	_port = url.port;
+	return true;
+}
+
+bool HttpConnection::get(const Url& url, const HeaderMap& headers) {
+	core_trace_scoped(HttpConnectionGet);
+	if (!url.valid()) {
+		Log::error("Invalid url given");
+		return false;
+	}
+	if (!connect(url)) {
+		return false;
+	}
+
+	HeaderMap requestHeaders(headers);
+	requestHeaders.put(header::USER_AGENT, app::App::getInstance()->appname().c_str());
+	requestHeaders.put(header::CONNECTION, "keep-alive");
+	if (!requestHeaders.hasKey(header::ACCEPT)) {
+		requestHeaders.put(header::ACCEPT, "*/*");
+	}
+	char headerBuf[1024];
+	if (!buildHeaderBuffer(headerBuf, lengthof(headerBuf), requestHeaders)) {
+		Log::error("Failed to assemble request header");
+		return false;
+	}
+	const core::String& message = core::string::format(
+			"GET %s%s%s HTTP/1.1\r\n"
+			"Host: %s\r\n"
+			"%s"
+			"\r\n",
+			url.path.c_str(),
+			(url.query.empty() ? "" : "?"),
+			url.query.c_str(),
+			url.hostname.c_str(),
+			headerBuf);
+
+	size_t sent = 0u;
+	while (sent < message.size()) {
+		const network_return ret = send(_socket, message.c_str() + sent, message.size() - sent, 0);
+		if (ret < 0) {
+			Log::error("Failed to perform http request to %s", url.url.c_str());
+			close();
+			return false;
+		}
+		sent += ret;
+	}
+	++_pendingResponses;
+	return true;
+}
+
+size_t HttpConnection::available() const {
+	return _recvBuf.size() - _recvPos;
+}
+
+const uint8_t* HttpConnection::pending() const {
+	return _recvBuf.data() + _recvPos;
+}
+
+void HttpConnection::consume(size_t bytes) {
+	core_assert(bytes <= available());
+	_recvPos += bytes;
+	if (_recvPos == _recvBuf.size()) {
+		_recvBuf.clear();
+		_recvPos = 0u;
+	}
+}
+
+bool HttpConnection::receive() {
+	if (_recvPos > 0u) {
+		_recvBuf.erase(0, _recvPos);
+		_recvPos = 0u;
+	}
+	uint8_t buf[16 * 1024];
+	const network_return received = recv(_socket, (char*)buf, sizeof(buf), 0);
+	if (received <= 0) {
+		return false;
+	}
+	_recvBuf.append(buf, (size_t)received);
+	return true;
+}
+
+bool HttpConnection::readLine(core::String& line) {
+	size_t searchStart = 0u;
+	for (;;) {
+		const uint8_t* data = pending();
+		const size_t size = available();
+		for (size_t i = searchStart; i + 1u < size; ++i) {
+			if (data[i] == '\r' && data[i + 1] == '\n') {
+				line = core::String((const char*)data, i);
+				consume(i + 2u);
+				return true;
+			}
+		}
+		searchStart = size > 0u ? size - 1u : 0u;
+		if (!receive()) {
+			return false;
+		}
+	}
+}
+
+bool HttpConnection::readBody(size_t length, const BodyCallback& callback) {
+	while (length > 0u) {
+		if (available() == 0u && !receive()) {
+			return false;
+		}
+		const size_t n = core_min(length, available());
+		if (!callback(pending(), n)) {
+			return false;
+		}
+		consume(n);
+		length -= n;
+	}
+	return true;
+}
+
+bool HttpConnection::readChunkedBody(const BodyCallback& callback) {
+	core::String line;
+	for (;;) {
+		if (!readLine(line)) {
+			return false;
+		}
+		const size_t chunkSize = (size_t)SDL_strtoul(line.c_str(), nullptr, 16);
+		if (chunkSize == 0u) {
+			break;
+		}
+		if (!readBody(chunkSize, callback)) {
+			return false;
+		}
+		if (!readLine(line)) {
+			return false;
+		}
+	}
+	// trailers - terminated by an empty line
+	do {
+		if (!readLine(line)) {
+			return false;
+		}
+	} while (!line.empty());
+	return true;
+}
+
+ResponseParser HttpConnection::read(const BodyCallback& callback) {
+	core_trace_scoped(HttpConnectionRead);
+	if (_socket == INVALID_SOCKET || _pendingResponses <= 0) {
+		return ResponseParser(nullptr, 0u);
+	}
+	--_pendingResponses;
+
+	// collect the header until the empty line
+	core::String rawHeader;
+	core::String line;
+	for (;;) {
+		if (!readLine(line)) {
+			Log::debug("Connection to %s was closed", _hostname.c_str());
+			close();
+			return ResponseParser(nullptr, 0u);
+		}
+		rawHeader += line;
+		rawHeader += "\r\n";
+		if (line.empty()) {
+			break;
+		}
+	}
+	uint8_t *headerBuf = (uint8_t*)SDL_malloc(rawHeader.size());
+	SDL_memcpy(headerBuf, rawHeader.c_str(), rawHeader.size());
+	ResponseParser response(headerBuf, rawHeader.size());
+
+	core::DynamicArray<uint8_t> body;
+	BodyCallback bodyCallback = callback;
+	// the bodies of error responses are kept for the caller
+	const bool successStatus = (int)response.status >= 200 && (int)response.status < 300;
+	if (!bodyCallback || !successStatus) {
+		bodyCallback = [&body] (const uint8_t* data, size_t size) {
+			body.append(data, size);
+			return true;
+		};
+	}
+
+	bool success;
+	bool closeConnection = response.isHeaderValue(header::CONNECTION, "close");
+	const char *contentLength = response.headerValue(header::CONTENT_LENGTH);
+	if (response.isHeaderValue(header::TRANSFER_ENCODING, "chunked")) {
+		success = readChunkedBody(bodyCallback);
+	} else if (contentLength != nullptr) {
+		success = readBody((size_t)SDL_strtoul(contentLength, nullptr, 10), bodyCallback);
+	} else {
+		// the body ends with the connection
+		success = true;
+		closeConnection = true;
+		while (available() > 0u || receive()) {
+			if (!bodyCallback(pending(), available())) {
+				break;
+			}
+			consume(available());
+		}
+	}
+	if (!success || closeConnection) {
+		close();
+	}
+	if (!success) {
+		Log::error("Failed to read the http response from %s", _hostname.c_str());
+		response.status = HttpStatus::Unknown;
+		return response;
+	}
+	if (callback && successStatus) {
+		return response;
+	}
+	// the parser owns the complete response
+	const size_t size = rawHeader.size() + body.size();
+	uint8_t *responseBuf = (uint8_t*)SDL_malloc(size);
+	SDL_memcpy(responseBuf, rawHeader.c_str(), rawHeader.size());
+	if (!body.empty()) {
+		SDL_memcpy(responseBuf + rawHeader.size(), body.data(), body.size());
+	}
+	return ResponseParser(responseBuf, size);
+}
+
+}
@@ -0,0 +1,89 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "ResponseParser.h"
+#include "HttpHeader.h"
+#include "Url.h"
+#include "Network.h"
+#include "core/NonCopyable.h"
+#include "core/collection/DynamicArray.h"
+#include <functional>
+
+namespace http {
+
+/**
+ * @brief A keep-alive connection to one http server.
+ *
+ * Several requests can be sent before their responses are read (pipelining) - the responses are read in the
+ * order of the requests. The connection is reestablished if the next request goes to another host.
+ *
+ * @note Not thread safe
+ */
+class HttpConnection : public core::NonCopyable {
+public:
+	/**
+	 * @return @c false to abort the transfer - the connection is closed in that case
+	 */
+	using BodyCallback = std::function<bool(const uint8_t* data, size_t size)>;
+private:
+	SOCKET _socket;
+	core::String _hostname;
+	uint16_t _port = 0u;
+	int _timeoutSeconds = 10;
+	// received bytes that were not yet consumed
+	core::DynamicArray<uint8_t> _recvBuf;
+	size_t _recvPos = 0u;
+	// the amount of requests that were sent without reading the response
+	int _pendingResponses = 0;
+
+	bool connect(const Url& url);
+	/**
+	 * @brief Receives more data from the server
+	 * @return @c false if the connection was closed or an error occurred
+	 */
+	bool receive();
+	size_t available() const;
+	const uint8_t* pending() const;
+	void consume(size_t bytes);
+	/**
+	 * @return The line without the line break or @c false if the connection was closed before the line was complete
+	 */
+	bool readLine(core::String& line);
+	bool readBody(size_t length, const BodyCallback& callback);
+	bool readChunkedBody(const BodyCallback& callback);
+public:
+	HttpConnection();
+	~HttpConnection();
+
+	void setTimeout(int seconds);
+
+	/**
+	 * @brief Sends a GET request to the server of the given url. Connects to the server if needed.
+	 */
+	bool get(const Url& url, const HeaderMap& headers);
+	/**
+	 * @brief Reads the response of the oldest request that was sent. The body is given to the callback as it
+	 * is received.
+	 * @param[in] callback Receives the body of successful responses. If this is empty or the status code is not
+	 * 2xx, the body is part of the returned response.
+	 * @return The parsed response. The @c status is @c HttpStatus::Unknown if the server didn't answer.
+	 */
+	ResponseParser read(const BodyCallback& callback = BodyCallback());
+	void close();
+
+	bool isConnected() const;
+	int pendingResponses() const;
+};
+
+inline void HttpConnection::setTimeout(int seconds) {
+	_timeoutSeconds = seconds;
+}
+
+inline int HttpConnection::pendingResponses() const {
+	return _pendingResponses;
+}
+
+}
@@ -23,6 +23,7 @@ static constexpr const char *ACCEPT = "Accept";
 static constexpr const char *SERVER = "Server";
 static constexpr const char *HOST = "Host";
 static constexpr const char *CONTENT_LENGTH = "Content-length";
+static constexpr const char *TRANSFER_ENCODING = "Transfer-Encoding";
 }
 
 extern bool buildHeaderBuffer(char *buf, size_t len, const HeaderMap& headers);
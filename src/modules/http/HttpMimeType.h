@@ -10,6 +10,7 @@ namespace mimetype {
 static constexpr const char *TEXT_PLAIN = "text/plain";
 static constexpr const char *TEXT_HTML = "text/html";
 static constexpr const char *APPLICATION_CHUNK = "application/chunk";
+static constexpr const char *APPLICATION_CHUNK_STREAM = "application/chunkstream";
 static constexpr const char *APPLICATION_JSON = "application/json";
 static constexpr const char *URL_ENCODE = "application/x-www-form-urlencoded";
 
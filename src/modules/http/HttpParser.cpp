@@ -12,6 +12,10 @@ HttpParser::HttpParser(uint8_t* buffer, const size_t bufferSize) :
 }
 
 HttpParser& HttpParser::operator=(HttpParser&& other) noexcept {
+	if (&other == this) {
+		return *this;
+	}
+	SDL_free(buf);
 	buf = other.buf;
 	bufSize = other.bufSize;
 	_valid = other._valid;
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "HttpHeader.h"
+#include "core/Common.h"
 #include <stdint.h>
 
 #define HTTP_PARSER_NEW_BASE(ptr) newBase(buf, other.buf, ptr)
@@ -28,7 +29,8 @@ protected:
 		return (const char*)newBufPtr + (intptr_t)((const uint8_t*)oldPtr - (const uint8_t*)oldBufPtr);
 	}
 	static inline auto newBase(const void* newBufPtr, const void* oldBufPtr, const core::CharPointerMap& map) {
-		core::CharPointerMap newMap(map.size());
+		// the pool of the map needs at least two slots
+		core::CharPointerMap newMap(core_max((int)map.size(), 2));
 		if (oldBufPtr == nullptr) {
 			return newMap;
 		}
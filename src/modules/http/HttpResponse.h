@@ -5,10 +5,12 @@
 #pragma once
 
 #include "core/String.h"
+#include "core/ByteStream.h"
 #include "HttpStatus.h"
 #include "HttpHeader.h"
 #include "HttpMimeType.h"
 #include <SDL_stdinc.h>
+#include <functional>
 
 namespace http {
 
@@ -21,11 +23,43 @@ struct HttpResponse {
 	// if the route handler sets this to false, the memory is not freed. Can be useful for static content
 	// like error pages.
 	bool freeBody = true;
+	/**
+	 * @brief If set, this is called instead of freeing the @c body after it was sent. The body is sent directly
+	 * from this memory - so memory of other allocators can be handed to the server without copying it.
+	 */
+	std::function<void(const char *body)> releaseBody;
+	/**
+	 * @brief If set, the @c body is ignored and the response is sent with chunked transfer encoding. The server
+	 * calls the function again on one of its worker threads whenever the previous part was sent. Each call may
+	 * append the next part of the body to the given stream and returns @c false after the last part was added.
+	 */
+	std::function<bool(core::ByteStream& out)> stream;
 
 	void contentLength(size_t len) {
 		bodySize = len;
 	}
 
+	void setBody(const char *body, size_t size, const std::function<void(const char *body)>& release) {
+		this->body = body;
+		contentLength(size);
+		freeBody = false;
+		releaseBody = release;
+	}
+
+	/**
+	 * @brief Frees the body if it is owned by the response
+	 */
+	void release() {
+		if (releaseBody) {
+			releaseBody(body);
+			releaseBody = nullptr;
+		} else if (freeBody) {
+			SDL_free((char*)body);
+		}
+		body = nullptr;
+		bodySize = 0u;
+	}
+
 	void setText(const char *body) {
 		this->body = body;
 		contentLength(SDL_strlen(body));
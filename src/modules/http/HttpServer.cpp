@@ -6,18 +6,21 @@
 #include "RequestParser.h"
 #include "core/Assert.h"
 #include "core/ArrayLength.h"
+#include "core/Common.h"
 #include "core/Log.h"
 #include "Network.cpp.h"
 #include "app/App.h"
 #include <string.h>
+#include <errno.h>
 #include <SDL_stdinc.h>
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
 
 namespace http {
 
 HttpServer::HttpServer(const metric::MetricPtr& metric) :
 		_socketFD(INVALID_SOCKET), _metric(metric) {
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
 }
 
 HttpServer::~HttpServer() {
@@ -53,6 +56,9 @@ bool HttpServer::unregisterRoute(HttpMethod method, const char *path) {
 }
 
 bool HttpServer::init(int16_t port) {
+	if (!networkInit()) {
+		return false;
+	}
 	_socketFD = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
 	if (_socketFD == INVALID_SOCKET) {
 		network_cleanup();
@@ -64,9 +70,6 @@ bool HttpServer::init(int16_t port) {
 	sin.sin_addr.s_addr = INADDR_ANY;
 	sin.sin_port = htons(port);
 
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
-
 	int t = 1;
 #ifdef _WIN32
 	if (setsockopt(_socketFD, SOL_SOCKET, SO_REUSEADDR, (char*) &t, sizeof(t)) != 0) {
@@ -86,7 +89,7 @@ bool HttpServer::init(int16_t port) {
 		return false;
 	}
 
-	if (listen(_socketFD, 5) < 0) {
+	if (listen(_socketFD, SOMAXCONN) < 0) {
 		network_cleanup();
 		closesocket(_socketFD);
 		_socketFD = INVALID_SOCKET;
@@ -95,191 +98,453 @@ bool HttpServer::init(int16_t port) {
 
 	networkNonBlocking(_socketFD);
 
-	FD_SET(_socketFD, &_readFDSet);
+	// the listen socket is the only one without userdata
+	if (!_poller.init() || !_poller.add(_socketFD, SocketPoller::Read, nullptr)) {
+		_poller.shutdown();
+		network_cleanup();
+		closesocket(_socketFD);
+		_socketFD = INVALID_SOCKET;
+		return false;
+	}
+
+	// the streamed parts are produced on the workers - the producers might block on loading their data
+	_threadPool = std::make_unique<core::ThreadPool>(core_max(_workers, (size_t)1u), "HttpServer");
+	_threadPool->init();
 
 	return true;
 }
 
-HttpServer::ClientSocketsIter HttpServer::closeClient(ClientSocketsIter& iter) {
-	Client& client = *iter;
-	const SOCKET clientSocket = client.socket;
-	FD_CLR(clientSocket, &_readFDSet);
-	FD_CLR(clientSocket, &_writeFDSet);
-	closesocket(clientSocket);
-	client.socket = INVALID_SOCKET;
-	SDL_free(client.request);
-	SDL_free(client.response);
-	return _clientSockets.erase(iter);
+void HttpServer::closeClient(Client* client) {
+	_poller.remove(client->socket);
+	closesocket(client->socket);
+	client->socket = INVALID_SOCKET;
+	SDL_free(client->request);
+	client->request = nullptr;
+	client->requestLength = 0u;
+	client->resetResponse();
+
+	Client* last = _clients[_clients.size() - 1];
+	last->index = client->index;
+	_clients[client->index] = last;
+	_clients.pop();
+	// the worker still needs the client - it is deleted once the response arrived
+	if (!client->busy) {
+		delete client;
+	}
 }
 
-bool HttpServer::update() {
-	core_trace_scoped(HttpServerUpdate);
-	fd_set readFDsOut;
-	fd_set writeFDsOut;
+void HttpServer::acceptClients() {
+	// the listen socket is non-blocking - take all the pending connections, but don't starve the other clients
+	for (int n = 0; n < 64; ++n) {
+		const SOCKET clientSocket = accept(_socketFD, nullptr, nullptr);
+		if (clientSocket == INVALID_SOCKET) {
+			return;
+		}
+		networkNonBlocking(clientSocket);
+		// the parts of streamed responses should not wait for more data
+		int t = 1;
+#ifdef _WIN32
+		setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, (char*) &t, sizeof(t));
+#else
+		setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &t, sizeof(t));
+#endif
+		Client* client = new Client();
+		client->socket = clientSocket;
+		client->events = SocketPoller::Read;
+		if (!_poller.add(clientSocket, client->events, client)) {
+			Log::warn("Failed to watch the client socket");
+			closesocket(clientSocket);
+			delete client;
+			continue;
+		}
+		client->index = _clients.size();
+		_clients.push_back(client);
+	}
+}
 
-	SDL_memcpy(&readFDsOut, &_readFDSet, sizeof(readFDsOut));
-	SDL_memcpy(&writeFDsOut, &_writeFDSet, sizeof(writeFDsOut));
+bool HttpServer::update(int timeoutMillis) {
+	core_trace_scoped(HttpServerUpdate);
+	finishRequests();
+	if (_inflight > 0 && (timeoutMillis < 0 || timeoutMillis > 1)) {
+		// don't block the responses of the workers for too long
+		timeoutMillis = 1;
+	}
 
-	struct timeval tv;
-	tv.tv_sec = 0;
-	tv.tv_usec = 0;
-	const int ready = select(FD_SETSIZE, &readFDsOut, &writeFDsOut, nullptr, &tv);
-	if (ready < 0) {
+	SocketPoller::Event events[128];
+	const int n = _poller.wait(events, lengthof(events), timeoutMillis);
+	if (n < 0) {
 		return false;
 	}
-	if (_socketFD != INVALID_SOCKET && FD_ISSET(_socketFD, &readFDsOut)) {
-		const SOCKET clientSocket = accept(_socketFD, nullptr, nullptr);
-		if (clientSocket != INVALID_SOCKET) {
-			FD_SET(clientSocket, &_readFDSet);
-			Client c;
-			c.socket = clientSocket;
-			_clientSockets.insert(c);
-			networkNonBlocking(clientSocket);
+	for (int i = 0; i < n; ++i) {
+		if (events[i].userdata == nullptr) {
+			acceptClients();
+			continue;
+		}
+		Client* client = (Client*)events[i].userdata;
+		if (!handleEvents(*client, events[i].events)) {
+			closeClient(client);
 		}
 	}
+	finishRequests();
+	return true;
+}
 
-	for (ClientSocketsIter i = _clientSockets.begin(); i != _clientSockets.end();) {
-		Client& client = *i;
-		const SOCKET clientSocket = client.socket;
-		if (clientSocket == INVALID_SOCKET) {
-			i = closeClient(i);
-			continue;
+bool HttpServer::writeResponse(Client& client) {
+	if (!sendMessage(client)) {
+		return false;
+	}
+	if (client.stream && client.alreadySent == client.responseLength()) {
+		if (!produceStreamPart(client)) {
+			return false;
 		}
-
-		if (FD_ISSET(clientSocket, &writeFDsOut)) {
-			if (!sendMessage(client) || client.finished()) {
-				i = closeClient(i);
-			} else {
-				++i;
-			}
-			continue;
+	}
+	if (client.finished()) {
+		if (!client.keepAlive) {
+			return false;
 		}
+		// wait for the next request on this connection
+		client.resetResponse();
+	}
+	return true;
+}
 
-		if (!FD_ISSET(clientSocket, &readFDsOut)) {
-			++i;
-			continue;
+bool HttpServer::handleEvents(Client& client, uint8_t events) {
+	if ((events & SocketPoller::Write) && client.head != nullptr) {
+		if (!writeResponse(client)) {
+			return false;
 		}
-
-		constexpr const int BUFFERSIZE = 2048;
+	} else if (events & SocketPoller::Read) {
+		constexpr const int BUFFERSIZE = 16384;
 		uint8_t recvBuf[BUFFERSIZE];
-		const network_return len = recv(clientSocket, (char*)recvBuf, BUFFERSIZE - 1, 0);
-		if (len < 0) {
-			i = closeClient(i);
-			continue;
-		}
-		if (len == 0) {
-			++i;
-			continue;
+		const network_return len = recv(client.socket, (char*)recvBuf, BUFFERSIZE, 0);
+		if (len <= 0) {
+			// error or the client closed the connection
+			return false;
 		}
-
 		client.request = (uint8_t*)SDL_realloc(client.request, client.requestLength + len);
 		SDL_memcpy(client.request + client.requestLength, recvBuf, len);
 		client.requestLength += len;
+	} else if (events & SocketPoller::Error) {
+		return false;
+	}
 
-		if (client.requestLength == 0) {
-			++i;
-			continue;
+	// pipelined requests might already be in the buffer - the responses are sent right away, the poller only
+	// waits for the socket to become writable if they don't fit into the send buffer
+	while (client.head == nullptr && !client.busy) {
+		handleRequest(client);
+		if (client.head == nullptr) {
+			break;
 		}
-
-		// GET / HTTP/1.1\r\n\r\n
-		if (client.requestLength < 18) {
-			++i;
-			continue;
+		if (!writeResponse(client)) {
+			return false;
 		}
+	}
+	watch(client);
+	return true;
+}
 
-		if (SDL_memcmp(client.request, "GET", 3) != 0 && SDL_memcmp(client.request, "POST", 4) != 0) {
-			FD_CLR(clientSocket, &_readFDSet);
-			FD_CLR(clientSocket, &readFDsOut);
-			assembleError(client, HttpStatus::NotImplemented);
-			++i;
-			continue;
-		}
+void HttpServer::watch(Client& client) {
+	uint8_t events = SocketPoller::None;
+	if (client.busy) {
+		// wait for the worker
+	} else if (client.head != nullptr) {
+		events = SocketPoller::Write;
+	} else {
+		events = SocketPoller::Read;
+	}
+	if (events == client.events) {
+		return;
+	}
+	client.events = events;
+	_poller.modify(client.socket, events, &client);
+}
 
-		if (client.requestLength > _maxRequestBytes) {
-			FD_CLR(clientSocket, &_readFDSet);
-			FD_CLR(clientSocket, &readFDsOut);
-			assembleError(client, HttpStatus::InternalServerError);
-			++i;
+size_t HttpServer::requestSize(const uint8_t* buf, size_t length) {
+	// the buffer isn't null terminated
+	for (size_t i = 0u; i + 4u <= length; ++i) {
+		if (SDL_memcmp(buf + i, "\r\n\r\n", 4) != 0) {
 			continue;
 		}
-
-		uint8_t *mem = (uint8_t *)SDL_malloc(client.requestLength);
-		SDL_memcpy(mem, client.request, client.requestLength);
-		const RequestParser request(mem, client.requestLength);
-		if (!request.valid()) {
-			++i;
-			continue;
+		const size_t headerSize = i + 4u;
+		size_t contentLength = 0u;
+		const size_t contentLengthKeySize = SDL_strlen(header::CONTENT_LENGTH);
+		for (size_t l = 0u; l + 2u + contentLengthKeySize < i; ++l) {
+			if (SDL_memcmp(buf + l, "\r\n", 2) != 0) {
+				continue;
+			}
+			const char *line = (const char*)buf + l + 2u;
+			if (SDL_strncasecmp(line, header::CONTENT_LENGTH, contentLengthKeySize) != 0 || line[contentLengthKeySize] != ':') {
+				continue;
+			}
+			contentLength = (size_t)SDL_strtoul(line + contentLengthKeySize + 1, nullptr, 10);
+			break;
+		}
+		if (headerSize + contentLength > length) {
+			return 0u;
 		}
+		return headerSize + contentLength;
+	}
+	return 0u;
+}
+
+void HttpServer::handleRequest(Client& client) {
+	// GET / HTTP/1.1\r\n\r\n
+	if (client.requestLength < 18) {
+		return;
+	}
+
+	if (SDL_memcmp(client.request, "GET", 3) != 0 && SDL_memcmp(client.request, "POST", 4) != 0) {
+		client.keepAlive = false;
+		assembleError(client, HttpStatus::NotImplemented);
+		return;
+	}
+
+	const size_t size = requestSize(client.request, client.requestLength);
+	if (size > _maxRequestBytes || (size == 0u && client.requestLength > _maxRequestBytes)) {
+		client.keepAlive = false;
+		assembleError(client, HttpStatus::InternalServerError);
+		return;
+	}
+	if (size == 0u) {
+		return;
+	}
 
-		FD_CLR(clientSocket, &_readFDSet);
-		FD_CLR(clientSocket, &readFDsOut);
+	uint8_t *mem = (uint8_t *)SDL_malloc(size);
+	SDL_memcpy(mem, client.request, size);
+	client.consumeRequest(size);
+	RequestParser request(mem, size);
+	if (!request.valid()) {
+		client.keepAlive = false;
+		assembleError(client, HttpStatus::BadRequest);
+		return;
+	}
 
-		HttpResponse response;
-		if (!route(request, response)) {
-			assembleError(client, HttpStatus::NotFound);
-			++i;
+	const char *connection = request.headerValue(header::CONNECTION);
+	client.keepAlive = connection != nullptr && SDL_strcasecmp(connection, "keep-alive") == 0;
+
+	if (_workers > 0u) {
+		// the request is answered in finishRequests() - pipelined requests wait until then
+		client.busy = true;
+		++_inflight;
+		RequestParser* r = new RequestParser(core::move(request));
+		Client* c = &client;
+		const bool keepAlive = client.keepAlive;
+		_threadPool->schedule([this, c, r, keepAlive] () {
+			HttpResponse* response = new HttpResponse();
+			const bool found = route(*r, *response, keepAlive);
+			delete r;
+			core::ScopedLock lock(_finishedLock);
+			_finished.push_back(FinishedRequest{c, response, found});
+		});
+		return;
+	}
+
+	HttpResponse response;
+	const bool found = route(request, response, client.keepAlive);
+	respond(client, response, found);
+}
+
+void HttpServer::finishRequests() {
+	if (_inflight <= 0) {
+		return;
+	}
+	core::DynamicArray<FinishedRequest> finished;
+	core::DynamicArray<FinishedPart> finishedParts;
+	{
+		core::ScopedLock lock(_finishedLock);
+		if (_finished.empty() && _finishedParts.empty()) {
+			return;
+		}
+		if (!_finished.empty()) {
+			finished.reserve(_finished.size());
+			finished.append(&_finished[0], _finished.size());
+			_finished.clear();
+		}
+		if (!_finishedParts.empty()) {
+			finishedParts.reserve(_finishedParts.size());
+			finishedParts.append(&_finishedParts[0], _finishedParts.size());
+			_finishedParts.clear();
+		}
+	}
+	for (FinishedPart& p : finishedParts) {
+		--_inflight;
+		Client* client = p.client;
+		client->busy = false;
+		if (client->socket == INVALID_SOCKET) {
+			// the connection was closed while the worker was busy
+			SDL_free(p.part);
+			delete client;
 			continue;
 		}
-		assembleResponse(client, response);
-		if (response.freeBody) {
-			SDL_free((char*)response.body);
+		client->stream = core::move(p.stream);
+		SDL_free(client->head);
+		client->head = nullptr;
+		client->setResponse(p.part, p.partSize);
+		if (!handleEvents(*client, SocketPoller::Write)) {
+			closeClient(client);
+		}
+	}
+	for (FinishedRequest& f : finished) {
+		--_inflight;
+		Client* client = f.client;
+		client->busy = false;
+		if (client->socket == INVALID_SOCKET) {
+			// the connection was closed while the worker was busy
+			f.response->release();
+			delete f.response;
+			delete client;
+			continue;
+		}
+		respond(*client, *f.response, f.found);
+		delete f.response;
+		if (!handleEvents(*client, SocketPoller::Write)) {
+			closeClient(client);
 		}
 	}
-	return true;
+}
+
+void HttpServer::respond(Client& client, HttpResponse& response, bool found) {
+	if (!found) {
+		response.release();
+		client.keepAlive = false;
+		assembleError(client, HttpStatus::NotFound);
+		return;
+	}
+	assembleResponse(client, response);
 }
 
 void HttpServer::assembleError(Client& client, HttpStatus status) {
+	const char *errorPage = "";
+	_errorPages.get((int)status, errorPage);
+
 	char buf[512];
 	SDL_snprintf(buf, sizeof(buf),
 			"HTTP/1.1 %i %s\r\n"
+			"Content-length: %u\r\n"
 			"Connection: close\r\n"
 			"Server: %s\r\n"
 			"\r\n",
 			(int)status,
 			toStatusString(status),
+			(unsigned int)SDL_strlen(errorPage),
 			app::App::getInstance()->appname().c_str());
 
-	const char *errorPage = "";
-	_errorPages.get((int)status, errorPage);
-
 	const size_t responseSize = SDL_strlen(errorPage) + SDL_strlen(buf);
 	char *responseBuf = (char*)SDL_malloc(responseSize + 1);
 	SDL_snprintf(responseBuf, responseSize + 1, "%s%s", buf, errorPage);
 	client.setResponse(responseBuf, responseSize);
 	metric(status);
-	FD_SET(client.socket, &_writeFDSet);
 }
 
-void HttpServer::assembleResponse(Client& client, const HttpResponse& response) {
+void HttpServer::assembleResponse(Client& client, HttpResponse& response) {
 	char headers[2048];
 	if (!buildHeaderBuffer(headers, lengthof(headers), response.headers)) {
+		response.release();
 		assembleError(client, HttpStatus::InternalServerError);
 		return;
 	}
 
 	char buf[4096];
-	const int headerSize = SDL_snprintf(buf, sizeof(buf),
-			"HTTP/1.1 %i %s\r\n"
-			"Content-length: %u\r\n"
-			"%s"
-			"\r\n",
-			(int)response.status,
-			toStatusString(response.status),
-			(unsigned int)response.bodySize,
-			headers);
+	int headerSize;
+	if (response.stream) {
+		headerSize = SDL_snprintf(buf, sizeof(buf),
+				"HTTP/1.1 %i %s\r\n"
+				"%s: chunked\r\n"
+				"%s"
+				"\r\n",
+				(int)response.status,
+				toStatusString(response.status),
+				header::TRANSFER_ENCODING,
+				headers);
+	} else {
+		headerSize = SDL_snprintf(buf, sizeof(buf),
+				"HTTP/1.1 %i %s\r\n"
+				"Content-length: %u\r\n"
+				"%s"
+				"\r\n",
+				(int)response.status,
+				toStatusString(response.status),
+				(unsigned int)response.bodySize,
+				headers);
+	}
 	if (headerSize >= lengthof(buf)) {
+		response.release();
 		assembleError(client, HttpStatus::InternalServerError);
 		return;
 	}
 
-	const size_t responseSize = response.bodySize + SDL_strlen(buf);
-	char *responseBuf = (char*)SDL_malloc(responseSize);
+	char *responseBuf = (char*)SDL_malloc(headerSize);
 	SDL_memcpy(responseBuf, buf, headerSize);
-	SDL_memcpy(responseBuf + headerSize, response.body, response.bodySize);
-	client.setResponse(responseBuf, responseSize);
-	Log::trace("Response buffer of size %i", (int)responseSize);
+	client.setResponse(responseBuf, headerSize);
+	if (response.stream) {
+		client.stream = response.stream;
+		response.release();
+	} else {
+		// the body is sent without copying it and released after it was sent
+		client.body = response.body;
+		client.bodyLength = response.bodySize;
+		if (response.releaseBody) {
+			client.releaseBody = response.releaseBody;
+		} else if (response.freeBody) {
+			client.releaseBody = [] (const char *body) {
+				SDL_free((char*)body);
+			};
+		}
+		response.body = nullptr;
+		response.bodySize = 0u;
+		response.releaseBody = nullptr;
+	}
+	Log::trace("Response header of size %i and body of size %i", headerSize, (int)client.bodyLength);
 	metric(response.status);
-	FD_SET(client.socket, &_writeFDSet);
+}
+
+bool HttpServer::produceStreamPart(Client& client) {
+	core_assert(!client.busy);
+	// the producer is handed to the worker and comes back with the part - closeClient() must not release it while
+	// the worker is using it
+	client.busy = true;
+	++_inflight;
+	Client* c = &client;
+	StreamCallback producer = core::move(client.stream);
+	client.stream = nullptr;
+	const bool scheduled = _threadPool->schedule([this, c, stream = core::move(producer)] () mutable {
+		core_trace_scoped(HttpServerStreamPart);
+		core::ByteStream out;
+		const bool more = stream(out);
+		size_t partSize = 0u;
+		char *part = assembleStreamPart(out, more, partSize);
+		if (!more) {
+			stream = nullptr;
+		}
+		core::ScopedLock lock(_finishedLock);
+		_finishedParts.push_back(FinishedPart{c, part, partSize, core::move(stream)});
+	});
+	if (!scheduled) {
+		client.busy = false;
+		--_inflight;
+		return false;
+	}
+	return true;
+}
+
+char* HttpServer::assembleStreamPart(const core::ByteStream& out, bool more, size_t& partSize) {
+	const size_t size = out.getSize();
+	// chunk header and trailer plus the terminating zero length chunk
+	char *responseBuf = (char*)SDL_malloc(size + 32);
+	size_t responseSize = 0u;
+	if (size > 0u) {
+		responseSize += SDL_snprintf(responseBuf, 16, "%x\r\n", (unsigned int)size);
+		SDL_memcpy(responseBuf + responseSize, out.getBuffer(), size);
+		responseSize += size;
+		SDL_memcpy(responseBuf + responseSize, "\r\n", 2);
+		responseSize += 2;
+	}
+	if (!more) {
+		SDL_memcpy(responseBuf + responseSize, "0\r\n\r\n", 5);
+		responseSize += 5;
+	}
+	partSize = responseSize;
+	return responseBuf;
 }
 
 void HttpServer::metric(HttpStatus status) const {
@@ -288,27 +553,65 @@ void HttpServer::metric(HttpStatus status) const {
 	_metric->count("http.request", 1, {{"status", buf}});
 }
 
+/**
+ * @brief Sends the not yet sent parts of the head and the body with one call
+ */
+static network_return sendParts(SOCKET socket, const char *head, size_t headLength, const char *body, size_t bodyLength, size_t alreadySent) {
+	const char *parts[2];
+	size_t lengths[2];
+	int n = 0;
+	if (alreadySent < headLength) {
+		parts[n] = head + alreadySent;
+		lengths[n++] = headLength - alreadySent;
+		alreadySent = 0u;
+	} else {
+		alreadySent -= headLength;
+	}
+	if (bodyLength > alreadySent) {
+		parts[n] = body + alreadySent;
+		lengths[n++] = bodyLength - alreadySent;
+	}
+#ifdef _WIN32
+	WSABUF buffers[2];
+	for (int i = 0; i < n; ++i) {
+		buffers[i].buf = (CHAR*)parts[i];
+		buffers[i].len = (ULONG)lengths[i];
+	}
+	DWORD sent = 0;
+	if (WSASend(socket, buffers, n, &sent, 0, nullptr, nullptr) != 0) {
+		return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : -1;
+	}
+	return (network_return)sent;
+#else
+	struct iovec buffers[2];
+	for (int i = 0; i < n; ++i) {
+		buffers[i].iov_base = (void*)parts[i];
+		buffers[i].iov_len = lengths[i];
+	}
+	const network_return sent = writev(socket, buffers, n);
+	if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+		return 0;
+	}
+	return sent;
+#endif
+}
+
 bool HttpServer::sendMessage(Client& client) {
-	core_assert(client.response != nullptr);
-	int remaining = (int)client.responseLength - (int)client.alreadySent;
-	if (remaining <= 0) {
-		return false;
+	core_assert(client.head != nullptr);
+	if (client.alreadySent >= client.responseLength()) {
+		// a streamed response that doesn't have the next part yet
+		return true;
 	}
-	const char* p = client.response + client.alreadySent;
-	const network_return sent = ::send(client.socket, p, remaining, 0);
+	const network_return sent = sendParts(client.socket, client.head, client.headLength, client.body, client.bodyLength, client.alreadySent);
 	if (sent < 0) {
 		Log::debug("Failed to send to the client");
 		return false;
 	}
-	if (sent == 0) {
-		return true;
-	}
-	remaining -= sent;
 	client.alreadySent += sent;
-	return remaining > 0;
+	return true;
 }
 
-bool HttpServer::route(const RequestParser& request, HttpResponse& response) {
+bool HttpServer::route(const RequestParser& request, HttpResponse& response, bool keepAlive) {
 	Routes* routes = getRoutes(request.method);
 	Log::trace("lookup for %s", request.path);
 	auto i = routes->find(request.path);
@@ -340,7 +643,7 @@ bool HttpServer::route(const RequestParser& request, HttpResponse& response) {
 		return false;
 	}
 	response.headers.put(header::CONTENT_TYPE, http::mimetype::TEXT_PLAIN);
-	response.headers.put(header::CONNECTION, "close");
+	response.headers.put(header::CONNECTION, keepAlive ? "keep-alive" : "close");
 	response.headers.put(header::SERVER, app::App::getInstance()->appname().c_str());
 	// TODO urldecode of request data
 	//core::string::urlDecode(request.query);
@@ -349,23 +652,31 @@ bool HttpServer::route(const RequestParser& request, HttpResponse& response) {
 }
 
 void HttpServer::shutdown() {
+	// the clients are closed first - the finished work of the workers doesn't schedule new streamed parts then
+	while (!_clients.empty()) {
+		closeClient(_clients[_clients.size() - 1]);
+	}
+	if (_threadPool) {
+		// wait for the running route handlers - the routes are removed below
+		_threadPool->shutdown(true);
+		finishRequests();
+		_threadPool = nullptr;
+	}
 	const size_t l = lengthof(_routes);
 	for (size_t i = 0; i < l; ++i) {
 		_routes[i].clear();
 	}
-	for (ClientSocketsIter i = _clientSockets.begin(); i != _clientSockets.end();) {
-		i = closeClient(i);
-	}
 
 	for (auto i : _errorPages) {
 		SDL_free((char*)i->second);
 	}
 	_errorPages.clear();
 
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
-	closesocket(_socketFD);
-	_socketFD = INVALID_SOCKET;
+	_poller.shutdown();
+	if (_socketFD != INVALID_SOCKET) {
+		closesocket(_socketFD);
+		_socketFD = INVALID_SOCKET;
+	}
 	network_cleanup();
 }
 
@@ -374,17 +685,46 @@ HttpServer::Client::Client() :
 }
 
 void HttpServer::Client::setResponse(char* responseBuf, size_t responseBufLength) {
-	core_assert(response == nullptr);
-	response = responseBuf;
-	responseLength = responseBufLength;
+	core_assert(head == nullptr);
+	head = responseBuf;
+	headLength = responseBufLength;
 	alreadySent = 0u;
 }
 
+void HttpServer::Client::resetResponse() {
+	SDL_free(head);
+	head = nullptr;
+	headLength = 0u;
+	if (releaseBody) {
+		releaseBody(body);
+		releaseBody = nullptr;
+	}
+	body = nullptr;
+	bodyLength = 0u;
+	alreadySent = 0u;
+	stream = nullptr;
+}
+
+void HttpServer::Client::consumeRequest(size_t length) {
+	core_assert(length <= requestLength);
+	requestLength -= length;
+	if (requestLength == 0u) {
+		SDL_free(request);
+		request = nullptr;
+		return;
+	}
+	SDL_memmove(request, request + length, requestLength);
+}
+
+size_t HttpServer::Client::responseLength() const {
+	return headLength + bodyLength;
+}
+
 bool HttpServer::Client::finished() const {
-	if (response == nullptr) {
+	if (head == nullptr || stream || busy) {
 		return false;
 	}
-	return responseLength == alreadySent;
+	return responseLength() == alreadySent;
 }
 
 }
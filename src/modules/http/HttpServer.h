@@ -11,8 +11,12 @@
 #include "Network.h"
 #include "HttpHeader.h"
 #include "HttpQuery.h"
-#include "core/collection/Map.h"
-#include "core/collection/List.h"
+#include "SocketPoller.h"
+#include "core/Trace.h"
+#include "core/collection/DynamicArray.h"
+#include "core/collection/DynamicMap.h"
+#include "core/concurrent/Lock.h"
+#include "core/concurrent/ThreadPool.h"
 #include "metric/Metric.h"
 #include <stdint.h>
 #include <functional>
@@ -22,47 +26,146 @@ namespace http {
 
 class RequestParser;
 
+/**
+ * @brief Http server that handles all connections in @c update()
+ *
+ * The sockets are watched with a @c SocketPoller - so there is no limit for the amount of connections. The
+ * connections of clients that ask for @c Connection: keep-alive stay open after the response was sent and
+ * pipelined requests are answered in the order they were received. The response bodies are sent directly from
+ * the memory the route handlers hand over.
+ *
+ * The server is driven by calling @c update() - either from the main loop of the application or from an own
+ * thread with a timeout. The route handlers can optionally run on worker threads, see @c setWorkers(). The parts
+ * of streamed responses are always produced on a worker thread - @c update() only sends the finished parts.
+ */
 class HttpServer {
 public:
 	using RouteCallback = std::function<void(const RequestParser& query, HttpResponse* response)>;
 private:
+	using StreamCallback = std::function<bool(core::ByteStream& out)>;
 	SOCKET _socketFD;
-	fd_set _readFDSet;
-	fd_set _writeFDSet;
-	using Routes = core::Map<const char*, RouteCallback, 8, core::hashCharPtr, core::hashCharCompare>;
+	SocketPoller _poller;
+	using Routes = core::DynamicMap<const char*, RouteCallback, 8, core::hashCharPtr, core::hashCharCompare>;
 	core::Map<int, const char*, 8, std::hash<int>> _errorPages;
 	Routes _routes[2];
 	size_t _maxRequestBytes = 1 * 1024 * 1024;
+	size_t _workers = 0u;
 	metric::MetricPtr _metric;
 
 	struct Client {
 		Client();
 		SOCKET socket;
+		// the index in the list of connected clients
+		size_t index = 0u;
+		// the events the poller watches for
+		uint8_t events = SocketPoller::None;
 
+		// the received bytes - might contain several pipelined requests
 		uint8_t *request = nullptr;
 		size_t requestLength = 0u;
 
-		char* response = nullptr;
-		size_t responseLength = 0u;
+		// the status line and the headers - or the framing of a streamed part
+		char* head = nullptr;
+		size_t headLength = 0u;
+		// the body is sent from the memory of the route handler and released after it was sent
+		const char* body = nullptr;
+		size_t bodyLength = 0u;
+		std::function<void(const char *body)> releaseBody;
 		size_t alreadySent = 0u;
+		// the producer of a streamed response that isn't complete yet
+		StreamCallback stream;
+		// the connection is reused for the next request after the response was sent
+		bool keepAlive = false;
+		// the route handler for the current request or the next part of a streamed response is running on a
+		// worker thread
+		bool busy = false;
 
 		void setResponse(char* responseBuf, size_t responseBufLength);
+		void resetResponse();
+		/**
+		 * @brief Removes the first @c length bytes of the received data
+		 */
+		void consumeRequest(size_t length);
+		size_t responseLength() const;
 		bool finished() const;
 	};
 
-	using ClientSockets = core::List<Client>;
-	using ClientSocketsIter = ClientSockets::iterator;
-	ClientSockets _clientSockets { 1024 };
+	core::DynamicArray<Client*> _clients;
 
-	ClientSocketsIter closeClient (ClientSocketsIter& i);
+	/**
+	 * @brief A request that was routed on a worker thread
+	 */
+	struct FinishedRequest {
+		Client* client;
+		HttpResponse* response;
+		bool found;
+	};
+	/**
+	 * @brief The next part of a streamed response that was produced on a worker thread
+	 */
+	struct FinishedPart {
+		Client* client;
+		// the part with the chunked transfer encoding framing
+		char* part;
+		size_t partSize;
+		// the producer for the following parts - empty after the last part
+		StreamCallback stream;
+	};
+	std::unique_ptr<core::ThreadPool> _threadPool;
+	core_trace_mutex(core::Lock, _finishedLock, "HttpServerFinished");
+	core::DynamicArray<FinishedRequest> _finished core_thread_guarded_by(_finishedLock);
+	core::DynamicArray<FinishedPart> _finishedParts core_thread_guarded_by(_finishedLock);
+	// the requests and streamed parts that are handled by the workers
+	int _inflight = 0;
+
+	void closeClient(Client* client);
+	void acceptClients();
+	/**
+	 * @return @c false if the connection should be closed
+	 */
+	bool handleEvents(Client& client, uint8_t events);
+	/**
+	 * @brief Sends as much of the response as possible and prepares the connection for the next request if the
+	 * response was completely sent
+	 * @return @c false if the connection should be closed
+	 */
+	bool writeResponse(Client& client);
+	/**
+	 * @brief Updates the events the poller watches for - depending on the state of the client
+	 */
+	void watch(Client& client);
 
 	void metric(HttpStatus status) const;
 
-	bool route(const RequestParser& request, HttpResponse& response);
-	void assembleResponse(Client& client, const HttpResponse& response);
+	bool route(const RequestParser& request, HttpResponse& response, bool keepAlive);
+	/**
+	 * @brief Parses and routes the first complete request that was received from the client
+	 */
+	void handleRequest(Client& client);
+	/**
+	 * @brief Hands the responses and streamed parts of the workers to their clients
+	 */
+	void finishRequests();
+	void respond(Client& client, HttpResponse& response, bool found);
+	void assembleResponse(Client& client, HttpResponse& response);
 	void assembleError(Client& client, HttpStatus status);
+	/**
+	 * @brief Produces the next part of a streamed response on a worker thread
+	 * @return @c false if the part could not be scheduled
+	 */
+	bool produceStreamPart(Client& client);
+	/**
+	 * @brief Frames the produced part with the chunked transfer encoding - executed on a worker thread
+	 * @return The part that is sent to the client - allocated with @c SDL_malloc()
+	 */
+	static char* assembleStreamPart(const core::ByteStream& out, bool more, size_t& partSize);
 	bool sendMessage(Client& client);
 
+	/**
+	 * @return The size of the first request in the given buffer or @c 0 if it wasn't completely received yet
+	 */
+	static size_t requestSize(const uint8_t* buf, size_t length);
+
 	Routes* getRoutes(HttpMethod method);
 
 public:
@@ -70,6 +173,12 @@ public:
 	~HttpServer();
 
 	void setMaxRequestSize(size_t maxBytes);
+	/**
+	 * @brief The amount of worker threads the route handlers are executed on - @c 0 to execute them in @c update().
+	 * The responses of the workers are sent in the next @c update() call. The parts of streamed responses are
+	 * produced on at least one worker thread - even if this is @c 0. Must be called before @c init().
+	 */
+	void setWorkers(size_t workers);
 
 	/**
 	 * @param[in] body The status code body. The pointer is copied and then released by the server.
@@ -77,7 +186,11 @@ public:
 	void setErrorText(HttpStatus status, const char *body);
 
 	bool init(int16_t port = 8080);
-	bool update();
+	/**
+	 * @param[in] timeoutMillis The time to wait for network events - @c 0 to only handle the pending events,
+	 * @c -1 to wait until there are events.
+	 */
+	bool update(int timeoutMillis = 0);
 	void shutdown();
 
 	void registerRoute(HttpMethod method, const char *path, const RouteCallback& callback);
@@ -88,6 +201,10 @@ inline void HttpServer::setMaxRequestSize(size_t maxBytes) {
 	_maxRequestBytes = maxBytes;
 }
 
+inline void HttpServer::setWorkers(size_t workers) {
+	_workers = workers;
+}
+
 
 typedef std::shared_ptr<HttpServer> HttpServerPtr;
 
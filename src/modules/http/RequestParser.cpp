@@ -8,12 +8,14 @@
 
 namespace http {
 
+// the buffer is taken over - so the pointers into it stay valid
 RequestParser& RequestParser::operator=(RequestParser &&other) noexcept {
 	if (&other != this) {
-		query = HTTP_PARSER_NEW_BASE_CHARPTR_MAP(other.query);
+		query = other.query;
 		other.query.clear();
 		method = other.method;
-		path = HTTP_PARSER_NEW_BASE(other.path);
+		path = other.path;
+		other.path = nullptr;
 		Super::operator=(std::move(other));
 	}
 	return *this;
@@ -21,10 +23,11 @@ RequestParser& RequestParser::operator=(RequestParser &&other) noexcept {
 
 RequestParser::RequestParser(RequestParser &&other) noexcept :
 		Super(std::move(other)) {
-	query = HTTP_PARSER_NEW_BASE_CHARPTR_MAP(other.query);
+	query = other.query;
 	other.query.clear();
 	method = other.method;
-	path = HTTP_PARSER_NEW_BASE(other.path);
+	path = other.path;
+	other.path = nullptr;
 }
 
 RequestParser& RequestParser::operator=(const RequestParser& other) {
@@ -0,0 +1,190 @@
+/**
+ * @file
+ */
+
+#include "SocketPoller.h"
+#include "Network.cpp.h"
+#include "core/Assert.h"
+#include "core/Common.h"
+#include "core/Log.h"
+#ifdef HTTP_EPOLL
+#include <errno.h>
+#include <sys/epoll.h>
+#endif
+
+namespace http {
+
+SocketPoller::~SocketPoller() {
+	shutdown();
+}
+
+#ifdef HTTP_EPOLL
+
+static uint32_t toEpoll(uint8_t events) {
+	uint32_t e = 0u;
+	if (events & SocketPoller::Read) {
+		e |= EPOLLIN;
+	}
+	if (events & SocketPoller::Write) {
+		e |= EPOLLOUT;
+	}
+	return e;
+}
+
+bool SocketPoller::init() {
+	_epollFD = epoll_create1(EPOLL_CLOEXEC);
+	if (_epollFD == -1) {
+		Log::error("Failed to create the epoll instance");
+		return false;
+	}
+	return true;
+}
+
+void SocketPoller::shutdown() {
+	if (_epollFD != -1) {
+		close(_epollFD);
+		_epollFD = -1;
+	}
+}
+
+bool SocketPoller::add(SOCKET socket, uint8_t events, void *userdata) {
+	struct epoll_event e;
+	e.events = toEpoll(events);
+	e.data.ptr = userdata;
+	return epoll_ctl(_epollFD, EPOLL_CTL_ADD, socket, &e) == 0;
+}
+
+bool SocketPoller::modify(SOCKET socket, uint8_t events, void *userdata) {
+	struct epoll_event e;
+	e.events = toEpoll(events);
+	e.data.ptr = userdata;
+	return epoll_ctl(_epollFD, EPOLL_CTL_MOD, socket, &e) == 0;
+}
+
+void SocketPoller::remove(SOCKET socket) {
+	struct epoll_event e;
+	epoll_ctl(_epollFD, EPOLL_CTL_DEL, socket, &e);
+}
+
+int SocketPoller::wait(Event *events, int maxEvents, int timeoutMillis) {
+	constexpr int MaxEvents = 256;
+	struct epoll_event epollEvents[MaxEvents];
+	const int n = epoll_wait(_epollFD, epollEvents, core_min(maxEvents, MaxEvents), timeoutMillis);
+	if (n < 0) {
+		return errno == EINTR ? 0 : -1;
+	}
+	for (int i = 0; i < n; ++i) {
+		const uint32_t e = epollEvents[i].events;
+		uint8_t flags = None;
+		if (e & EPOLLIN) {
+			flags |= Read;
+		}
+		if (e & EPOLLOUT) {
+			flags |= Write;
+		}
+		if (e & (EPOLLERR | EPOLLHUP)) {
+			flags |= Error;
+		}
+		events[i].userdata = epollEvents[i].data.ptr;
+		events[i].events = flags;
+	}
+	return n;
+}
+
+#else
+
+#ifdef __WINDOWS__
+#define poll WSAPoll
+#endif
+
+static short toPoll(uint8_t events) {
+	short e = 0;
+	if (events & SocketPoller::Read) {
+		e |= POLLIN;
+	}
+	if (events & SocketPoller::Write) {
+		e |= POLLOUT;
+	}
+	return e;
+}
+
+bool SocketPoller::init() {
+	return true;
+}
+
+void SocketPoller::shutdown() {
+	_fds.clear();
+	_userdata.clear();
+}
+
+bool SocketPoller::add(SOCKET socket, uint8_t events, void *userdata) {
+	struct pollfd fd;
+	fd.fd = socket;
+	fd.events = toPoll(events);
+	fd.revents = 0;
+	_fds.push_back(fd);
+	_userdata.push_back(userdata);
+	return true;
+}
+
+bool SocketPoller::modify(SOCKET socket, uint8_t events, void *userdata) {
+	for (size_t i = 0u; i < _fds.size(); ++i) {
+		if (_fds[i].fd == socket) {
+			_fds[i].events = toPoll(events);
+			_userdata[i] = userdata;
+			return true;
+		}
+	}
+	return false;
+}
+
+void SocketPoller::remove(SOCKET socket) {
+	for (size_t i = 0u; i < _fds.size(); ++i) {
+		if (_fds[i].fd != socket) {
+			continue;
+		}
+		_fds[i] = _fds[_fds.size() - 1];
+		_userdata[i] = _userdata[_userdata.size() - 1];
+		_fds.pop();
+		_userdata.pop();
+		return;
+	}
+}
+
+int SocketPoller::wait(Event *events, int maxEvents, int timeoutMillis) {
+	if (_fds.empty()) {
+		return 0;
+	}
+	const int ready = poll(&_fds[0], (unsigned int)_fds.size(), timeoutMillis);
+	if (ready <= 0) {
+		return ready;
+	}
+	int n = 0;
+	const size_t size = _fds.size();
+	for (size_t j = 0u; j < size && n < maxEvents; ++j) {
+		const size_t i = (_offset + j) % size;
+		const short e = _fds[i].revents;
+		if (e == 0) {
+			continue;
+		}
+		uint8_t flags = None;
+		if (e & POLLIN) {
+			flags |= Read;
+		}
+		if (e & POLLOUT) {
+			flags |= Write;
+		}
+		if (e & (POLLERR | POLLHUP | POLLNVAL)) {
+			flags |= Error;
+		}
+		events[n].userdata = _userdata[i];
+		events[n].events = flags;
+		++n;
+	}
+	++_offset;
+	return n;
+}
+
+#endif
+
+}
@@ -0,0 +1,72 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "Network.h"
+#include "core/collection/DynamicArray.h"
+#include <stdint.h>
+
+#if defined(__linux__)
+#define HTTP_EPOLL 1
+#elif !defined(__WINDOWS__)
+#include <poll.h>
+#endif
+
+namespace http {
+
+/**
+ * @brief Waits for events on a set of sockets.
+ *
+ * Uses epoll on linux and @c poll() on the other platforms - other than @c select() there is no limit for the
+ * socket descriptors. The events are level triggered.
+ */
+class SocketPoller {
+public:
+	enum Events : uint8_t {
+		None = 0,
+		Read = 1,
+		Write = 2,
+		// the connection was closed or has an error
+		Error = 4
+	};
+
+	struct Event {
+		void *userdata;
+		uint8_t events;
+	};
+
+private:
+#ifdef HTTP_EPOLL
+	int _epollFD = -1;
+#else
+	core::DynamicArray<struct pollfd> _fds;
+	core::DynamicArray<void*> _userdata;
+	// the index of the entry that is reported first - to not starve the other sockets if there are more events
+	// than the caller wants to handle
+	size_t _offset = 0u;
+#endif
+
+public:
+	~SocketPoller();
+
+	bool init();
+	void shutdown();
+
+	/**
+	 * @param[in] events A combination of @c Events::Read and @c Events::Write
+	 * @param[in] userdata Is given back in the @c Event of the socket
+	 */
+	bool add(SOCKET socket, uint8_t events, void *userdata);
+	bool modify(SOCKET socket, uint8_t events, void *userdata);
+	void remove(SOCKET socket);
+
+	/**
+	 * @param[in] timeoutMillis @c 0 to return immediately, @c -1 to wait until there are events
+	 * @return The amount of events that were written to the given array or @c -1 on error
+	 */
+	int wait(Event *events, int maxEvents, int timeoutMillis);
+};
+
+}
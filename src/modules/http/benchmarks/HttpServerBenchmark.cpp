@@ -0,0 +1,194 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "app/App.h"
+#include "http/HttpServer.h"
+#include "http/Network.cpp.h"
+#include "core/Algorithm.h"
+#include "core/collection/DynamicArray.h"
+#include "core/concurrent/Atomic.h"
+#include "core/TimeProvider.h"
+#include "core/Log.h"
+#include <thread>
+
+/**
+ * @brief Local load generator for the @c http::HttpServer - keep-alive connections that send pipelined requests
+ * for a chunk sized body. The server runs in its own thread.
+ */
+class HttpServerBenchmark : public app::AbstractBenchmark {
+protected:
+	static constexpr int16_t Port = 8190;
+	static constexpr size_t BodySize = 32 * 1024;
+	uint8_t _body[BodySize];
+
+	struct Connection {
+		SOCKET socket = INVALID_SOCKET;
+		core::DynamicArray<uint8_t> received;
+	};
+
+	SOCKET connectClient() const {
+		const SOCKET s = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (s == INVALID_SOCKET) {
+			return INVALID_SOCKET;
+		}
+		struct sockaddr_in sin;
+		SDL_memset(&sin, 0, sizeof(sin));
+		sin.sin_family = AF_INET;
+		sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		sin.sin_port = htons(Port);
+		if (connect(s, (struct sockaddr *) &sin, sizeof(sin)) != 0) {
+			closesocket(s);
+			return INVALID_SOCKET;
+		}
+		return s;
+	}
+
+	/**
+	 * @return The size of the first complete response in the buffer or @c 0
+	 */
+	static size_t responseSize(const core::DynamicArray<uint8_t>& buf) {
+		const size_t length = buf.size();
+		if (length == 0u) {
+			return 0u;
+		}
+		const char *data = (const char *)&buf[0];
+		for (size_t i = 0u; i + 4u <= length; ++i) {
+			if (SDL_memcmp(data + i, "\r\n\r\n", 4) != 0) {
+				continue;
+			}
+			const size_t headerSize = i + 4u;
+			size_t contentLength = 0u;
+			const size_t keyLength = SDL_strlen(http::header::CONTENT_LENGTH);
+			for (size_t l = 0u; l + 2u + keyLength < i; ++l) {
+				if (SDL_memcmp(data + l, "\r\n", 2) == 0 && SDL_strncasecmp(data + l + 2u, http::header::CONTENT_LENGTH, keyLength) == 0) {
+					contentLength = (size_t)SDL_strtoul(data + l + 2u + keyLength + 1u, nullptr, 10);
+					break;
+				}
+			}
+			if (headerSize + contentLength > length) {
+				return 0u;
+			}
+			return headerSize + contentLength;
+		}
+		return 0u;
+	}
+
+	/**
+	 * @brief Blocks until the given amount of responses were received on the connection
+	 * @param[in] sendTime The time the requests were sent - the latencies of the responses are added to the given array
+	 */
+	static bool receive(Connection& c, int responses, uint64_t sendTime, core::DynamicArray<uint64_t>& latencies) {
+		uint8_t buf[65536];
+		while (responses > 0) {
+			const size_t size = responseSize(c.received);
+			if (size > 0u) {
+				latencies.push_back(core::TimeProvider::highResTime() - sendTime);
+				c.received.erase(0, size);
+				--responses;
+				continue;
+			}
+			const network_return len = recv(c.socket, (char*)buf, sizeof(buf), 0);
+			if (len <= 0) {
+				return false;
+			}
+			c.received.append(buf, (size_t)len);
+		}
+		return true;
+	}
+
+	/**
+	 * @param[in] state @c range(0) is the amount of connections, @c range(1) the amount of pipelined requests per
+	 * connection and @c range(2) the amount of worker threads for the route handlers
+	 */
+	void load(benchmark::State &state) {
+		const int connections = (int)state.range(0);
+		const int pipelined = (int)state.range(1);
+		http::HttpServer server(_benchmarkApp->metric());
+		server.setWorkers((size_t)state.range(2));
+		if (!server.init(Port)) {
+			state.SkipWithError("Failed to start the server");
+			return;
+		}
+		server.registerRoute(http::HttpMethod::GET, "/chunk", [this] (const http::RequestParser& request, http::HttpResponse* response) {
+			response->setBody((const char*)_body, sizeof(_body), [] (const char *) {});
+		});
+		core::AtomicBool running { true };
+		std::thread serverThread([&server, &running] () {
+			while (running) {
+				server.update(5);
+			}
+		});
+
+		core::DynamicArray<Connection> clients;
+		clients.resize(connections);
+		for (Connection& c : clients) {
+			c.socket = connectClient();
+		}
+
+		core::String request;
+		for (int i = 0; i < pipelined; ++i) {
+			request += "GET /chunk?x=0&y=0&z=0 HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n";
+		}
+
+		core::DynamicArray<uint64_t> latencies;
+		latencies.reserve(4096);
+		int64_t requests = 0;
+		const uint64_t start = core::TimeProvider::highResTime();
+		for (auto _ : state) {
+			const uint64_t sendTime = core::TimeProvider::highResTime();
+			for (Connection& c : clients) {
+				if (::send(c.socket, request.c_str(), (int)request.size(), 0) != (network_return)request.size()) {
+					state.SkipWithError("Failed to send the requests");
+					break;
+				}
+			}
+			for (Connection& c : clients) {
+				if (!receive(c, pipelined, sendTime, latencies)) {
+					state.SkipWithError("Failed to receive the responses");
+					break;
+				}
+			}
+			requests += (int64_t)connections * pipelined;
+		}
+		const double seconds = (double)(core::TimeProvider::highResTime() - start) / (double)core::TimeProvider::highResTimeResolution();
+
+		for (Connection& c : clients) {
+			closesocket(c.socket);
+		}
+		running = false;
+		serverThread.join();
+		server.shutdown();
+
+		if (latencies.empty()) {
+			return;
+		}
+		core::sort(latencies.begin(), latencies.end(), core::Less<uint64_t>());
+		const uint64_t p99 = latencies[(latencies.size() * 99u) / 100u];
+		state.counters["requests/s"] = (double)requests / seconds;
+		state.counters["p99Millis"] = (double)p99 * 1000.0 / (double)core::TimeProvider::highResTimeResolution();
+	}
+
+public:
+	bool onInitApp() override {
+		for (size_t i = 0u; i < BodySize; ++i) {
+			_body[i] = (uint8_t)i;
+		}
+		return true;
+	}
+};
+
+BENCHMARK_DEFINE_F(HttpServerBenchmark, Chunk)(benchmark::State &state) {
+	load(state);
+}
+
+BENCHMARK_REGISTER_F(HttpServerBenchmark, Chunk)
+	->Args({1, 1, 0})
+	->Args({64, 1, 0})
+	->Args({64, 8, 0})
+	->Args({256, 4, 0})
+	->Args({256, 4, 2})
+	->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
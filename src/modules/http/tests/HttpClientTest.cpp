@@ -9,43 +9,58 @@
 #include "core/concurrent/ThreadPool.h"
 #include "core/concurrent/Lock.h"
 #include "core/concurrent/ConditionVariable.h"
+#include <functional>
+#include <thread>
 
 namespace http {
 
 class HttpClientTest : public app::AbstractTest {
-};
+protected:
+	/**
+	 * @brief Runs a http server with the routes of the given function until the test app is shut down
+	 * @param[in] workers The amount of threads the route handlers run on
+	 * @return @c false if the server could not be started
+	 */
+	bool startServer(uint16_t port, const std::function<void(HttpServer& server)>& routes, size_t workers = 0u) {
+		core_trace_mutex(core::Lock, serverStartMutex, "Server start mutex");
+		core::ConditionVariable startCondition;
+		core::AtomicBool serverSuccess { false };
+		core::AtomicBool finishedSetup { false };
 
-TEST_F(HttpClientTest, testSimple) {
-	core_trace_mutex(core::Lock, serverStartMutex, "Server start mutex");
-	core::ConditionVariable startCondition;
-	core::AtomicBool serverSuccess { false };
-	core::AtomicBool finishedSetup { false };
-
-	core::ScopedLock lock(serverStartMutex);
-	_testApp->threadPool().enqueue([this, &startCondition, &serverSuccess, &finishedSetup] () {
-		http::HttpServer _httpServer(_testApp->metric());
-		serverSuccess = _httpServer.init(8095);
-		if (!serverSuccess) {
-			Log::error("Failed to initialize the http server on port 8095");
+		core::ScopedLock lock(serverStartMutex);
+		_testApp->threadPool().enqueue([this, port, routes, workers, &startCondition, &serverSuccess, &finishedSetup] () {
+			http::HttpServer _httpServer(_testApp->metric());
+			_httpServer.setWorkers(workers);
+			serverSuccess = _httpServer.init(port);
+			if (!serverSuccess) {
+				Log::error("Failed to initialize the http server on port %i", (int)port);
+				finishedSetup = true;
+				startCondition.notify_one();
+				return;
+			}
+			routes(_httpServer);
 			finishedSetup = true;
 			startCondition.notify_one();
-			return;
-		}
-		_httpServer.registerRoute(http::HttpMethod::GET, "/", [] (const http::RequestParser& request, HttpResponse* response) {
-			response->setText("Success");
+
+			while (_testApp->state() == app::AppState::Running) {
+				_httpServer.update();
+			}
+			_httpServer.shutdown();
+		});
+		startCondition.wait(serverStartMutex, [&finishedSetup] {
+			return (bool)finishedSetup;
 		});
-		finishedSetup = true;
-		startCondition.notify_one();
+		return serverSuccess;
+	}
+};
 
-		while (_testApp->state() == app::AppState::Running) {
-			_httpServer.update();
-		}
-		_httpServer.shutdown();
-	});
-	startCondition.wait(serverStartMutex, [&finishedSetup] {
-		return (bool)finishedSetup;
+TEST_F(HttpClientTest, testSimple) {
+	const bool started = startServer(8095, [] (HttpServer& server) {
+		server.registerRoute(http::HttpMethod::GET, "/", [] (const http::RequestParser& request, HttpResponse* response) {
+			response->setText("Success");
+		});
 	});
-	if (!serverSuccess) {
+	if (!started) {
 		return;
 	}
 	HttpClient client("http://localhost:8095");
@@ -60,4 +75,87 @@ TEST_F(HttpClientTest, testSimple) {
 	EXPECT_STREQ("text/plain", type);
 }
 
+TEST_F(HttpClientTest, testKeepAlive) {
+	const bool started = startServer(8096, [] (HttpServer& server) {
+		server.registerRoute(http::HttpMethod::GET, "/", [] (const http::RequestParser& request, HttpResponse* response) {
+			response->setText("Success");
+		});
+	});
+	if (!started) {
+		return;
+	}
+	HttpClient client("http://localhost:8096");
+	client.setRequestTimeout(1);
+	for (int i = 0; i < 3; ++i) {
+		ResponseParser response = client.get("/");
+		ASSERT_TRUE(response.valid()) << "Invalid response for request " << i;
+		EXPECT_EQ(HttpStatus::Ok, response.status);
+		EXPECT_TRUE(response.isHeaderValue(http::header::CONNECTION, "keep-alive"));
+		ASSERT_EQ(7u, response.contentLength);
+		EXPECT_EQ(0, SDL_strncmp("Success", response.content, response.contentLength));
+	}
+}
+
+TEST_F(HttpClientTest, testStream) {
+	static std::thread::id serverThread;
+	static core::AtomicInt partsOnServerThread { 0 };
+	const bool started = startServer(8097, [] (HttpServer& server) {
+		server.registerRoute(http::HttpMethod::GET, "/stream", [] (const http::RequestParser& request, HttpResponse* response) {
+			// without workers the route is executed in update()
+			serverThread = std::this_thread::get_id();
+			int parts = 0;
+			response->stream = [parts] (core::ByteStream& out) mutable {
+				if (std::this_thread::get_id() == serverThread) {
+					partsOnServerThread.increment(1);
+				}
+				out.addByte('a' + parts);
+				return ++parts < 3;
+			};
+		});
+	});
+	if (!started) {
+		return;
+	}
+	HttpClient client("http://localhost:8097");
+	client.setRequestTimeout(1);
+	core::String received;
+	const core::String paths[] = { "/stream", "/stream" };
+	const int responses = client.stream(paths, 2, [&] (const uint8_t* data, size_t size) {
+		received += core::String((const char*)data, size);
+		return true;
+	});
+	EXPECT_EQ(2, responses);
+	EXPECT_EQ("abcabc", received);
+	EXPECT_EQ(0, (int)partsOnServerThread) << "The streamed parts must not block the server thread";
+}
+
+TEST_F(HttpClientTest, testWorkers) {
+	static core::AtomicInt released { 0 };
+	const bool started = startServer(8098, [] (HttpServer& server) {
+		server.registerRoute(http::HttpMethod::GET, "/", [] (const http::RequestParser& request, HttpResponse* response) {
+			static const char *body = "Worker";
+			response->setBody(body, SDL_strlen(body), [] (const char *) {
+				released.increment(1);
+			});
+		});
+	}, 2u);
+	if (!started) {
+		return;
+	}
+	HttpClient client("http://localhost:8098");
+	client.setRequestTimeout(1);
+	for (int i = 0; i < 3; ++i) {
+		ResponseParser response = client.get("/");
+		ASSERT_TRUE(response.valid()) << "Invalid response for request " << i;
+		EXPECT_EQ(HttpStatus::Ok, response.status);
+		ASSERT_EQ(6u, response.contentLength);
+		EXPECT_EQ(0, SDL_strncmp("Worker", response.content, response.contentLength));
+	}
+	// the body of the last response is released after it was sent
+	EXPECT_GE((int)released, 2);
+	ResponseParser notFound = client.get("/missing/path");
+	ASSERT_TRUE(notFound.valid());
+	EXPECT_EQ(HttpStatus::NotFound, notFound.status);
+}
+
 }
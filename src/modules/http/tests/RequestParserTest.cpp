@@ -46,6 +46,26 @@ TEST_F(RequestParserTest, testCopy) {
 	validateMapEntry(request.headers, header::HOST, "localhost:8088");
 }
 
+TEST_F(RequestParserTest, testMove) {
+	char *buf = SDL_strdup(
+		"GET /foo?param=value HTTP/1.1\r\n"
+		"Host: localhost:8088\r\n"
+		"\r\n");
+	RequestParser original((uint8_t*)buf, SDL_strlen(buf));
+	RequestParser request(std::move(original));
+	EXPECT_TRUE(request.valid());
+	EXPECT_EQ(HttpMethod::GET, request.method);
+	EXPECT_STREQ("/foo", request.path);
+	validateMapEntry(request.query, "param", "value");
+	validateMapEntry(request.headers, header::HOST, "localhost:8088");
+
+	RequestParser assigned(nullptr, 0u);
+	assigned = std::move(request);
+	EXPECT_TRUE(assigned.valid());
+	EXPECT_STREQ("/foo", assigned.path);
+	validateMapEntry(assigned.query, "param", "value");
+}
+
 TEST_F(RequestParserTest, testQuery) {
 	char *buf = SDL_strdup(
 		"GET /foo?param=value&param2=value&param3&param4=1 HTTP/1.1\r\n"
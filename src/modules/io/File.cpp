@@ -28,7 +28,7 @@ bool File::validHandle() const {
 }
 
 bool File::exists() const {
-	if (_mode == FileMode::Read || _mode == FileMode::SysRead) {
+	if (_mode == FileMode::Read || _mode == FileMode::SysRead || _mode == FileMode::SysUpdate) {
 		return _file != nullptr;
 	}
 
@@ -65,6 +65,8 @@ SDL_RWops* File::createRWops(FileMode mode) const {
 	const char *fmode = "rb";
 	if (mode == FileMode::Write || mode == FileMode::SysWrite) {
 		fmode = "wb";
+	} else if (mode == FileMode::SysUpdate) {
+		fmode = "r+b";
 	}
 	SDL_RWops *rwops = SDL_RWFromFile(_rawPath.c_str(), fmode);
 	if (rwops == nullptr) {
@@ -79,7 +81,7 @@ long File::write(const unsigned char *buf, size_t len) const {
 				(int)len, _rawPath.c_str());
 		return -1;
 	}
-	if (_mode != FileMode::Write && _mode != FileMode::SysWrite) {
+	if (_mode != FileMode::Write && _mode != FileMode::SysWrite && _mode != FileMode::SysUpdate) {
 		Log::debug("Invalid file mode given - can write buffer of length %i (path: %s)",
 				(int)len, _rawPath.c_str());
 		return -1L;
@@ -175,7 +177,7 @@ int File::read(void *buffer, int n) {
 }
 
 int File::read(void *buf, size_t size, size_t maxnum) {
-	if (_mode != FileMode::Read && _mode != FileMode::SysRead) {
+	if (_mode != FileMode::Read && _mode != FileMode::SysRead && _mode != FileMode::SysUpdate) {
 		_state = IOSTATE_FAILED;
 		Log::debug("File %s is not opened in read mode", _rawPath.c_str());
 		return -1;
@@ -18,7 +18,8 @@ enum class FileMode {
 	Read,		/**< reading from the virtual file system */
 	Write,		/**< writing into the virtual file system */
 	SysRead,	/**< reading from the given path */
-	SysWrite	/**< writing into the given path */
+	SysWrite,	/**< writing into the given path */
+	SysUpdate	/**< reading and writing into the given path - the existing content is kept */
 };
 
 extern void normalizePath(core::String& str);
@@ -77,6 +77,20 @@ bool Filesystem::removeFile(const core::String& file) const {
 	return uv_fs_unlink(_loop, &req, file.c_str(), nullptr) == 0;
 }
 
+bool Filesystem::rename(const core::String& from, const core::String& to) const {
+	if (from.empty() || to.empty()) {
+		return false;
+	}
+	uv_fs_t req;
+	const int retVal = uv_fs_rename(_loop, &req, from.c_str(), to.c_str(), nullptr);
+	uv_fs_req_cleanup(&req);
+	if (retVal != 0) {
+		Log::error("Failed to rename '%s' to '%s': %s", from.c_str(), to.c_str(), uv_strerror(retVal));
+		return false;
+	}
+	return true;
+}
+
 bool Filesystem::removeDir(const core::String& dir, bool recursive) const {
 	if (dir.empty()) {
 		return false;
@@ -392,7 +406,7 @@ bool Filesystem::pushDir(const core::String& directory) {
 }
 
 io::FilePtr Filesystem::open(const core::String& filename, FileMode mode) const {
-	if (mode == FileMode::SysWrite) {
+	if (mode == FileMode::SysWrite || mode == FileMode::SysUpdate) {
 		Log::debug("Use absolute path to open file %s for writing", filename.c_str());
 		return core::make_shared<io::File>(filename, mode);
 	} else if (mode == FileMode::Write) {
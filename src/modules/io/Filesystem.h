@@ -159,6 +159,10 @@ public:
 
 	bool removeDir(const core::String& dir, bool recursive = false) const;
 	bool removeFile(const core::String& file) const;
+	/**
+	 * @brief Moves the file to the given path - an existing file at the target path is replaced
+	 */
+	bool rename(const core::String& from, const core::String& to) const;
 private:
 	static bool _list(const core::String& directory, core::DynamicArray<DirEntry>& entities, const core::String& filter = "");
 };
@@ -0,0 +1,105 @@
+/**
+ * @file
+ */
+
+#include "MemoryMappedFile.h"
+#include "core/Log.h"
+#include <SDL_platform.h>
+#ifdef __WINDOWS__
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace io {
+
+MemoryMappedFile::~MemoryMappedFile() {
+	close();
+}
+
+#ifdef __WINDOWS__
+
+bool MemoryMappedFile::open(const core::String& path) {
+	close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		Log::error("Failed to map file %s", path.c_str());
+		CloseHandle(file);
+		return false;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr) {
+		Log::error("Failed to map file %s", path.c_str());
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	_file = file;
+	_mapping = mapping;
+	_data = (uint8_t*)data;
+	_size = (size_t)size.QuadPart;
+	return true;
+}
+
+void MemoryMappedFile::close() {
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+		CloseHandle((HANDLE)_mapping);
+		CloseHandle((HANDLE)_file);
+	}
+	_data = nullptr;
+	_size = 0u;
+	_file = nullptr;
+	_mapping = nullptr;
+}
+
+#else
+
+bool MemoryMappedFile::open(const core::String& path) {
+	close();
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		::close(fd);
+		return false;
+	}
+	void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	// the mapping stays valid without the descriptor
+	::close(fd);
+	if (data == MAP_FAILED) {
+		Log::error("Failed to map file %s", path.c_str());
+		return false;
+	}
+	_data = (uint8_t*)data;
+	_size = (size_t)st.st_size;
+	return true;
+}
+
+void MemoryMappedFile::close() {
+	if (_data != nullptr) {
+		munmap(_data, _size);
+	}
+	_data = nullptr;
+	_size = 0u;
+}
+
+#endif
+
+}
@@ -0,0 +1,55 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/String.h"
+#include "core/NonCopyable.h"
+#include <stdint.h>
+#include <stddef.h>
+
+namespace io {
+
+/**
+ * @brief Read only memory mapping of a whole file.
+ *
+ * Reading from the mapping doesn't need any syscall - the pages are loaded by the operating system
+ * when they are accessed. The mapped size doesn't change if the file grows - @c close() and @c open()
+ * the file again to see the new data.
+ */
+class MemoryMappedFile : public core::NonCopyable {
+private:
+	uint8_t* _data = nullptr;
+	size_t _size = 0u;
+	// platform handles of the file and the mapping that must be closed with the mapping
+	void* _file = nullptr;
+	void* _mapping = nullptr;
+public:
+	~MemoryMappedFile();
+
+	/**
+	 * @param[in] path The system path of the file
+	 * @return @c false if the file doesn't exist, is empty or could not get mapped
+	 */
+	bool open(const core::String& path);
+	void close();
+
+	bool isOpen() const;
+	const uint8_t* data() const;
+	size_t size() const;
+};
+
+inline bool MemoryMappedFile::isOpen() const {
+	return _data != nullptr;
+}
+
+inline const uint8_t* MemoryMappedFile::data() const {
+	return _data;
+}
+
+inline size_t MemoryMappedFile::size() const {
+	return _size;
+}
+
+}
@@ -0,0 +1,36 @@
+/**
+ * @file
+ */
+
+#include <gtest/gtest.h>
+#include "io/Filesystem.h"
+#include "io/MemoryMappedFile.h"
+
+namespace io {
+
+class MemoryMappedFileTest: public testing::Test {
+};
+
+TEST_F(MemoryMappedFileTest, testMap) {
+	io::Filesystem fs;
+	ASSERT_TRUE(fs.init("test", "test")) << "Failed to initialize the filesystem";
+	ASSERT_TRUE(fs.write("mmaptest.txt", "mapped content"));
+	MemoryMappedFile file;
+	ASSERT_TRUE(file.open(fs.writePath("mmaptest.txt")));
+	ASSERT_TRUE(file.isOpen());
+	ASSERT_EQ(14u, file.size());
+	EXPECT_EQ(0, memcmp(file.data(), "mapped content", file.size()));
+	file.close();
+	EXPECT_FALSE(file.isOpen());
+	EXPECT_EQ(nullptr, file.data());
+}
+
+TEST_F(MemoryMappedFileTest, testMissingFile) {
+	io::Filesystem fs;
+	ASSERT_TRUE(fs.init("test", "test")) << "Failed to initialize the filesystem";
+	MemoryMappedFile file;
+	EXPECT_FALSE(file.open(fs.writePath("mmaptest-does-not-exist.txt")));
+	EXPECT_FALSE(file.isOpen());
+}
+
+}
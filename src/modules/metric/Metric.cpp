@@ -6,14 +6,222 @@
 #include "core/Log.h"
 #include "core/Var.h"
 #include "core/Assert.h"
+#include "core/Common.h"
+#include "core/Hash.h"
+#include "core/concurrent/Atomic.h"
 #include <stdio.h>
 #include <string.h>
+#include <SDL_atomic.h>
 #include <SDL_stdinc.h>
+#include <SDL_thread.h>
 
 namespace metric {
 
+/**
+ * @brief The aggregated values of one metric key, type and tag combination
+ */
+struct Metric::Aggregate {
+	struct Sample {
+		uint32_t value;
+		uint32_t count;
+	};
+	/**
+	 * @brief The timings and histograms below this value are counted in a table that is indexed by the value
+	 */
+	static constexpr uint32_t MaxIndexedSample = 4096u;
+
+	Aggregate(uint32_t _hash, const char *_key, Type _type, const TagMap& _tags) :
+			hash(_hash), key(_key), type(_type), tags(_tags) {
+	}
+
+	const uint32_t hash;
+	const core::String key;
+	const Type type;
+	const TagMap tags;
+	// the next aggregate with the same hash
+	Aggregate* next = nullptr;
+	// the sum of the counters and meters or the last value of a gauge
+	int64_t value = 0;
+	// the amount of times a timing or histogram value below MaxIndexedSample was recorded - indexed by the value
+	core::DynamicArray<uint32_t> counts;
+	// the distinct timing and histogram values that are too big for the counts table
+	core::DynamicArray<Sample> samples;
+	bool dirty = false;
+
+	inline bool distinct() const {
+		return type == Type::Timing || type == Type::Histogram;
+	}
+
+	bool matches(const char *_key, Type _type, const TagMap& _tags) const {
+		if (type != _type || tags.size() != _tags.size() || key != _key) {
+			return false;
+		}
+		for (const auto& e : _tags) {
+			auto i = tags.find(e->key);
+			if (i == tags.end() || i->value != e->value) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void add(int64_t v, uint32_t count = 1u) {
+		dirty = true;
+		switch (type) {
+		case Type::Counter:
+		case Type::Meter:
+			value += v;
+			break;
+		case Type::Gauge:
+			value = v;
+			break;
+		case Type::Timing:
+		case Type::Histogram:
+			addSample((uint32_t)v, count);
+			break;
+		}
+	}
+
+	void addSample(uint32_t v, uint32_t count) {
+		if (v < MaxIndexedSample) {
+			if (v >= counts.size()) {
+				counts.resize(v + 1u);
+			}
+			counts[v] += count;
+			return;
+		}
+		for (Sample& sample : samples) {
+			if (sample.value == v) {
+				sample.count += count;
+				return;
+			}
+		}
+		samples.push_back(Sample{v, count});
+	}
+
+	void merge(const Aggregate& other) {
+		if (!other.dirty) {
+			return;
+		}
+		if (!other.distinct()) {
+			add(other.value);
+			return;
+		}
+		dirty = true;
+		for (size_t v = 0u; v < other.counts.size(); ++v) {
+			if (other.counts[v] > 0u) {
+				addSample((uint32_t)v, other.counts[v]);
+			}
+		}
+		for (const Sample& sample : other.samples) {
+			addSample(sample.value, sample.count);
+		}
+	}
+
+	void reset() {
+		value = 0;
+		// keep the memory - the same values are likely recorded again
+		for (size_t v = 0u; v < counts.size(); ++v) {
+			counts[v] = 0u;
+		}
+		samples.clear();
+		dirty = false;
+	}
+};
+
+/**
+ * @brief The aggregates of one thread - the owning thread and the flush are the only ones that are touching them
+ * and the spin lock is only contended while the flush collects them.
+ */
+struct Metric::ThreadBuffer {
+	const SDL_threadID thread;
+	SDL_SpinLock lock = 0;
+	Aggregates aggregates;
+
+	ThreadBuffer(SDL_threadID _thread) :
+			thread(_thread) {
+	}
+
+	~ThreadBuffer() {
+		deleteAggregates(aggregates);
+	}
+};
+
+static core::AtomicInt metricIds(1);
+
+Metric::Metric() :
+		_id((uint32_t)metricIds.increment(1)) {
+}
+
 Metric::~Metric() {
 	shutdown();
+	clearAggregates();
+}
+
+void Metric::clearAggregates() {
+	core::ScopedLock lock(_threadBuffersMutex);
+	for (ThreadBuffer* buffer : _threadBuffers) {
+		delete buffer;
+	}
+	_threadBuffers.clear();
+	deleteAggregates(_pending);
+}
+
+uint32_t Metric::hash(const char* key, Type type, const TagMap& tags) {
+	// a longer id is cut off - the aggregates with the same hash are told apart by Aggregate::matches()
+	char id[256];
+	size_t len = 0u;
+	auto append = [&] (const char *str, size_t strLen) {
+		const size_t n = core_min(strLen, sizeof(id) - len);
+		SDL_memcpy(&id[len], str, n);
+		len += n;
+	};
+	append(key, SDL_strlen(key));
+	append("|", 1u);
+	const char *t = typeName(type);
+	append(t, SDL_strlen(t));
+	for (const auto& e : tags) {
+		append("|", 1u);
+		append(e->key.c_str(), e->key.size());
+		append("=", 1u);
+		append(e->value.c_str(), e->value.size());
+	}
+	return core::hash((const void*)id, (int)len);
+}
+
+Metric::Aggregate* Metric::findAggregate(const Aggregates& aggregates, uint32_t hash, const char* key, Type type, const TagMap& tags) {
+	Aggregate* aggregate = nullptr;
+	if (!aggregates.get(hash, aggregate)) {
+		return nullptr;
+	}
+	for (; aggregate != nullptr; aggregate = aggregate->next) {
+		if (aggregate->matches(key, type, tags)) {
+			return aggregate;
+		}
+	}
+	return nullptr;
+}
+
+void Metric::addAggregate(Aggregates& aggregates, Aggregate* aggregate) {
+	Aggregate* first = nullptr;
+	if (aggregates.get(aggregate->hash, first)) {
+		aggregate->next = first->next;
+		first->next = aggregate;
+		return;
+	}
+	aggregates.put(aggregate->hash, aggregate);
+}
+
+void Metric::deleteAggregates(Aggregates& aggregates) {
+	for (const auto& e : aggregates) {
+		Aggregate* aggregate = e->second;
+		while (aggregate != nullptr) {
+			Aggregate* next = aggregate->next;
+			delete aggregate;
+			aggregate = next;
+		}
+	}
+	aggregates.clear();
 }
 
 bool Metric::init(const char *prefix, const IMetricSenderPtr& messageSender) {
@@ -34,14 +242,178 @@ bool Metric::init(const char *prefix, const IMetricSenderPtr& messageSender) {
 	} else {
 		Log::warn("Invalid %s given - using telegraf", cfg::MetricFlavor);
 	}
+	const int flushMillis = core::Var::get(cfg::MetricFlushInterval, "0")->intVal();
+	_flushMillis = flushMillis > 0 ? (uint64_t)flushMillis : 0u;
+	if (_flushMillis > 0u) {
+		Log::debug("Aggregate metrics and flush them every %i millis", flushMillis);
+	}
+	_lastFlushMillis = 0u;
 	_messageSender = messageSender;
 	return true;
 }
 
 void Metric::shutdown() {
+	if (_messageSender && aggregates()) {
+		flush();
+	}
 	_messageSender = IMetricSenderPtr();
 }
 
+void Metric::update(uint64_t nowMillis) {
+	if (!aggregates()) {
+		return;
+	}
+	if (_lastFlushMillis == 0u) {
+		_lastFlushMillis = nowMillis;
+		return;
+	}
+	if (nowMillis - _lastFlushMillis < _flushMillis) {
+		return;
+	}
+	_lastFlushMillis = nowMillis;
+	flush();
+}
+
+Metric::ThreadBuffer* Metric::threadBuffer() const {
+	struct Cache {
+		uint32_t metricId = 0u;
+		ThreadBuffer* buffer = nullptr;
+	};
+	// the ids are never reused - a destroyed metric instance can't be mistaken for a new one at the same address
+	thread_local Cache cache;
+	if (cache.metricId == _id) {
+		return cache.buffer;
+	}
+	const SDL_threadID thread = SDL_ThreadID();
+	core::ScopedLock lock(_threadBuffersMutex);
+	ThreadBuffer* buffer = nullptr;
+	for (ThreadBuffer* b : _threadBuffers) {
+		if (b->thread == thread) {
+			buffer = b;
+			break;
+		}
+	}
+	if (buffer == nullptr) {
+		buffer = new ThreadBuffer(thread);
+		_threadBuffers.push_back(buffer);
+	}
+	cache.metricId = _id;
+	cache.buffer = buffer;
+	return buffer;
+}
+
+bool Metric::record(const char* key, int64_t value, Type type, const TagMap& tags) const {
+	if (!_messageSender) {
+		return false;
+	}
+	if (!aggregates()) {
+		return assemble(key, value, type, tags);
+	}
+	const uint32_t h = hash(key, type, tags);
+	ThreadBuffer* buffer = threadBuffer();
+	SDL_AtomicLock(&buffer->lock);
+	Aggregate* aggregate = findAggregate(buffer->aggregates, h, key, type, tags);
+	if (aggregate == nullptr) {
+		aggregate = new Aggregate(h, key, type, tags);
+		addAggregate(buffer->aggregates, aggregate);
+	}
+	aggregate->add(value);
+	SDL_AtomicUnlock(&buffer->lock);
+	return true;
+}
+
+bool Metric::flush() const {
+	if (!_messageSender) {
+		return false;
+	}
+	core::ScopedLock lock(_flushMutex);
+	{
+		core::ScopedLock bufferLock(_threadBuffersMutex);
+		for (ThreadBuffer* buffer : _threadBuffers) {
+			SDL_AtomicLock(&buffer->lock);
+			for (const auto& e : buffer->aggregates) {
+				for (Aggregate* aggregate = e->second; aggregate != nullptr; aggregate = aggregate->next) {
+					if (!aggregate->dirty) {
+						continue;
+					}
+					const char *key = aggregate->key.c_str();
+					Aggregate* pending = findAggregate(_pending, aggregate->hash, key, aggregate->type, aggregate->tags);
+					if (pending == nullptr) {
+						pending = new Aggregate(aggregate->hash, key, aggregate->type, aggregate->tags);
+						addAggregate(_pending, pending);
+					}
+					pending->merge(*aggregate);
+					aggregate->reset();
+				}
+			}
+			SDL_AtomicUnlock(&buffer->lock);
+		}
+	}
+
+	char datagram[MaxDatagramSize + 1];
+	size_t datagramSize = 0u;
+	bool success = true;
+	constexpr int metricSize = 256;
+	char line[metricSize];
+	auto addLine = [&] (int len) {
+		if (len < 0) {
+			success = false;
+			return;
+		}
+		if (datagramSize > 0u && datagramSize + 1u + (size_t)len > MaxDatagramSize) {
+			success &= _messageSender->send(datagram);
+			datagramSize = 0u;
+		}
+		if (datagramSize > 0u) {
+			datagram[datagramSize++] = '\n';
+		}
+		SDL_memcpy(&datagram[datagramSize], line, (size_t)len);
+		datagramSize += (size_t)len;
+		datagram[datagramSize] = '\0';
+	};
+	for (const auto& e : _pending) {
+		for (Aggregate* aggregate = e->second; aggregate != nullptr; aggregate = aggregate->next) {
+			if (!aggregate->dirty) {
+				continue;
+			}
+			const char *key = aggregate->key.c_str();
+			if (!aggregate->distinct()) {
+				addLine(format(line, sizeof(line), key, aggregate->value, aggregate->type, aggregate->tags));
+			} else {
+				for (size_t v = 0u; v < aggregate->counts.size(); ++v) {
+					if (aggregate->counts[v] > 0u) {
+						addLine(format(line, sizeof(line), key, (int64_t)v, aggregate->type, aggregate->tags, aggregate->counts[v]));
+					}
+				}
+				for (const Aggregate::Sample& sample : aggregate->samples) {
+					addLine(format(line, sizeof(line), key, sample.value, aggregate->type, aggregate->tags, sample.count));
+				}
+			}
+			aggregate->reset();
+		}
+	}
+	if (datagramSize > 0u) {
+		success &= _messageSender->send(datagram);
+	}
+	return success;
+}
+
+const char* Metric::typeName(Type type) {
+	switch (type) {
+	case Type::Counter:
+		return "c";
+	case Type::Gauge:
+		return "g";
+	case Type::Timing:
+		return "ms";
+	case Type::Histogram:
+		return "h";
+	case Type::Meter:
+		return "m";
+	}
+	return "";
+}
+
 bool Metric::createTags(char* buffer, size_t len, const TagMap& tags, const char* sep, const char* preamble, const char *split) {
 	if (tags.empty()) {
 		return true;
@@ -77,40 +449,70 @@ bool Metric::createTags(char* buffer, size_t len, const TagMap& tags, const char
 	return true;
 }
 
-bool Metric::assemble(const char* key, int value, const char* type, const TagMap& tags) const {
-	if (!_messageSender) {
-		return false;
-	}
-	constexpr int metricSize = 256;
-	char buffer[metricSize];
+/**
+ * @note With a fixed amount of decimals, the rate of a few million samples would be sent as zero
+ */
+static void formatSampleRate(char *buffer, size_t len, uint32_t samples) {
+	SDL_snprintf(buffer, len, "|@%.9g", 1.0 / (double)samples);
+}
+
+int Metric::format(char *buffer, size_t len, const char* key, int64_t value, Type type, const TagMap& tags, uint32_t samples) const {
 	constexpr int tagsSize = 256;
 	char tagsBuffer[tagsSize] = "";
+	// a value that was recorded multiple times is sent with the matching sample rate
+	char sampleRate[32] = "";
+	const char *typeStr = typeName(type);
+	const long long v = (long long)value;
 	int written;
 	switch (_flavor) {
 	case Flavor::Etsy:
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s:%i|%s", _prefix.c_str(), key, value, type);
+		if (samples > 1u) {
+			formatSampleRate(sampleRate, sizeof(sampleRate), samples);
+		}
+		written = SDL_snprintf(buffer, len, "%s.%s:%lld|%s%s", _prefix.c_str(), key, v, typeStr, sampleRate);
 		break;
 	case Flavor::Datadog:
 		if (!createTags(tagsBuffer, sizeof(tagsBuffer), tags, ":", "|#", ",")) {
-			return false;
+			return -1;
 		}
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s:%i|%s%s", _prefix.c_str(), key, value, type, tagsBuffer);
+		if (samples > 1u) {
+			formatSampleRate(sampleRate, sizeof(sampleRate), samples);
+		}
+		written = SDL_snprintf(buffer, len, "%s.%s:%lld|%s%s%s", _prefix.c_str(), key, v, typeStr, sampleRate, tagsBuffer);
 		break;
 	case Flavor::Influx:
 		if (!createTags(tagsBuffer, sizeof(tagsBuffer), tags, "=", ",", ",")) {
-			return false;
+			return -1;
 		}
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s_%s,type=%s%s value=%i", _prefix.c_str(), key, type, tagsBuffer, value);
+		if (samples > 1u) {
+			SDL_snprintf(sampleRate, sizeof(sampleRate), ",count=%u", samples);
+		}
+		written = SDL_snprintf(buffer, len, "%s_%s,type=%s%s value=%lld%s", _prefix.c_str(), key, typeStr, tagsBuffer, v, sampleRate);
 		break;
 	case Flavor::Telegraf:
 	default:
 		if (!createTags(tagsBuffer, sizeof(tagsBuffer), tags, "=", ",", ",")) {
-			return false;
+			return -1;
 		}
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s%s:%i|%s", _prefix.c_str(), key, tagsBuffer, value, type);
+		if (samples > 1u) {
+			formatSampleRate(sampleRate, sizeof(sampleRate), samples);
+		}
+		written = SDL_snprintf(buffer, len, "%s.%s%s:%lld|%s%s", _prefix.c_str(), key, tagsBuffer, v, typeStr, sampleRate);
 		break;
 	}
-	if (written >= metricSize) {
+	if (written < 0 || written >= (int)len) {
+		return -1;
+	}
+	return written;
+}
+
+bool Metric::assemble(const char* key, int64_t value, Type type, const TagMap& tags) const {
+	if (!_messageSender) {
+		return false;
+	}
+	constexpr int metricSize = 256;
+	char buffer[metricSize];
+	if (format(buffer, sizeof(buffer), key, value, type, tags) < 0) {
 		return false;
 	}
 	return _messageSender->send(buffer);
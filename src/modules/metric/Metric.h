@@ -12,7 +12,11 @@
 
 #include "IMetricSender.h"
 #include "core/NonCopyable.h"
+#include "core/collection/DynamicArray.h"
+#include "core/collection/Map.h"
 #include "core/collection/StringMap.h"
+#include "core/concurrent/Lock.h"
+#include "core/Trace.h"
 #include <memory>
 #include <stdint.h>
 
@@ -33,14 +37,52 @@ enum class Flavor {
  */
 using TagMap = core::StringMap<core::String, 4>;
 
+/**
+ * @brief The default for the metrics without tags - every constructed @c TagMap allocates the pool of its entries
+ */
+inline const TagMap& noTags() {
+	static const TagMap tags(2);
+	return tags;
+}
+
+/**
+ * @brief The max size of a datagram with batched metric lines - leaves room for the IP and UDP headers in the
+ * ethernet MTU
+ */
+static constexpr size_t MaxDatagramSize = 1432u;
+
 /**
  * @brief The Metric class generates and publishes metrics
+ *
+ * If the @c metric_flushinterval cvar is not @c 0, the metrics are aggregated per thread and only sent on
+ * @c flush() - multiple metric lines are packed into one datagram of up to @c MaxDatagramSize bytes. Counters
+ * and meters are summed up, only the last value of a gauge is sent and the timings and histograms are sent as
+ * distinct values with a sample rate that reflects how often the value was recorded.
  */
 class Metric : public core::NonCopyable {
 private:
+	enum class Type : uint8_t {
+		Counter, Gauge, Timing, Histogram, Meter
+	};
+	struct Aggregate;
+	struct ThreadBuffer;
+	/**
+	 * @brief The aggregates by the hash of their key, type and tags - aggregates with the same hash are chained
+	 */
+	using Aggregates = core::Map<uint32_t, Aggregate*, 64, std::hash<uint32_t>>;
+
+	const uint32_t _id;
 	core::String _prefix;
 	Flavor _flavor = Flavor::Telegraf;
 	IMetricSenderPtr _messageSender;
+	uint64_t _flushMillis = 0u;
+	uint64_t _lastFlushMillis = 0u;
+
+	mutable core_trace_mutex(core::Lock, _threadBuffersMutex, "MetricThreadBuffers");
+	mutable core::DynamicArray<ThreadBuffer*> _threadBuffers;
+	mutable core_trace_mutex(core::Lock, _flushMutex, "MetricFlush");
+	// the aggregates of all threads that are collected on flush
+	mutable Aggregates _pending;
 
 	/**
 	 * @brief Create the needed tag list if it is supported by the specified flavor
@@ -52,26 +94,64 @@ private:
 	 * @return @c false if not all tags could get written into the specified target buffer, @c true otherwise
 	 */
 	static bool createTags(char *buffer, size_t len, const TagMap& tags, const char* sep, const char* preamble, const char *split = ",");
-	bool assemble(const char* key, int value, const char* type, const TagMap& tags = {}) const;
+	static const char* typeName(Type type);
+	/**
+	 * @return The hash of the key, the type and the tags of a metric
+	 */
+	static uint32_t hash(const char* key, Type type, const TagMap& tags);
+	static Aggregate* findAggregate(const Aggregates& aggregates, uint32_t hash, const char* key, Type type, const TagMap& tags);
+	static void addAggregate(Aggregates& aggregates, Aggregate* aggregate);
+	static void deleteAggregates(Aggregates& aggregates);
+	/**
+	 * @param[in] samples The amount of times the value was recorded - only used for timings and histograms
+	 * @return The length of the metric line or @c -1 if it doesn't fit into the buffer
+	 */
+	int format(char *buffer, size_t len, const char* key, int64_t value, Type type, const TagMap& tags, uint32_t samples = 1u) const;
+	bool assemble(const char* key, int64_t value, Type type, const TagMap& tags = noTags()) const;
+	bool record(const char* key, int64_t value, Type type, const TagMap& tags) const;
+	ThreadBuffer* threadBuffer() const;
+	void clearAggregates();
 public:
+	Metric();
 	~Metric();
 
 	/**
 	 * @param[in] messageSender @c IMessageSender - must already be initialized
-	 * @note Reads the @c metric_flavor cvar to configure the flavor.
+	 * @note Reads the @c metric_flavor cvar to configure the flavor and the @c metric_flushinterval cvar to
+	 * configure the aggregation.
 	 */
 	bool init(const char *prefix, const IMetricSenderPtr& messageSender);
+	/**
+	 * @brief Sends the aggregated metrics and shuts down
+	 */
 	void shutdown();
 
+	/**
+	 * @brief Flushes the aggregated metrics if the flush interval has passed
+	 * @param[in] nowMillis The current time in millis
+	 */
+	void update(uint64_t nowMillis);
+
+	/**
+	 * @brief Sends all the metrics that were aggregated since the last flush
+	 * @return @c false if not all metric lines could get sent
+	 */
+	bool flush() const;
+
+	/**
+	 * @return @c true if the metrics are aggregated and only sent on @c flush()
+	 */
+	bool aggregates() const;
+
 	/**
 	 * @brief Increments the key
 	 */
-	bool increment(const char* key, const TagMap& tags = {}) const;
+	bool increment(const char* key, const TagMap& tags = noTags()) const;
 
 	/**
 	 * @brief Decrements the key
 	 */
-	bool decrement(const char* key, const TagMap& tags = {}) const;
+	bool decrement(const char* key, const TagMap& tags = noTags()) const;
 
 	/**
 	 * @brief Add the specified delta to the given key
@@ -83,7 +163,7 @@ public:
 	 * @code <metric name>:<value>|c[|@<sample rate>] @endcode
 	 * @note Record event counts
 	 */
-	bool count(const char* key, int delta, const TagMap& tags = {}, float sampleRate = 1.0f) const;
+	bool count(const char* key, int delta, const TagMap& tags = noTags(), float sampleRate = 1.0f) const;
 
 	/**
 	 * @brief Records a gauge with the give value for the key
@@ -94,7 +174,7 @@ public:
 	 * @code <metric name>:<value>|g @endcode
 	 * @note Record raw values
 	 */
-	bool gauge(const char* key, uint32_t value, const TagMap& tags = {}) const;
+	bool gauge(const char* key, uint32_t value, const TagMap& tags = noTags()) const;
 
 	/**
 	 * @brief Records a timing in millis for a key
@@ -104,7 +184,7 @@ public:
 	 * @code <metric name>:<value>|ms @endcode
 	 * @note Record execution times
 	 */
-	bool timing(const char* key, uint32_t millis, const TagMap& tags = {}) const;
+	bool timing(const char* key, uint32_t millis, const TagMap& tags = noTags()) const;
 
 	/**
 	 * @brief Records a histogram
@@ -115,7 +195,7 @@ public:
 	 * @code <metric name>:<value>|h @endcode
 	 * @note Record value distributions
 	 */
-	bool histogram(const char* key, uint32_t millis, const TagMap& tags = {}) const;
+	bool histogram(const char* key, uint32_t millis, const TagMap& tags = noTags()) const;
 
 	/**
 	 * @brief Records a meter
@@ -130,7 +210,7 @@ public:
 	 * The shortened form is documented here for completeness.
 	 * @note Record execution rates
 	 */
-	bool meter(const char* key, int value, const TagMap& tags = {}) const;
+	bool meter(const char* key, int value, const TagMap& tags = noTags()) const;
 };
 
 inline bool Metric::increment(const char* key, const TagMap& tags) const {
@@ -142,23 +222,27 @@ inline bool Metric::decrement(const char* key, const TagMap& tags) const {
 }
 
 inline bool Metric::count(const char* key, int delta, const TagMap& tags, float sampleRate) const {
-	return assemble(key, delta, "c", tags); // TODO:"|@%f", sampleRate
+	return record(key, delta, Type::Counter, tags); // TODO:"|@%f", sampleRate
 }
 
 inline bool Metric::gauge(const char* key, uint32_t value, const TagMap& tags) const {
-	return assemble(key, value, "g", tags);
+	return record(key, value, Type::Gauge, tags);
 }
 
 inline bool Metric::timing(const char* key, uint32_t millis, const TagMap& tags) const {
-	return assemble(key, millis, "ms", tags);
+	return record(key, millis, Type::Timing, tags);
 }
 
 inline bool Metric::histogram(const char* key, uint32_t millis, const TagMap& tags) const {
-	return assemble(key, millis, "h", tags);
+	return record(key, millis, Type::Histogram, tags);
 }
 
 inline bool Metric::meter(const char* key, int value, const TagMap& tags) const {
-	return assemble(key, value, "m", tags);
+	return record(key, value, Type::Meter, tags);
+}
+
+inline bool Metric::aggregates() const {
+	return _flushMillis > 0u;
 }
 
 using MetricPtr = std::shared_ptr<Metric>;
@@ -6,22 +6,31 @@
 #include "metric/Metric.h"
 #include "metric/IMetricSender.h"
 #include "core/Var.h"
+#include "core/GameConfig.h"
+#include "core/StringUtil.h"
+#include <thread>
 
 namespace metric {
 
 class BufferSender : public IMetricSender {
 private:
 	mutable core::String _lastBuffer;
+	mutable int _sends = 0;
 public:
 
 	bool send(const char* buffer) const override {
 		_lastBuffer = buffer;
+		++_sends;
 		return true;
 	}
 
 	inline const core::String& metricLine() const {
 		return _lastBuffer;
 	}
+
+	inline int sends() const {
+		return _sends;
+	}
 };
 
 #define PREFIX "test"
@@ -36,6 +45,23 @@ protected:
 
 	void TearDown() override {
 		sender->shutdown();
+		core::Var::get(cfg::MetricFlushInterval, "")->setVal("0");
+	}
+
+	inline void aggregate(Metric& m, Flavor flavor) const {
+		setFlavor(flavor);
+		core::Var::get(cfg::MetricFlushInterval, "")->setVal("1000");
+		m.init(PREFIX, sender);
+		ASSERT_TRUE(m.aggregates());
+	}
+
+	static bool hasLine(const core::DynamicArray<core::String>& lines, const char *line) {
+		for (const core::String& l : lines) {
+			if (l == line) {
+				return true;
+			}
+		}
+		return false;
 	}
 
 	inline core::String count(const char *id, int value, Flavor flavor, const TagMap& tags = {}) const {
@@ -122,4 +148,103 @@ TEST_F(MetricTest, DISABLED_testTimingMultipleTags) {
 		<< "Expected to get tags after type in datadog flavor";
 }
 
+TEST_F(MetricTest, testAggregateCounter) {
+	Metric m;
+	aggregate(m, Flavor::Etsy);
+	for (int i = 0; i < 10; ++i) {
+		EXPECT_TRUE(m.increment("counter"));
+	}
+	EXPECT_EQ(0, sender->sends()) << "Nothing should get sent before the flush";
+	EXPECT_TRUE(m.flush());
+	EXPECT_EQ(1, sender->sends());
+	EXPECT_EQ(sender->metricLine(), PREFIX ".counter:10|c");
+	EXPECT_TRUE(m.flush());
+	EXPECT_EQ(1, sender->sends()) << "Nothing was recorded since the last flush";
+}
+
+TEST_F(MetricTest, testAggregateGaugeAndTimings) {
+	Metric m;
+	aggregate(m, Flavor::Telegraf);
+	m.gauge("gauge", 1);
+	m.gauge("gauge", 3);
+	for (int i = 0; i < 4; ++i) {
+		m.timing("timing", 5, {{"key1", "value1"}});
+	}
+	m.timing("timing", 7, {{"key1", "value1"}});
+	EXPECT_TRUE(m.flush());
+	EXPECT_EQ(1, sender->sends()) << "All lines should get batched into one datagram";
+	core::DynamicArray<core::String> lines;
+	core::string::splitString(sender->metricLine(), lines, "\n");
+	ASSERT_EQ(3u, lines.size()) << sender->metricLine().c_str();
+	EXPECT_TRUE(hasLine(lines, PREFIX ".gauge:3|g")) << sender->metricLine().c_str();
+	EXPECT_TRUE(hasLine(lines, PREFIX ".timing,key1=value1:5|ms|@0.25")) << sender->metricLine().c_str();
+	EXPECT_TRUE(hasLine(lines, PREFIX ".timing,key1=value1:7|ms")) << sender->metricLine().c_str();
+}
+
+TEST_F(MetricTest, testAggregateDistinctIds) {
+	Metric m;
+	aggregate(m, Flavor::Telegraf);
+	m.count("key", 1, {{"tag", "a"}});
+	m.count("key", 2, {{"tag", "b"}});
+	m.count("key", 3, {{"tag", "a"}});
+	m.gauge("key", 4);
+	m.timing("key", 5000);
+	m.timing("key", 5000);
+	m.timing("key", 0);
+	EXPECT_TRUE(m.flush());
+	core::DynamicArray<core::String> lines;
+	core::string::splitString(sender->metricLine(), lines, "\n");
+	ASSERT_EQ(5u, lines.size()) << sender->metricLine().c_str();
+	EXPECT_TRUE(hasLine(lines, PREFIX ".key,tag=a:4|c")) << sender->metricLine().c_str();
+	EXPECT_TRUE(hasLine(lines, PREFIX ".key,tag=b:2|c")) << sender->metricLine().c_str();
+	EXPECT_TRUE(hasLine(lines, PREFIX ".key:4|g")) << sender->metricLine().c_str();
+	EXPECT_TRUE(hasLine(lines, PREFIX ".key:5000|ms|@0.5")) << sender->metricLine().c_str();
+	EXPECT_TRUE(hasLine(lines, PREFIX ".key:0|ms")) << sender->metricLine().c_str();
+}
+
+TEST_F(MetricTest, testAggregateSampleRate) {
+	Metric m;
+	aggregate(m, Flavor::Telegraf);
+	for (int i = 0; i < 3000000; ++i) {
+		m.timing("timing", 5);
+	}
+	EXPECT_TRUE(m.flush());
+	core::DynamicArray<core::String> lines;
+	core::string::splitString(sender->metricLine(), lines, "\n");
+	ASSERT_EQ(1u, lines.size()) << sender->metricLine().c_str();
+	EXPECT_TRUE(hasLine(lines, PREFIX ".timing:5|ms|@3.33333333e-07")) << "The sample rate must not be rounded to zero: "
+			<< sender->metricLine().c_str();
+}
+
+TEST_F(MetricTest, testAggregateThreads) {
+	Metric m;
+	aggregate(m, Flavor::Etsy);
+	std::thread threads[4];
+	for (std::thread& t : threads) {
+		t = std::thread([&m] () {
+			for (int i = 0; i < 1000; ++i) {
+				m.increment("counter");
+			}
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	EXPECT_TRUE(m.flush());
+	EXPECT_EQ(sender->metricLine(), PREFIX ".counter:4000|c");
+}
+
+TEST_F(MetricTest, testAggregateDatagramSize) {
+	Metric m;
+	aggregate(m, Flavor::Influx);
+	for (int i = 0; i < 200; ++i) {
+		const core::String& key = core::String::format("key%i", i);
+		m.count(key.c_str(), i + 1);
+	}
+	EXPECT_TRUE(m.flush());
+	EXPECT_GT(sender->sends(), 1);
+	EXPECT_LT(sender->sends(), 200);
+	EXPECT_LE(sender->metricLine().size(), MaxDatagramSize);
+}
+
 }
@@ -0,0 +1,160 @@
+/**
+ * @file
+ */
+
+#include <gtest/gtest.h>
+#include "metric/Metric.h"
+#include "metric/UDPMetricSender.h"
+#include "core/GameConfig.h"
+#include "core/StringUtil.h"
+#include "core/Var.h"
+#ifndef __WINDOWS__
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#define closesocket close
+#define INVALID_SOCKET (-1)
+#endif
+
+namespace metric {
+
+#define PREFIX "test"
+
+/**
+ * @brief Receives the datagrams of the @c UDPMetricSender on a local port
+ */
+class UDPMetricSenderTest: public testing::Test {
+protected:
+	SOCKET _sink = INVALID_SOCKET;
+	int _port = 0;
+
+	void SetUp() override {
+#ifdef __WINDOWS__
+		WSADATA wsaData;
+		ASSERT_EQ(NO_ERROR, WSAStartup(MAKEWORD(2, 2), &wsaData));
+#endif
+		_sink = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		ASSERT_NE(INVALID_SOCKET, _sink);
+		struct sockaddr_in addr;
+		SDL_memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		// let the os pick a free port
+		addr.sin_port = 0;
+		ASSERT_EQ(0, bind(_sink, (const struct sockaddr*)&addr, sizeof(addr)));
+		socklen_t len = sizeof(addr);
+		ASSERT_EQ(0, getsockname(_sink, (struct sockaddr*)&addr, &len));
+		_port = ntohs(addr.sin_port);
+#ifdef __WINDOWS__
+		const DWORD timeout = 1000;
+#else
+		struct timeval timeout;
+		timeout.tv_sec = 1;
+		timeout.tv_usec = 0;
+#endif
+		ASSERT_EQ(0, setsockopt(_sink, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout)));
+	}
+
+	void TearDown() override {
+		if (_sink != INVALID_SOCKET) {
+			closesocket(_sink);
+		}
+		core::Var::get(cfg::MetricFlushInterval, "")->setVal("0");
+#ifdef __WINDOWS__
+		WSACleanup();
+#endif
+	}
+
+	/**
+	 * @return The lines of the next datagram - empty if nothing was received
+	 */
+	core::DynamicArray<core::String> receive() const {
+		char buf[MaxDatagramSize + 1];
+		const int received = (int)recv(_sink, buf, MaxDatagramSize, 0);
+		core::DynamicArray<core::String> lines;
+		if (received <= 0) {
+			return lines;
+		}
+		buf[received] = '\0';
+		core::string::splitString(buf, lines, "\n");
+		return lines;
+	}
+
+	static bool hasLine(const core::DynamicArray<core::String>& lines, const char *line) {
+		for (const core::String& l : lines) {
+			if (l == line) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void flush(const char *flavor, core::DynamicArray<core::String>& lines) const {
+		core::Var::get(cfg::MetricFlavor, "")->setVal(flavor);
+		core::Var::get(cfg::MetricFlushInterval, "")->setVal("1000");
+		const std::shared_ptr<UDPMetricSender> sender = std::make_shared<UDPMetricSender>("127.0.0.1", _port);
+		ASSERT_TRUE(sender->init());
+		Metric m;
+		ASSERT_TRUE(m.init(PREFIX, sender));
+		for (int i = 0; i < 3; ++i) {
+			m.increment("counter", {{"key1", "value1"}});
+			m.timing("timing", 5);
+		}
+		m.gauge("gauge", 42);
+		ASSERT_TRUE(m.flush());
+		m.shutdown();
+		sender->shutdown();
+		lines = receive();
+	}
+};
+
+TEST_F(UDPMetricSenderTest, testSend) {
+	const std::shared_ptr<UDPMetricSender> sender = std::make_shared<UDPMetricSender>("127.0.0.1", _port);
+	ASSERT_TRUE(sender->init());
+	ASSERT_TRUE(sender->send(PREFIX ".counter:1|c"));
+	sender->shutdown();
+	const core::DynamicArray<core::String>& lines = receive();
+	ASSERT_EQ(1u, lines.size());
+	EXPECT_EQ(lines[0], PREFIX ".counter:1|c");
+}
+
+TEST_F(UDPMetricSenderTest, testEtsy) {
+	core::DynamicArray<core::String> lines;
+	flush("etsy", lines);
+	ASSERT_EQ(3u, lines.size());
+	EXPECT_TRUE(hasLine(lines, PREFIX ".counter:3|c"));
+	EXPECT_TRUE(hasLine(lines, PREFIX ".timing:5|ms|@0.333333333"));
+	EXPECT_TRUE(hasLine(lines, PREFIX ".gauge:42|g"));
+}
+
+TEST_F(UDPMetricSenderTest, testDatadog) {
+	core::DynamicArray<core::String> lines;
+	flush("datadog", lines);
+	ASSERT_EQ(3u, lines.size());
+	EXPECT_TRUE(hasLine(lines, PREFIX ".counter:3|c|#key1:value1"));
+	EXPECT_TRUE(hasLine(lines, PREFIX ".timing:5|ms|@0.333333333"));
+	EXPECT_TRUE(hasLine(lines, PREFIX ".gauge:42|g"));
+}
+
+TEST_F(UDPMetricSenderTest, testTelegraf) {
+	core::DynamicArray<core::String> lines;
+	flush("telegraf", lines);
+	ASSERT_EQ(3u, lines.size());
+	EXPECT_TRUE(hasLine(lines, PREFIX ".counter,key1=value1:3|c"));
+	EXPECT_TRUE(hasLine(lines, PREFIX ".timing:5|ms|@0.333333333"));
+	EXPECT_TRUE(hasLine(lines, PREFIX ".gauge:42|g"));
+}
+
+TEST_F(UDPMetricSenderTest, testInflux) {
+	core::DynamicArray<core::String> lines;
+	flush("influx", lines);
+	ASSERT_EQ(3u, lines.size());
+	EXPECT_TRUE(hasLine(lines, PREFIX "_counter,type=c,key1=value1 value=3"));
+	EXPECT_TRUE(hasLine(lines, PREFIX "_timing,type=ms value=5,count=3"));
+	EXPECT_TRUE(hasLine(lines, PREFIX "_gauge,type=g value=42"));
+}
+
+}
@@ -0,0 +1,107 @@
+/**
+ * @file
+ */
+
+#include "SimplexBatch.h"
+#include "SimplexBatchKernel.h"
+#include "Simplex.h"
+#include <SDL_cpuinfo.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOISE_BATCH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace noise {
+
+#ifdef NOISE_BATCH_SSE2
+namespace details {
+
+struct SSE2 {
+	static constexpr int Width = 4;
+	typedef __m128 Float;
+	typedef __m128i Int;
+
+	static inline Float set(float v) { return _mm_set1_ps(v); }
+	static inline Float load(const float* v) { return _mm_load_ps(v); }
+	static inline void store(float* out, Float v) { _mm_storeu_ps(out, v); }
+	static inline Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+	static inline Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+	static inline Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+	static inline Float and_(Float a, Float b) { return _mm_and_ps(a, b); }
+	static inline Float andNot(Float mask, Float b) { return _mm_andnot_ps(mask, b); }
+	static inline Float or_(Float a, Float b) { return _mm_or_ps(a, b); }
+	static inline Float xor_(Float a, Float b) { return _mm_xor_ps(a, b); }
+	static inline Float select(Float mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	static inline Float ge(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+	static inline Float lt(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+	static inline int movemask(Float mask) { return _mm_movemask_ps(mask); }
+
+	static inline Float mulDouble(Float a, double b) {
+		const __m128d d = _mm_set1_pd(b);
+		const __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(a), d));
+		const __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), d));
+		return _mm_movelh_ps(lo, hi);
+	}
+	static inline Float addDouble(Float a, double b) {
+		const __m128d d = _mm_set1_pd(b);
+		const __m128 lo = _mm_cvtpd_ps(_mm_add_pd(_mm_cvtps_pd(a), d));
+		const __m128 hi = _mm_cvtpd_ps(_mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), d));
+		return _mm_movelh_ps(lo, hi);
+	}
+
+	static inline Int setInt(int v) { return _mm_set1_epi32(v); }
+	static inline Int loadInt(const int* v) { return _mm_load_si128((const __m128i*)v); }
+	static inline void storeInt(int* out, Int v) { _mm_store_si128((__m128i*)out, v); }
+	static inline Int addInt(Int a, Int b) { return _mm_add_epi32(a, b); }
+	static inline Int andInt(Int a, Int b) { return _mm_and_si128(a, b); }
+	static inline Int eqInt(Int a, Int b) { return _mm_cmpeq_epi32(a, b); }
+	static inline Int ltInt(Int a, Int b) { return _mm_cmplt_epi32(a, b); }
+	static inline Float intMask(Int mask) { return _mm_castsi128_ps(mask); }
+	static inline Float toFloat(Int v) { return _mm_cvtepi32_ps(v); }
+	// same as FASTFLOOR - truncate and subtract one for everything that is not greater than zero
+	static inline Int fastFloor(Float v) {
+		const Int truncated = _mm_cvttps_epi32(v);
+		const Int notPositive = _mm_castps_si128(_mm_cmple_ps(v, _mm_setzero_ps()));
+		return _mm_add_epi32(truncated, notPositive);
+	}
+};
+
+}
+#endif
+
+SimdLevel bestSimdLevel() {
+	static const SimdLevel level = [] () {
+		if (SDL_HasAVX2() && details::batchFBmAVX2(nullptr, nullptr, nullptr, 0, 0, 0.0f, 0.0f) != -1) {
+			return SimdLevel::AVX2;
+		}
+#ifdef NOISE_BATCH_SSE2
+		if (SDL_HasSSE2()) {
+			return SimdLevel::SSE2;
+		}
+#endif
+		return SimdLevel::Scalar;
+	}();
+	return level;
+}
+
+void fBm(const glm::vec3* positions, float* results, int amount, uint8_t octaves, float lacunarity, float gain, SimdLevel level) {
+	if (level > bestSimdLevel()) {
+		level = bestSimdLevel();
+	}
+	const uint8_t* perm = details::perm;
+	int processed = 0;
+	if (level == SimdLevel::AVX2) {
+		processed = details::batchFBmAVX2(perm, positions, results, amount, octaves, lacunarity, gain);
+	}
+#ifdef NOISE_BATCH_SSE2
+	else if (level == SimdLevel::SSE2) {
+		processed = details::batchFBm<details::SSE2>(perm, positions, results, amount, octaves, lacunarity, gain);
+	}
+#endif
+	for (int i = processed; i < amount; ++i) {
+		results[i] = fBm(positions[i], octaves, lacunarity, gain);
+	}
+}
+
+}
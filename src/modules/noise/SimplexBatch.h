@@ -0,0 +1,44 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <stdint.h>
+
+namespace noise {
+
+/**
+ * @brief The instruction sets the batched noise functions can use
+ */
+enum class SimdLevel : uint8_t {
+	Scalar,
+	SSE2,
+	AVX2
+};
+
+/**
+ * @brief The best instruction set that is supported by the cpu. This is detected at runtime.
+ */
+SimdLevel bestSimdLevel();
+
+/**
+ * @brief Evaluates @c fBm(const glm::vec3&) for all the given positions at once.
+ *
+ * The points are processed in groups of four (SSE2) or eight (AVX2). The results are bit identical to
+ * calling the scalar @c fBm() for each position, so the same seed produces the same world no matter
+ * which path was taken.
+ *
+ * @param[in] positions The already scaled noise positions
+ * @param[out] results Receives one value for each position
+ * @param[in] amount The amount of positions
+ * @param[in] level The instruction set to use - an unsupported level falls back to the best supported one
+ */
+void fBm(const glm::vec3* positions, float* results, int amount, uint8_t octaves, float lacunarity, float gain, SimdLevel level);
+
+inline void fBm(const glm::vec3* positions, float* results, int amount, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f) {
+	fBm(positions, results, amount, octaves, lacunarity, gain, bestSimdLevel());
+}
+
+}
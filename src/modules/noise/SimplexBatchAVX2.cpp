@@ -0,0 +1,87 @@
+/**
+ * @file
+ * @note This file is compiled with AVX2 enabled - see the CMakeLists.txt. Don't include anything here that
+ * might produce inline code that is shared with other translation units.
+ */
+
+#include "SimplexBatchKernel.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+namespace noise {
+namespace details {
+
+struct AVX2 {
+	static constexpr int Width = 8;
+	typedef __m256 Float;
+	typedef __m256i Int;
+
+	static inline Float set(float v) { return _mm256_set1_ps(v); }
+	static inline Float load(const float* v) { return _mm256_load_ps(v); }
+	static inline void store(float* out, Float v) { _mm256_storeu_ps(out, v); }
+	static inline Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+	static inline Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+	static inline Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+	static inline Float and_(Float a, Float b) { return _mm256_and_ps(a, b); }
+	static inline Float andNot(Float mask, Float b) { return _mm256_andnot_ps(mask, b); }
+	static inline Float or_(Float a, Float b) { return _mm256_or_ps(a, b); }
+	static inline Float xor_(Float a, Float b) { return _mm256_xor_ps(a, b); }
+	static inline Float select(Float mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+	static inline Float ge(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static inline Float lt(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static inline int movemask(Float mask) { return _mm256_movemask_ps(mask); }
+
+	static inline Float combine(__m128 lo, __m128 hi) {
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+	}
+	static inline Float mulDouble(Float a, double b) {
+		const __m256d d = _mm256_set1_pd(b);
+		const __m128 lo = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a)), d));
+		const __m128 hi = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)), d));
+		return combine(lo, hi);
+	}
+	static inline Float addDouble(Float a, double b) {
+		const __m256d d = _mm256_set1_pd(b);
+		const __m128 lo = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a)), d));
+		const __m128 hi = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)), d));
+		return combine(lo, hi);
+	}
+
+	static inline Int setInt(int v) { return _mm256_set1_epi32(v); }
+	static inline Int loadInt(const int* v) { return _mm256_load_si256((const __m256i*)v); }
+	static inline void storeInt(int* out, Int v) { _mm256_store_si256((__m256i*)out, v); }
+	static inline Int addInt(Int a, Int b) { return _mm256_add_epi32(a, b); }
+	static inline Int andInt(Int a, Int b) { return _mm256_and_si256(a, b); }
+	static inline Int eqInt(Int a, Int b) { return _mm256_cmpeq_epi32(a, b); }
+	static inline Int ltInt(Int a, Int b) { return _mm256_cmpgt_epi32(b, a); }
+	static inline Float intMask(Int mask) { return _mm256_castsi256_ps(mask); }
+	static inline Float toFloat(Int v) { return _mm256_cvtepi32_ps(v); }
+	// same as FASTFLOOR - truncate and subtract one for everything that is not greater than zero
+	static inline Int fastFloor(Float v) {
+		const Int truncated = _mm256_cvttps_epi32(v);
+		const Int notPositive = _mm256_castps_si256(_mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_LE_OQ));
+		return _mm256_add_epi32(truncated, notPositive);
+	}
+};
+
+int batchFBmAVX2(const uint8_t* perm, const glm::vec3* positions, float* results, int amount, uint8_t octaves, float lacunarity, float gain) {
+	return batchFBm<AVX2>(perm, positions, results, amount, octaves, lacunarity, gain);
+}
+
+}
+}
+
+#else
+
+namespace noise {
+namespace details {
+
+int batchFBmAVX2(const uint8_t*, const glm::vec3*, float*, int, uint8_t, float, float) {
+	return -1;
+}
+
+}
+}
+
+#endif
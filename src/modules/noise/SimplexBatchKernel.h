@@ -0,0 +1,166 @@
+/**
+ * @file
+ * @brief The vectorized 3d simplex noise for @c SimplexBatch.h
+ *
+ * The kernel is written against a small set of operations that each instruction set provides (@c V). It is
+ * included by one translation unit per instruction set - the unit for AVX2 is compiled with different flags
+ * and must not share any inline code with the rest of the module. That's also why the permutation table is
+ * handed in instead of using the one from @c Simplex.h.
+ *
+ * Every operation mirrors the scalar @c noise(const glm::vec3&) exactly. This includes the skew factors that
+ * are double constants there: the products and sums with them are done in double precision and rounded back
+ * to float, just like the implicit conversions in the scalar code.
+ */
+
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <stdint.h>
+
+namespace noise {
+namespace details {
+
+// keep these in sync with Simplex.h
+static constexpr double BatchF3 = 0.333333333;
+static constexpr double BatchG3 = 0.166666667;
+static constexpr double BatchG3x2 = 2.0f * BatchG3;
+static constexpr double BatchG3x3 = 3.0f * BatchG3;
+
+/**
+ * @brief The dot product of the gradient that is selected by the hash with the given offsets - see @c grad()
+ */
+template<class V>
+inline typename V::Float batchGrad(typename V::Int hash, typename V::Float x, typename V::Float y, typename V::Float z) {
+	typedef typename V::Float Float;
+	const typename V::Int h = V::andInt(hash, V::setInt(15));
+	const Float u = V::select(V::intMask(V::ltInt(h, V::setInt(8))), x, y);
+	const Float h12or14 = V::or_(V::intMask(V::eqInt(h, V::setInt(12))), V::intMask(V::eqInt(h, V::setInt(14))));
+	const Float v = V::select(V::intMask(V::ltInt(h, V::setInt(4))), y, V::select(h12or14, x, z));
+	const Float signBit = V::set(-0.0f);
+	const Float negU = V::intMask(V::eqInt(V::andInt(h, V::setInt(1)), V::setInt(1)));
+	const Float negV = V::intMask(V::eqInt(V::andInt(h, V::setInt(2)), V::setInt(2)));
+	return V::add(V::xor_(u, V::and_(negU, signBit)), V::xor_(v, V::and_(negV, signBit)));
+}
+
+template<class V>
+inline typename V::Float batchCorner(typename V::Int hash, typename V::Float x, typename V::Float y, typename V::Float z) {
+	typedef typename V::Float Float;
+	Float t = V::sub(V::sub(V::sub(V::set(0.6f), V::mul(x, x)), V::mul(y, y)), V::mul(z, z));
+	const Float outside = V::lt(t, V::set(0.0f));
+	t = V::mul(t, t);
+	const Float n = V::mul(V::mul(t, t), batchGrad<V>(hash, x, y, z));
+	return V::andNot(outside, n);
+}
+
+/**
+ * @brief 3d simplex noise for @c V::Width points
+ */
+template<class V>
+typename V::Float batchSimplex(const uint8_t* perm, typename V::Float x, typename V::Float y, typename V::Float z) {
+	typedef typename V::Float Float;
+	typedef typename V::Int Int;
+	constexpr int W = V::Width;
+
+	const Float s = V::mulDouble(V::add(V::add(x, y), z), BatchF3);
+	const Int i = V::fastFloor(V::add(x, s));
+	const Int j = V::fastFloor(V::add(y, s));
+	const Int k = V::fastFloor(V::add(z, s));
+	const Float t = V::mulDouble(V::toFloat(V::addInt(V::addInt(i, j), k)), BatchG3);
+	const Float x0 = V::sub(x, V::sub(V::toFloat(i), t));
+	const Float y0 = V::sub(y, V::sub(V::toFloat(j), t));
+	const Float z0 = V::sub(z, V::sub(V::toFloat(k), t));
+
+	// the branches of the scalar version to find the simplex we are in as masks
+	const Float xy = V::ge(x0, y0);
+	const Float yz = V::ge(y0, z0);
+	const Float xz = V::ge(x0, z0);
+	const Float all = V::intMask(V::setInt(-1));
+	const Float i1 = V::and_(xy, V::or_(yz, xz));
+	const Float j1 = V::andNot(xy, yz);
+	const Float k1 = V::andNot(V::or_(yz, V::and_(xy, xz)), all);
+	const Float i2 = V::or_(xy, V::and_(yz, xz));
+	const Float j2 = V::or_(yz, V::andNot(xy, all));
+	const Float k2 = V::andNot(V::and_(yz, V::or_(xy, xz)), all);
+
+	const Float one = V::set(1.0f);
+	const Float x1 = V::addDouble(V::sub(x0, V::and_(i1, one)), BatchG3);
+	const Float y1 = V::addDouble(V::sub(y0, V::and_(j1, one)), BatchG3);
+	const Float z1 = V::addDouble(V::sub(z0, V::and_(k1, one)), BatchG3);
+	const Float x2 = V::addDouble(V::sub(x0, V::and_(i2, one)), BatchG3x2);
+	const Float y2 = V::addDouble(V::sub(y0, V::and_(j2, one)), BatchG3x2);
+	const Float z2 = V::addDouble(V::sub(z0, V::and_(k2, one)), BatchG3x2);
+	const Float x3 = V::addDouble(V::sub(x0, one), BatchG3x3);
+	const Float y3 = V::addDouble(V::sub(y0, one), BatchG3x3);
+	const Float z3 = V::addDouble(V::sub(z0, one), BatchG3x3);
+
+	// the permutation table lookups are done per lane
+	alignas(32) int ii[W], jj[W], kk[W];
+	alignas(32) int h0[W], h1[W], h2[W], h3[W];
+	const Int mask = V::setInt(0xff);
+	V::storeInt(ii, V::andInt(i, mask));
+	V::storeInt(jj, V::andInt(j, mask));
+	V::storeInt(kk, V::andInt(k, mask));
+	const int mi1 = V::movemask(i1), mj1 = V::movemask(j1), mk1 = V::movemask(k1);
+	const int mi2 = V::movemask(i2), mj2 = V::movemask(j2), mk2 = V::movemask(k2);
+	for (int l = 0; l < W; ++l) {
+		const int a = ii[l];
+		const int b = jj[l];
+		const int c = kk[l];
+		const int oi1 = (mi1 >> l) & 1, oj1 = (mj1 >> l) & 1, ok1 = (mk1 >> l) & 1;
+		const int oi2 = (mi2 >> l) & 1, oj2 = (mj2 >> l) & 1, ok2 = (mk2 >> l) & 1;
+		h0[l] = perm[a + perm[b + perm[c]]];
+		h1[l] = perm[a + oi1 + perm[b + oj1 + perm[c + ok1]]];
+		h2[l] = perm[a + oi2 + perm[b + oj2 + perm[c + ok2]]];
+		h3[l] = perm[a + 1 + perm[b + 1 + perm[c + 1]]];
+	}
+
+	const Float n0 = batchCorner<V>(V::loadInt(h0), x0, y0, z0);
+	const Float n1 = batchCorner<V>(V::loadInt(h1), x1, y1, z1);
+	const Float n2 = batchCorner<V>(V::loadInt(h2), x2, y2, z2);
+	const Float n3 = batchCorner<V>(V::loadInt(h3), x3, y3, z3);
+	return V::mul(V::set(32.0f), V::add(V::add(V::add(n0, n1), n2), n3));
+}
+
+/**
+ * @return The amount of positions that were processed - the remaining ones (less than @c V::Width) are left
+ * for the scalar code
+ */
+template<class V>
+int batchFBm(const uint8_t* perm, const glm::vec3* positions, float* results, int amount, uint8_t octaves, float lacunarity, float gain) {
+	typedef typename V::Float Float;
+	constexpr int W = V::Width;
+	int processed = 0;
+	for (; processed + W <= amount; processed += W) {
+		alignas(32) float xs[W], ys[W], zs[W];
+		for (int l = 0; l < W; ++l) {
+			const glm::vec3& p = positions[processed + l];
+			xs[l] = p.x;
+			ys[l] = p.y;
+			zs[l] = p.z;
+		}
+		const Float x = V::load(xs);
+		const Float y = V::load(ys);
+		const Float z = V::load(zs);
+		Float sum = V::set(0.0f);
+		float freq = 1.0f;
+		float amp = 0.5f;
+		for (uint8_t o = 0; o < octaves; ++o) {
+			const Float f = V::set(freq);
+			const Float n = batchSimplex<V>(perm, V::mul(x, f), V::mul(y, f), V::mul(z, f));
+			sum = V::add(sum, V::mul(n, V::set(amp)));
+			freq *= lacunarity;
+			amp *= gain;
+		}
+		V::store(results + processed, sum);
+	}
+	return processed;
+}
+
+/**
+ * @brief Implemented in its own translation unit that is compiled with AVX2 enabled
+ * @return @c -1 if the module was compiled without AVX2 support
+ */
+int batchFBmAVX2(const uint8_t* perm, const glm::vec3* positions, float* results, int amount, uint8_t octaves, float lacunarity, float gain);
+
+}
+}
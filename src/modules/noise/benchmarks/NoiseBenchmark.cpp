@@ -0,0 +1,64 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "noise/Simplex.h"
+#include "noise/SimplexBatch.h"
+
+class NoiseBenchmark: public app::AbstractBenchmark {
+protected:
+	// one column of a world chunk
+	static constexpr int Amount = 256;
+	glm::vec3 _positions[Amount];
+	float _results[Amount];
+
+public:
+	void SetUp(benchmark::State& state) override {
+		app::AbstractBenchmark::SetUp(state);
+		for (int i = 0; i < Amount; ++i) {
+			_positions[i] = glm::vec3(13.0f, (float)i, 42.0f) * 0.01f;
+		}
+	}
+
+	void batch(benchmark::State& state, noise::SimdLevel level) {
+		if (level > noise::bestSimdLevel()) {
+			state.SkipWithError("Instruction set is not supported");
+			return;
+		}
+		for (auto _ : state) {
+			noise::fBm(_positions, _results, Amount, 4, 2.0f, 0.5f, level);
+			benchmark::DoNotOptimize(_results);
+		}
+		state.SetItemsProcessed(state.iterations() * Amount);
+	}
+};
+
+BENCHMARK_DEFINE_F(NoiseBenchmark, fBm3D) (benchmark::State& state) {
+	for (auto _ : state) {
+		for (int i = 0; i < Amount; ++i) {
+			_results[i] = noise::fBm(_positions[i]);
+		}
+		benchmark::DoNotOptimize(_results);
+	}
+	state.SetItemsProcessed(state.iterations() * Amount);
+}
+
+BENCHMARK_DEFINE_F(NoiseBenchmark, fBm3DBatchScalar) (benchmark::State& state) {
+	batch(state, noise::SimdLevel::Scalar);
+}
+
+BENCHMARK_DEFINE_F(NoiseBenchmark, fBm3DBatchSSE2) (benchmark::State& state) {
+	batch(state, noise::SimdLevel::SSE2);
+}
+
+BENCHMARK_DEFINE_F(NoiseBenchmark, fBm3DBatchAVX2) (benchmark::State& state) {
+	batch(state, noise::SimdLevel::AVX2);
+}
+
+BENCHMARK_REGISTER_F(NoiseBenchmark, fBm3D);
+BENCHMARK_REGISTER_F(NoiseBenchmark, fBm3DBatchScalar);
+BENCHMARK_REGISTER_F(NoiseBenchmark, fBm3DBatchSSE2);
+BENCHMARK_REGISTER_F(NoiseBenchmark, fBm3DBatchAVX2);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,59 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "noise/Simplex.h"
+#include "noise/SimplexBatch.h"
+#include <random>
+
+namespace noise {
+
+class SimplexBatchTest: public app::AbstractTest {
+protected:
+	// not a multiple of the simd width to also cover the scalar tail
+	static constexpr int Amount = 1003;
+	glm::vec3 _positions[Amount];
+
+	void compare(SimdLevel level, uint8_t octaves, float lacunarity, float gain) {
+		float results[Amount];
+		fBm(_positions, results, Amount, octaves, lacunarity, gain, level);
+		for (int i = 0; i < Amount; ++i) {
+			const float expected = fBm(_positions[i], octaves, lacunarity, gain);
+			// the batched noise must produce the very same terrain - not just something close to it
+			ASSERT_EQ(expected, results[i]) << "Position " << i << " (" << _positions[i].x << ", " << _positions[i].y << ", "
+					<< _positions[i].z << ") differs for level " << (int)level << " and " << (int)octaves << " octaves";
+		}
+	}
+public:
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		std::default_random_engine engine;
+		std::uniform_real_distribution<float> distribution(-500.0f, 500.0f);
+		for (int i = 0; i < Amount; ++i) {
+			_positions[i] = glm::vec3(distribution(engine), distribution(engine), distribution(engine));
+		}
+		// lattice points and zero are hitting the edge cases of the floor
+		for (int i = 0; i < 64; ++i) {
+			_positions[i] = glm::vec3((float)(i % 4 - 2), (float)(i / 4 % 4 - 2), (float)(i / 16 - 2));
+		}
+	}
+};
+
+TEST_F(SimplexBatchTest, testScalar) {
+	compare(SimdLevel::Scalar, 4, 2.0f, 0.5f);
+}
+
+TEST_F(SimplexBatchTest, testSSE2) {
+	compare(SimdLevel::SSE2, 1, 2.0f, 0.5f);
+	compare(SimdLevel::SSE2, 4, 2.0f, 0.5f);
+	compare(SimdLevel::SSE2, 6, 2.3f, 0.4f);
+}
+
+TEST_F(SimplexBatchTest, testAVX2) {
+	compare(SimdLevel::AVX2, 1, 2.0f, 0.5f);
+	compare(SimdLevel::AVX2, 4, 2.0f, 0.5f);
+	compare(SimdLevel::AVX2, 6, 2.3f, 0.4f);
+}
+
+}
@@ -10,6 +10,7 @@
 #include "core/Singleton.h"
 #include "core/Log.h"
 #include "core/StringUtil.h"
+#include <SDL_stdinc.h>
 
 namespace persistence {
 
@@ -114,4 +115,18 @@ void BindParam::push(const Model& model, const Field& field) {
 	}
 }
 
+void BindParam::copyValues() {
+	std::vector<core::String> buffers;
+	buffers.reserve(position);
+	for (int i = 0; i < position; ++i) {
+		if (values[i] == nullptr) {
+			continue;
+		}
+		const size_t length = formats[i] == 1 ? (size_t)lengths[i] : SDL_strlen(values[i]);
+		buffers.emplace_back(values[i], length);
+		values[i] = buffers.back().c_str();
+	}
+	valueBuffers = core::move(buffers);
+}
+
 }
@@ -38,6 +38,12 @@ struct BindParam {
 	 * @brief Pushes a new value for the given field of the given model to the parameter
 	 */
 	void push(const Model& model, const Field& field);
+	/**
+	 * @brief Copies the values that are referenced by the parameters - e.g. blobs - into the value buffers
+	 * to be able to use the parameters after the model was modified.
+	 * @note The instance may only be moved afterwards - a copy would still point to the buffers of the source.
+	 */
+	void copyValues();
 };
 
 }
@@ -199,6 +199,29 @@ bool DBHandler::exec(const core::String& query) const {
 	return execInternal(query).result;
 }
 
+bool DBHandler::execPrepared(const core::String& name, const core::String& query, const BindParam& params) const {
+	ScopedConnection scoped(_connectionPool, connection());
+	if (!scoped) {
+		Log::error(logid, "Could not execute query '%s' - could not acquire connection", query.c_str());
+		return false;
+	}
+	Connection* c = scoped.connection();
+	if (!c->hasPreparedStatement(name)) {
+		State s(c);
+		if (!s.prepare(name.c_str(), query.c_str(), params.position)) {
+			Log::error(logid, "Failed to prepare query '%s'", query.c_str());
+			return false;
+		}
+		Log::debug(logid, "Prepared query '%s' as %s", query.c_str(), name.c_str());
+	}
+	State s(c);
+	Log::debug(logid, "Execute prepared query %s with %i parameters", name.c_str(), params.position);
+	if (!s.execPrepared(name.c_str(), params.position, &params.values[0], &params.lengths[0], &params.formats[0])) {
+		Log::warn(logid, "Failed to execute prepared query: '%s'", query.c_str());
+	}
+	return s.result;
+}
+
 State DBHandler::execInternal(const core::String& query) const {
 	ScopedConnection scoped(_connectionPool, connection());
 	if (!scoped) {
@@ -281,6 +281,15 @@ public:
 	 */
 	virtual bool exec(const core::String& query) const;
 
+	/**
+	 * @brief Executes the query as prepared statement - the statement is prepared once per connection
+	 * @param[in] name The name of the prepared statement. The same name must always be used for the same query.
+	 * @param[in] query The query to prepare if the connection doesn't know the statement yet
+	 * @param[in] params The values for the placeholders of the query
+	 * @return @c true if the statement was executed successfully, @c false otherwise.
+	 */
+	bool execPrepared(const core::String& name, const core::String& query, const BindParam& params) const;
+
 	// transactions
 	bool begin();
 	bool commit();
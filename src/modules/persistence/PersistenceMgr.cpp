@@ -4,9 +4,16 @@
 
 #include "PersistenceMgr.h"
 #include "DBHandler.h"
-#include "MassQuery.h"
+#include "Model.h"
+#include "SQLGenerator.h"
+#include "core/Assert.h"
 #include "core/Common.h"
+#include "core/StringUtil.h"
+#include "core/TimeProvider.h"
 #include "core/Trace.h"
+#include "core/concurrent/Thread.h"
+#include <algorithm>
+#include <string.h>
 
 namespace persistence {
 
@@ -14,6 +21,10 @@ PersistenceMgr::PersistenceMgr(const DBHandlerPtr& dbHandler) :
 		_lock("persistencemgr"), _dbHandler(dbHandler) {
 }
 
+PersistenceMgr::~PersistenceMgr() {
+	core_assert_msg(_writerThread == nullptr, "PersistenceMgr::shutdown() wasn't called");
+}
+
 bool PersistenceMgr::registerSavable(uint32_t fourcc, ISavable *savable) {
 	Log::trace(logid, "Register savable (fourcc: %u, savable: %p)", fourcc, savable);
 	core::ScopedWriteLock lock(_lock);
@@ -33,10 +44,14 @@ bool PersistenceMgr::unregisterSavable(uint32_t fourcc, ISavable *savable) {
 	auto s = i->second.find(savable);
 	if (s != i->second.end()) {
 		i->second.erase(s);
-		// make sure to persist the dirty state
-		MassQuery stmt = _dbHandler->massQuery();
-		stmt.add(savable);
-		stmt.commit();
+		// make sure to persist the dirty state - the savable is gone after this call, so this must not be skipped
+		Rows rows;
+		collect(savable, rows);
+		if (!rows.empty()) {
+			Snapshot snapshot;
+			createStatements(rows, snapshot);
+			_queue.push(core::move(snapshot));
+		}
 		Log::trace(logid, "Removed savable (fourcc: %u, savable: %p)", fourcc, savable);
 		return true;
 	}
@@ -44,31 +59,191 @@ bool PersistenceMgr::unregisterSavable(uint32_t fourcc, ISavable *savable) {
 	return false;
 }
 
+int PersistenceMgr::writerThread(void *data) {
+	PersistenceMgr* mgr = (PersistenceMgr*)data;
+	Snapshot snapshot;
+	while (mgr->_queue.waitAndPop(snapshot)) {
+		mgr->write(snapshot);
+	}
+	return 0;
+}
+
 bool PersistenceMgr::init() {
+	if (_writerThread != nullptr) {
+		return true;
+	}
+	_queue.reset();
+	_writerThread = new core::Thread("PersistenceMgr", writerThread, this);
 	return true;
 }
 
 void PersistenceMgr::shutdown() {
 	core_trace_scoped(PersistenceMgrShutdown);
-	update(0l);
+	createSnapshot(true);
+	if (_writerThread != nullptr) {
+		_queue.abortWait();
+		// the notification of the abort gets lost if the writer thread is not yet waiting
+		_queue.push(Snapshot());
+		_writerThread->join();
+		delete _writerThread;
+		_writerThread = nullptr;
+	}
+	// the writer thread doesn't write the snapshots that are still queued after the abort
+	Snapshot queued;
+	while (_queue.pop(queued)) {
+		write(queued);
+	}
 	core::ScopedWriteLock lock(_lock);
 	_savables.clear();
 }
 
-void PersistenceMgr::update(long dt) {
-	core_trace_scoped(PersistenceMgrUpdate);
-	core::ScopedReadLock lock(_lock);
-	for (auto& collection : _savables) {
-		if (collection.second.empty()) {
+void PersistenceMgr::collect(ISavable* savable, Rows& rows) const {
+	core_assert(savable != nullptr);
+	std::vector<const Model*> models;
+	if (!savable->getDirtyModels(models)) {
+		return;
+	}
+	rows.reserve(rows.size() + models.size());
+	for (const Model* m : models) {
+		const Fields& fields = m->fields();
+		core_assert_msg(fields.size() <= 64u, "Too many fields in table %s", m->tableName());
+		uint64_t mask = 0u;
+		for (size_t i = 0; i < fields.size(); ++i) {
+			if (m->isValid(fields[i])) {
+				mask |= (uint64_t)1u << (uint64_t)i;
+			}
+		}
+		rows.push_back(Row{m, mask});
+	}
+}
+
+void PersistenceMgr::createStatements(Rows& rows, Snapshot& snapshot) const {
+	core_trace_scoped(PersistenceMgrCreateStatements);
+	auto less = [] (const Row& a, const Row& b) {
+		const int schema = strcmp(a.model->schema(), b.model->schema());
+		if (schema != 0) {
+			return schema < 0;
+		}
+		const int table = strcmp(a.model->tableName(), b.model->tableName());
+		if (table != 0) {
+			return table < 0;
+		}
+		if (a.model->shouldBeDeleted() != b.model->shouldBeDeleted()) {
+			return b.model->shouldBeDeleted();
+		}
+		return a.fields < b.fields;
+	};
+	// keep the order in which the savables returned the models of a group
+	std::stable_sort(rows.begin(), rows.end(), less);
+
+	std::vector<const Model*> models;
+	models.reserve(core_min(rows.size(), MaxRows));
+	size_t i = 0;
+	while (i < rows.size()) {
+		size_t end = i + 1;
+		while (end < rows.size() && !less(rows[i], rows[end])) {
+			++end;
+		}
+		const Model& first = *rows[i].model;
+		if (first.shouldBeDeleted()) {
+			for (; i < end; ++i) {
+				Statement statement((int)first.primaryKeys().size());
+				statement.query = createDeleteStatement(*rows[i].model, &statement.params);
+				statement.rows = 1;
+				addStatement(first, core::move(statement), snapshot);
+			}
 			continue;
 		}
-		MassQuery stmt = _dbHandler->massQuery();
-		for (ISavable *savable : collection.second) {
-			stmt.add(savable);
+		int fieldsPerRow = 0;
+		for (uint64_t mask = rows[i].fields; mask != 0u; mask &= mask - 1u) {
+			++fieldsPerRow;
 		}
-		stmt.commit();
+		while (i < end) {
+			size_t amount = MaxRows;
+			while (amount > end - i) {
+				amount /= 2u;
+			}
+			models.clear();
+			for (size_t r = i; r < i + amount; ++r) {
+				models.push_back(rows[r].model);
+			}
+			Statement statement(core_max(1, (int)amount * fieldsPerRow));
+			statement.query = createInsertStatement(models, &statement.params);
+			statement.rows = (int)amount;
+			addStatement(first, core::move(statement), snapshot);
+			i += amount;
+		}
+	}
+}
+
+void PersistenceMgr::addStatement(const Model& model, Statement&& statement, Snapshot& snapshot) const {
+	// the models are modified after the snapshot was taken
+	statement.params.copyValues();
+	{
+		core::ScopedLock<core::Lock> lock(_statementNamesLock);
+		if (!_statementNames.get(statement.query, statement.name)) {
+			// the running index keeps the names unique - the table and the rows are only for debugging
+			statement.name = core::string::format("persistence_%s_%s_%i_%i", model.schema(), model.tableName(),
+					statement.rows, (int)_statementNames.size());
+			_statementNames.put(statement.query, statement.name);
+		}
+	}
+	snapshot.push_back(core::move(statement));
+}
+
+void PersistenceMgr::createSnapshot(bool force) {
+	core_trace_scoped(PersistenceMgrSnapshot);
+	if (!force && _queue.size() >= MaxQueueDepth) {
+		_skippedUpdates.increment();
+		Log::warn(logid, "Skip the update - the writer thread is still busy with %u snapshots", _queue.size());
+		return;
+	}
+	Rows rows;
+	{
+		core::ScopedReadLock lock(_lock);
+		for (auto& collection : _savables) {
+			for (ISavable *savable : collection.second) {
+				collect(savable, rows);
+			}
+		}
+	}
+	_dirtyModels = (int)rows.size();
+	if (rows.empty()) {
+		return;
 	}
-	Log::debug(logid, "Persisted dirty states of %i savables", (int)_savables.size());
+	Snapshot snapshot;
+	createStatements(rows, snapshot);
+	_queue.push(core::move(snapshot));
+	Log::debug(logid, "Queued %i dirty models", (int)rows.size());
+}
+
+void PersistenceMgr::write(const Snapshot& snapshot) {
+	if (snapshot.empty()) {
+		return;
+	}
+	core_trace_scoped(PersistenceMgrWrite);
+	const uint64_t start = core::TimeProvider::systemMillis();
+	for (const Statement& statement : snapshot) {
+		if (!_dbHandler->execPrepared(statement.name, statement.query, statement.params)) {
+			Log::warn(logid, "Failed to persist %i rows", statement.rows);
+		}
+	}
+	_flushMillis = (int)(core::TimeProvider::systemMillis() - start);
+	Log::debug(logid, "Persisted %i statements in %ims", (int)snapshot.size(), (int)_flushMillis);
+}
+
+void PersistenceMgr::update(long dt) {
+	core_trace_scoped(PersistenceMgrUpdate);
+	createSnapshot(false);
+}
+
+PersistenceStats PersistenceMgr::stats() const {
+	PersistenceStats stats;
+	stats.dirtyModels = (uint32_t)(int)_dirtyModels;
+	stats.flushMillis = (uint32_t)(int)_flushMillis;
+	stats.queueDepth = _queue.size();
+	stats.skippedUpdates = (uint32_t)(int)_skippedUpdates;
+	return stats;
 }
 
 }
@@ -7,43 +7,147 @@
 #include <memory>
 #include <map>
 #include <unordered_set>
+#include <vector>
 #include "ISavable.h"
 #include "DBHandler.h"
+#include "BindParam.h"
 #include "core/IComponent.h"
+#include "core/collection/ConcurrentQueue.h"
+#include "core/collection/StringMap.h"
+#include "core/concurrent/Atomic.h"
+#include "core/concurrent/Lock.h"
 #include "core/concurrent/ReadWriteLock.h"
 
+namespace core {
+class Thread;
+}
+
 /**
  * Persistence layer
  */
 namespace persistence {
 
+/**
+ * @brief Metrics of the @c PersistenceMgr
+ */
+struct PersistenceStats {
+	/**
+	 * @brief The amount of dirty models in the last snapshot
+	 */
+	uint32_t dirtyModels = 0u;
+	/**
+	 * @brief The duration in millis the writer thread needed for the last snapshot
+	 */
+	uint32_t flushMillis = 0u;
+	/**
+	 * @brief The amount of snapshots that are waiting for the writer thread
+	 */
+	uint32_t queueDepth = 0u;
+	/**
+	 * @brief The amount of updates that were skipped because the queue was full
+	 */
+	uint32_t skippedUpdates = 0u;
+};
+
 /**
  * @brief This class is responsible for calling the update mechanisms for the single components of each player.
  * It will collect all database actions in prepared statements to write delta values into the database.
+ *
+ * The caller of @c update() and @c unregisterSavable() only copies the values of the dirty models into a
+ * snapshot. The models of the same table with the same set of valid fields are written with one multi-row
+ * upsert. The snapshots are handed over to a writer thread via a bounded queue - if the queue is full, the
+ * update is skipped and the models stay dirty in the @c ISavable instances until the next update.
+ *
  * @note Your @c ISavable instances must be registered and unregistered.
  */
 class PersistenceMgr : public core::IComponent {
 private:
 	static constexpr uint32_t logid = Log::logid("PersistenceMgr");
+	/**
+	 * @brief The max amount of rows in one upsert statement. The rows are split into batches with a power of two
+	 * size - this limits the amount of statements that are prepared per connection.
+	 */
+	static constexpr size_t MaxRows = 256u;
+	/**
+	 * @brief The max amount of snapshots that are waiting for the writer thread
+	 */
+	static constexpr uint32_t MaxQueueDepth = 4u;
+
 	using Savables = std::unordered_set<ISavable*>;
 	using Map = std::map<uint32_t, Savables>;
 	Map _savables core_thread_guarded_by(_lock);
 	core::ReadWriteLock _lock;
 	const DBHandlerPtr _dbHandler;
+
+	/**
+	 * @brief A prepared statement with the copied values of the dirty models
+	 */
+	struct Statement {
+		core::String name;
+		core::String query;
+		BindParam params;
+		int rows;
+
+		Statement(int parameters) : params(parameters), rows(0) {
+		}
+	};
+	using Snapshot = std::vector<Statement>;
+
+	struct Row {
+		const Model* model;
+		// the bit mask of the valid fields - rows with the same mask share the statement
+		uint64_t fields;
+	};
+	using Rows = std::vector<Row>;
+
+	/**
+	 * @brief The prepared statement names by query - a name is never shared by two different queries
+	 */
+	mutable core::StringMap<core::String, 64> _statementNames core_thread_guarded_by(_statementNamesLock);
+	mutable core_trace_mutex(core::Lock, _statementNamesLock, "PersistenceMgrStatementNames");
+
+	core::ConcurrentQueue<Snapshot> _queue;
+	core::Thread* _writerThread = nullptr;
+	core::AtomicInt _dirtyModels;
+	core::AtomicInt _flushMillis;
+	core::AtomicInt _skippedUpdates;
+
+	static int writerThread(void *data);
+	void collect(ISavable* savable, Rows& rows) const;
+	void createStatements(Rows& rows, Snapshot& snapshot) const;
+	void addStatement(const Model& model, Statement&& statement, Snapshot& snapshot) const;
+	/**
+	 * @brief Creates a snapshot of the dirty models of all registered savables
+	 * @param[in] force If @c false, the snapshot is skipped if the queue is full
+	 */
+	void createSnapshot(bool force);
+	void write(const Snapshot& snapshot);
 public:
 	PersistenceMgr(const DBHandlerPtr& dbHandler);
-	virtual ~PersistenceMgr() {}
+	virtual ~PersistenceMgr();
 
 	virtual bool registerSavable(uint32_t fourcc, ISavable *savable);
+	/**
+	 * @note The dirty models of the savable are copied - but written asynchronously.
+	 */
 	virtual bool unregisterSavable(uint32_t fourcc, ISavable *savable);
 
+	/**
+	 * @brief Starts the writer thread
+	 */
 	bool init() override;
 	/**
+	 * @brief Writes the remaining dirty models and the queued snapshots before the writer thread is stopped
 	 * @note You have to make sure, that the update is not called anymore and also not called currently.
 	 */
 	void shutdown() override;
 
+	/**
+	 * @brief Hands the dirty models of all registered savables over to the writer thread
+	 */
 	void update(long dt);
+
+	PersistenceStats stats() const;
 };
 
 typedef std::shared_ptr<PersistenceMgr> PersistenceMgrPtr;
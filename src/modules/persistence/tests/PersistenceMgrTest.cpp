@@ -114,6 +114,30 @@ TEST_F(PersistenceMgrTest, testSavableUpdate) {
 	update(mgr, create());
 }
 
+TEST_F(PersistenceMgrTest, testSavableSnapshot) {
+	if (!_supported) {
+		return;
+	}
+	PersistenceMgr mgr(_dbHandler);
+	EXPECT_TRUE(mgr.init());
+	EXPECT_TRUE(mgr.registerSavable(FourCC('F','O','O','O'), this));
+	db::TestModel mdl = create(1, "snapshot");
+	_dirtyModels.push_back(&mdl);
+	mgr.update(0l);
+	EXPECT_EQ(1u, mgr.stats().dirtyModels);
+	// the values are copied in the update - modifying the model afterwards doesn't change the written values
+	mdl.setName("modified");
+	EXPECT_TRUE(mgr.unregisterSavable(FourCC('F','O','O','O'), this));
+	mgr.shutdown();
+	EXPECT_EQ(0u, mgr.stats().queueDepth);
+	int found = 0;
+	EXPECT_TRUE(_dbHandler->select(db::TestModel(), DBConditionOne(), [&] (db::TestModel&& selected) {
+		++found;
+		EXPECT_EQ("snapshotfoobar", selected.name());
+	}));
+	EXPECT_EQ(1, found);
+}
+
 TEST_F(PersistenceMgrTest, testSavableDelete) {
 	if (!_supported) {
 		return;
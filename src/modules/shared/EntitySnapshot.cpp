@@ -0,0 +1,213 @@
+/**
+ * @file
+ */
+
+#include "EntitySnapshot.h"
+#include "core/Assert.h"
+#include <glm/common.hpp>
+#include <glm/gtc/constants.hpp>
+
+namespace shared {
+
+EntityState EntityState::quantize(int64_t id, const glm::vec3& pos, float orientation, uint8_t animation) {
+	EntityState state;
+	state.id = id;
+	state.pos = glm::ivec3(glm::round(pos * PositionScale));
+	state.rotation = (uint16_t)(int32_t)glm::round(orientation / glm::two_pi<float>() * 65536.0f);
+	state.animation = animation;
+	return state;
+}
+
+glm::vec3 EntityState::position() const {
+	return glm::vec3(pos) / PositionScale;
+}
+
+float EntityState::orientation() const {
+	return (float)rotation / 65536.0f * glm::two_pi<float>();
+}
+
+static inline void writeVarUInt(core::DynamicArray<uint8_t>& out, uint64_t value) {
+	while (value >= 0x80u) {
+		out.push_back((uint8_t)(value | 0x80u));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+static inline void writeVarInt(core::DynamicArray<uint8_t>& out, int32_t value) {
+	writeVarUInt(out, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+static inline bool readVarUInt(const uint8_t*& data, const uint8_t* end, uint64_t& value) {
+	value = 0u;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (data >= end) {
+			return false;
+		}
+		const uint8_t byte = *data++;
+		value |= (uint64_t)(byte & 0x7Fu) << shift;
+		if ((byte & 0x80u) == 0u) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline bool readVarInt(const uint8_t*& data, const uint8_t* end, int32_t& value) {
+	uint64_t raw;
+	if (!readVarUInt(data, end, raw)) {
+		return false;
+	}
+	const uint32_t v = (uint32_t)raw;
+	value = (int32_t)(v >> 1) ^ -(int32_t)(v & 1u);
+	return true;
+}
+
+static void writeEntry(core::DynamicArray<uint8_t>& out, int64_t& lastId, const EntityState* base, const EntityState* current) {
+	const int64_t id = current != nullptr ? current->id : base->id;
+	uint8_t flags = 0u;
+	if (current == nullptr) {
+		flags = EntityStateChange::Removed;
+	} else if (base == nullptr) {
+		flags = EntityStateChange::Position | EntityStateChange::Rotation | EntityStateChange::Animation;
+	} else {
+		if (current->pos != base->pos) {
+			flags |= EntityStateChange::Position;
+		}
+		if (current->rotation != base->rotation) {
+			flags |= EntityStateChange::Rotation;
+		}
+		if (current->animation != base->animation) {
+			flags |= EntityStateChange::Animation;
+		}
+		if (flags == 0u) {
+			return;
+		}
+	}
+	writeVarUInt(out, (uint64_t)(id - lastId));
+	lastId = id;
+	out.push_back(flags);
+	if (flags & EntityStateChange::Position) {
+		const glm::ivec3 from = base != nullptr ? base->pos : glm::ivec3(0);
+		writeVarInt(out, current->pos.x - from.x);
+		writeVarInt(out, current->pos.y - from.y);
+		writeVarInt(out, current->pos.z - from.z);
+	}
+	if (flags & EntityStateChange::Rotation) {
+		const uint16_t from = base != nullptr ? base->rotation : 0u;
+		writeVarInt(out, (int16_t)(uint16_t)(current->rotation - from));
+	}
+	if (flags & EntityStateChange::Animation) {
+		out.push_back(current->animation);
+	}
+}
+
+int encodeSnapshot(const EntityStates& base, const EntityStates& current, core::DynamicArray<uint8_t>& out) {
+	const size_t startSize = out.size();
+	int64_t lastId = 0;
+	int entities = 0;
+	size_t b = 0u;
+	size_t c = 0u;
+	while (b < base.size() || c < current.size()) {
+		const size_t size = out.size();
+		if (c >= current.size() || (b < base.size() && base[b].id < current[c].id)) {
+			writeEntry(out, lastId, &base[b], nullptr);
+			++b;
+		} else if (b >= base.size() || current[c].id < base[b].id) {
+			writeEntry(out, lastId, nullptr, &current[c]);
+			++c;
+		} else {
+			writeEntry(out, lastId, &base[b], &current[c]);
+			++b;
+			++c;
+		}
+		if (out.size() != size) {
+			++entities;
+		}
+	}
+	core_assert(entities > 0 || out.size() == startSize);
+	return entities;
+}
+
+bool decodeSnapshot(const EntityStates& base, const uint8_t* data, size_t size, EntityStates& out, core::DynamicArray<EntityChange>* changes) {
+	out.clear();
+	out.reserve(base.size());
+	const uint8_t* end = data + size;
+	int64_t id = 0;
+	size_t b = 0u;
+	while (data < end) {
+		uint64_t idDelta;
+		if (!readVarUInt(data, end, idDelta)) {
+			return false;
+		}
+		id += (int64_t)idDelta;
+		if (data >= end) {
+			return false;
+		}
+		const uint8_t flags = *data++;
+		// the unchanged entities in front of this one
+		while (b < base.size() && base[b].id < id) {
+			out.push_back(base[b]);
+			++b;
+		}
+		EntityState state;
+		state.id = id;
+		if (b < base.size() && base[b].id == id) {
+			state = base[b];
+			++b;
+		} else if (flags & EntityStateChange::Removed) {
+			return false;
+		}
+		if (flags & EntityStateChange::Position) {
+			glm::ivec3 delta;
+			if (!readVarInt(data, end, delta.x) || !readVarInt(data, end, delta.y) || !readVarInt(data, end, delta.z)) {
+				return false;
+			}
+			state.pos += delta;
+		}
+		if (flags & EntityStateChange::Rotation) {
+			int32_t delta;
+			if (!readVarInt(data, end, delta)) {
+				return false;
+			}
+			state.rotation = (uint16_t)(state.rotation + delta);
+		}
+		if (flags & EntityStateChange::Animation) {
+			if (data >= end) {
+				return false;
+			}
+			state.animation = *data++;
+		}
+		if (changes != nullptr) {
+			changes->push_back(EntityChange{state, flags});
+		}
+		if (!(flags & EntityStateChange::Removed)) {
+			out.push_back(state);
+		}
+	}
+	while (b < base.size()) {
+		out.push_back(base[b]);
+		++b;
+	}
+	return true;
+}
+
+const EntityStates& SnapshotHistory::put(uint32_t sequence, const EntityStates& states) {
+	core_assert(sequence != 0u);
+	const uint32_t index = sequence % Size;
+	_sequences[index] = sequence;
+	EntityStates& slot = _states[index];
+	// keep the memory of the slot
+	slot.clear();
+	slot.append(states.data(), states.size());
+	return slot;
+}
+
+void SnapshotHistory::clear() {
+	for (uint32_t i = 0u; i < Size; ++i) {
+		_sequences[i] = 0u;
+		_states[i].clear();
+	}
+}
+
+}
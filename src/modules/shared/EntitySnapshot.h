@@ -0,0 +1,121 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/collection/DynamicArray.h"
+#include <glm/vec3.hpp>
+#include <stdint.h>
+
+/**
+ * Shared between client and server
+ */
+namespace shared {
+
+/**
+ * @brief The ENet channel the unreliable entity snapshots are sent on - the reliable messages are sent on channel 0
+ */
+static constexpr int SnapshotChannel = 1;
+/**
+ * @brief The amount of channels the client and the server are using
+ */
+static constexpr int Channels = 2;
+
+/**
+ * @brief The quantized state of an entity in a snapshot
+ */
+struct EntityState {
+	int64_t id = 0;
+	// 1/PositionScale units
+	glm::ivec3 pos { 0 };
+	// the full circle is mapped to 65536
+	uint16_t rotation = 0u;
+	uint8_t animation = 0u;
+
+	static constexpr float PositionScale = 16.0f;
+
+	static EntityState quantize(int64_t id, const glm::vec3& pos, float orientation, uint8_t animation);
+	glm::vec3 position() const;
+	float orientation() const;
+
+	bool operator==(const EntityState& rhs) const;
+};
+
+/**
+ * @brief The entities in a snapshot - sorted by their id
+ */
+using EntityStates = core::DynamicArray<EntityState>;
+
+enum EntityStateChange : uint8_t {
+	Position = 1,
+	Rotation = 2,
+	Animation = 4,
+	// the entity is no longer part of the snapshot
+	Removed = 8
+};
+
+struct EntityChange {
+	EntityState state;
+	// a combination of @c EntityStateChange
+	uint8_t flags;
+};
+
+/**
+ * @brief Encodes the entities that changed relative to the base snapshot.
+ *
+ * The ids are written as delta to the previous entry and the changed fields as zigzag varints relative to the state
+ * in the base snapshot. Entities that didn't change are not written at all.
+ *
+ * @param[in] base The snapshot the receiver already has - empty for a full snapshot
+ * @param[in] current The snapshot to encode
+ * @param[out] out The encoded data is appended
+ * @return The amount of entities that were written
+ */
+int encodeSnapshot(const EntityStates& base, const EntityStates& current, core::DynamicArray<uint8_t>& out);
+
+/**
+ * @brief Restores the snapshot that was encoded with @c encodeSnapshot() against the given base
+ * @param[out] changes If not @c null, the entities that were written by the sender are added here
+ * @return @c false if the data is malformed
+ */
+bool decodeSnapshot(const EntityStates& base, const uint8_t* data, size_t size, EntityStates& out, core::DynamicArray<EntityChange>* changes = nullptr);
+
+/**
+ * @brief Ring buffer of the last snapshots by their sequence number
+ */
+class SnapshotHistory {
+public:
+	static constexpr uint32_t Size = 32u;
+private:
+	EntityStates _states[Size];
+	// 0 is an invalid sequence number
+	uint32_t _sequences[Size] {};
+public:
+	/**
+	 * @return @c nullptr if the snapshot with the given sequence is not or no longer known
+	 */
+	const EntityStates* get(uint32_t sequence) const;
+	/**
+	 * @brief Stores a copy of the given snapshot with the given sequence - overwrites the oldest one
+	 */
+	const EntityStates& put(uint32_t sequence, const EntityStates& states);
+	void clear();
+};
+
+inline bool EntityState::operator==(const EntityState& rhs) const {
+	return id == rhs.id && pos == rhs.pos && rotation == rhs.rotation && animation == rhs.animation;
+}
+
+inline const EntityStates* SnapshotHistory::get(uint32_t sequence) const {
+	if (sequence == 0u) {
+		return nullptr;
+	}
+	const uint32_t index = sequence % Size;
+	if (_sequences[index] != sequence) {
+		return nullptr;
+	}
+	return &_states[index];
+}
+
+}
@@ -0,0 +1,114 @@
+/**
+ * @file
+ */
+
+#include <gtest/gtest.h>
+#include "shared/EntitySnapshot.h"
+#include <glm/gtc/constants.hpp>
+
+namespace shared {
+
+class EntitySnapshotTest: public testing::Test {
+protected:
+	EntityStates crowd(int amount, float offset) const {
+		EntityStates states;
+		for (int i = 0; i < amount; ++i) {
+			states.push_back(EntityState::quantize(i * 3 + 1, glm::vec3(i * 2.0f + offset, 10.0f, -i * 1.5f), 0.5f, 1u));
+		}
+		return states;
+	}
+
+	void roundTrip(const EntityStates& base, const EntityStates& current) {
+		core::DynamicArray<uint8_t> data;
+		encodeSnapshot(base, current, data);
+		EntityStates decoded;
+		ASSERT_TRUE(decodeSnapshot(base, data.data(), data.size(), decoded));
+		ASSERT_EQ(current.size(), decoded.size());
+		for (size_t i = 0; i < current.size(); ++i) {
+			EXPECT_EQ(current[i], decoded[i]) << "entity " << i;
+		}
+	}
+};
+
+TEST_F(EntitySnapshotTest, testQuantize) {
+	const EntityState state = EntityState::quantize(1, glm::vec3(1.5f, -2.25f, 100.0f), glm::pi<float>(), 3u);
+	EXPECT_FLOAT_EQ(1.5f, state.position().x);
+	EXPECT_FLOAT_EQ(-2.25f, state.position().y);
+	EXPECT_FLOAT_EQ(100.0f, state.position().z);
+	EXPECT_NEAR(glm::pi<float>(), state.orientation(), 0.001f);
+	const EntityState negative = EntityState::quantize(1, glm::vec3(0.0f), -glm::half_pi<float>(), 3u);
+	EXPECT_NEAR(glm::three_over_two_pi<float>(), negative.orientation(), 0.001f);
+}
+
+TEST_F(EntitySnapshotTest, testFullSnapshot) {
+	roundTrip(EntityStates(), crowd(100, 0.0f));
+}
+
+TEST_F(EntitySnapshotTest, testDelta) {
+	const EntityStates& base = crowd(100, 0.0f);
+	EntityStates current = crowd(100, 0.0f);
+	current[10].pos.x += 3;
+	current[20].rotation = 65535u;
+	current[30].animation = 4u;
+	core::DynamicArray<uint8_t> data;
+	EXPECT_EQ(3, encodeSnapshot(base, current, data));
+	EXPECT_LT(data.size(), 20u);
+	roundTrip(base, current);
+}
+
+TEST_F(EntitySnapshotTest, testUnchanged) {
+	const EntityStates& base = crowd(100, 0.0f);
+	core::DynamicArray<uint8_t> data;
+	EXPECT_EQ(0, encodeSnapshot(base, base, data));
+	EXPECT_TRUE(data.empty());
+	roundTrip(base, base);
+}
+
+TEST_F(EntitySnapshotTest, testAddAndRemove) {
+	const EntityStates& base = crowd(10, 0.0f);
+	EntityStates current;
+	// remove the first and the last, add new entities in between and at the end
+	for (size_t i = 1; i < base.size() - 1; ++i) {
+		current.push_back(base[i]);
+		if (i == 5) {
+			current.push_back(EntityState::quantize(base[i].id + 1, glm::vec3(-1000.0f), 1.0f, 2u));
+		}
+	}
+	current.push_back(EntityState::quantize(1000, glm::vec3(1000.0f), 1.0f, 2u));
+	core::DynamicArray<uint8_t> data;
+	core::DynamicArray<EntityChange> changes;
+	encodeSnapshot(base, current, data);
+	EntityStates decoded;
+	ASSERT_TRUE(decodeSnapshot(base, data.data(), data.size(), decoded, &changes));
+	ASSERT_EQ(4u, changes.size());
+	EXPECT_EQ(EntityStateChange::Removed, changes[0].flags);
+	EXPECT_EQ(base[0].id, changes[0].state.id);
+	roundTrip(base, current);
+}
+
+TEST_F(EntitySnapshotTest, testMalformed) {
+	const EntityStates& base = crowd(10, 0.0f);
+	const EntityStates& current = crowd(10, 1.0f);
+	core::DynamicArray<uint8_t> data;
+	encodeSnapshot(base, current, data);
+	EntityStates decoded;
+	EXPECT_FALSE(decodeSnapshot(base, data.data(), data.size() - 1, decoded));
+	// the removal of an entity that is not part of the base
+	const uint8_t removeUnknown[] = {42u, EntityStateChange::Removed};
+	EXPECT_FALSE(decodeSnapshot(base, removeUnknown, sizeof(removeUnknown), decoded));
+}
+
+TEST_F(EntitySnapshotTest, testHistory) {
+	SnapshotHistory history;
+	const EntityStates& states = crowd(2, 0.0f);
+	EXPECT_EQ(nullptr, history.get(0u));
+	EXPECT_EQ(nullptr, history.get(1u));
+	history.put(1u, states);
+	ASSERT_NE(nullptr, history.get(1u));
+	EXPECT_EQ(2u, history.get(1u)->size());
+	history.put(1u + SnapshotHistory::Size, EntityStates());
+	EXPECT_EQ(nullptr, history.get(1u)) << "The snapshot should have been overwritten";
+	EXPECT_NE(nullptr, history.get(1u + SnapshotHistory::Size));
+}
+
+}
@@ -0,0 +1,158 @@
+/**
+ * @file
+ */
+
+#include "CompressedChunkCache.h"
+#include "core/Zip.h"
+#include "core/Log.h"
+#include "core/Trace.h"
+#include "core/StandardLib.h"
+
+namespace voxel {
+
+CompressedChunkCache::CompressedChunkCache(uint32_t memoryLimitInBytes) :
+		_memoryLimit(memoryLimitInBytes) {
+}
+
+CompressedChunkCache::~CompressedChunkCache() {
+	clear();
+}
+
+uint8_t* CompressedChunkCache::compress(const Voxel* voxels, uint32_t sizeInBytes, uint32_t& compressedSize) {
+	core_trace_scoped(CompressChunk);
+	const uint32_t bufferSize = core::zip::compressBound(sizeInBytes);
+	uint8_t* buffer = (uint8_t*)core_malloc(bufferSize);
+	size_t finalBufferSize = 0u;
+	if (!core::zip::compress((const uint8_t*)voxels, sizeInBytes, buffer, bufferSize, &finalBufferSize)) {
+		core_free(buffer);
+		compressedSize = 0u;
+		return nullptr;
+	}
+	// don't waste the memory of the upper bound as long as the entry lives in the cache
+	compressedSize = (uint32_t)finalBufferSize;
+	return (uint8_t*)core_realloc(buffer, finalBufferSize);
+}
+
+void CompressedChunkCache::freeEntry(const Entry& entry) {
+	_memoryUsage -= entry.size;
+	core_free(entry.data);
+}
+
+void CompressedChunkCache::put(const glm::ivec3& pos, uint8_t* compressed, uint32_t compressedSize) {
+	if (compressed == nullptr) {
+		return;
+	}
+	if (compressedSize > _memoryLimit) {
+		core_free(compressed);
+		return;
+	}
+	core::ScopedLock lock(_lock);
+	Entry entry;
+	if (_entries.get(pos, entry)) {
+		freeEntry(entry);
+		++_staleOrders;
+	}
+	entry.data = compressed;
+	entry.size = compressedSize;
+	entry.sequence = ++_sequence;
+	_entries.put(pos, entry);
+	_order.push_back(Order{pos, entry.sequence});
+	_memoryUsage += compressedSize;
+	shrink();
+}
+
+void CompressedChunkCache::shrink() {
+	while (_memoryUsage > _memoryLimit && _orderStart < _order.size()) {
+		const Order& order = _order[_orderStart++];
+		Entry entry;
+		if (!_entries.get(order.pos, entry) || entry.sequence != order.sequence) {
+			--_staleOrders;
+			continue;
+		}
+		freeEntry(entry);
+		_entries.remove(order.pos);
+	}
+	compactOrder();
+}
+
+void CompressedChunkCache::compactOrder() {
+	const size_t dropped = _orderStart + _staleOrders;
+	if (dropped == 0u || dropped * 2u < _order.size()) {
+		return;
+	}
+	size_t n = 0u;
+	for (size_t i = _orderStart; i < _order.size(); ++i) {
+		const Order order = _order[i];
+		Entry entry;
+		if (_entries.get(order.pos, entry) && entry.sequence == order.sequence) {
+			_order[n++] = order;
+		}
+	}
+	_order.resize(n);
+	_orderStart = 0u;
+	_staleOrders = 0u;
+}
+
+bool CompressedChunkCache::take(const glm::ivec3& pos, Voxel* voxels, uint32_t sizeInBytes) {
+	Entry entry;
+	{
+		core::ScopedLock lock(_lock);
+		if (!_entries.get(pos, entry)) {
+			++_misses;
+			return false;
+		}
+		_entries.remove(pos);
+		_memoryUsage -= entry.size;
+		++_hits;
+		++_staleOrders;
+		compactOrder();
+	}
+	core_trace_scoped(InflateChunk);
+	size_t finalBufferSize = 0u;
+	const bool success = core::zip::uncompress(entry.data, entry.size, (uint8_t*)voxels, sizeInBytes, &finalBufferSize);
+	core_free(entry.data);
+	if (!success || finalBufferSize != sizeInBytes) {
+		Log::error("Failed to inflate the chunk at %i:%i:%i", pos.x, pos.y, pos.z);
+		// the caller falls back to the pager - which expects an empty chunk
+		core_memset(voxels, 0, sizeInBytes);
+		return false;
+	}
+	return true;
+}
+
+bool CompressedChunkCache::remove(const glm::ivec3& pos) {
+	core::ScopedLock lock(_lock);
+	Entry entry;
+	if (!_entries.get(pos, entry)) {
+		return false;
+	}
+	freeEntry(entry);
+	_entries.remove(pos);
+	++_staleOrders;
+	compactOrder();
+	return true;
+}
+
+void CompressedChunkCache::clear() {
+	core::ScopedLock lock(_lock);
+	for (auto iter = _entries.begin(); iter != _entries.end(); ++iter) {
+		freeEntry(iter->value);
+	}
+	_entries.clear();
+	_order.clear();
+	_orderStart = 0u;
+	_staleOrders = 0u;
+}
+
+CompressedChunkCache::Stats CompressedChunkCache::stats() const {
+	core::ScopedLock lock(_lock);
+	Stats stats;
+	stats.entries = (int)_entries.size();
+	stats.orderEntries = (int)(_order.size() - _orderStart);
+	stats.memoryUsage = _memoryUsage;
+	stats.hits = _hits;
+	stats.misses = _misses;
+	return stats;
+}
+
+}
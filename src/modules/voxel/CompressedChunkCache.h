@@ -0,0 +1,101 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "Voxel.h"
+#include "core/GLM.h"
+#include "core/NonCopyable.h"
+#include "core/Trace.h"
+#include "core/concurrent/Lock.h"
+#include "core/collection/DynamicMap.h"
+#include "core/collection/DynamicArray.h"
+
+namespace voxel {
+
+/**
+ * @brief Memory bounded cache of compressed chunk data.
+ *
+ * This is the tier between the uncompressed chunks of the @c PagedVolume and its @c Pager. Inflating the
+ * data of a chunk is a lot cheaper than generating it again or loading it from a database. If the memory
+ * limit is exceeded, the chunks that were put into the cache first are dropped.
+ *
+ * @note The cache only holds copies - it never calls the pager. The chunks must be paged out before they
+ * are put into the cache.
+ */
+class CompressedChunkCache : public core::NonCopyable {
+private:
+	struct Entry {
+		uint8_t* data;
+		uint32_t size;
+		uint32_t sequence;
+	};
+	typedef core::DynamicMap<glm::ivec3, Entry, 64, glm::hash<glm::ivec3>> Entries;
+	struct Order {
+		glm::ivec3 pos;
+		uint32_t sequence;
+	};
+
+	Entries _entries core_thread_guarded_by(_lock);
+	// the insertion order of the entries - entries that were taken or replaced in the meantime are skipped
+	core::DynamicArray<Order> _order core_thread_guarded_by(_lock);
+	size_t _orderStart core_thread_guarded_by(_lock) = 0u;
+	// the amount of order entries behind _orderStart whose entry was taken, removed or replaced
+	size_t _staleOrders core_thread_guarded_by(_lock) = 0u;
+	uint32_t _sequence core_thread_guarded_by(_lock) = 0u;
+	size_t _memoryUsage core_thread_guarded_by(_lock) = 0u;
+	int _hits core_thread_guarded_by(_lock) = 0;
+	int _misses core_thread_guarded_by(_lock) = 0;
+	const size_t _memoryLimit;
+	mutable core_trace_mutex(core::Lock, _lock, "CompressedChunkCache");
+
+	void freeEntry(const Entry& entry) core_thread_requires(_lock);
+	void shrink() core_thread_requires(_lock);
+	/**
+	 * @brief Drops the consumed and stale order entries once they make up half of the order list - independent
+	 * of the memory limit, otherwise a cache that never exceeds its limit would grow the order list forever
+	 */
+	void compactOrder() core_thread_requires(_lock);
+public:
+	CompressedChunkCache(uint32_t memoryLimitInBytes);
+	~CompressedChunkCache();
+
+	/**
+	 * @brief Compresses the given voxels. This can be done without blocking any other user of the cache.
+	 * @return The compressed data that must be handed over to @c put() or freed with @c core_free
+	 */
+	static uint8_t* compress(const Voxel* voxels, uint32_t sizeInBytes, uint32_t& compressedSize);
+
+	/**
+	 * @brief Stores the compressed data for the chunk at the given chunk position. An existing entry is replaced.
+	 * @note Takes the ownership of the given data
+	 */
+	void put(const glm::ivec3& pos, uint8_t* compressed, uint32_t compressedSize);
+
+	/**
+	 * @brief Removes the entry of the given chunk position from the cache and inflates it into the given buffer
+	 * @return @c false if there is no entry for the given position or if the entry could not be inflated. In the
+	 * latter case the entry is dropped and the given buffer is zeroed.
+	 */
+	bool take(const glm::ivec3& pos, Voxel* voxels, uint32_t sizeInBytes);
+
+	bool remove(const glm::ivec3& pos);
+	void clear();
+
+	struct Stats {
+		int entries = 0;
+		// the insertion order entries that are tracked - including the stale ones
+		int orderEntries = 0;
+		size_t memoryUsage = 0u;
+		int hits = 0;
+		int misses = 0;
+	};
+	Stats stats() const;
+
+	inline size_t memoryLimit() const {
+		return _memoryLimit;
+	}
+};
+
+}
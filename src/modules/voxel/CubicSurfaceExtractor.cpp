@@ -4,9 +4,62 @@
 
 #include "CubicSurfaceExtractor.h"
 #include "core/Common.h"
+#include <limits>
 
 namespace voxel {
 
+/**
+ * @brief Slabs thinner than this don't pay off the additional vertex planes and the stitching
+ */
+static constexpr int MinSlabSlices = 8;
+
+/**
+ * @brief Marks quads that were merged into another quad and vertices that weren't mapped to the result mesh yet
+ */
+static constexpr uint32_t InvalidIndex = (std::numeric_limits<uint32_t>::max)();
+
+QuadListLayout::QuadListLayout(const Region& region) {
+	const glm::ivec3 size = region.getUpperCorner() - region.getLowerCorner() + 2;
+	uint32_t offset = 0u;
+	for (int i = 0; i < core::enumVal(FaceNames::Max); ++i) {
+		_offsets[i] = offset;
+		const FaceNames face = (FaceNames)i;
+		if (face == FaceNames::PositiveX || face == FaceNames::NegativeX) {
+			offset += size.x;
+		} else if (face == FaceNames::PositiveY || face == FaceNames::NegativeY) {
+			offset += size.y;
+		} else {
+			offset += size.z;
+		}
+	}
+	_offsets[core::enumVal(FaceNames::Max)] = offset;
+}
+
+CubicSlab::CubicSlab(const Region& region, int _zStart, int _zEnd, Mesh* result) :
+		zStart(_zStart), zEnd(_zEnd), localMesh(0, 0, true) {
+	const uint32_t width = region.getWidthInVoxels() + 2;
+	const uint32_t height = region.getHeightInVoxels() + 2;
+	firstPlane = std::make_unique<Array>(width, height, MaxVerticesPerPosition);
+	planes[0] = std::make_unique<Array>(width, height, MaxVerticesPerPosition);
+	if (zStart == region.getLowerZ()) {
+		mesh = result;
+	} else {
+		// the first plane must survive the walk to stitch this slab onto the previous one
+		planes[1] = std::make_unique<Array>(width, height, MaxVerticesPerPosition);
+		mesh = &localMesh;
+		const int slabs = core_max(1, region.getDepthInVoxels() / (zEnd - zStart + 1));
+		localMesh.getVertexVector().reserve(core_max((size_t)128, result->getVertexVector().capacity() / slabs));
+	}
+}
+
+int cubicSlabCount(const Region& region, const core::ThreadPool* threadPool) {
+	if (threadPool == nullptr) {
+		return 1;
+	}
+	const int maxSlabs = region.getDepthInVoxels() / MinSlabSlices;
+	return core_max(1, core_min((int)threadPool->size() + 1, maxSlabs));
+}
+
 static bool isSameVertex(const VoxelVertex& v1, const VoxelVertex& v2) {
 	return v1.colorIndex == v2.colorIndex && v1.ambientOcclusion == v2.ambientOcclusion;
 }
@@ -16,7 +69,7 @@ static bool isSameColor(const VoxelVertex& v1, const VoxelVertex& v2) {
 }
 
 template<class FUNC>
-static bool mergeQuads(Quad& q1, Quad& q2, Mesh* meshCurrent, FUNC&& equal) {
+static bool mergeQuads(Quad& q1, const Quad& q2, const Mesh* meshCurrent, FUNC&& equal) {
 	core_trace_scoped(MergeQuads);
 	const VertexArray& vv = meshCurrent->getVertexVector();
 	const VoxelVertex& v11 = vv[q1.vertices[0]];
@@ -67,7 +120,12 @@ static bool mergeQuads(Quad& q1, Quad& q2, Mesh* meshCurrent, FUNC&& equal) {
 	return false;
 }
 
-static bool performQuadMerging(QuadList& quads, Mesh* meshCurrent, bool ambientOcclusion) {
+/**
+ * @brief Merged quads are only marked while iterating and removed at the end of the pass - this
+ * keeps the order of the remaining quads.
+ * @param[in,out] amount The amount of quads in the list
+ */
+static bool performQuadMerging(Quad* quads, uint32_t& amount, const Mesh* meshCurrent, bool ambientOcclusion) {
 	core_trace_scoped(PerformQuadMerging);
 	bool didMerge = false;
 
@@ -76,22 +134,31 @@ static bool performQuadMerging(QuadList& quads, Mesh* meshCurrent, bool ambientO
 		equal = isSameColor;
 	}
 
-	for (QuadList::iterator outerIter = quads.begin(); outerIter != quads.end(); ++outerIter) {
-		QuadList::iterator innerIter = outerIter;
-		++innerIter;
-		while (innerIter != quads.end()) {
-			Quad& q1 = *outerIter;
-			Quad& q2 = *innerIter;
-
-			const bool result = mergeQuads(q1, q2, meshCurrent, equal);
-
-			if (result) {
+	for (uint32_t outer = 0u; outer < amount; ++outer) {
+		Quad& q1 = quads[outer];
+		if (q1.vertices[0] == InvalidIndex) {
+			continue;
+		}
+		for (uint32_t inner = outer + 1u; inner < amount; ++inner) {
+			Quad& q2 = quads[inner];
+			if (q2.vertices[0] == InvalidIndex) {
+				continue;
+			}
+			if (mergeQuads(q1, q2, meshCurrent, equal)) {
 				didMerge = true;
-				innerIter = quads.erase(innerIter);
-			} else {
-				++innerIter;
+				q2.vertices[0] = InvalidIndex;
+			}
+		}
+	}
+
+	if (didMerge) {
+		uint32_t remaining = 0u;
+		for (uint32_t i = 0u; i < amount; ++i) {
+			if (quads[i].vertices[0] != InvalidIndex) {
+				quads[remaining++] = quads[i];
 			}
 		}
+		amount = remaining;
 	}
 
 	return didMerge;
@@ -118,22 +185,106 @@ SDL_FORCE_INLINE bool isQuadFlipped(const VoxelVertex& v00, const VoxelVertex& v
 	return v00.ambientOcclusion + v11.ambientOcclusion > v01.ambientOcclusion + v10.ambientOcclusion;
 }
 
-void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadListVector& vecListQuads) {
+/**
+ * @brief Maps the vertices of the slab to the result mesh. The vertices on the first plane of the slab were
+ * maybe already created by the previous slab - all others are appended in the order they were created in.
+ */
+static void stitchSlab(Mesh* result, bool reuseVertices, const CubicSlab& previous, CubicSlab& slab) {
+	core_trace_scoped(StitchSlab);
+	const VertexArray& vertices = slab.localMesh.getVertexVector();
+	slab.remap.resize(vertices.size());
+	for (size_t i = 0u; i < vertices.size(); ++i) {
+		slab.remap[i] = InvalidIndex;
+	}
+
+	if (reuseVertices) {
+		const Array& firstPlane = *slab.firstPlane;
+		const Array& lastPlane = *previous.lastPlane;
+		for (uint32_t y = 0u; y < firstPlane.height(); ++y) {
+			for (uint32_t x = 0u; x < firstPlane.width(); ++x) {
+				for (uint32_t ct = 0u; ct < MaxVerticesPerPosition; ++ct) {
+					const VertexData& entry = firstPlane(x, y, ct);
+					if (entry.index == 0) {
+						break;
+					}
+					for (uint32_t pct = 0u; pct < MaxVerticesPerPosition; ++pct) {
+						const VertexData& existing = lastPlane(x, y, pct);
+						if (existing.index == 0) {
+							break;
+						}
+						if (existing.ambientOcclusion == entry.ambientOcclusion && existing.voxel.isSame(entry.voxel)) {
+							slab.remap[entry.index - 1] = previous.globalIndex(existing.index - 1);
+							break;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0u; i < vertices.size(); ++i) {
+		if (slab.remap[i] == InvalidIndex) {
+			slab.remap[i] = result->addVertex(vertices[i]);
+		}
+	}
+}
+
+void meshify(Mesh* result, bool mergeQuads, bool reuseVertices, bool ambientOcclusion, const QuadListLayout& layout,
+		std::vector<std::unique_ptr<CubicSlab>>& slabs, core::ThreadPool* threadPool) {
 	core_trace_scoped(GenerateMeshify);
-	for (QuadList& listQuads : vecListQuads) {
-		if (mergeQuads) {
-			core_trace_scoped(MergeQuads);
+	for (size_t i = 1u; i < slabs.size(); ++i) {
+		stitchSlab(result, reuseVertices, *slabs[i - 1], *slabs[i]);
+	}
+
+	// sort the quads of all slabs into the lists - the slabs are ordered along the z axis, so
+	// the quads end up in the same order the single threaded walk would have recorded them
+	const uint32_t lists = layout.size();
+	std::vector<uint32_t> listStart(lists + 1, 0u);
+	for (const std::unique_ptr<CubicSlab>& slab : slabs) {
+		for (const SlabQuad& quad : slab->quads) {
+			++listStart[quad.list + 1];
+		}
+	}
+	for (uint32_t list = 0u; list < lists; ++list) {
+		listStart[list + 1] += listStart[list];
+	}
+	std::vector<Quad> quads(listStart[lists]);
+	std::vector<uint32_t> listSize(lists, 0u);
+	for (const std::unique_ptr<CubicSlab>& slab : slabs) {
+		for (const SlabQuad& slabQuad : slab->quads) {
+			Quad& quad = quads[listStart[slabQuad.list] + listSize[slabQuad.list]++];
+			for (int i = 0; i < 4; ++i) {
+				quad.vertices[i] = slab->globalIndex(slabQuad.quad.vertices[i]);
+			}
+		}
+	}
+	slabs.clear();
+
+	if (mergeQuads) {
+		core_trace_scoped(MergeQuads);
+		auto merge = [&] (int list) {
 			// Repeatedly call this function until it returns
 			// false to indicate nothing more can be done.
-			while (performQuadMerging(listQuads, result, ambientOcclusion)) {
+			while (performQuadMerging(quads.data() + listStart[list], listSize[list], result, ambientOcclusion)) {
+			}
+		};
+		if (threadPool != nullptr && threadPool->size() > 0u) {
+			threadPool->parallelFor(0, (int)lists, merge);
+		} else {
+			for (uint32_t list = 0u; list < lists; ++list) {
+				merge((int)list);
 			}
 		}
+	}
 
-		for (const Quad& quad : listQuads) {
-			const IndexType i0 = quad.vertices[0];
-			const IndexType i1 = quad.vertices[1];
-			const IndexType i2 = quad.vertices[2];
-			const IndexType i3 = quad.vertices[3];
+	for (uint32_t list = 0u; list < lists; ++list) {
+		const Quad* listQuads = quads.data() + listStart[list];
+		for (uint32_t i = 0u; i < listSize[list]; ++i) {
+			const Quad& quad = listQuads[i];
+			const uint32_t i0 = quad.vertices[0];
+			const uint32_t i1 = quad.vertices[1];
+			const uint32_t i2 = quad.vertices[2];
+			const uint32_t i3 = quad.vertices[3];
 			const VoxelVertex& v00 = result->getVertex(i3);
 			const VoxelVertex& v01 = result->getVertex(i0);
 			const VoxelVertex& v10 = result->getVertex(i2);
@@ -150,7 +301,7 @@ void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadListVecto
 	}
 }
 
-IndexType addVertex(bool reuseVertices, uint32_t x, uint32_t y, uint32_t z, const Voxel& materialIn, Array& existingVertices,
+uint32_t addVertex(bool reuseVertices, uint32_t x, uint32_t y, uint32_t z, const Voxel& materialIn, Array& existingVertices,
 		Mesh* meshCurrent, const VoxelType face1, const VoxelType face2, const VoxelType corner, const glm::ivec3& offset) {
 	core_trace_scoped(AddVertex);
 	const uint8_t ambientOcclusion = vertexAmbientOcclusion(
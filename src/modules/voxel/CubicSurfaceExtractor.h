@@ -17,7 +17,8 @@
 #include "Face.h"
 #include <glm/fwd.hpp>
 #include <glm/vec3.hpp>
-#include <list>
+#include "core/concurrent/ThreadPool.h"
+#include <memory>
 #include <vector>
 
 namespace voxel {
@@ -40,10 +41,13 @@ const uint32_t MaxVerticesPerPosition = 8;
  */
 
 struct Quad {
-	inline Quad(IndexType v0, IndexType v1, IndexType v2, IndexType v3) : vertices{v0, v1, v2, v3} {
+	inline Quad() {
 	}
 
-	IndexType vertices[4];
+	inline Quad(uint32_t v0, uint32_t v1, uint32_t v2, uint32_t v3) : vertices{v0, v1, v2, v3} {
+	}
+
+	uint32_t vertices[4];
 };
 
 struct VertexData {
@@ -80,148 +84,121 @@ public:
 		return _elements[z * _width * _height + y * _width + x];
 	}
 
+	inline const VertexData& operator()(uint32_t x, uint32_t y, uint32_t z) const {
+		core_assert_msg(x < _width && y < _height && z < _depth, "Array access is out-of-range.");
+		return _elements[z * _width * _height + y * _width + x];
+	}
+
+	inline uint32_t width() const {
+		return _width;
+	}
+
+	inline uint32_t height() const {
+		return _height;
+	}
+
 	void swap(Array& other) {
 		core::exchange(_elements, other._elements);
 	}
 };
 
 /**
- * @brief Should be a list because random inserts which we need in @c performQuadMerging are O(1)
+ * @brief All quads in a list are in the same plane and facing in the same direction. The lists of all faces
+ * are stored one after another in a flat array - this gives the index of the list for a face and a slice.
  */
-typedef std::list<Quad> QuadList;
-typedef std::vector<QuadList> QuadListVector;
+class QuadListLayout {
+private:
+	uint32_t _offsets[core::enumVal(FaceNames::Max) + 1];
+public:
+	QuadListLayout(const Region& region);
+
+	inline uint32_t list(FaceNames face, uint32_t slice) const {
+		return _offsets[core::enumVal(face)] + slice;
+	}
+
+	inline uint32_t size() const {
+		return _offsets[core::enumVal(FaceNames::Max)];
+	}
+};
+
+/**
+ * @brief A quad that was recorded while walking the volume - @c list is the index given by the @c QuadListLayout
+ */
+struct SlabQuad {
+	Quad quad;
+	uint32_t list;
+};
+
+/**
+ * @brief The vertices and quads of a range of z slices.
+ *
+ * The slabs of a region are extracted independently of each other. The first slab writes its vertices directly into the
+ * result mesh, all others use their own mesh and are stitched onto the previous slab once all slabs are done. The quads
+ * are recorded into one flat arena per slab instead of a list node per quad.
+ */
+struct CubicSlab : public core::NonCopyable {
+	CubicSlab(const Region& region, int zStart, int zEnd, Mesh* result);
+
+	/** inclusive range of world z coordinates */
+	const int zStart;
+	const int zEnd;
+	Mesh localMesh;
+	/** the result mesh for the first slab - @c localMesh for all the others */
+	Mesh* mesh;
+	std::vector<SlabQuad> quads;
+	/**
+	 * The vertices of the z plane the slab starts with and the plane it ends with. The first plane is shared
+	 * with the last plane of the previous slab.
+	 */
+	std::unique_ptr<Array> firstPlane;
+	std::unique_ptr<Array> planes[2];
+	Array* lastPlane = nullptr;
+	/** maps the indices of the @c localMesh to the indices in the result mesh - empty for the first slab */
+	VertexIndexArray remap;
+
+	inline uint32_t globalIndex(uint32_t local) const {
+		return remap.empty() ? local : remap[local];
+	}
+};
 
 /**
  * @section Surface extraction
  */
 
-extern IndexType addVertex(bool reuseVertices, uint32_t x, uint32_t y, uint32_t z, const Voxel& materialIn, Array& existingVertices,
+extern uint32_t addVertex(bool reuseVertices, uint32_t x, uint32_t y, uint32_t z, const Voxel& materialIn, Array& existingVertices,
 		Mesh* meshCurrent, const VoxelType face1, const VoxelType face2, const VoxelType corner, const glm::ivec3& offset);
 
-extern void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadListVector& vecListQuads);
+/**
+ * @return The amount of slabs the region is split into when extracted on the given pool - @c 1 without a pool
+ */
+extern int cubicSlabCount(const Region& region, const core::ThreadPool* threadPool);
 
 /**
- * The CubicSurfaceExtractor creates a mesh in which each voxel appears to be rendered as a cube
- *
- * @par Introduction
- *
- * Games such as Minecraft and Voxatron have a unique graphical style in which each voxel in the world appears to be rendered
- * as a single cube. Actually rendering a cube for each voxel would be very expensive, but in practice the only faces which need
- * to be drawn are those which lie on the boundary between solid and empty voxels. The CubicSurfaceExtractor can be used to create
- * such a mesh from PolyVox volume data. As an example, images from Minecraft and Voxatron are shown below:
- *
- * @image html MinecraftAndVoxatron.jpg
- *
- * Before we get into the specifics of the CubicSurfaceExtractor, it is useful to understand the principles which apply to *all* PolyVox
- * surface extractors and which are described in the Surface Extraction document (ADD LINK). From here on, it is assumed that you
- * are familier with PolyVox regions and how they are used to limit surface extraction to a particular part of the volume. The
- * principles of allowing dynamic terrain are also common to all surface extractors and are described here (ADD LINK).
- *
- * @par Basic Operation
- *
- * At its core, the CubicSurfaceExtractor works by by looking at pairs of adjacent voxels and determining whether a quad should be
- * placed between then. The most simple situation to imagine is a binary volume where every voxel is either solid or empty. In this
- * case a quad should be generated whenever a solid voxel is next to an empty voxel as this represents part of the surface of the
- * solid object. There is no need to generate a quad between two solid voxels (this quad would never be seen as it is inside the
- * object) and there is no need to generate a quad between two empty voxels (there is no object here). PolyVox allows the principle
- * to be extended far beyond such simple binary volumes but they provide a useful starting point for understanding how the algorithm
- * works.
- *
- * As an example, lets consider the part of a volume shown below. We are going to explain the principles in only two dimensions as
- * this makes it much simpler to illustrate, so you will need to mentally extend the process into the third dimension. Hopefully you will
- * find this intuitive. The diagram below shows a small part of a larger volume (as indicated by the voxel coordinates on the axes) which
- * contains only solid and empty voxels represented by solid and hollow circles respectively. The region on which we are running the
- * surface extractor is marked in pink, and for the purpose of this example it corresponds to the whole of the diagram.
- *
- * @image html CubicSurfaceExtractor1.png
- *
- * The output of the surface extractor is the mesh marked in red. As you can see, this forms a closed object which corresponds to the
- * shape of the underlying voxel data.
- *
- * @par Working with Regions
- *
- * So far the behaviour is easy to understand, but let's look at what happens when the extraction is limited to a particular region of
- * the volume. The figure below shows the same data set as the previous figure, but the extraction region (still marked in pink) has
- * been limited to 13 to 16 in x and 47 to 51 in y:
- *
- * @image html CubicSurfaceExtractor2.png
- *
- * As you can see, the extractor continues to generate a number of quads as indicated by the solid red lines. However, you can also see
- * that the shape is no longer closed. This is because the solid voxels actually extend outside the region which is being processed, and
- * so the extractor does not encounter a boundary between solid and empty voxels. Although this may initially appear problematic, the
- * hole in the mesh does not actually matter because it will be hidden by the mesh corresponding to the region adjacent to it (see next
- * diagram).
- *
- * More interestingly, the diagram also contains a couple of dotted red lines lying on the bottom and right hand side of the extracted
- * region. These are present to illustrate a common point of confusion, which is that *no quads are generated at this position even though
- * it is a boundary between solid and empty voxels*. This is indeed somewhat counter intuitive but there is a rational reasaoning behind
- * it.
- * If you consider the dashed line on the righthand side of the extracted region, then it is clear that this lies on a boundary between
- * solid and empty voxels and so we do need to create quads here. But what is not so clear is whether these quads should be assigned to
- * the mesh which corresponds to the region in pink, or whether they should be assigned to the region to the right of it which is marked
- * in blue in the diagram below:
- *
- * @image html CubicSurfaceExtractor3.png
- *
- * We could choose to add the quads to *both* regions, but this can cause confusion when one of the region is modified (causing the face
- * to disappear or a new one to be created) as *both* regions need to have their mesh regenerated to correctly represent the new state of
- * the volume data. Such pairs of coplanar quads can also cause problems with physics engines, and may prevent transparent voxels from
- * rendering correctly. Therefore we choose to instead only add the quad to one of the the regions and we always choose the one with the
- * greater coordinate value in the direction in which they differ. In the above example the regions differ by the 'x' component of their
- * position, and so the quad is added to the region with the greater 'x' value (the one marked in blue).
- *
- * One of the practical implications of this is that when you modify a voxel *you may have to re-extract the mesh for regions other than
- * region which actually contains the voxel you modified.* This happens when the voxel lies on the upper x,y or z face of a region.
- * Assuming that you have some management code which can mark a region as needing re-extraction when a voxel changes, you should probably
- * extend this to mark the regions of neighbouring voxels as invalid (this will have no effect when the voxel is well within a region,
- * but will mark the neighbouring region as needing an update if the voxel lies on a region face).
- *
- * Another scenario which sometimes results in confusion is when you wish to extract a region which corresponds to the whole volume,
- * particularly when solid voxels extend right to the edge of the volume.
- *
- * This version of the function performs the extraction into a user-provided mesh rather than allocating a mesh automatically.
- * There are a few reasons why this might be useful to more advanced users:
- *
- * @li It leaves the user in control of memory allocation and would allow them to implement e.g. a mesh pooling system.
- * @li The user-provided mesh could have a different index type (e.g. 16-bit indices) to reduce memory usage.
- * @li The user could provide a custom mesh class, e.g a thin wrapper around an openGL VBO to allow direct writing into this structure.
+ * @brief Stitches the slabs into the result mesh, merges the quads of each plane and generates the triangles
+ * @note If a thread pool is given, the planes are merged in parallel - the result is the same as without it.
+ */
+extern void meshify(Mesh* result, bool mergeQuads, bool reuseVertices, bool ambientOcclusion, const QuadListLayout& layout,
+		std::vector<std::unique_ptr<CubicSlab>>& slabs, core::ThreadPool* threadPool);
+
+/**
+ * @brief Walks the z slices of the given slab and records the vertices and the quads that are needed for them
+ * @sa extractCubicMesh()
  */
 template<typename VolumeType, typename IsQuadNeeded>
-void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool mergeQuads = true, bool reuseVertices = true, bool ambientOcclusion = true) {
-	core_trace_scoped(ExtractCubicMesh);
+void extractCubicSlab(VolumeType* volData, const Region& region, const QuadListLayout& layout, CubicSlab& slab, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool reuseVertices) {
+	core_trace_scoped(ExtractCubicSlab);
 
-	result->clear();
 	const glm::ivec3& offset = region.getLowerCorner();
 	const glm::ivec3& upper = region.getUpperCorner();
-	result->setOffset(offset);
+	Mesh* result = slab.mesh;
 
 	// Used to avoid creating duplicate vertices.
-	const int widthInCells = upper.x - offset.x;
-	const int heightInCells = upper.y - offset.y;
-	Array previousSliceVertices(widthInCells + 2, heightInCells + 2, MaxVerticesPerPosition);
-	Array currentSliceVertices(widthInCells + 2, heightInCells + 2, MaxVerticesPerPosition);
-
-	// During extraction we create a number of different lists of quads. All the
-	// quads in a given list are in the same plane and facing in the same direction.
-	QuadListVector vecQuads[core::enumVal(FaceNames::Max)];
-
-	const int xSize = upper.x - offset.x + 2;
-	const int ySize = upper.y - offset.y + 2;
-	const int zSize = upper.z - offset.z + 2;
-	vecQuads[core::enumVal(FaceNames::NegativeX)].resize(xSize);
-	vecQuads[core::enumVal(FaceNames::PositiveX)].resize(xSize);
-
-	vecQuads[core::enumVal(FaceNames::NegativeY)].resize(ySize);
-	vecQuads[core::enumVal(FaceNames::PositiveY)].resize(ySize);
-
-	vecQuads[core::enumVal(FaceNames::NegativeZ)].resize(zSize);
-	vecQuads[core::enumVal(FaceNames::PositiveZ)].resize(zSize);
+	Array* previousSliceVertices = slab.firstPlane.get();
+	Array* currentSliceVertices = slab.planes[0].get();
 
 	typename VolumeType::Sampler volumeSampler(volData);
 
-	{
-	core_trace_scoped(QuadGeneration);
-	for (int32_t z = offset.z; z <= upper.z; ++z) {
+	for (int32_t z = slab.zStart; z <= slab.zEnd; ++z) {
 		const uint32_t regZ = z - offset.z;
 		for (int32_t x = offset.x; x <= upper.x; ++x) {
 			const uint32_t regX = x - offset.x;
@@ -282,15 +259,15 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 
 				// X [A] LEFT
 				if (isQuadNeeded(voxelCurrentMaterial, voxelLeftMaterial, FaceNames::NegativeX)) {
-					const IndexType v_0_1 = addVertex(reuseVertices, regX, regY,     regZ,     voxelCurrent, previousSliceVertices, result,
+					const uint32_t v_0_1 = addVertex(reuseVertices, regX, regY,     regZ,     voxelCurrent, *previousSliceVertices, result,
 							voxelLeftBeforeMaterial, voxelBelowLeftMaterial, voxelBelowLeftBeforeMaterial, translate);
-					const IndexType v_1_4 = addVertex(reuseVertices, regX, regY,     regZ + 1, voxelCurrent, currentSliceVertices,  result,
+					const uint32_t v_1_4 = addVertex(reuseVertices, regX, regY,     regZ + 1, voxelCurrent, *currentSliceVertices, result,
 							voxelBelowLeftMaterial, voxelLeftBehindMaterial, voxelBelowLeftBehindMaterial, translate);
-					const IndexType v_2_8 = addVertex(reuseVertices, regX, regY + 1, regZ + 1, voxelCurrent, currentSliceVertices,  result,
+					const uint32_t v_2_8 = addVertex(reuseVertices, regX, regY + 1, regZ + 1, voxelCurrent, *currentSliceVertices, result,
 							voxelLeftBehindMaterial, voxelAboveLeftMaterial, voxelAboveLeftBehindMaterial, translate);
-					const IndexType v_3_5 = addVertex(reuseVertices, regX, regY + 1, regZ,     voxelCurrent, previousSliceVertices, result,
+					const uint32_t v_3_5 = addVertex(reuseVertices, regX, regY + 1, regZ,     voxelCurrent, *previousSliceVertices, result,
 							voxelAboveLeftMaterial, voxelLeftBeforeMaterial, voxelAboveLeftBeforeMaterial, translate);
-					vecQuads[core::enumVal(FaceNames::NegativeX)][regX].emplace_back(v_0_1, v_1_4, v_2_8, v_3_5);
+					slab.quads.push_back(SlabQuad{Quad(v_0_1, v_1_4, v_2_8, v_3_5), layout.list(FaceNames::NegativeX, regX)});
 				}
 
 				// X [B] RIGHT
@@ -303,15 +280,15 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 					const VoxelType _voxelAboveRightBefore = voxelAboveBefore.getMaterial();
 					const VoxelType _voxelBelowRightBefore = voxelBelowBefore.getMaterial();
 
-					const IndexType v_0_2 = addVertex(reuseVertices, regX, regY,     regZ,     voxelLeft, previousSliceVertices, result,
+					const uint32_t v_0_2 = addVertex(reuseVertices, regX, regY,     regZ,     voxelLeft, *previousSliceVertices, result,
 							voxelBelowMaterial, voxelBeforeMaterial, _voxelBelowRightBefore, translate);
-					const IndexType v_1_3 = addVertex(reuseVertices, regX, regY,     regZ + 1, voxelLeft, currentSliceVertices,  result,
+					const uint32_t v_1_3 = addVertex(reuseVertices, regX, regY,     regZ + 1, voxelLeft, *currentSliceVertices, result,
 							voxelBelowMaterial, _voxelRightBehind, _voxelBelowRightBehind, translate);
-					const IndexType v_2_7 = addVertex(reuseVertices, regX, regY + 1, regZ + 1, voxelLeft, currentSliceVertices,  result,
+					const uint32_t v_2_7 = addVertex(reuseVertices, regX, regY + 1, regZ + 1, voxelLeft, *currentSliceVertices, result,
 							_voxelAboveRight, _voxelRightBehind, _voxelAboveRightBehind, translate);
-					const IndexType v_3_6 = addVertex(reuseVertices, regX, regY + 1, regZ,     voxelLeft, previousSliceVertices, result,
+					const uint32_t v_3_6 = addVertex(reuseVertices, regX, regY + 1, regZ,     voxelLeft, *previousSliceVertices, result,
 							_voxelAboveRight, voxelBeforeMaterial, _voxelAboveRightBefore, translate);
-					vecQuads[core::enumVal(FaceNames::PositiveX)][regX].emplace_back(v_0_2, v_3_6, v_2_7, v_1_3);
+					slab.quads.push_back(SlabQuad{Quad(v_0_2, v_3_6, v_2_7, v_1_3), layout.list(FaceNames::PositiveX, regX)});
 				}
 
 				// Y [C] BELOW
@@ -326,15 +303,15 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 					const VoxelType voxelBelowBehindMaterial      = voxelBelowBehind.getMaterial();
 					const VoxelType voxelBelowRightBehindMaterial = voxelBelowRightBehind.getMaterial();
 
-					const IndexType v_0_1 = addVertex(reuseVertices, regX,     regY, regZ,     voxelCurrent, previousSliceVertices, result,
+					const uint32_t v_0_1 = addVertex(reuseVertices, regX,     regY, regZ,     voxelCurrent, *previousSliceVertices, result,
 							voxelBelowBeforeMaterial, voxelBelowLeftMaterial, voxelBelowLeftBeforeMaterial, translate);
-					const IndexType v_1_2 = addVertex(reuseVertices, regX + 1, regY, regZ,     voxelCurrent, previousSliceVertices, result,
+					const uint32_t v_1_2 = addVertex(reuseVertices, regX + 1, regY, regZ,     voxelCurrent, *previousSliceVertices, result,
 							voxelBelowRightMaterial, voxelBelowBeforeMaterial, voxelBelowRightBeforeMaterial, translate);
-					const IndexType v_2_3 = addVertex(reuseVertices, regX + 1, regY, regZ + 1, voxelCurrent, currentSliceVertices,  result,
+					const uint32_t v_2_3 = addVertex(reuseVertices, regX + 1, regY, regZ + 1, voxelCurrent, *currentSliceVertices, result,
 							voxelBelowBehindMaterial, voxelBelowRightMaterial, voxelBelowRightBehindMaterial, translate);
-					const IndexType v_3_4 = addVertex(reuseVertices, regX,     regY, regZ + 1, voxelCurrent, currentSliceVertices,  result,
+					const uint32_t v_3_4 = addVertex(reuseVertices, regX,     regY, regZ + 1, voxelCurrent, *currentSliceVertices, result,
 							voxelBelowLeftMaterial, voxelBelowBehindMaterial, voxelBelowLeftBehindMaterial, translate);
-					vecQuads[core::enumVal(FaceNames::NegativeY)][regY].emplace_back(v_0_1, v_1_2, v_2_3, v_3_4);
+					slab.quads.push_back(SlabQuad{Quad(v_0_1, v_1_2, v_2_3, v_3_4), layout.list(FaceNames::NegativeY, regY)});
 				}
 
 				// Y [D] ABOVE
@@ -346,15 +323,15 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 					const VoxelType _voxelAboveRightBefore = voxelRightBefore.getMaterial();
 					const VoxelType _voxelAboveLeftBehind  = voxelLeftBehind.getMaterial();
 
-					const IndexType v_0_5 = addVertex(reuseVertices, regX,     regY, regZ,     voxelBelow, previousSliceVertices, result,
+					const uint32_t v_0_5 = addVertex(reuseVertices, regX,     regY, regZ,     voxelBelow, *previousSliceVertices, result,
 							voxelBeforeMaterial, voxelLeftMaterial, voxelLeftBeforeMaterial, translate);
-					const IndexType v_1_6 = addVertex(reuseVertices, regX + 1, regY, regZ,     voxelBelow, previousSliceVertices, result,
+					const uint32_t v_1_6 = addVertex(reuseVertices, regX + 1, regY, regZ,     voxelBelow, *previousSliceVertices, result,
 							_voxelAboveRight, voxelBeforeMaterial, _voxelAboveRightBefore, translate);
-					const IndexType v_2_7 = addVertex(reuseVertices, regX + 1, regY, regZ + 1, voxelBelow, currentSliceVertices,  result,
+					const uint32_t v_2_7 = addVertex(reuseVertices, regX + 1, regY, regZ + 1, voxelBelow, *currentSliceVertices, result,
 							_voxelAboveBehind, _voxelAboveRight, _voxelAboveRightBehind, translate);
-					const IndexType v_3_8 = addVertex(reuseVertices, regX,     regY, regZ + 1, voxelBelow, currentSliceVertices,  result,
+					const uint32_t v_3_8 = addVertex(reuseVertices, regX,     regY, regZ + 1, voxelBelow, *currentSliceVertices, result,
 							voxelLeftMaterial, _voxelAboveBehind, _voxelAboveLeftBehind, translate);
-					vecQuads[core::enumVal(FaceNames::PositiveY)][regY].emplace_back(v_0_5, v_3_8, v_2_7, v_1_6);
+					slab.quads.push_back(SlabQuad{Quad(v_0_5, v_3_8, v_2_7, v_1_6), layout.list(FaceNames::PositiveY, regY)});
 				}
 
 				// Z [E] BEFORE
@@ -365,15 +342,15 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 					const VoxelType voxelAboveRightBeforeMaterial = voxelAboveRightBefore.getMaterial();
 					const VoxelType voxelBelowRightBeforeMaterial = voxelBelowRightBefore.getMaterial();
 
-					const IndexType v_0_1 = addVertex(reuseVertices, regX,     regY,     regZ, voxelCurrent, previousSliceVertices, result,
+					const uint32_t v_0_1 = addVertex(reuseVertices, regX,     regY,     regZ, voxelCurrent, *previousSliceVertices, result,
 							voxelBelowBeforeMaterial, voxelLeftBeforeMaterial, voxelBelowLeftBeforeMaterial, translate); //1
-					const IndexType v_1_5 = addVertex(reuseVertices, regX,     regY + 1, regZ, voxelCurrent, previousSliceVertices, result,
+					const uint32_t v_1_5 = addVertex(reuseVertices, regX,     regY + 1, regZ, voxelCurrent, *previousSliceVertices, result,
 							voxelAboveBeforeMaterial, voxelLeftBeforeMaterial, voxelAboveLeftBeforeMaterial, translate); //5
-					const IndexType v_2_6 = addVertex(reuseVertices, regX + 1, regY + 1, regZ, voxelCurrent, previousSliceVertices, result,
+					const uint32_t v_2_6 = addVertex(reuseVertices, regX + 1, regY + 1, regZ, voxelCurrent, *previousSliceVertices, result,
 							voxelAboveBeforeMaterial, voxelRightBeforeMaterial, voxelAboveRightBeforeMaterial, translate); //6
-					const IndexType v_3_2 = addVertex(reuseVertices, regX + 1, regY,     regZ, voxelCurrent, previousSliceVertices, result,
+					const uint32_t v_3_2 = addVertex(reuseVertices, regX + 1, regY,     regZ, voxelCurrent, *previousSliceVertices, result,
 							voxelBelowBeforeMaterial, voxelRightBeforeMaterial, voxelBelowRightBeforeMaterial, translate); //2
-					vecQuads[core::enumVal(FaceNames::NegativeZ)][regZ].emplace_back(v_0_1, v_1_5, v_2_6, v_3_2);
+					slab.quads.push_back(SlabQuad{Quad(v_0_1, v_1_5, v_2_6, v_3_2), layout.list(FaceNames::NegativeZ, regZ)});
 				}
 
 				// Z [F] BEHIND
@@ -383,15 +360,15 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 					const VoxelType _voxelAboveRightBehind = volumeSampler.peekVoxel1px1py0pz().getMaterial();
 					const VoxelType _voxelBelowRightBehind = volumeSampler.peekVoxel1px1ny0pz().getMaterial();
 
-					const IndexType v_0_4 = addVertex(reuseVertices, regX,     regY,     regZ, voxelBefore, previousSliceVertices, result,
+					const uint32_t v_0_4 = addVertex(reuseVertices, regX,     regY,     regZ, voxelBefore, *previousSliceVertices, result,
 							voxelBelowMaterial, voxelLeftMaterial, voxelBelowLeftMaterial, translate); //4
-					const IndexType v_1_8 = addVertex(reuseVertices, regX,     regY + 1, regZ, voxelBefore, previousSliceVertices, result,
+					const uint32_t v_1_8 = addVertex(reuseVertices, regX,     regY + 1, regZ, voxelBefore, *previousSliceVertices, result,
 							_voxelAboveBehind, voxelLeftMaterial, voxelAboveLeftMaterial, translate); //8
-					const IndexType v_2_7 = addVertex(reuseVertices, regX + 1, regY + 1, regZ, voxelBefore, previousSliceVertices, result,
+					const uint32_t v_2_7 = addVertex(reuseVertices, regX + 1, regY + 1, regZ, voxelBefore, *previousSliceVertices, result,
 							_voxelAboveBehind, _voxelRightBehind, _voxelAboveRightBehind, translate); //7
-					const IndexType v_3_3 = addVertex(reuseVertices, regX + 1, regY,     regZ, voxelBefore, previousSliceVertices, result,
+					const uint32_t v_3_3 = addVertex(reuseVertices, regX + 1, regY,     regZ, voxelBefore, *previousSliceVertices, result,
 							voxelBelowMaterial, _voxelRightBehind, _voxelBelowRightBehind, translate); //3
-					vecQuads[core::enumVal(FaceNames::PositiveZ)][regZ].emplace_back(v_0_4, v_3_3, v_2_7, v_1_8);
+					slab.quads.push_back(SlabQuad{Quad(v_0_4, v_3_3, v_2_7, v_1_8), layout.list(FaceNames::PositiveZ, regZ)});
 				}
 
 				if (core_likely(y != upper.y)) {
@@ -400,22 +377,154 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 			}
 		}
 
-		previousSliceVertices.swap(currentSliceVertices);
-		currentSliceVertices.clear();
-	}
+		if (z == slab.zStart && slab.planes[1]) {
+			// the first plane is needed to stitch the slab onto the previous one
+			previousSliceVertices = currentSliceVertices;
+			currentSliceVertices = slab.planes[1].get();
+		} else {
+			core::exchange(previousSliceVertices, currentSliceVertices);
+			currentSliceVertices->clear();
+		}
 	}
+	slab.lastPlane = previousSliceVertices;
+}
+
+/**
+ * The CubicSurfaceExtractor creates a mesh in which each voxel appears to be rendered as a cube
+ *
+ * @par Introduction
+ *
+ * Games such as Minecraft and Voxatron have a unique graphical style in which each voxel in the world appears to be rendered
+ * as a single cube. Actually rendering a cube for each voxel would be very expensive, but in practice the only faces which need
+ * to be drawn are those which lie on the boundary between solid and empty voxels. The CubicSurfaceExtractor can be used to create
+ * such a mesh from PolyVox volume data. As an example, images from Minecraft and Voxatron are shown below:
+ *
+ * @image html MinecraftAndVoxatron.jpg
+ *
+ * Before we get into the specifics of the CubicSurfaceExtractor, it is useful to understand the principles which apply to *all* PolyVox
+ * surface extractors and which are described in the Surface Extraction document (ADD LINK). From here on, it is assumed that you
+ * are familier with PolyVox regions and how they are used to limit surface extraction to a particular part of the volume. The
+ * principles of allowing dynamic terrain are also common to all surface extractors and are described here (ADD LINK).
+ *
+ * @par Basic Operation
+ *
+ * At its core, the CubicSurfaceExtractor works by by looking at pairs of adjacent voxels and determining whether a quad should be
+ * placed between then. The most simple situation to imagine is a binary volume where every voxel is either solid or empty. In this
+ * case a quad should be generated whenever a solid voxel is next to an empty voxel as this represents part of the surface of the
+ * solid object. There is no need to generate a quad between two solid voxels (this quad would never be seen as it is inside the
+ * object) and there is no need to generate a quad between two empty voxels (there is no object here). PolyVox allows the principle
+ * to be extended far beyond such simple binary volumes but they provide a useful starting point for understanding how the algorithm
+ * works.
+ *
+ * As an example, lets consider the part of a volume shown below. We are going to explain the principles in only two dimensions as
+ * this makes it much simpler to illustrate, so you will need to mentally extend the process into the third dimension. Hopefully you will
+ * find this intuitive. The diagram below shows a small part of a larger volume (as indicated by the voxel coordinates on the axes) which
+ * contains only solid and empty voxels represented by solid and hollow circles respectively. The region on which we are running the
+ * surface extractor is marked in pink, and for the purpose of this example it corresponds to the whole of the diagram.
+ *
+ * @image html CubicSurfaceExtractor1.png
+ *
+ * The output of the surface extractor is the mesh marked in red. As you can see, this forms a closed object which corresponds to the
+ * shape of the underlying voxel data.
+ *
+ * @par Working with Regions
+ *
+ * So far the behaviour is easy to understand, but let's look at what happens when the extraction is limited to a particular region of
+ * the volume. The figure below shows the same data set as the previous figure, but the extraction region (still marked in pink) has
+ * been limited to 13 to 16 in x and 47 to 51 in y:
+ *
+ * @image html CubicSurfaceExtractor2.png
+ *
+ * As you can see, the extractor continues to generate a number of quads as indicated by the solid red lines. However, you can also see
+ * that the shape is no longer closed. This is because the solid voxels actually extend outside the region which is being processed, and
+ * so the extractor does not encounter a boundary between solid and empty voxels. Although this may initially appear problematic, the
+ * hole in the mesh does not actually matter because it will be hidden by the mesh corresponding to the region adjacent to it (see next
+ * diagram).
+ *
+ * More interestingly, the diagram also contains a couple of dotted red lines lying on the bottom and right hand side of the extracted
+ * region. These are present to illustrate a common point of confusion, which is that *no quads are generated at this position even though
+ * it is a boundary between solid and empty voxels*. This is indeed somewhat counter intuitive but there is a rational reasaoning behind
+ * it.
+ * If you consider the dashed line on the righthand side of the extracted region, then it is clear that this lies on a boundary between
+ * solid and empty voxels and so we do need to create quads here. But what is not so clear is whether these quads should be assigned to
+ * the mesh which corresponds to the region in pink, or whether they should be assigned to the region to the right of it which is marked
+ * in blue in the diagram below:
+ *
+ * @image html CubicSurfaceExtractor3.png
+ *
+ * We could choose to add the quads to *both* regions, but this can cause confusion when one of the region is modified (causing the face
+ * to disappear or a new one to be created) as *both* regions need to have their mesh regenerated to correctly represent the new state of
+ * the volume data. Such pairs of coplanar quads can also cause problems with physics engines, and may prevent transparent voxels from
+ * rendering correctly. Therefore we choose to instead only add the quad to one of the the regions and we always choose the one with the
+ * greater coordinate value in the direction in which they differ. In the above example the regions differ by the 'x' component of their
+ * position, and so the quad is added to the region with the greater 'x' value (the one marked in blue).
+ *
+ * One of the practical implications of this is that when you modify a voxel *you may have to re-extract the mesh for regions other than
+ * region which actually contains the voxel you modified.* This happens when the voxel lies on the upper x,y or z face of a region.
+ * Assuming that you have some management code which can mark a region as needing re-extraction when a voxel changes, you should probably
+ * extend this to mark the regions of neighbouring voxels as invalid (this will have no effect when the voxel is well within a region,
+ * but will mark the neighbouring region as needing an update if the voxel lies on a region face).
+ *
+ * Another scenario which sometimes results in confusion is when you wish to extract a region which corresponds to the whole volume,
+ * particularly when solid voxels extend right to the edge of the volume.
+ *
+ * This version of the function performs the extraction into a user-provided mesh rather than allocating a mesh automatically.
+ * There are a few reasons why this might be useful to more advanced users:
+ *
+ * @li It leaves the user in control of memory allocation and would allow them to implement e.g. a mesh pooling system.
+ * @li The user-provided mesh could have a different index type (e.g. 16-bit indices) to reduce memory usage.
+ * @li The user could provide a custom mesh class, e.g a thin wrapper around an openGL VBO to allow direct writing into this structure.
+ *
+ * @par Parallel extraction
+ *
+ * If a thread pool is given, the region is split into slabs of z slices that are walked in parallel. Each slab records its
+ * vertices and quads on its own, the slabs are stitched together afterwards and the quads of the planes are merged in parallel.
+ * The resulting mesh is exactly the same as the one that is extracted without a thread pool.
+ */
+template<typename VolumeType, typename IsQuadNeeded>
+void extractCubicMesh(core::ThreadPool* threadPool, VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool mergeQuads = true, bool reuseVertices = true, bool ambientOcclusion = true) {
+	core_trace_scoped(ExtractCubicMesh);
+
+	result->clear();
+	const int lowerZ = region.getLowerZ();
+	const int slices = region.getDepthInVoxels();
+	result->setOffset(region.getLowerCorner());
+
+	// During extraction we create a number of different lists of quads. All the
+	// quads in a given list are in the same plane and facing in the same direction.
+	const QuadListLayout layout(region);
+	const int slabCount = cubicSlabCount(region, threadPool);
+	std::vector<std::unique_ptr<CubicSlab>> slabs(slabCount);
+	auto extractSlab = [&] (int slab) {
+		const int zStart = lowerZ + slab * slices / slabCount;
+		const int zEnd = lowerZ + (slab + 1) * slices / slabCount - 1;
+		slabs[slab] = std::make_unique<CubicSlab>(region, zStart, zEnd, result);
+		extractCubicSlab(volData, region, layout, *slabs[slab], isQuadNeeded, translate, reuseVertices);
+	};
 
 	{
-		core_trace_scoped(GenerateMesh);
-		for (QuadListVector& vecListQuads : vecQuads) {
-			meshify(result, mergeQuads, ambientOcclusion, vecListQuads);
+		core_trace_scoped(QuadGeneration);
+		if (slabCount > 1) {
+			threadPool->parallelFor(0, slabCount, extractSlab);
+		} else {
+			extractSlab(0);
 		}
 	}
 
+	meshify(result, mergeQuads, reuseVertices, ambientOcclusion, layout, slabs, threadPool);
+
 	result->removeUnusedVertices();
 	result->compressIndices();
 }
 
+/**
+ * @brief Single threaded extraction
+ * @sa extractCubicMesh(core::ThreadPool*, VolumeType*, const Region&, Mesh*, IsQuadNeeded, const glm::ivec3&, bool, bool, bool)
+ */
+template<typename VolumeType, typename IsQuadNeeded>
+void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool mergeQuads = true, bool reuseVertices = true, bool ambientOcclusion = true) {
+	extractCubicMesh((core::ThreadPool*)nullptr, volData, region, result, isQuadNeeded, translate, mergeQuads, reuseVertices, ambientOcclusion);
+}
 }
 
 #undef BUFFERED_SAMPLER
@@ -25,6 +25,8 @@ Mesh::Mesh(int vertices, int indices, bool mayGetResized) : _mayGetResized(mayGe
 Mesh::Mesh(Mesh&& other) noexcept {
 	_vecIndices = std::move(other._vecIndices);
 	_vecVertices = std::move(other._vecVertices);
+	_ranges = std::move(other._ranges);
+	_wideIndices = std::move(other._wideIndices);
 	_compressedIndices = other._compressedIndices;
 	other._compressedIndices = nullptr;
 	_compressedIndexSize = other._compressedIndexSize;
@@ -36,6 +38,8 @@ Mesh::Mesh(Mesh&& other) noexcept {
 Mesh::Mesh(const Mesh& other) {
 	_vecIndices = other._vecIndices;
 	_vecVertices = other._vecVertices;
+	_ranges = other._ranges;
+	_wideIndices = other._wideIndices;
 	_compressedIndexSize = other._compressedIndexSize;
 	if (other._compressedIndices != nullptr) {
 		_compressedIndices = (uint8_t*)core_malloc(_vecIndices.size() * _compressedIndexSize);
@@ -53,6 +57,8 @@ Mesh& Mesh::operator=(const Mesh& other) {
 	}
 	_vecIndices = other._vecIndices;
 	_vecVertices = other._vecVertices;
+	_ranges = other._ranges;
+	_wideIndices = other._wideIndices;
 	_compressedIndexSize = other._compressedIndexSize;
 	core_free(_compressedIndices);
 	if (other._compressedIndices != nullptr) {
@@ -69,6 +75,8 @@ Mesh& Mesh::operator=(const Mesh& other) {
 Mesh& Mesh::operator=(Mesh&& other) noexcept {
 	_vecIndices = std::move(other._vecIndices);
 	_vecVertices = std::move(other._vecVertices);
+	_ranges = std::move(other._ranges);
+	_wideIndices = std::move(other._wideIndices);
 	core_free(_compressedIndices);
 	_compressedIndices = other._compressedIndices;
 	other._compressedIndices = nullptr;
@@ -103,7 +111,7 @@ size_t Mesh::getNoOfVertices() const {
 	return _vecVertices.size();
 }
 
-const VoxelVertex& Mesh::getVertex(IndexType index) const {
+const VoxelVertex& Mesh::getVertex(uint32_t index) const {
 	return _vecVertices[index];
 }
 
@@ -115,7 +123,7 @@ size_t Mesh::getNoOfIndices() const {
 	return _vecIndices.size();
 }
 
-IndexType Mesh::getIndex(IndexType index) const {
+IndexType Mesh::getIndex(size_t index) const {
 	return _vecIndices[index];
 }
 
@@ -123,6 +131,20 @@ const IndexType* Mesh::getRawIndexData() const {
 	return _vecIndices.data();
 }
 
+const IndexRangeArray& Mesh::getIndexRanges() const {
+	return _ranges;
+}
+
+void Mesh::resolveIndices(VertexIndexArray& indices) const {
+	indices.clear();
+	indices.reserve(_vecIndices.size());
+	for (const IndexRange& range : _ranges) {
+		for (uint32_t i = range.firstIndex; i < range.firstIndex + range.numIndices; ++i) {
+			indices.push_back(range.baseVertex + _vecIndices[i]);
+		}
+	}
+}
+
 const glm::ivec3& Mesh::getOffset() const {
 	return _offset;
 }
@@ -134,6 +156,8 @@ void Mesh::setOffset(const glm::ivec3& offset) {
 void Mesh::clear() {
 	_vecVertices.clear();
 	_vecIndices.clear();
+	_ranges.clear();
+	_wideIndices.clear();
 	_offset = glm::ivec3(0);
 }
 
@@ -141,68 +165,153 @@ bool Mesh::isEmpty() const {
 	return getNoOfVertices() == 0 || getNoOfIndices() == 0;
 }
 
-void Mesh::addTriangle(IndexType index0, IndexType index1, IndexType index2) {
+void Mesh::addTriangle(uint32_t index0, uint32_t index1, uint32_t index2) {
 	//Make sure the specified indices correspond to valid vertices.
 	core_assert_msg(index0 < _vecVertices.size(), "Index points at an invalid vertex.");
 	core_assert_msg(index1 < _vecVertices.size(), "Index points at an invalid vertex.");
 	core_assert_msg(index2 < _vecVertices.size(), "Index points at an invalid vertex.");
-	if (!_mayGetResized) {
-		core_assert_msg(_vecIndices.size() + 3 < _vecIndices.capacity(), "addTriangle() call exceeds the capacity of the indices vector and will trigger a realloc (%i vs %i)", (int)_vecIndices.size(), (int)_vecIndices.capacity());
+
+	const bool fitsRange = _ranges.size() <= 1u && (_ranges.empty() || _ranges[0].baseVertex == 0u);
+	if (_wideIndices.empty() && fitsRange && index0 < MaxRangeVertices && index1 < MaxRangeVertices && index2 < MaxRangeVertices) {
+		if (!_mayGetResized) {
+			core_assert_msg(_vecIndices.size() + 3 < _vecIndices.capacity(), "addTriangle() call exceeds the capacity of the indices vector and will trigger a realloc (%i vs %i)", (int)_vecIndices.size(), (int)_vecIndices.capacity());
+		}
+		_vecIndices.push_back((IndexType)index0);
+		_vecIndices.push_back((IndexType)index1);
+		_vecIndices.push_back((IndexType)index2);
+		if (_ranges.empty()) {
+			_ranges.push_back(IndexRange{0u, 0u, 0u});
+		}
+		_ranges[0].numIndices += 3u;
+		return;
 	}
 
-	_vecIndices.push_back(index0);
-	_vecIndices.push_back(index1);
-	_vecIndices.push_back(index2);
+	if (_wideIndices.empty()) {
+		// the 16 bit indices can't address the vertices anymore - collect the vertex indices until
+		// they are split into ranges in removeUnusedVertices()
+		_wideIndices.reserve(core_max(_vecIndices.capacity(), _vecIndices.size() + 3));
+		resolveIndices(_wideIndices);
+		_vecIndices.clear();
+		_ranges.clear();
+	}
+	if (_wideIndices.size() + 3 > _wideIndices.capacity()) {
+		// the dynamic array only grows linearly
+		_wideIndices.reserve(_wideIndices.capacity() * 2 + 3);
+	}
+	_wideIndices.push_back(index0);
+	_wideIndices.push_back(index1);
+	_wideIndices.push_back(index2);
 }
 
-IndexType Mesh::addVertex(const VoxelVertex& vertex) {
+uint32_t Mesh::addVertex(const VoxelVertex& vertex) {
 	// We should not add more vertices than our chosen index type will let us index.
-	core_assert_msg(_vecVertices.size() < (std::numeric_limits<IndexType>::max)(), "Mesh has more vertices that the chosen index type allows.");
+	core_assert_msg(_vecVertices.size() < (std::numeric_limits<uint32_t>::max)(), "Mesh has more vertices that the chosen index type allows.");
 	if (!_mayGetResized) {
 		core_assert_msg(_vecVertices.size() + 1 < _vecVertices.capacity(), "addVertex() call exceeds the capacity of the vertices vector and will trigger a realloc (%i vs %i)", (int)_vecVertices.size(), (int)_vecVertices.capacity());
 	}
 
 	_vecVertices.push_back(vertex);
-	return (IndexType)_vecVertices.size() - 1;
+	return (uint32_t)_vecVertices.size() - 1;
 }
 
 size_t Mesh::size() {
 	constexpr size_t classSize = sizeof(*this);
-	const size_t indicesSize = _vecIndices.size() * sizeof(IndexType);
+	const size_t indicesSize = _vecIndices.size() * sizeof(IndexType) + _wideIndices.size() * sizeof(uint32_t);
 	const size_t verticesSize = _vecVertices.size() * sizeof(VoxelVertex);
-	const size_t contentSize = indicesSize + verticesSize;
+	const size_t rangesSize = _ranges.size() * sizeof(IndexRange);
+	const size_t contentSize = indicesSize + verticesSize + rangesSize;
 	return classSize + contentSize;
 }
 
+void Mesh::splitIndices() {
+	core_trace_scoped(MeshSplitIndices);
+	const size_t vertices = _vecVertices.size();
+	const size_t indices = _wideIndices.size();
+	// the range the vertex was last added to and its index in that range
+	std::vector<uint32_t> vertexRange(vertices, (std::numeric_limits<uint32_t>::max)());
+	std::vector<uint32_t> rangeIndex(vertices);
+
+	// keep the capacity of the vertices - the dynamic array only grows linearly if the mesh is reused
+	VertexArray rangeVertices;
+	rangeVertices.reserve(core_max(_vecVertices.capacity(), vertices + vertices / 8));
+	_vecIndices.clear();
+	_vecIndices.reserve(indices);
+	_ranges.clear();
+	IndexRange range{0u, 0u, 0u};
+
+	for (size_t triCt = 0u; triCt + 2u < indices; triCt += 3u) {
+		uint32_t rangeId = (uint32_t)_ranges.size();
+		uint32_t newVertices = 0u;
+		for (size_t i = triCt; i < triCt + 3u; ++i) {
+			if (vertexRange[_wideIndices[i]] != rangeId) {
+				++newVertices;
+			}
+		}
+		if (rangeVertices.size() - range.baseVertex + newVertices > MaxRangeVertices) {
+			// close the current range - shared vertices are duplicated into the next one
+			_ranges.push_back(range);
+			range = IndexRange{(uint32_t)_vecIndices.size(), 0u, (uint32_t)rangeVertices.size()};
+			rangeId = (uint32_t)_ranges.size();
+		}
+		for (size_t i = triCt; i < triCt + 3u; ++i) {
+			const uint32_t v = _wideIndices[i];
+			if (vertexRange[v] != rangeId) {
+				vertexRange[v] = rangeId;
+				rangeIndex[v] = (uint32_t)rangeVertices.size() - range.baseVertex;
+				rangeVertices.push_back(_vecVertices[v]);
+			}
+			_vecIndices.push_back((IndexType)rangeIndex[v]);
+		}
+		range.numIndices += 3u;
+	}
+	if (range.numIndices > 0u) {
+		_ranges.push_back(range);
+	}
+
+	_vecVertices = core::move(rangeVertices);
+	_wideIndices.clear();
+}
+
 void Mesh::removeUnusedVertices() {
+	if (!_wideIndices.empty()) {
+		// only the referenced vertices are added to the ranges
+		splitIndices();
+		return;
+	}
 	const size_t vertices = _vecVertices.size();
-	const size_t indices = _vecIndices.size();
 	std::vector<bool> isVertexUsed(vertices);
 	std::fill(isVertexUsed.begin(), isVertexUsed.end(), false);
 
-	for (size_t triCt = 0u; triCt < indices; ++triCt) {
-		IndexType v = _vecIndices[triCt];
-		isVertexUsed[v] = true;
+	for (const IndexRange& range : _ranges) {
+		for (uint32_t i = range.firstIndex; i < range.firstIndex + range.numIndices; ++i) {
+			isVertexUsed[range.baseVertex + _vecIndices[i]] = true;
+		}
 	}
 
-	int noOfUsedVertices = 0;
-	IndexArray newPos(vertices);
+	// the vertices keep their order - so the indices of a range are still in the 16 bit range relative
+	// to the new position of its base vertex
+	uint32_t noOfUsedVertices = 0u;
+	std::vector<uint32_t> newPos(vertices + 1);
 	for (size_t vertCt = 0u; vertCt < vertices; ++vertCt) {
+		newPos[vertCt] = noOfUsedVertices;
 		if (!isVertexUsed[vertCt]) {
 			continue;
 		}
 		const VoxelVertex& v = _vecVertices[vertCt];
 		_vecVertices[noOfUsedVertices] = v;
-		newPos[vertCt] = noOfUsedVertices;
 		++noOfUsedVertices;
 	}
+	newPos[vertices] = noOfUsedVertices;
 
 	_vecVertices.resize(noOfUsedVertices);
 
-	for (size_t triCt = 0u; triCt < indices; ++triCt) {
-		_vecIndices[triCt] = newPos[_vecIndices[triCt]];
+	for (IndexRange& range : _ranges) {
+		const uint32_t baseVertex = newPos[range.baseVertex];
+		for (uint32_t i = range.firstIndex; i < range.firstIndex + range.numIndices; ++i) {
+			_vecIndices[i] = (IndexType)(newPos[range.baseVertex + _vecIndices[i]] - baseVertex);
+		}
+		range.baseVertex = baseVertex;
 	}
-	_vecIndices.resize(indices);
 }
 
 void Mesh::compressIndices() {
@@ -11,9 +11,18 @@ namespace voxel {
 
 using VertexArray = core::DynamicArray<voxel::VoxelVertex>;
 using IndexArray = core::DynamicArray<voxel::IndexType>;
+using IndexRangeArray = core::DynamicArray<voxel::IndexRange>;
+/**
+ * @brief Indices that are already resolved to vertex indices - see @c Mesh::resolveIndices()
+ */
+using VertexIndexArray = core::DynamicArray<uint32_t>;
 
 /**
  * @brief A simple and general-purpose mesh class to represent the data returned by the surface extraction functions.
+ *
+ * The indices are stored as 16 bit values. Meshes with more vertices are split into index ranges that each address up
+ * to @c MaxRangeVertices vertices relative to their base vertex. They have to be drawn with the base vertex of the
+ * range (e.g. @c glDrawElementsBaseVertex).
  */
 class Mesh {
 public:
@@ -32,13 +41,23 @@ public:
 	size_t size();
 
 	size_t getNoOfVertices() const;
-	const VoxelVertex& getVertex(IndexType index) const;
+	const VoxelVertex& getVertex(uint32_t index) const;
 	const VoxelVertex* getRawVertexData() const;
 
 	size_t getNoOfIndices() const;
-	IndexType getIndex(IndexType index) const;
+	IndexType getIndex(size_t index) const;
 	const IndexType* getRawIndexData() const;
 
+	/**
+	 * @brief The ranges the indices are split into - there is only one range with base vertex @c 0 for meshes that
+	 * don't reference more than @c MaxRangeVertices vertices
+	 */
+	const IndexRangeArray& getIndexRanges() const;
+	/**
+	 * @brief Adds the base vertex of their range to all indices
+	 */
+	void resolveIndices(VertexIndexArray& indices) const;
+
 	const IndexArray& getIndexVector() const;
 	const VertexArray& getVertexVector() const;
 	IndexArray& getIndexVector();
@@ -47,11 +66,19 @@ public:
 	const glm::ivec3& getOffset() const;
 	void setOffset(const glm::ivec3& offset);
 
-	IndexType addVertex(const VoxelVertex& vertex);
-	void addTriangle(IndexType index0, IndexType index1, IndexType index2);
+	uint32_t addVertex(const VoxelVertex& vertex);
+	/**
+	 * @param index0 The vertex index - not relative to any range
+	 * @note If the vertex indices exceed the 16 bit indices, the indices are only split into ranges
+	 * in @c removeUnusedVertices() - this has to be called before the indices can be used.
+	 */
+	void addTriangle(uint32_t index0, uint32_t index1, uint32_t index2);
 
 	void clear();
 	bool isEmpty() const;
+	/**
+	 * @brief Removes the vertices that are not referenced and splits the indices into ranges if needed
+	 */
 	void removeUnusedVertices();
 	void compressIndices();
 
@@ -60,8 +87,16 @@ public:
 
 	bool operator<(const Mesh& rhs) const;
 private:
+	void splitIndices();
+
 	alignas(16) IndexArray _vecIndices;
 	alignas(16) VertexArray _vecVertices;
+	IndexRangeArray _ranges;
+	/**
+	 * The vertex indices of the triangles as long as the mesh references more vertices than the 16 bit
+	 * indices can address
+	 */
+	VertexIndexArray _wideIndices;
 	uint8_t *_compressedIndices = nullptr;
 	size_t _compressedIndexSize = 0u;
 	glm::ivec3 _offset { 0 };
@@ -6,6 +6,7 @@
 #include "Morton.h"
 #include "core/Log.h"
 #include "core/Common.h"
+#include "core/StandardLib.h"
 #include "core/Trace.h"
 #include "math/Functions.h"
 #define GLM_ENABLE_EXPERIMENTAL
@@ -21,9 +22,11 @@ namespace voxel {
  * @param targetMemoryUsageInBytes The upper limit to how much memory this PagedVolume should aim to use.
  * @param chunkSideLength The size of the chunks making up the volume. Small chunks will compress/decompress faster, but there will also be
  * more of them meaning voxel access could be slower.
+ * @param chunkStorage Palette packed chunks need less memory but the samplers have to work on decoded copies of them.
  */
-PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16_t chunkSideLength) :
-		_chunkSideLength(chunkSideLength), _pager(pager), _region(0, 0, 0, -1, -1, -1) {
+PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16_t chunkSideLength, ChunkStorage chunkStorage) :
+		_chunkStorage(chunkStorage), _compressedChunks(targetMemoryUsageInBytes / 100u * CompressedMemoryPercent), _chunkSideLength(chunkSideLength),
+		_pager(pager), _region(0, 0, 0, -1, -1, -1) {
 	// Validation of parameters
 	core_assert_msg(_pager, "You must provide a valid pager when constructing a PagedVolume");
 	core_assert_msg(targetMemoryUsageInBytes >= 1 * 1024 * 1024, "Target memory usage is too small to be practical");
@@ -36,9 +39,17 @@ PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16
 	// Use to perform modulo by bit operations
 	_chunkMask = _chunkSideLength - 1;
 
-	// Calculate the number of chunks based on the memory limit and the size of each chunk.
+	// Calculate the number of chunks based on the memory limit and the size of each chunk. The
+	// remaining memory is used to keep evicted chunks in compressed form and the decoded copies
+	// of packed chunks.
 	uint32_t chunkSizeInBytes = PagedVolume::Chunk::calculateSizeInBytes(_chunkSideLength);
-	_chunkCountLimit = targetMemoryUsageInBytes / chunkSizeInBytes;
+	uint32_t chunkMemory = targetMemoryUsageInBytes - (uint32_t)_compressedChunks.memoryLimit();
+	if (_chunkStorage == ChunkStorage::Palette) {
+		const uint32_t decodedMemory = targetMemoryUsageInBytes / 100u * DecodedMemoryPercent;
+		_decodedChunkLimit = core_max(MinDecodedChunkCount, core_min(DecodedChunkCount, decodedMemory / chunkSizeInBytes));
+		chunkMemory -= core_min(chunkMemory, _decodedChunkLimit * chunkSizeInBytes);
+	}
+	_chunkCountLimit = chunkMemory / chunkSizeInBytes;
 
 	// Enforce sensible limits on the number of chunks.
 	const uint32_t minPracticalNoOfChunks = 32; // Enough to make sure a chunks and it's neighbours can be loaded, with a few to spare.
@@ -49,8 +60,11 @@ PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16
 	_chunkCountLimit = core_max(_chunkCountLimit, minPracticalNoOfChunks);
 
 	// Inform the user about the chosen memory configuration.
-	Log::info("Memory usage limit for volume now set to %uMb (%u chunks of %uKb each).",
-			(_chunkCountLimit * chunkSizeInBytes) / (1024 * 1024), _chunkCountLimit, chunkSizeInBytes / 1024);
+	Log::info("Memory usage limit for volume now set to %uMb (%u chunks of %uKb each), %uMb for compressed chunks and %u decoded chunks.",
+			(_chunkCountLimit * chunkSizeInBytes) / (1024 * 1024), _chunkCountLimit, chunkSizeInBytes / 1024,
+			(uint32_t)(_compressedChunks.memoryLimit() / (1024 * 1024)), _decodedChunkLimit);
+
+	_pageOutThread.init();
 }
 
 /**
@@ -59,6 +73,7 @@ PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16
  */
 PagedVolume::~PagedVolume() {
 	flushAll();
+	_pageOutThread.shutdown(true);
 }
 
 /**
@@ -169,41 +184,192 @@ void PagedVolume::setVoxels(int32_t uXPos, int32_t uYPos, int32_t uZPos, int nx,
  * Removes all voxels from memory by removing all chunks. The application has the chance to persist the data via @c Pager::pageOut
  */
 void PagedVolume::flushAll() {
-	core::ScopedWriteLock writeLock(_volumeLock);
-	_chunks.clear();
+	waitForEviction();
+	for (uint32_t i = 0u; i < ChunkShardCount; ++i) {
+		ChunkShard& shard = _shards[i];
+		core::ScopedWriteLock writeLock(shard.lock);
+		_chunkCount.decrement((int)shard.chunks.size());
+		shard.chunks.clear();
+	}
+	{
+		core::ScopedLock lock(_clockLock);
+		_clock.clear();
+		_clockHand = 0u;
+	}
+	// the chunks are paged out when the last reference is gone - don't do this while holding the lock
+	ChunkMap pendingPageOuts;
+	{
+		core::ScopedLock lock(_pageOutLock);
+		pendingPageOuts = core::move(_pendingPageOuts);
+	}
+	_compressedChunks.clear();
+	core::ScopedLock lock(_decodeLock);
+	for (uint32_t i = 0u; i < DecodedChunkCount; ++i) {
+		_decodedChunks[i] = ChunkPtr();
+	}
+}
+
+void PagedVolume::waitForEviction() {
+	std::shared_future<void> eviction;
+	{
+		core::ScopedLock lock(_evictionLock);
+		eviction = _eviction;
+	}
+	if (eviction.valid()) {
+		eviction.wait();
+	}
+}
+
+PagedVolume::Metrics PagedVolume::metrics() const {
+	Metrics metrics;
+	metrics.chunks = _chunkCount;
+	{
+		core::ScopedLock lock(_pageOutLock);
+		metrics.pendingPageOuts = (int)_pendingPageOuts.size();
+	}
+	metrics.pagedIn = _pagedIn;
+	metrics.evicted = _evicted;
+	metrics.pagedOut = _pagedOut;
+	metrics.reclaimed = _reclaimed;
+	const CompressedChunkCache::Stats& stats = _compressedChunks.stats();
+	metrics.compressedChunks = stats.entries;
+	metrics.compressedMemoryKb = (int)(stats.memoryUsage / 1024u);
+	metrics.compressedHits = stats.hits;
+	metrics.compressedMisses = stats.misses;
+	core::ScopedLock lock(_decodeLock);
+	for (uint32_t i = 0u; i < _decodedChunkLimit; ++i) {
+		if (_decodedChunks[i]) {
+			++metrics.decodedChunks;
+		}
+	}
+	return metrics;
+}
+
+PagedVolume::ChunkShard& PagedVolume::chunkShard(const glm::ivec3& pos) const {
+	// the chunk map buckets are using the glm hash - use a different one here to not
+	// end up with only a few of the buckets being used in each shard.
+	const uint32_t hash = (uint32_t)pos.x * 73856093u ^ (uint32_t)pos.y * 19349663u ^ (uint32_t)pos.z * 83492791u;
+	return _shards[(hash >> 16) % ChunkShardCount];
+}
+
+void PagedVolume::track(const ChunkPtr& chunk) const {
+	core::ScopedLock lock(_clockLock);
+	_clock.push_back(chunk);
+}
+
+void PagedVolume::scheduleEviction() const {
+	if ((uint32_t)_chunkCount <= _chunkCountLimit) {
+		return;
+	}
+	core::ScopedLock lock(_evictionLock);
+	if (_evictionRunning) {
+		// the running eviction checks the chunk count again before it finishes
+		return;
+	}
+	_evictionRunning = true;
+	_eviction = _pageOutThread.enqueue([this] () {
+		for (;;) {
+			const bool stuck = !evictChunks();
+			core::ScopedLock lock(_evictionLock);
+			// if all chunks are still loading, the next new chunk will schedule the eviction again
+			if (stuck || (uint32_t)_chunkCount <= _chunkCountLimit) {
+				_evictionRunning = false;
+				break;
+			}
+		}
+	}).share();
 }
 
 /**
- * As we have added a chunk we may have exceeded our target chunk limit. Search through the array to
- * determine how many chunks we have, as well as finding the oldest timestamp. Note that this is potentially
- * wasteful and we may instead wish to track how many chunks we have and/or delete a chunk at random (or
- * just check e.g. 10 and delete the oldest of those) but we'll see if this is a bottleneck first. Paging
- * the data in is probably more expensive.
+ * The clock hand moves over all tracked chunks. A chunk that was accessed since the hand passed it the last
+ * time gets a second chance and the hand moves on. Each accessed chunk costs one step - thus finding a victim
+ * is done in amortized constant time, while the accessing threads only have to set a flag.
  */
-void PagedVolume::deleteOldestChunkIfNeeded() const {
-	core_trace_scoped(DeleteOldestChunk);
-	ChunkMap::iterator oldestChunk = _chunks.end();
-	uint32_t oldestChunkTimestamp = _timestamper;
-	for (ChunkMap::iterator i = _chunks.begin(); i != _chunks.end(); ++i) {
-		const ChunkPtr& chunk = i->second;
-		if (chunk->_chunkLastAccessed < oldestChunkTimestamp) {
-			oldestChunkTimestamp = chunk->_chunkLastAccessed;
-			oldestChunk = i;
+PagedVolume::ChunkPtr PagedVolume::nextVictim() const {
+	core::ScopedLock lock(_clockLock);
+	// after two turns of the clock hand all flags are cleared - only chunks that are still loading are left
+	const size_t maxSteps = _clock.size() * 2u;
+	for (size_t i = 0u; i < maxSteps; ++i) {
+		if (_clockHand >= _clock.size()) {
+			_clockHand = 0u;
 		}
+		ChunkPtr& chunk = _clock[_clockHand];
+		if (!chunk->_loaded) {
+			++_clockHand;
+			continue;
+		}
+		if (chunk->_referenced) {
+			chunk->_referenced = false;
+			++_clockHand;
+			continue;
+		}
+		const ChunkPtr victim = chunk;
+		// the order of the ring doesn't matter - fill the gap with the last entry
+		if (_clockHand != _clock.size() - 1u) {
+			chunk = core::move(_clock.back());
+		}
+		_clock.pop();
+		return victim;
 	}
-	if (oldestChunk != _chunks.end()) {
-		Log::debug("delete oldest chunk - reached %u", _chunkCountLimit);
-		_chunks.erase(oldestChunk);
+	return ChunkPtr();
+}
+
+bool PagedVolume::evictChunks() const {
+	core_trace_scoped(EvictChunks);
+	while ((uint32_t)_chunkCount > _chunkCountLimit) {
+		const ChunkPtr victim = nextVictim();
+		if (!victim) {
+			return false;
+		}
+		const glm::ivec3& pos = victim->chunkPos();
+		ChunkShard& shard = chunkShard(pos);
+		{
+			core::ScopedWriteLock writeLock(shard.lock);
+			ChunkPtr current;
+			if (!shard.chunks.get(pos, current) || current != victim) {
+				// already flushed
+				continue;
+			}
+			shard.chunks.remove(pos);
+			// still holding the shard lock - a concurrent request for this chunk must find it in one of the maps
+			core::ScopedLock lock(_pageOutLock);
+			_pendingPageOuts.put(pos, victim);
+		}
+		_chunkCount.decrement(1);
+		_evicted.increment(1);
+		Log::debug("evicted chunk at %i:%i:%i - reached %u", pos.x, pos.y, pos.z, _chunkCountLimit);
+		if (victim->pageOut()) {
+			_pagedOut.increment(1);
+		}
+		victim->dropDecoded();
+		uint32_t compressedSize = 0u;
+		uint8_t* compressed;
+		if (victim->isPacked()) {
+			// don't unpack the chunk - a reclaimed chunk should stay packed
+			Voxel* voxels = (Voxel*)core_malloc(victim->dataSizeInBytes());
+			victim->fillVoxels(voxels);
+			compressed = CompressedChunkCache::compress(voxels, victim->dataSizeInBytes(), compressedSize);
+			core_free(voxels);
+		} else {
+			compressed = CompressedChunkCache::compress(victim->data(), victim->dataSizeInBytes(), compressedSize);
+		}
+		core::ScopedLock lock(_pageOutLock);
+		ChunkPtr pending;
+		if (_pendingPageOuts.get(pos, pending) && pending == victim) {
+			// not reclaimed in the meantime - the compressed data is the current state of the chunk
+			_compressedChunks.put(pos, compressed, compressedSize);
+			_pendingPageOuts.remove(pos);
+		} else {
+			core_free(compressed);
+		}
 	}
+	return true;
 }
 
-PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
+void PagedVolume::pageIn(const ChunkPtr& chunk) const {
 	core_trace_scoped(CreateNewChunk);
-	// The chunk was not found so we will create a new one.
-	glm::ivec3 pos(chunkX, chunkY, chunkZ);
-	Log::debug("create new chunk at %i:%i:%i", chunkX, chunkY, chunkZ);
-	ChunkPtr chunk = core::make_shared<Chunk>(pos, _chunkSideLength, _pager);
-	chunk->_chunkLastAccessed = ++_timestamper; // Important, as we may soon delete the oldest chunk
+	const glm::ivec3& pos = chunk->chunkPos();
+	Log::debug("create new chunk at %i:%i:%i", pos.x, pos.y, pos.z);
 
 	// Pass the chunk to the Pager to give it a chance to initialise it with any data
 	// From the coordinates of the chunk we deduce the coordinates of the contained voxels.
@@ -213,30 +379,91 @@ PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY
 	pctx.region = Region(mins, maxs);
 	pctx.chunk = chunk;
 
-	// Page the data in
-	// We'll use this later to decide if data needs to be paged out again.
-	chunk->_dataModified = _pager->pageIn(pctx);
-	Log::debug("finished creating new chunk at %i:%i:%i", chunkX, chunkY, chunkZ);
+	if (_compressedChunks.take(pos, chunk->data(), chunk->dataSizeInBytes())) {
+		// the chunk was already paged out before it was compressed
+		chunk->_dataModified = false;
+	} else {
+		// Page the data in
+		// We'll use this later to decide if data needs to be paged out again.
+		chunk->_dataModified = _pager->pageIn(pctx);
+		_pagedIn.increment(1);
+	}
+	if (_chunkStorage == ChunkStorage::Palette) {
+		chunk->compact();
+	}
+	chunk->markLoaded();
+	Log::debug("finished creating new chunk at %i:%i:%i", pos.x, pos.y, pos.z);
+}
 
-	return chunk;
+PagedVolume::DecodedVoxelsPtr PagedVolume::decode(const ChunkPtr& chunk) const {
+	bool created = false;
+	const DecodedVoxelsPtr& decoded = chunk->decode(created);
+	if (!created) {
+		return decoded;
+	}
+	// the decoded copy of the chunk that was put into the ring first is released - samplers
+	// that are still using it are keeping it alive
+	ChunkPtr oldest;
+	{
+		core::ScopedLock lock(_decodeLock);
+		oldest = core::move(_decodedChunks[_decodedChunkIndex]);
+		_decodedChunks[_decodedChunkIndex] = chunk;
+		_decodedChunkIndex = (_decodedChunkIndex + 1u) % _decodedChunkLimit;
+	}
+	if (oldest) {
+		oldest->dropDecoded();
+	}
+	return decoded;
 }
 
 PagedVolume::ChunkPtr PagedVolume::chunk(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
 	core_trace_scoped(PagedVolumeChunk);
-	core::ScopedWriteLock chunkWriteLock(_volumeLock);
 	const glm::ivec3 pos(chunkX, chunkY, chunkZ);
-	auto i = _chunks.find(pos);
-	if (i == _chunks.end()) {
-		const ChunkPtr& chunk = createNewChunk(chunkX, chunkY, chunkZ);
-		_chunks.put(pos, chunk);
-		const size_t chunkCount = _chunks.size();
-		if (chunkCount >= _chunkCountLimit) {
-			deleteOldestChunkIfNeeded();
+	ChunkShard& shard = chunkShard(pos);
+	ChunkPtr chunk;
+	{
+		core::ScopedReadLock readLock(shard.lock);
+		shard.chunks.get(pos, chunk);
+	}
+	if (!chunk) {
+		// The chunk was not found so we will create a new one - the allocation is done without
+		// holding the lock. If another thread was faster, we just throw it away again.
+		ChunkPtr newChunk = core::make_shared<Chunk>(pos, _chunkSideLength, _pager);
+		bool reclaimed = false;
+		{
+			core::ScopedWriteLock writeLock(shard.lock);
+			if (!shard.chunks.get(pos, chunk)) {
+				{
+					core::ScopedLock lock(_pageOutLock);
+					reclaimed = _pendingPageOuts.get(pos, chunk);
+					if (reclaimed) {
+						_pendingPageOuts.remove(pos);
+					}
+				}
+				if (!reclaimed) {
+					newChunk->_loadingThread = core::getThreadId();
+					chunk = newChunk;
+				}
+				chunk->_referenced = true;
+				shard.chunks.put(pos, chunk);
+			}
 		}
-		return chunk;
+		if (reclaimed || chunk == newChunk) {
+			track(chunk);
+			_chunkCount.increment(1);
+			if (reclaimed) {
+				_reclaimed.increment(1);
+			} else {
+				pageIn(chunk);
+			}
+			scheduleEviction();
+			return chunk;
+		}
+	}
+	if (!chunk->_referenced) {
+		chunk->_referenced = true;
 	}
-	const ChunkPtr& chunk = i->second;
-	chunk->_chunkLastAccessed = ++_timestamper;
+	chunk->waitUntilLoaded();
 	return chunk;
 }
 
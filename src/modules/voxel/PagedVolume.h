@@ -6,13 +6,20 @@
 
 #include "Voxel.h"
 #include "Region.h"
+#include "CompressedChunkCache.h"
 #include "core/NonCopyable.h"
 #include "core/GLM.h"
 #include "core/Assert.h"
 #include "core/concurrent/ReadWriteLock.h"
 #include "core/concurrent/Atomic.h"
-#include "core/collection/Map.h"
+#include "core/concurrent/Lock.h"
+#include "core/concurrent/ConditionVariable.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/Trace.h"
+#include "core/collection/DynamicMap.h"
+#include "core/collection/DynamicArray.h"
 #include "core/SharedPtr.h"
+#include <atomic>
 
 namespace voxel {
 
@@ -37,6 +44,43 @@ public:
 	/// The Pager class is responsible for the loading and unloading of Chunks, and can be subclassed by the user.
 	class Pager;
 
+	/**
+	 * @brief How the voxels of a loaded chunk are kept in memory
+	 */
+	enum class ChunkStorage {
+		/** @brief @c sideLength^3 voxels */
+		Raw,
+		/**
+		 * @brief The distinct voxels of a chunk are put into a palette and each voxel only stores
+		 * the bit packed index into this palette. Chunks with more than 256 distinct voxels stay raw.
+		 */
+		Palette
+	};
+
+	/**
+	 * @brief Read-only copy of the voxels of a palette packed chunk
+	 */
+	struct DecodedVoxels {
+		Voxel* voxels = nullptr;
+		~DecodedVoxels();
+	};
+	typedef core::SharedPtr<DecodedVoxels> DecodedVoxelsPtr;
+
+	/**
+	 * @brief Summary of one x/z column of a chunk. The heights are relative to the chunk.
+	 * This allows to answer floor queries without walking the voxels of the column.
+	 */
+	struct ColumnSummary {
+		/** @brief The highest voxel that is not enterable or @c -1 if there is none */
+		int16_t highestSolid = -1;
+		/** @brief The lowest enterable voxel or @c -1 if the column is completely solid */
+		int16_t firstWalkable = 0;
+		/** @brief The highest water voxel or @c -1 if there is none */
+		int16_t waterLevel = -1;
+		Voxel solid;
+		Voxel walkable;
+	};
+
 	class Chunk {
 		friend class PagedVolume;
 		friend class PagedVolumeWrapper;
@@ -58,16 +102,108 @@ public:
 		void setVoxels(uint32_t x, uint32_t y, uint32_t z, const Voxel* values, int amount);
 		void setVoxel(const glm::i16vec3& pos, const Voxel& value);
 
+		/**
+		 * @return The summary of the given column - the coordinates are relative to the chunk
+		 * @note The summary of all columns is built by the first call and then kept up to date by the modifications.
+		 * This keeps the scan of the whole chunk out of the page-in of chunks that never see a floor query - but the
+		 * first query of a chunk pays for it.
+		 */
+		const ColumnSummary& column(uint32_t x, uint32_t z) const;
+
 		const glm::ivec3& chunkPos() const;
 		int16_t sideLength() const;
 
+		/**
+		 * @brief Puts the voxels into a palette and only keeps the bit packed palette indices
+		 * @note The chunk must not be accessed by other threads while it is compacted.
+		 * @return @c false if the chunk has too many distinct voxels and stays raw
+		 */
+		bool compact();
+		bool isPacked() const;
+		/**
+		 * @return The amount of bytes that are used for the voxels of this chunk
+		 */
+		uint32_t memoryUsage() const;
+
 	private:
-		// This is updated by the PagedVolume and used to discard the least recently used chunks.
-		uint32_t _chunkLastAccessed = 0u;
+		// Set by the PagedVolume on each access and cleared again by the clock hand of the eviction.
+		// Chunks that were not accessed since the clock hand passed them the last time are discarded.
+		core::AtomicBool _referenced { true };
+
+		/**
+		 * @brief Hands the chunk data to the pager if it was modified since it was paged in
+		 * @return @c true if the pager was called
+		 */
+		bool pageOut();
+
+		/**
+		 * @brief Blocks until the pager has filled this chunk. Chunks are published in the
+		 * chunk map before they are paged in to allow other threads to wait for the data of
+		 * exactly this chunk instead of blocking the whole volume.
+		 */
+		void waitUntilLoaded() const;
+		void markLoaded();
+
+		core::AtomicBool _loaded { false };
+		// the thread that is paging in the chunk - the pager is allowed to access the chunk
+		// while it is still loading
+		size_t _loadingThread = 0u;
+		mutable core_trace_mutex(core::Lock, _loadLock, "PagedVolumeChunkLoad");
+		mutable core::ConditionVariable _loadCondition;
 
 		static uint32_t calculateSizeInBytes(uint32_t sideLength);
 
-		Voxel* _data = nullptr;
+		uint32_t paletteIndex(uint32_t index) const;
+		void fillVoxels(Voxel* voxels) const;
+		/**
+		 * @brief Makes the raw voxels the valid representation of the chunk again - this is needed
+		 * for every modification. The palette stays alive until the chunk is compacted again or
+		 * destroyed to not pull it away under concurrent readers.
+		 */
+		void unpack() const;
+		/**
+		 * @brief Returns the cached decoded copy of the packed voxels - or an invalid pointer if
+		 * the chunk is not packed (anymore).
+		 * @param[out] created @c true if the copy was created by this call
+		 */
+		DecodedVoxelsPtr decode(bool& created) const;
+		void dropDecoded() const;
+
+		/**
+		 * @brief Builds the summary of all columns from the voxels if it doesn't exist yet
+		 */
+		ColumnSummary* columns() const;
+		/**
+		 * @return The summary of all columns or @c nullptr if it wasn't built yet. Waits for a build that is
+		 * in progress - a modification must not be missed by the build and the incremental update.
+		 */
+		ColumnSummary* builtColumns() const;
+		/**
+		 * @brief Rebuilds the summary of all columns from the voxels if it exists
+		 */
+		void updateColumns();
+		ColumnSummary summarizeColumn(uint32_t x, uint32_t z) const;
+		void updateColumn(uint32_t x, uint32_t z);
+		/**
+		 * @brief Keeps the column summary up to date for a single modified voxel - the column is
+		 * only scanned again if the voxel was the highest solid, the lowest enterable or the
+		 * highest water voxel of the column.
+		 */
+		void updateColumn(uint32_t x, uint32_t y, uint32_t z, const Voxel& value);
+
+		// one entry per x/z column - null until the first floor query hits this chunk. The summary is published
+		// with a release store to allow the lock free readers to see the filled columns.
+		mutable std::atomic<ColumnSummary*> _columns { nullptr };
+		mutable core_trace_mutex(core::Lock, _columnsLock, "PagedVolumeChunkColumns");
+		// null if the chunk is packed - the buffer is published by unpack() with a release store, so the
+		// lock free readers must load it with acquire semantics to see the filled voxels
+		mutable std::atomic<Voxel*> _data { nullptr };
+		Voxel* _palette = nullptr;
+		uint32_t* _indices = nullptr;
+		uint16_t _paletteSize = 0u;
+		uint8_t _bitsPerIndex = 0u;
+		mutable DecodedVoxelsPtr _decoded core_thread_guarded_by(_storageLock);
+		mutable core_trace_mutex(core::Lock, _storageLock, "PagedVolumeChunkStorage");
 		uint16_t _sideLength = 0u;
 
 		// This is so we can tell whether a uncompressed chunk has to be recompressed and whether
@@ -198,9 +334,17 @@ public:
 		int32_t _yPosInVolume = 0;
 		int32_t _zPosInVolume = 0;
 
+		/**
+		 * @brief Points the current voxel into the data of the current chunk - or into the decoded
+		 * copy of it if the chunk is packed
+		 */
+		void updateCurrentVoxel(uint32_t voxelIndexInChunk);
+
 		//Other current position information
 		Voxel* _currentVoxel = nullptr;
 		ChunkPtr _currentChunk;
+		// keeps the decoded voxels of a packed current chunk alive
+		DecodedVoxelsPtr _currentDecoded;
 		mutable ChunkPtr _cachedChunk;
 
 		uint32_t _xPosInChunk = 0u;
@@ -216,7 +360,7 @@ public:
 
 public:
 	/** @brief Constructor for creating a fixed size volume. */
-	PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes = 256 * 1024 * 1024, uint16_t chunkSideLength = 32);
+	PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes = 256 * 1024 * 1024, uint16_t chunkSideLength = 32, ChunkStorage chunkStorage = ChunkStorage::Raw);
 	~PagedVolume();
 
 	/** @brief Gets a voxel at the position given by <tt>x,y,z</tt> coordinates */
@@ -237,6 +381,39 @@ public:
 	/** @brief Removes all voxels from memory */
 	void flushAll();
 
+	/**
+	 * @brief Blocks until the currently scheduled eviction and the page out of the evicted chunks is done
+	 */
+	void waitForEviction();
+
+	/**
+	 * @brief Counters about the paging of the volume. Except for @c chunks and @c pendingPageOuts the
+	 * values are accumulated over the lifetime of the volume.
+	 */
+	struct Metrics {
+		int chunks = 0;
+		int pendingPageOuts = 0;
+		int pagedIn = 0;
+		int evicted = 0;
+		int pagedOut = 0;
+		/**
+		 * @brief Chunks that were requested again while they were waiting to get paged out
+		 */
+		int reclaimed = 0;
+		int compressedChunks = 0;
+		int compressedMemoryKb = 0;
+		/**
+		 * @brief Chunks that were inflated from the compressed chunk cache instead of asking the pager
+		 */
+		int compressedHits = 0;
+		int compressedMisses = 0;
+		/**
+		 * @brief Decoded copies of palette packed chunks that are kept alive for the samplers
+		 */
+		int decodedChunks = 0;
+	};
+	Metrics metrics() const;
+
 	ChunkPtr chunk(const glm::ivec3& pos) const;
 
 	glm::ivec3 chunkPos(int x, int y, int z) const;
@@ -257,16 +434,96 @@ protected:
 	PagedVolume& operator=(const PagedVolume& rhs);
 
 private:
+	typedef core::DynamicMap<glm::ivec3, ChunkPtr, 64, glm::hash<glm::ivec3>> ChunkMap;
+
+	/**
+	 * @brief The chunks are distributed over several shards with their own lock each. Looking up a
+	 * loaded chunk only needs a shared lock on one shard, and pager calls are never done with a lock held.
+	 */
+	struct ChunkShard {
+		ChunkMap chunks core_thread_guarded_by(lock);
+		core::SharedReadWriteLock lock{"pagedvolumeshard"};
+	};
+	static constexpr uint32_t ChunkShardCount = 16u;
+
+	ChunkShard& chunkShard(const glm::ivec3& pos) const;
 	ChunkPtr chunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
-	ChunkPtr createNewChunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
-	void deleteOldestChunkIfNeeded() const;
+	void pageIn(const ChunkPtr& chunk) const;
+	/**
+	 * @brief The decode cache for the samplers - the decoded copies of the last @c _decodedChunkLimit
+	 * packed chunks that were sampled are kept alive.
+	 */
+	DecodedVoxelsPtr decode(const ChunkPtr& chunk) const;
+	/**
+	 * @brief Puts the chunk under the control of the clock hand
+	 */
+	void track(const ChunkPtr& chunk) const;
+	/**
+	 * @brief Schedules the eviction on the page out thread if the chunk limit was reached
+	 */
+	void scheduleEviction() const;
+	/**
+	 * @brief Runs on the page out thread and evicts chunks until we are below the limit again
+	 * @return @c false if no chunk could get evicted
+	 */
+	bool evictChunks() const;
+	/**
+	 * @brief Picks the next chunk that wasn't accessed since the last turn of the clock hand
+	 */
+	ChunkPtr nextVictim() const;
 
-	mutable int32_t _timestamper = 0;
+	mutable core::AtomicInt _chunkCount { 0 };
 
 	uint32_t _chunkCountLimit = 0u;
 
-	typedef core::Map<glm::ivec3, ChunkPtr, 64, glm::hash<glm::ivec3>> ChunkMap;
-	mutable ChunkMap _chunks core_thread_guarded_by(_volumeLock);
+	mutable ChunkShard _shards[ChunkShardCount];
+
+	/**
+	 * @brief All tracked chunks - the eviction uses the clock (second chance) algorithm on this ring
+	 * to find a victim in amortized constant time.
+	 */
+	mutable core::DynamicArray<ChunkPtr> _clock core_thread_guarded_by(_clockLock);
+	mutable size_t _clockHand core_thread_guarded_by(_clockLock) = 0u;
+	mutable core_trace_mutex(core::Lock, _clockLock, "PagedVolumeClock");
+
+	/**
+	 * @brief Evicted chunks that are not yet handed over to the pager. If such a chunk is requested
+	 * again, it is moved back into the chunk map - paging it in again would load outdated data.
+	 */
+	mutable ChunkMap _pendingPageOuts core_thread_guarded_by(_pageOutLock);
+	mutable core_trace_mutex(core::Lock, _pageOutLock, "PagedVolumePageOut");
+
+	mutable std::shared_future<void> _eviction core_thread_guarded_by(_evictionLock);
+	mutable bool _evictionRunning core_thread_guarded_by(_evictionLock) = false;
+	mutable core_trace_mutex(core::Lock, _evictionLock, "PagedVolumeEviction");
+	mutable core::ThreadPool _pageOutThread { 1, "PageOut" };
+
+	/**
+	 * @brief The percentage of the target memory usage that is used to keep evicted chunks in compressed form
+	 */
+	static constexpr uint32_t CompressedMemoryPercent = 25u;
+	/**
+	 * @brief The percentage of the target memory usage that is used for the decoded copies of palette packed chunks
+	 */
+	static constexpr uint32_t DecodedMemoryPercent = 10u;
+	/**
+	 * @brief A sampler close to the corner of a chunk column walks over four chunks - less decoded copies
+	 * would decode the same chunks over and over again
+	 */
+	static constexpr uint32_t MinDecodedChunkCount = 4u;
+	static constexpr uint32_t DecodedChunkCount = 16u;
+	// the decoded copies are counted against the memory limit of palette volumes
+	uint32_t _decodedChunkLimit = 1u;
+	mutable ChunkPtr _decodedChunks[DecodedChunkCount] core_thread_guarded_by(_decodeLock);
+	mutable uint32_t _decodedChunkIndex core_thread_guarded_by(_decodeLock) = 0u;
+	mutable core_trace_mutex(core::Lock, _decodeLock, "PagedVolumeDecode");
+	const ChunkStorage _chunkStorage;
+	mutable CompressedChunkCache _compressedChunks;
+
+	mutable core::AtomicInt _pagedIn { 0 };
+	mutable core::AtomicInt _evicted { 0 };
+	mutable core::AtomicInt _pagedOut { 0 };
+	mutable core::AtomicInt _reclaimed { 0 };
 
 	// The size of the chunks
 	uint16_t _chunkSideLength;
@@ -276,8 +533,6 @@ private:
 	Pager* _pager = nullptr;
 
 	Region _region;
-
-	mutable core::ReadWriteLock _volumeLock{"pagedvolume"};
 };
 
 inline const Voxel& PagedVolume::Sampler::voxel() const {
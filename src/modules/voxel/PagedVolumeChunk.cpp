@@ -5,8 +5,12 @@
 #include "PagedVolume.h"
 #include "Morton.h"
 #include "math/Functions.h"
+#include "core/ArrayLength.h"
 #include "core/Common.h"
 #include "core/StandardLib.h"
+#include "core/Trace.h"
+#include "core/concurrent/Concurrency.h"
+#include <atomic>
 
 namespace voxel {
 
@@ -21,30 +25,174 @@ PagedVolume::Chunk::Chunk(const glm::ivec3& pos, uint16_t sideLength, Pager* pag
 
 	// Allocate the data
 	const uint32_t uNoOfVoxels = _sideLength * _sideLength * _sideLength;
-	_data = (Voxel*)core_malloc(uNoOfVoxels * sizeof(Voxel));
-	core_memset(_data, 0, uNoOfVoxels * sizeof(Voxel));
+	Voxel* data = (Voxel*)core_malloc(uNoOfVoxels * sizeof(Voxel));
+	core_memset(data, 0, uNoOfVoxels * sizeof(Voxel));
+	_data.store(data, std::memory_order_relaxed);
 }
 
 PagedVolume::Chunk::~Chunk() {
-	if (_dataModified && _pager) {
-		_pager->pageOut(this);
-	}
+	pageOut();
+
+	core_free(_data.load(std::memory_order_relaxed));
+	_data.store(nullptr, std::memory_order_relaxed);
+	core_free(_palette);
+	_palette = nullptr;
+	core_free(_indices);
+	_indices = nullptr;
+	core_free(_columns.load(std::memory_order_relaxed));
+	_columns.store(nullptr, std::memory_order_relaxed);
+}
 
-	core_free(_data);
-	_data = nullptr;
+PagedVolume::DecodedVoxels::~DecodedVoxels() {
+	core_free(voxels);
 }
 
 bool PagedVolume::Chunk::setData(const Voxel* voxels, size_t sizeInBytes) {
 	if (sizeInBytes != dataSizeInBytes()) {
 		return false;
 	}
+	unpack();
 	_dataModified = true;
-	core_memcpy((uint8_t*)_data, (const uint8_t*)voxels, sizeInBytes);
+	core_memcpy((uint8_t*)_data.load(std::memory_order_acquire), (const uint8_t*)voxels, sizeInBytes);
+	updateColumns();
 	return true;
 }
 
 Voxel* PagedVolume::Chunk::data() const {
-	return _data;
+	unpack();
+	return _data.load(std::memory_order_acquire);
+}
+
+bool PagedVolume::Chunk::compact() {
+	core_trace_scoped(CompactChunk);
+	const Voxel* data = _data.load(std::memory_order_acquire);
+	if (data == nullptr) {
+		return true;
+	}
+	const uint32_t n = voxels();
+	// maps the material and color of a voxel to the palette index + 1
+	uint16_t* lookup = (uint16_t*)core_malloc(65536 * sizeof(uint16_t));
+	core_memset(lookup, 0, 65536 * sizeof(uint16_t));
+	Voxel palette[256];
+	uint32_t paletteSize = 0u;
+	for (uint32_t i = 0u; i < n; ++i) {
+		const Voxel& v = data[i];
+		const uint16_t key = (uint16_t)((uint16_t)v.getMaterial() << 8 | v.getColor());
+		if (lookup[key] != 0u) {
+			continue;
+		}
+		if (paletteSize >= (uint32_t)lengthof(palette)) {
+			core_free(lookup);
+			return false;
+		}
+		palette[paletteSize++] = v;
+		lookup[key] = (uint16_t)paletteSize;
+	}
+
+	uint8_t bits = 0u;
+	while ((1u << bits) < paletteSize) {
+		// keep the indices aligned to the 32 bit words - no index is spread over two words
+		bits = bits == 0u ? 1u : bits * 2u;
+	}
+	uint32_t* indices = nullptr;
+	if (bits > 0u) {
+		const uint32_t words = (n * bits + 31u) / 32u;
+		indices = (uint32_t*)core_malloc(words * sizeof(uint32_t));
+		core_memset(indices, 0, words * sizeof(uint32_t));
+		for (uint32_t i = 0u; i < n; ++i) {
+			const Voxel& v = data[i];
+			const uint32_t paletteIdx = lookup[(uint16_t)v.getMaterial() << 8 | v.getColor()] - 1u;
+			const uint32_t bit = i * bits;
+			indices[bit >> 5] |= paletteIdx << (bit & 31u);
+		}
+	}
+	core_free(lookup);
+
+	core_free(_palette);
+	core_free(_indices);
+	_palette = (Voxel*)core_malloc(paletteSize * sizeof(Voxel));
+	core_memcpy((uint8_t*)_palette, (const uint8_t*)palette, paletteSize * sizeof(Voxel));
+	_paletteSize = (uint16_t)paletteSize;
+	_indices = indices;
+	_bitsPerIndex = bits;
+	_data.store(nullptr, std::memory_order_release);
+	core_free((void*)data);
+	dropDecoded();
+	return true;
+}
+
+bool PagedVolume::Chunk::isPacked() const {
+	return _data.load(std::memory_order_acquire) == nullptr;
+}
+
+uint32_t PagedVolume::Chunk::memoryUsage() const {
+	if (!isPacked()) {
+		return dataSizeInBytes();
+	}
+	const uint32_t words = (voxels() * _bitsPerIndex + 31u) / 32u;
+	return _paletteSize * (uint32_t)sizeof(Voxel) + words * (uint32_t)sizeof(uint32_t);
+}
+
+uint32_t PagedVolume::Chunk::paletteIndex(uint32_t index) const {
+	if (_bitsPerIndex == 0u) {
+		return 0u;
+	}
+	const uint32_t bit = index * _bitsPerIndex;
+	const uint32_t mask = (1u << _bitsPerIndex) - 1u;
+	return (_indices[bit >> 5] >> (bit & 31u)) & mask;
+}
+
+void PagedVolume::Chunk::fillVoxels(Voxel* voxels) const {
+	core_trace_scoped(DecodeChunk);
+	const uint32_t n = this->voxels();
+	if (_bitsPerIndex == 0u) {
+		for (uint32_t i = 0u; i < n; ++i) {
+			voxels[i] = _palette[0];
+		}
+		return;
+	}
+	for (uint32_t i = 0u; i < n; ++i) {
+		voxels[i] = _palette[paletteIndex(i)];
+	}
+}
+
+void PagedVolume::Chunk::unpack() const {
+	if (_data.load(std::memory_order_acquire) != nullptr) {
+		return;
+	}
+	core::ScopedLock lock(_storageLock);
+	if (_data.load(std::memory_order_relaxed) != nullptr) {
+		return;
+	}
+	Voxel* voxels = (Voxel*)core_malloc(dataSizeInBytes());
+	fillVoxels(voxels);
+	// readers that check the data pointer without the lock must see the filled buffer
+	_data.store(voxels, std::memory_order_release);
+	_decoded = DecodedVoxelsPtr();
+}
+
+PagedVolume::DecodedVoxelsPtr PagedVolume::Chunk::decode(bool& created) const {
+	created = false;
+	if (_data.load(std::memory_order_acquire) != nullptr) {
+		return DecodedVoxelsPtr();
+	}
+	core::ScopedLock lock(_storageLock);
+	if (_data.load(std::memory_order_relaxed) != nullptr) {
+		return DecodedVoxelsPtr();
+	}
+	if (!_decoded) {
+		DecodedVoxelsPtr decoded = core::make_shared<DecodedVoxels>();
+		decoded->voxels = (Voxel*)core_malloc(dataSizeInBytes());
+		fillVoxels(decoded->voxels);
+		_decoded = decoded;
+		created = true;
+	}
+	return _decoded;
+}
+
+void PagedVolume::Chunk::dropDecoded() const {
+	core::ScopedLock lock(_storageLock);
+	_decoded = DecodedVoxelsPtr();
 }
 
 uint32_t PagedVolume::Chunk::dataSizeInBytes() const {
@@ -61,10 +209,12 @@ const Voxel& PagedVolume::Chunk::voxel(uint32_t x, uint32_t y, uint32_t z) const
 	core_assert_msg(x < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", x, _sideLength);
 	core_assert_msg(y < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", y, _sideLength);
 	core_assert_msg(z < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", z, _sideLength);
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
-
 	const uint32_t index = morton256_x[x] | morton256_y[y] | morton256_z[z];
-	return _data[index];
+	const Voxel* data = _data.load(std::memory_order_acquire);
+	if (data != nullptr) {
+		return data[index];
+	}
+	return _palette[paletteIndex(index)];
 }
 
 const Voxel& PagedVolume::Chunk::voxel(const glm::i16vec3& pos) const {
@@ -77,11 +227,12 @@ void PagedVolume::Chunk::setVoxel(uint32_t x, uint32_t y, uint32_t z, const Voxe
 	core_assert_msg(x < _sideLength, "Supplied position is outside of the chunk");
 	core_assert_msg(y < _sideLength, "Supplied position is outside of the chunk");
 	core_assert_msg(z < _sideLength, "Supplied position is outside of the chunk");
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
+	unpack();
 
 	const uint32_t index = morton256_x[x] | morton256_y[y] | morton256_z[z];
-	_data[index] = value;
+	_data.load(std::memory_order_acquire)[index] = value;
 	_dataModified = true;
+	updateColumn(x, y, z, value);
 }
 
 void PagedVolume::Chunk::setVoxels(uint32_t x, uint32_t z, const Voxel* values, int amount) {
@@ -95,13 +246,163 @@ void PagedVolume::Chunk::setVoxels(uint32_t x, uint32_t y, uint32_t z, const Vox
 	core_assert_msg(x < _sideLength, "Supplied x position is outside of the chunk");
 	core_assert_msg(y < _sideLength, "Supplied y position is outside of the chunk");
 	core_assert_msg(z < _sideLength, "Supplied z position is outside of the chunk");
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
+	unpack();
 
+	Voxel* data = _data.load(std::memory_order_acquire);
 	for (int i = y; i < amount; ++i) {
 		const uint32_t index = morton256_x[x] | morton256_y[i] | morton256_z[z];
-		_data[index] = values[i];
+		data[index] = values[i];
 	}
 	_dataModified = true;
+	updateColumn(x, z);
+}
+
+const PagedVolume::ColumnSummary& PagedVolume::Chunk::column(uint32_t x, uint32_t z) const {
+	core_assert_msg(x < _sideLength, "Supplied x position is outside of the chunk");
+	core_assert_msg(z < _sideLength, "Supplied z position is outside of the chunk");
+	return columns()[z * _sideLength + x];
+}
+
+PagedVolume::ColumnSummary* PagedVolume::Chunk::columns() const {
+	ColumnSummary* columns = _columns.load(std::memory_order_acquire);
+	if (columns != nullptr) {
+		return columns;
+	}
+	core::ScopedLock lock(_columnsLock);
+	columns = _columns.load(std::memory_order_relaxed);
+	if (columns != nullptr) {
+		return columns;
+	}
+	core_trace_scoped(BuildChunkColumns);
+	const uint32_t n = _sideLength * _sideLength;
+	columns = (ColumnSummary*)core_malloc(n * sizeof(ColumnSummary));
+	for (uint32_t z = 0u; z < _sideLength; ++z) {
+		for (uint32_t x = 0u; x < _sideLength; ++x) {
+			columns[z * _sideLength + x] = summarizeColumn(x, z);
+		}
+	}
+	_columns.store(columns, std::memory_order_release);
+	return columns;
+}
+
+PagedVolume::ColumnSummary* PagedVolume::Chunk::builtColumns() const {
+	ColumnSummary* columns = _columns.load(std::memory_order_acquire);
+	// only the loading thread accesses the chunk while it is paged in - no build can run concurrently
+	if (columns != nullptr || !_loaded) {
+		return columns;
+	}
+	// the voxel was already modified - a build that starts after this lock sees the new value
+	core::ScopedLock lock(_columnsLock);
+	return _columns.load(std::memory_order_acquire);
+}
+
+void PagedVolume::Chunk::updateColumns() {
+	ColumnSummary* columns = builtColumns();
+	if (columns == nullptr) {
+		return;
+	}
+	core_trace_scoped(UpdateChunkColumns);
+	for (uint32_t z = 0u; z < _sideLength; ++z) {
+		for (uint32_t x = 0u; x < _sideLength; ++x) {
+			columns[z * _sideLength + x] = summarizeColumn(x, z);
+		}
+	}
+}
+
+void PagedVolume::Chunk::updateColumn(uint32_t x, uint32_t z) {
+	ColumnSummary* columns = builtColumns();
+	if (columns == nullptr) {
+		return;
+	}
+	columns[z * _sideLength + x] = summarizeColumn(x, z);
+}
+
+PagedVolume::ColumnSummary PagedVolume::Chunk::summarizeColumn(uint32_t x, uint32_t z) const {
+	ColumnSummary summary;
+	summary.firstWalkable = -1;
+	for (int y = _sideLength - 1; y >= 0; --y) {
+		const Voxel& v = voxel(x, y, z);
+		const VoxelType material = v.getMaterial();
+		if (!isEnterable(material)) {
+			if (summary.highestSolid == -1) {
+				summary.highestSolid = (int16_t)y;
+				summary.solid = v;
+			}
+			continue;
+		}
+		summary.firstWalkable = (int16_t)y;
+		summary.walkable = v;
+		if (summary.waterLevel == -1 && isWater(material)) {
+			summary.waterLevel = (int16_t)y;
+		}
+	}
+	return summary;
+}
+
+void PagedVolume::Chunk::updateColumn(uint32_t x, uint32_t y, uint32_t z, const Voxel& value) {
+	ColumnSummary* columns = builtColumns();
+	if (columns == nullptr) {
+		return;
+	}
+	ColumnSummary& summary = columns[z * _sideLength + x];
+	const int16_t height = (int16_t)y;
+	const VoxelType material = value.getMaterial();
+	if (!isEnterable(material)) {
+		if (height == summary.firstWalkable || height == summary.waterLevel) {
+			updateColumn(x, z);
+			return;
+		}
+		if (height >= summary.highestSolid) {
+			summary.highestSolid = height;
+			summary.solid = value;
+		}
+		return;
+	}
+	if (height == summary.highestSolid || (height == summary.waterLevel && !isWater(material))) {
+		updateColumn(x, z);
+		return;
+	}
+	if (summary.firstWalkable == -1 || height <= summary.firstWalkable) {
+		summary.firstWalkable = height;
+		summary.walkable = value;
+	}
+	if (isWater(material) && height > summary.waterLevel) {
+		summary.waterLevel = height;
+	}
+}
+
+void PagedVolume::Chunk::waitUntilLoaded() const {
+	if (_loaded) {
+		return;
+	}
+	// the pager might access the chunk it is currently filling
+	if (_loadingThread == core::getThreadId()) {
+		return;
+	}
+	core_trace_scoped(WaitForChunk);
+	core::ScopedLock lock(_loadLock);
+	while (!_loaded) {
+		_loadCondition.wait(_loadLock);
+	}
+}
+
+bool PagedVolume::Chunk::pageOut() {
+	if (!_dataModified || _pager == nullptr) {
+		return false;
+	}
+	// reset before the pager is called - modifications that are done in the meantime
+	// must lead to another page out
+	_dataModified = false;
+	_pager->pageOut(this);
+	return true;
+}
+
+void PagedVolume::Chunk::markLoaded() {
+	{
+		core::ScopedLock lock(_loadLock);
+		_loaded = true;
+	}
+	_loadCondition.notify_all();
 }
 
 int16_t PagedVolume::Chunk::sideLength() const {
@@ -86,7 +86,23 @@ void PagedVolume::Sampler::setPosition(int32_t xPos, int32_t yPos, int32_t zPos)
 	_zPosInChunk = static_cast<uint32_t>(zPos & _volume->_chunkMask);
 
 	const uint32_t voxelIndexInChunk = morton256_x[_xPosInChunk] | morton256_y[_yPosInChunk] | morton256_z[_zPosInChunk];
-	_currentVoxel = _currentChunk->_data + voxelIndexInChunk;
+	updateCurrentVoxel(voxelIndexInChunk);
+}
+
+void PagedVolume::Sampler::updateCurrentVoxel(uint32_t voxelIndexInChunk) {
+	Voxel* data = _currentChunk->_data.load(std::memory_order_acquire);
+	if (data != nullptr) {
+		_currentDecoded = DecodedVoxelsPtr();
+		_currentVoxel = data + voxelIndexInChunk;
+		return;
+	}
+	_currentDecoded = _volume->decode(_currentChunk);
+	if (!_currentDecoded) {
+		// unpacked in the meantime
+		_currentVoxel = _currentChunk->_data.load(std::memory_order_acquire) + voxelIndexInChunk;
+		return;
+	}
+	_currentVoxel = _currentDecoded->voxels + voxelIndexInChunk;
 }
 
 bool PagedVolume::Sampler::setVoxel(const Voxel& voxel) {
@@ -96,6 +112,12 @@ bool PagedVolume::Sampler::setVoxel(const Voxel& voxel) {
 	//Need to think what effect this has on any existing iterators.
 	//core_assert_msg(false, "This function cannot be used on PagedVolume samplers.");
 	//TODO: the region is not updated properly - but we might not need this for paged volumes.
+	if (_currentDecoded) {
+		// the decoded voxels are just a read-only copy - the chunk has to get unpacked
+		_currentChunk->setVoxel(_xPosInChunk, _yPosInChunk, _zPosInChunk, voxel);
+		updateCurrentVoxel(morton256_x[_xPosInChunk] | morton256_y[_yPosInChunk] | morton256_z[_zPosInChunk]);
+		return true;
+	}
 	*_currentVoxel = voxel;
 	return true;
 }
@@ -40,7 +40,7 @@ void PagedVolumeWrapper::Sampler::setPosition(int32_t xPos, int32_t yPos, int32_
 		_currentChunk = _volume->chunk(xChunk, yChunk, zChunk);
 	}
 
-	_currentVoxel = _currentChunk->_data + voxelIndexInChunk;
+	updateCurrentVoxel(voxelIndexInChunk);
 }
 
 PagedVolumeWrapper::PagedVolumeWrapper(PagedVolume* voxelStorage, const PagedVolume::ChunkPtr& chunk, const Region& region) :
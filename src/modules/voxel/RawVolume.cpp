@@ -42,6 +42,29 @@ RawVolume::RawVolume(const RawVolume& copy) :
 	core_memcpy((void*)_data, (void*)copy._data, size);
 }
 
+RawVolume::RawVolume(const RawVolume& copy, const Region& region) :
+		_region(region) {
+	_region.cropTo(copy.region());
+	setBorderValue(copy.borderValue());
+	const size_t size = width() * height() * depth() * sizeof(Voxel);
+	_data = (Voxel*)core_malloc(size);
+	_mins = glm::ivec3((std::numeric_limits<int>::max)() / 2);
+	_maxs = glm::ivec3((std::numeric_limits<int>::min)() / 2);
+	_boundsValid = false;
+	const glm::ivec3& lower = _region.getLowerCorner();
+	const glm::ivec3& copyLower = copy.region().getLowerCorner();
+	const size_t rowSize = width() * sizeof(Voxel);
+	for (int z = 0; z < depth(); ++z) {
+		for (int y = 0; y < height(); ++y) {
+			const int srcX = lower.x - copyLower.x;
+			const int srcY = lower.y - copyLower.y + y;
+			const int srcZ = lower.z - copyLower.z + z;
+			const Voxel* src = copy._data + srcX + srcY * copy.width() + srcZ * copy.width() * copy.height();
+			core_memcpy((void*)(_data + y * width() + z * width() * height()), (const void*)src, rowSize);
+		}
+	}
+}
+
 RawVolume::RawVolume(RawVolume&& move) noexcept {
 	_data = move._data;
 	move._data = nullptr;
@@ -92,6 +92,11 @@ public:
 	RawVolume(const Region& region);
 	RawVolume(const RawVolume* copy);
 	RawVolume(const RawVolume& copy);
+	/**
+	 * @brief Only copies the voxels of the given region - the region is cropped to the region of the
+	 * copied volume. Reading outside of it still gives you the border value of the copied volume.
+	 */
+	RawVolume(const RawVolume& copy, const Region& region);
 	RawVolume(RawVolume&& move) noexcept;
 
 	static RawVolume* createRaw(const Voxel* data, const voxel::Region& region) {
@@ -21,7 +21,24 @@ struct VoxelVertex {
 };
 static_assert(sizeof(VoxelVertex) == 8, "Unexpected size of the vertex struct");
 
-// TODO: maybe reduce to uint16_t and use glDrawElementsBaseVertex
-typedef uint32_t IndexType;
+/**
+ * @brief The indices are relative to the base vertex of the range they belong to
+ * @sa IndexRange
+ */
+typedef uint16_t IndexType;
+
+/**
+ * @brief A range of indices that all refer to at most @c MaxRangeVertices vertices starting at @c baseVertex
+ */
+struct IndexRange {
+	uint32_t firstIndex;
+	uint32_t numIndices;
+	uint32_t baseVertex;
+};
+
+/**
+ * @brief The amount of vertices that can be addressed by the indices of one @c IndexRange
+ */
+constexpr uint32_t MaxRangeVertices = 65536u;
 
 }
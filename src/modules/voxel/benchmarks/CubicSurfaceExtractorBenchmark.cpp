@@ -9,12 +9,61 @@
 #include "voxel/Constants.h"
 #include "voxel/RawVolume.h"
 #include "voxel/PagedVolume.h"
+#include "core/concurrent/Atomic.h"
+#include "core/concurrent/ThreadPool.h"
+#include <SDL_stdinc.h>
 
 static constexpr int MAX_BENCHMARK_VOLUME_SIZE = 64;
 static const int meshSize = voxel::MAX_MESH_CHUNK_HEIGHT;
+
+static SDL_malloc_func malloc_func;
+static SDL_calloc_func calloc_func;
+static SDL_realloc_func realloc_func;
+static SDL_free_func free_func;
+static core::AtomicInt allocations { 0 };
+
+static void *count_malloc_func(size_t size) {
+	allocations.increment(1);
+	return malloc_func(size);
+}
+
+static void *count_calloc_func(size_t nmemb, size_t size) {
+	allocations.increment(1);
+	return calloc_func(nmemb, size);
+}
+
+static void *count_realloc_func(void *mem, size_t size) {
+	allocations.increment(1);
+	return realloc_func(mem, size);
+}
+
 class CubicSurfaceExtractorBenchmark : public app::AbstractBenchmark {
+protected:
+	core::ThreadPool _threadPool{4, "Extractor"};
+
+	template<class Volume>
+	void extract(benchmark::State &state, Volume* volume, const voxel::Region& region, bool mergeQuads, bool reuseVertices, bool parallel = false) {
+		voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+		core::ThreadPool* threadPool = parallel ? &_threadPool : nullptr;
+		const int before = allocations;
+		for (auto _ : state) {
+			voxel::extractCubicMesh(threadPool, volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), mergeQuads, reuseVertices);
+		}
+		// the amount of heap allocations of all threads per extraction and the time it took for each voxel of the region
+		state.counters["allocs"] = benchmark::Counter((double)(allocations - before) / (double)state.iterations());
+		state.counters["timePerVoxel"] = benchmark::Counter((double)region.voxels(), benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+		// the size of the 16 bit index buffer compared to 32 bit indices for the same mesh
+		const size_t indices = mesh.getNoOfIndices();
+		state.counters["indexBytes"] = (double)(indices * sizeof(voxel::IndexType) + mesh.getIndexRanges().size() * sizeof(voxel::IndexRange));
+		state.counters["indexBytes32"] = (double)(indices * sizeof(uint32_t));
+		state.counters["compressedIndexBytes"] = (double)(indices * mesh.compressedIndexSize());
+		state.counters["ranges"] = (double)mesh.getIndexRanges().size();
+	}
+
 public:
 	void onCleanupApp() override {
+		_threadPool.shutdown();
+		SDL_SetMemoryFunctions(malloc_func, calloc_func, realloc_func, free_func);
 	}
 
 	template<class Volume>
@@ -40,10 +89,47 @@ public:
 		}
 	};
 
+	/**
+	 * @brief Generates some terrain while the chunk is paged in - chunks are only packed after they were paged in
+	 */
+	class TerrainPager: public voxel::PagedVolume::Pager {
+	public:
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			const voxel::Region& region = ctx.region;
+			const glm::ivec3& mins = region.getLowerCorner();
+			for (int x = 0; x < region.getWidthInVoxels(); ++x) {
+				for (int z = 0; z < region.getDepthInVoxels(); ++z) {
+					const int height = ((mins.x + x) * 3 + (mins.z + z) * 5) % meshSize;
+					for (int y = 0; y < height - mins.y && y < region.getHeightInVoxels(); ++y) {
+						ctx.chunk->setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Dirt, (mins.y + y) % 8));
+					}
+				}
+			}
+			return true;
+		}
+
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+	void extractTerrain(benchmark::State &state, voxel::PagedVolume::ChunkStorage chunkStorage, bool parallel = false) {
+		const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+		TerrainPager pager;
+		voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 64, chunkStorage);
+		voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+		// page in all the chunks - only the extraction should be measured
+		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
+		extract(state, &volume, region, true, true, parallel);
+		state.counters["chunkBytes"] = volume.chunk(region.getLowerCorner())->memoryUsage();
+	}
+
 	bool onInitApp() override {
 		if (!voxel::initDefaultMaterialColors()) {
 			return false;
 		}
+		SDL_GetMemoryFunctions(&malloc_func, &calloc_func, &realloc_func, &free_func);
+		SDL_SetMemoryFunctions(count_malloc_func, count_calloc_func, count_realloc_func, free_func);
+		_threadPool.init();
 		return true;
 	}
 };
@@ -53,10 +139,7 @@ BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedy)(bench
 	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
 	voxel::RawVolume volume(volumeRegion);
 	fill(region, &volume);
-	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
-	for (auto _ : state) {
-		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
-	}
+	extract(state, &volume, region, true, true);
 }
 
 BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtract)(benchmark::State &state) {
@@ -64,30 +147,21 @@ BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtract)(benchmark::
 	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
 	voxel::RawVolume volume(volumeRegion);
 	fill(region, &volume);
-	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
-	for (auto _ : state) {
-		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), false, false);
-	}
+	extract(state, &volume, region, false, false);
 }
 
 BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedyEmpty)(benchmark::State &state) {
 	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
 	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
 	voxel::RawVolume volume(volumeRegion);
-	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
-	for (auto _ : state) {
-		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
-	}
+	extract(state, &volume, region, true, true);
 }
 
 BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractEmpty)(benchmark::State &state) {
 	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
 	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
 	voxel::RawVolume volume(volumeRegion);
-	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
-	for (auto _ : state) {
-		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), false, false);
-	}
+	extract(state, &volume, region, false, false);
 }
 
 BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedy)(benchmark::State &state) {
@@ -95,10 +169,7 @@ BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedy)(ben
 	BenchmarkPager pager;
 	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 256);
 	fill(region, &volume);
-	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
-	for (auto _ : state) {
-		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
-	}
+	extract(state, &volume, region, true, true);
 }
 
 BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtract)(benchmark::State &state) {
@@ -106,40 +177,56 @@ BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtract)(benchmark
 	BenchmarkPager pager;
 	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 256);
 	fill(region, &volume);
-	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
-	for (auto _ : state) {
-		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), false, false);
-	}
+	extract(state, &volume, region, false, false);
 }
 
 BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedyEmpty)(benchmark::State &state) {
 	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
 	BenchmarkPager pager;
 	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 256);
-	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
-	for (auto _ : state) {
-		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
-	}
+	extract(state, &volume, region, true, true);
 }
 
 BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractEmpty)(benchmark::State &state) {
 	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
 	BenchmarkPager pager;
 	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 256);
-	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
-	for (auto _ : state) {
-		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), false, false);
-	}
+	extract(state, &volume, region, false, false);
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedyParallel)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
+	voxel::RawVolume volume(volumeRegion);
+	fill(region, &volume);
+	extract(state, &volume, region, true, true, true);
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractTerrain)(benchmark::State &state) {
+	extractTerrain(state, voxel::PagedVolume::ChunkStorage::Raw);
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractTerrainParallel)(benchmark::State &state) {
+	extractTerrain(state, voxel::PagedVolume::ChunkStorage::Raw, true);
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumePaletteExtractTerrain)(benchmark::State &state) {
+	extractTerrain(state, voxel::PagedVolume::ChunkStorage::Palette);
 }
 
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedy)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtract)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedyEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedyParallel)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE)->UseRealTime();
 
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedy)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtract)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedyEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractTerrain)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractTerrainParallel)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE)->UseRealTime();
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumePaletteExtractTerrain)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+
 BENCHMARK_MAIN();
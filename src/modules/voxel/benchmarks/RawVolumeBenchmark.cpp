@@ -0,0 +1,146 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include "voxel/MaterialColor.h"
+#include "voxel/RawVolume.h"
+#include "core/collection/DynamicArray.h"
+#include "core/TimeProvider.h"
+#include <stdio.h>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Simulates the mesh extraction of the RawVolumeRenderer for a single voxel edit - every block that
+ * looks at the modified voxel gets a snapshot of the volume and is extracted from it.
+ */
+class RawVolumeBenchmark : public app::AbstractBenchmark {
+protected:
+	static constexpr int BlockSize = 64;
+
+	/**
+	 * @return The resident set size in bytes - @c 0 if this is not supported
+	 */
+	static size_t residentBytes() {
+#ifdef __linux__
+		FILE* file = fopen("/proc/self/statm", "r");
+		if (file == nullptr) {
+			return 0u;
+		}
+		long pages = 0;
+		long resident = 0;
+		const int n = fscanf(file, "%li %li", &pages, &resident);
+		fclose(file);
+		if (n != 2) {
+			return 0u;
+		}
+		return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+#else
+		return 0u;
+#endif
+	}
+
+	static int floorDiv(int a, int b) {
+		const int d = a / b;
+		return (a % b != 0 && (a < 0) != (b < 0)) ? d - 1 : d;
+	}
+
+	void fill(voxel::RawVolume& volume) const {
+		const voxel::Region& region = volume.region();
+		for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+			for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+				const int height = (x * 3 + z * 5) % region.getHeightInVoxels();
+				for (int y = region.getLowerY(); y < height; ++y) {
+					volume.setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Dirt, y % 8));
+				}
+			}
+		}
+	}
+
+	/**
+	 * @param[in] regionCopy Only copy the voxels the extraction of a block looks at instead of the whole volume
+	 */
+	void edit(benchmark::State &state, bool regionCopy) {
+		const int size = (int)state.range(0);
+		voxel::RawVolume volume(voxel::Region(0, size - 1));
+		fill(volume);
+		// an edit at the corner of the blocks in the middle of the volume touches the most blocks
+		const glm::ivec3 pos(size / 2);
+		// the same blocks the RawVolumeRenderer schedules for a modified region
+		const glm::ivec3 l(floorDiv(pos.x - 2, BlockSize), floorDiv(pos.y - 2, BlockSize), floorDiv(pos.z - 2, BlockSize));
+		const glm::ivec3 u(floorDiv(pos.x + 1, BlockSize), floorDiv(pos.y + 1, BlockSize), floorDiv(pos.z + 1, BlockSize));
+
+		core::DynamicArray<voxel::RawVolume*> snapshots;
+		core::DynamicArray<voxel::Region> regions;
+		voxel::Mesh mesh(65536, 65536, true);
+		size_t snapshotBytes = 0u;
+		size_t peakResident = 0u;
+		uint64_t snapshotTime = 0u;
+		uint8_t color = 0u;
+		for (auto _ : state) {
+			const size_t resident = residentBytes();
+			const uint64_t start = core::TimeProvider::highResTime();
+			volume.setVoxel(pos, voxel::createVoxel(voxel::VoxelType::Generic, ++color));
+			snapshotBytes = 0u;
+			for (int x = l.x; x <= u.x; ++x) {
+				for (int y = l.y; y <= u.y; ++y) {
+					for (int z = l.z; z <= u.z; ++z) {
+						const glm::ivec3 mins(x * BlockSize, y * BlockSize, z * BlockSize);
+						const voxel::Region blockRegion(mins, mins + BlockSize - 1);
+						if (!voxel::intersects(volume.region(), blockRegion)) {
+							continue;
+						}
+						voxel::RawVolume* snapshot;
+						if (regionCopy) {
+							snapshot = new voxel::RawVolume(volume, voxel::Region(mins - 1, blockRegion.getUpperCorner() + 2));
+						} else {
+							snapshot = new voxel::RawVolume(volume);
+						}
+						snapshotBytes += (size_t)snapshot->region().voxels() * sizeof(voxel::Voxel);
+						snapshots.push_back(snapshot);
+						regions.push_back(blockRegion);
+					}
+				}
+			}
+			snapshotTime += core::TimeProvider::highResTime() - start;
+			// all snapshots of the edit are alive until the extraction tasks are done
+			const size_t snapshotResident = residentBytes();
+			peakResident = core_max(peakResident, snapshotResident - core_min(resident, snapshotResident));
+			for (size_t i = 0; i < snapshots.size(); ++i) {
+				voxel::Region reg = regions[i];
+				reg.shiftUpperCorner(1, 1, 1);
+				voxel::extractCubicMesh(snapshots[i], reg, &mesh, voxel::IsQuadNeeded(), reg.getLowerCorner());
+				delete snapshots[i];
+			}
+			state.counters["blocks"] = (double)snapshots.size();
+			snapshots.clear();
+			regions.clear();
+		}
+		// the memory that is held by the snapshots of one edit and the growth of the resident set while they are alive
+		state.counters["snapshotBytes"] = (double)snapshotBytes;
+		state.counters["peakRSS"] = (double)peakResident;
+		// the time the editor is blocked by taking the snapshots - the extraction runs in the background
+		const double snapshotMillis = (double)snapshotTime * 1000.0 / (double)core::TimeProvider::highResTimeResolution();
+		state.counters["snapshotMillis"] = snapshotMillis / (double)state.iterations();
+	}
+
+public:
+	bool onInitApp() override {
+		return voxel::initDefaultMaterialColors();
+	}
+};
+
+BENCHMARK_DEFINE_F(RawVolumeBenchmark, EditFullCopy)(benchmark::State &state) {
+	edit(state, false);
+}
+
+BENCHMARK_DEFINE_F(RawVolumeBenchmark, EditRegionCopy)(benchmark::State &state) {
+	edit(state, true);
+}
+
+BENCHMARK_REGISTER_F(RawVolumeBenchmark, EditFullCopy)->RangeMultiplier(2)->Range(128, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(RawVolumeBenchmark, EditRegionCopy)->RangeMultiplier(2)->Range(128, 256)->Unit(benchmark::kMillisecond);
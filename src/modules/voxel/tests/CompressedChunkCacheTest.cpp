@@ -0,0 +1,113 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/CompressedChunkCache.h"
+#include "core/StandardLib.h"
+
+namespace voxel {
+
+class CompressedChunkCacheTest: public app::AbstractTest {
+protected:
+	static constexpr uint32_t Voxels = 32 * 32 * 32;
+	Voxel _voxels[Voxels];
+
+	void put(CompressedChunkCache& cache, const glm::ivec3& pos) {
+		uint32_t compressedSize = 0u;
+		uint8_t* compressed = CompressedChunkCache::compress(_voxels, sizeof(_voxels), compressedSize);
+		ASSERT_NE(nullptr, compressed);
+		ASSERT_LT(compressedSize, sizeof(_voxels));
+		cache.put(pos, compressed, compressedSize);
+	}
+public:
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		for (uint32_t i = 0; i < Voxels; ++i) {
+			_voxels[i] = i < Voxels / 2 ? createVoxel(VoxelType::Dirt, i % 4) : Voxel();
+		}
+	}
+};
+
+TEST_F(CompressedChunkCacheTest, testPutTake) {
+	CompressedChunkCache cache(1024 * 1024);
+	put(cache, glm::ivec3(1, 2, 3));
+	EXPECT_EQ(1, cache.stats().entries);
+
+	Voxel inflated[Voxels];
+	ASSERT_TRUE(cache.take(glm::ivec3(1, 2, 3), inflated, sizeof(inflated)));
+	for (uint32_t i = 0; i < Voxels; ++i) {
+		ASSERT_TRUE(inflated[i].isSame(_voxels[i])) << "Voxel " << i << " differs";
+	}
+	EXPECT_FALSE(cache.take(glm::ivec3(1, 2, 3), inflated, sizeof(inflated))) << "Taking the entry must remove it";
+
+	const CompressedChunkCache::Stats& stats = cache.stats();
+	EXPECT_EQ(0, stats.entries);
+	EXPECT_EQ(0u, stats.memoryUsage);
+	EXPECT_EQ(1, stats.hits);
+	EXPECT_EQ(1, stats.misses);
+}
+
+TEST_F(CompressedChunkCacheTest, testTakeCorrupted) {
+	CompressedChunkCache cache(1024 * 1024);
+	const uint32_t corruptedSize = 64u;
+	uint8_t* corrupted = (uint8_t*)core_malloc(corruptedSize);
+	for (uint32_t i = 0; i < corruptedSize; ++i) {
+		corrupted[i] = (uint8_t)(i * 31u + 7u);
+	}
+	cache.put(glm::ivec3(1, 2, 3), corrupted, corruptedSize);
+
+	Voxel inflated[Voxels];
+	for (uint32_t i = 0; i < Voxels; ++i) {
+		inflated[i] = createVoxel(VoxelType::Rock, 1);
+	}
+	EXPECT_FALSE(cache.take(glm::ivec3(1, 2, 3), inflated, sizeof(inflated)));
+	for (uint32_t i = 0; i < Voxels; ++i) {
+		ASSERT_TRUE(inflated[i].isSame(Voxel())) << "Voxel " << i << " was not cleared";
+	}
+	EXPECT_EQ(0, cache.stats().entries);
+	EXPECT_EQ(0u, cache.stats().memoryUsage);
+}
+
+TEST_F(CompressedChunkCacheTest, testMemoryLimit) {
+	uint32_t compressedSize = 0u;
+	core_free(CompressedChunkCache::compress(_voxels, sizeof(_voxels), compressedSize));
+	// room for three entries
+	CompressedChunkCache cache(compressedSize * 3 + compressedSize / 2);
+	for (int i = 0; i < 5; ++i) {
+		put(cache, glm::ivec3(i, 0, 0));
+	}
+	// replacing an entry makes it the newest one
+	put(cache, glm::ivec3(2, 0, 0));
+	put(cache, glm::ivec3(5, 0, 0));
+
+	const CompressedChunkCache::Stats& stats = cache.stats();
+	EXPECT_EQ(3, stats.entries);
+	EXPECT_LE(stats.memoryUsage, cache.memoryLimit());
+	EXPECT_FALSE(cache.remove(glm::ivec3(3, 0, 0))) << "The oldest entries should have been dropped";
+	EXPECT_TRUE(cache.remove(glm::ivec3(2, 0, 0)));
+	EXPECT_TRUE(cache.remove(glm::ivec3(4, 0, 0)));
+	EXPECT_TRUE(cache.remove(glm::ivec3(5, 0, 0)));
+	EXPECT_EQ(0u, cache.stats().memoryUsage);
+}
+
+TEST_F(CompressedChunkCacheTest, testOrderBelowMemoryLimit) {
+	CompressedChunkCache cache(1024 * 1024);
+	Voxel inflated[Voxels];
+	for (int i = 0; i < 1000; ++i) {
+		// evicted and reloaded chunks and replaced entries - the cache never reaches its memory limit
+		put(cache, glm::ivec3(i % 3, 0, 0));
+		put(cache, glm::ivec3(i % 3, 0, 0));
+		if (i % 2 == 0) {
+			ASSERT_TRUE(cache.take(glm::ivec3(i % 3, 0, 0), inflated, sizeof(inflated)));
+		} else {
+			ASSERT_TRUE(cache.remove(glm::ivec3(i % 3, 0, 0)));
+		}
+		put(cache, glm::ivec3(3, 0, 0));
+	}
+	const CompressedChunkCache::Stats& stats = cache.stats();
+	EXPECT_EQ(1, stats.entries);
+	EXPECT_LE(stats.orderEntries, 4) << "The stale order entries must not pile up";
+}
+
+}
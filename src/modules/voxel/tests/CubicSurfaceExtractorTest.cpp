@@ -0,0 +1,92 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include "voxel/RawVolume.h"
+
+namespace voxel {
+
+class CubicSurfaceExtractorTest: public app::AbstractTest {
+protected:
+	/**
+	 * @brief Hills with caves and a few materials - to get merged quads and shared vertices across the slabs
+	 */
+	void fill(RawVolume& volume) const {
+		const Region& region = volume.region();
+		for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+			for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+				const int height = 8 + (x * 7 + z * 3) % 13 + (x / 5) % 3;
+				for (int y = region.getLowerY(); y <= region.getUpperY() && y < height; ++y) {
+					if ((x * 31 + y * 17 + z * 13) % 23 == 0) {
+						continue;
+					}
+					const VoxelType type = y < 4 ? VoxelType::Rock : (y < height - 1 ? VoxelType::Dirt : VoxelType::Grass);
+					volume.setVoxel(x, y, z, createVoxel(type, (x / 4 + z / 6) % 3));
+				}
+			}
+		}
+	}
+
+	void compare(const Mesh& expected, const Mesh& mesh) const {
+		ASSERT_EQ(expected.getNoOfVertices(), mesh.getNoOfVertices());
+		ASSERT_EQ(expected.getNoOfIndices(), mesh.getNoOfIndices());
+		for (size_t i = 0; i < expected.getNoOfVertices(); ++i) {
+			const VoxelVertex& e = expected.getVertex(i);
+			const VoxelVertex& v = mesh.getVertex(i);
+			ASSERT_EQ(e.position, v.position) << "vertex " << i;
+			ASSERT_EQ(e.colorIndex, v.colorIndex) << "vertex " << i;
+			ASSERT_EQ(e.ambientOcclusion, v.ambientOcclusion) << "vertex " << i;
+		}
+		for (size_t i = 0; i < expected.getNoOfIndices(); ++i) {
+			ASSERT_EQ(expected.getIndex(i), mesh.getIndex(i)) << "index " << i;
+		}
+		EXPECT_EQ(expected.getOffset(), mesh.getOffset());
+	}
+
+	void testParallel(bool mergeQuads, bool reuseVertices, bool ambientOcclusion) {
+		const Region region(glm::ivec3(-3, 0, -5), glm::ivec3(16, 16, 34));
+		RawVolume volume(region);
+		fill(volume);
+		core::ThreadPool threadPool(3, "Extractor");
+		threadPool.init();
+		ASSERT_GT(cubicSlabCount(region, &threadPool), 1);
+
+		Mesh expected;
+		extractCubicMesh(&volume, region, &expected, IsQuadNeeded(), region.getLowerCorner(), mergeQuads, reuseVertices, ambientOcclusion);
+		ASSERT_FALSE(expected.isEmpty());
+		Mesh mesh;
+		extractCubicMesh(&threadPool, &volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner(), mergeQuads, reuseVertices, ambientOcclusion);
+		compare(expected, mesh);
+	}
+};
+
+TEST_F(CubicSurfaceExtractorTest, testParallel) {
+	testParallel(true, true, true);
+}
+
+TEST_F(CubicSurfaceExtractorTest, testParallelNoMerge) {
+	testParallel(false, true, true);
+}
+
+TEST_F(CubicSurfaceExtractorTest, testParallelNoReuse) {
+	testParallel(true, false, false);
+}
+
+TEST_F(CubicSurfaceExtractorTest, testParallelSmallRegion) {
+	const Region region(0, 3);
+	RawVolume volume(region);
+	fill(volume);
+	core::ThreadPool threadPool(2, "Extractor");
+	threadPool.init();
+	EXPECT_EQ(1, cubicSlabCount(region, &threadPool));
+	Mesh expected;
+	extractCubicMesh(&volume, region, &expected, IsQuadNeeded(), region.getLowerCorner());
+	Mesh mesh;
+	extractCubicMesh(&threadPool, &volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner());
+	compare(expected, mesh);
+}
+
+}
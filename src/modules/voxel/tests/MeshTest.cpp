@@ -0,0 +1,96 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/Mesh.h"
+#include "core/ArrayLength.h"
+
+namespace voxel {
+
+class MeshTest: public app::AbstractTest {
+protected:
+	static VoxelVertex vertex(uint32_t id) {
+		VoxelVertex v;
+		v.position = glm::i16vec3((int16_t)(id % 1000u), (int16_t)(id / 1000u), 0);
+		v.ambientOcclusion = 3;
+		v.colorIndex = 1;
+		return v;
+	}
+
+	static uint32_t id(const VoxelVertex& v) {
+		return (uint32_t)v.position.x + (uint32_t)v.position.y * 1000u;
+	}
+
+	/**
+	 * @brief Checks that the ranges cover all indices and only address vertices that are part of the mesh
+	 */
+	void checkRanges(const Mesh& mesh) const {
+		size_t indices = 0u;
+		for (const IndexRange& range : mesh.getIndexRanges()) {
+			ASSERT_EQ(indices, range.firstIndex);
+			ASSERT_EQ(0u, range.numIndices % 3u);
+			for (uint32_t i = range.firstIndex; i < range.firstIndex + range.numIndices; ++i) {
+				ASSERT_LT((uint32_t)mesh.getIndex(i), MaxRangeVertices);
+				ASSERT_LT(range.baseVertex + mesh.getIndex(i), mesh.getNoOfVertices());
+			}
+			indices += range.numIndices;
+		}
+		ASSERT_EQ(mesh.getNoOfIndices(), indices);
+	}
+};
+
+TEST_F(MeshTest, testSingleRange) {
+	Mesh mesh;
+	for (uint32_t i = 0u; i < 8u; ++i) {
+		mesh.addVertex(vertex(i));
+	}
+	mesh.addTriangle(0, 2, 4);
+	mesh.addTriangle(4, 2, 6);
+	mesh.removeUnusedVertices();
+	ASSERT_EQ(4u, mesh.getNoOfVertices());
+	ASSERT_EQ(1, (int)mesh.getIndexRanges().size());
+	EXPECT_EQ(0u, mesh.getIndexRanges()[0].baseVertex);
+	checkRanges(mesh);
+	VertexIndexArray indices;
+	mesh.resolveIndices(indices);
+	const uint32_t expected[] = {0u, 2u, 4u, 4u, 2u, 6u};
+	ASSERT_EQ(lengthof(expected), (int)indices.size());
+	for (int i = 0; i < lengthof(expected); ++i) {
+		EXPECT_EQ(expected[i], id(mesh.getVertex(indices[i])));
+	}
+}
+
+TEST_F(MeshTest, testSplitIndices) {
+	const uint32_t vertices = 3u * MaxRangeVertices;
+	Mesh mesh(vertices, vertices * 3, true);
+	for (uint32_t i = 0u; i < vertices; ++i) {
+		mesh.addVertex(vertex(i));
+	}
+	// triangles that share vertices with the start of the mesh and skip every 7th vertex
+	VertexIndexArray triangles;
+	triangles.reserve(vertices * 3u);
+	for (uint32_t i = 1u; i < vertices; ++i) {
+		if (i % 7u == 0u) {
+			continue;
+		}
+		triangles.push_back(i);
+		triangles.push_back(i / 3u);
+		triangles.push_back(i % 5u);
+	}
+	for (size_t i = 0u; i < triangles.size(); i += 3u) {
+		mesh.addTriangle(triangles[i], triangles[i + 1], triangles[i + 2]);
+	}
+	mesh.removeUnusedVertices();
+	ASSERT_GT((int)mesh.getIndexRanges().size(), 1);
+	checkRanges(mesh);
+
+	VertexIndexArray indices;
+	mesh.resolveIndices(indices);
+	ASSERT_EQ(triangles.size(), indices.size());
+	for (size_t i = 0u; i < triangles.size(); ++i) {
+		ASSERT_EQ(triangles[i], id(mesh.getVertex(indices[i]))) << "index " << i;
+	}
+}
+
+}
@@ -0,0 +1,165 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/PagedVolume.h"
+#include "core/concurrent/Atomic.h"
+#include <future>
+#include <chrono>
+
+namespace voxel {
+
+class PagedVolumeTest: public app::AbstractTest {
+protected:
+	class Pager: public PagedVolume::Pager {
+	public:
+		core::AtomicInt pageIns { 0 };
+		core::AtomicInt pageOuts { 0 };
+		core::AtomicBool block { false };
+		core::AtomicBool entered { false };
+		std::promise<glm::ivec3> blockedChunk;
+		std::shared_future<void> unblock;
+
+		bool pageIn(PagedVolume::PagerContext& ctx) override {
+			pageIns.increment(1);
+			ctx.chunk->setVoxel(0, 0, 0, createVoxel(VoxelType::Grass, 1));
+			return true;
+		}
+
+		void pageOut(PagedVolume::Chunk* chunk) override {
+			pageOuts.increment(1);
+			if (!block) {
+				return;
+			}
+			if (!entered) {
+				entered = true;
+				blockedChunk.set_value(chunk->chunkPos());
+			}
+			unblock.wait();
+		}
+	};
+	// the memory limit is too low for the chunk size - the volume uses its minimum amount of chunks
+	static constexpr uint32_t ChunkLimit = 32u;
+	static constexpr uint16_t ChunkSideLength = 64u;
+	static constexpr uint32_t MemoryLimit = 1024u * 1024u;
+};
+
+TEST_F(PagedVolumeTest, testEvict) {
+	Pager pager;
+	{
+		PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+		const int n = 100;
+		for (int i = 0; i < n; ++i) {
+			volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+		}
+		volume.waitForEviction();
+		const PagedVolume::Metrics& metrics = volume.metrics();
+		EXPECT_EQ(n, metrics.pagedIn);
+		EXPECT_EQ((int)ChunkLimit, metrics.chunks);
+		EXPECT_EQ(n - (int)ChunkLimit, metrics.evicted);
+		EXPECT_EQ(metrics.evicted, metrics.pagedOut);
+		EXPECT_EQ(0, metrics.pendingPageOuts);
+		EXPECT_EQ(metrics.pagedOut, (int)pager.pageOuts);
+	}
+	EXPECT_EQ(pager.pageIns, pager.pageOuts) << "Each modified chunk must get paged out";
+}
+
+TEST_F(PagedVolumeTest, testInflateEvictedChunk) {
+	Pager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	const glm::ivec3 first(0);
+	for (uint32_t i = 0; i < ChunkLimit * 2; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	volume.waitForEviction();
+	EXPECT_EQ((int)ChunkLimit, volume.metrics().compressedChunks);
+	const int pageIns = pager.pageIns;
+
+	const PagedVolume::ChunkPtr& chunk = volume.chunk(first);
+	EXPECT_EQ(pageIns, (int)pager.pageIns) << "The chunk should have been inflated from the compressed chunks";
+	EXPECT_TRUE(chunk->voxel(0, 0, 0).isSame(createVoxel(VoxelType::Grass, 1)));
+	EXPECT_TRUE(chunk->voxel(1, 0, 0).isSame(Voxel()));
+	const PagedVolume::Metrics& metrics = volume.metrics();
+	EXPECT_EQ(1, metrics.compressedHits);
+	EXPECT_EQ((int)ChunkLimit * 2, metrics.compressedMisses);
+}
+
+TEST_F(PagedVolumeTest, testPaletteStorage) {
+	Pager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength, PagedVolume::ChunkStorage::Palette);
+	const PagedVolume::ChunkPtr& chunk = volume.chunk(glm::ivec3(0));
+	ASSERT_TRUE(chunk->isPacked());
+	// two distinct voxels - one bit per voxel
+	EXPECT_LT(chunk->memoryUsage(), chunk->dataSizeInBytes() / 10u);
+	EXPECT_TRUE(chunk->voxel(0, 0, 0).isSame(createVoxel(VoxelType::Grass, 1)));
+	EXPECT_TRUE(chunk->voxel(1, 0, 0).isSame(Voxel()));
+
+	PagedVolume::Sampler sampler(volume);
+	sampler.setPosition(1, 0, 0);
+	EXPECT_TRUE(sampler.voxel().isSame(Voxel()));
+	EXPECT_TRUE(sampler.peekVoxel1nx0py0pz().isSame(createVoxel(VoxelType::Grass, 1)));
+	sampler.moveNegativeX();
+	EXPECT_TRUE(sampler.voxel().isSame(createVoxel(VoxelType::Grass, 1)));
+
+	// modifications are unpacking the chunk
+	EXPECT_TRUE(sampler.setVoxel(createVoxel(VoxelType::Rock, 2)));
+	EXPECT_FALSE(chunk->isPacked());
+	EXPECT_EQ(chunk->dataSizeInBytes(), chunk->memoryUsage());
+	EXPECT_TRUE(sampler.voxel().isSame(createVoxel(VoxelType::Rock, 2)));
+	EXPECT_TRUE(volume.voxel(0, 0, 0).isSame(createVoxel(VoxelType::Rock, 2)));
+	EXPECT_TRUE(volume.voxel(1, 0, 0).isSame(Voxel()));
+}
+
+TEST_F(PagedVolumeTest, testPaletteDecodedChunks) {
+	Pager pager;
+	// ten percent of the memory limit are used for the decoded copies
+	const uint32_t chunkSize = ChunkSideLength * ChunkSideLength * ChunkSideLength * (uint32_t)sizeof(Voxel);
+	PagedVolume volume(&pager, chunkSize * 100u, ChunkSideLength, PagedVolume::ChunkStorage::Palette);
+	for (int i = 0; i < 12; ++i) {
+		PagedVolume::Sampler sampler(volume);
+		sampler.setPosition(i * ChunkSideLength, 0, 0);
+		EXPECT_TRUE(sampler.voxel().isSame(createVoxel(VoxelType::Grass, 1)));
+	}
+	EXPECT_EQ(10, volume.metrics().decodedChunks) << "The decoded copies must be limited by the memory limit";
+}
+
+TEST_F(PagedVolumeTest, testAccessedChunkSurvives) {
+	Pager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	const glm::ivec3 hot(0);
+	for (int i = 0; i < 100; ++i) {
+		volume.chunk(glm::ivec3((i + 1) * ChunkSideLength, 0, 0));
+		volume.chunk(hot);
+		volume.waitForEviction();
+	}
+	EXPECT_EQ(101, volume.metrics().pagedIn) << "The accessed chunk was evicted";
+}
+
+TEST_F(PagedVolumeTest, testReclaimPendingPageOut) {
+	Pager pager;
+	std::promise<void> unblock;
+	pager.unblock = unblock.get_future().share();
+	pager.block = true;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	for (uint32_t i = 0; i <= ChunkLimit; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	std::future<glm::ivec3> blockedChunk = pager.blockedChunk.get_future();
+	ASSERT_EQ(std::future_status::ready, blockedChunk.wait_for(std::chrono::seconds(10))) << "No chunk was evicted";
+	const glm::ivec3 chunkPos = blockedChunk.get();
+	EXPECT_EQ(1, volume.metrics().pendingPageOuts);
+
+	// the chunk is still in memory - it must not get paged in again
+	volume.chunk(chunkPos * (int)ChunkSideLength);
+	const PagedVolume::Metrics& metrics = volume.metrics();
+	EXPECT_EQ((int)ChunkLimit + 1, metrics.pagedIn);
+	EXPECT_EQ(1, metrics.reclaimed);
+	EXPECT_EQ(0, metrics.pendingPageOuts);
+
+	unblock.set_value();
+	volume.waitForEviction();
+	EXPECT_EQ((int)ChunkLimit, volume.metrics().chunks);
+}
+
+}
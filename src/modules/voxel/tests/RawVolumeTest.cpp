@@ -0,0 +1,38 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/RawVolume.h"
+
+namespace voxel {
+
+class RawVolumeTest: public app::AbstractTest {
+};
+
+TEST_F(RawVolumeTest, testCopyRegion) {
+	const Region region(glm::ivec3(-4, 0, -2), glm::ivec3(11, 7, 9));
+	RawVolume v(region);
+	for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+		for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+				v.setVoxel(x, y, z, createVoxel(VoxelType::Generic, (x * 7 + y * 3 + z) & 0xff));
+			}
+		}
+	}
+	// the region exceeds the volume on the lower side
+	const Region copyRegion(glm::ivec3(-6, 2, 1), glm::ivec3(3, 5, 4));
+	RawVolume copy(v, copyRegion);
+	EXPECT_EQ(glm::ivec3(-4, 2, 1), copy.region().getLowerCorner());
+	EXPECT_EQ(glm::ivec3(3, 5, 4), copy.region().getUpperCorner());
+	for (int x = -4; x <= 3; ++x) {
+		for (int y = 2; y <= 5; ++y) {
+			for (int z = 1; z <= 4; ++z) {
+				ASSERT_EQ(v.voxel(x, y, z), copy.voxel(x, y, z)) << x << ":" << y << ":" << z;
+			}
+		}
+	}
+	EXPECT_EQ(v.borderValue(), copy.voxel(4, 2, 1));
+}
+
+}
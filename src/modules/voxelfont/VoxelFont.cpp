@@ -189,7 +189,7 @@ bool VoxelFont::renderGlyphs(const char* string) {
 	return true;
 }
 
-int VoxelFont::render(const char* string, core::DynamicArray<glm::vec4>& pos, voxel::IndexArray& indices) {
+int VoxelFont::render(const char* string, core::DynamicArray<glm::vec4>& pos, voxel::VertexIndexArray& indices) {
 	return render(string, pos, indices, [] (const voxel::VoxelVertex& vertex, core::DynamicArray<glm::vec4>& pos, int x, int y) {
 		glm::vec4 vp(vertex.position, 1.0f);
 		vp.x += x;
@@ -198,7 +198,7 @@ int VoxelFont::render(const char* string, core::DynamicArray<glm::vec4>& pos, vo
 	});
 }
 
-int VoxelFont::render(const char* string, voxel::VertexArray& vertices, voxel::IndexArray& indices) {
+int VoxelFont::render(const char* string, voxel::VertexArray& vertices, voxel::VertexIndexArray& indices) {
 	return render(string, vertices, indices, [] (const voxel::VoxelVertex& vertex, voxel::VertexArray& vertices, int x, int y) {
 		voxel::VoxelVertex copy = vertex;
 		copy.position.x += x;
@@ -61,7 +61,7 @@ public:
 	}
 
 	template<class T, class FUNC>
-	int render(const char* string, core::DynamicArray<T>& out, voxel::IndexArray& indices, FUNC&& func) {
+	int render(const char* string, core::DynamicArray<T>& out, voxel::VertexIndexArray& indices, FUNC&& func) {
 		const char **s = &string;
 		const int newlines = core::string::count(string, '\n');
 
@@ -114,9 +114,11 @@ public:
 				const voxel::VoxelVertex& vp = meshVertices[mv];
 				func(vp, out, x, y);
 			}
-			for (size_t mi = 0; mi < meshNumberIndices; ++mi) {
-				// offset by the already added vertices
-				indices.push_back(meshIndices[mi] + positionSize);
+			for (const voxel::IndexRange& range : mesh->getIndexRanges()) {
+				for (uint32_t mi = range.firstIndex; mi < range.firstIndex + range.numIndices; ++mi) {
+					// offset by the already added vertices
+					indices.push_back((uint32_t)positionSize + range.baseVertex + meshIndices[mi]);
+				}
 			}
 
 			xBase += advance;
@@ -124,8 +126,8 @@ public:
 		return charCount;
 	}
 
-	int render(const char* string, core::DynamicArray<glm::vec4>& pos, voxel::IndexArray& indices);
-	int render(const char* string, voxel::VertexArray& vertices, voxel::IndexArray& indices);
+	int render(const char* string, core::DynamicArray<glm::vec4>& pos, voxel::VertexIndexArray& indices);
+	int render(const char* string, voxel::VertexArray& vertices, voxel::VertexIndexArray& indices);
 };
 
 }
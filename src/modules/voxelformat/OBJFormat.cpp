@@ -55,6 +55,7 @@ bool OBJFormat::saveMeshes(const Meshes& meshes, const io::FilePtr &file, float
 
 	int idxOffset = 0;
 	int texcoordOffset = 0;
+	voxel::VertexIndexArray indices;
 	for (const auto& meshExt : meshes) {
 		const voxel::Mesh* mesh = meshExt.mesh;
 		Log::debug("Exporting layer %s", meshExt.name.c_str());
@@ -66,7 +67,7 @@ bool OBJFormat::saveMeshes(const Meshes& meshes, const io::FilePtr &file, float
 		}
 		const glm::vec3 offset(mesh->getOffset());
 		const voxel::VoxelVertex* vertices = mesh->getRawVertexData();
-		const voxel::IndexType* indices = mesh->getRawIndexData();
+		mesh->resolveIndices(indices);
 		const char *objectName = meshExt.name.c_str();
 		if (objectName[0] == '\0') {
 			objectName = "Noname";
@@ -85,6 +85,7 @@ bool PLYFormat::saveMeshes(const Meshes& meshes, const io::FilePtr &file, float
 	}
 
 	int idxOffset = 0;
+	voxel::VertexIndexArray meshIndices;
 	for (const auto& meshExt : meshes) {
 		const voxel::Mesh& mesh = *meshExt.mesh;
 		const int ni = mesh.getNoOfIndices();
@@ -93,7 +94,8 @@ bool PLYFormat::saveMeshes(const Meshes& meshes, const io::FilePtr &file, float
 			Log::error("Unexpected indices amount");
 			return false;
 		}
-		const voxel::IndexType* indices = mesh.getRawIndexData();
+		mesh.resolveIndices(meshIndices);
+		const uint32_t* indices = meshIndices.data();
 		if (quad) {
 			for (int i = 0; i < ni; i += 6) {
 				const uint32_t one   = idxOffset + indices[i + 0];
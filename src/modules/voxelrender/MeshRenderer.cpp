@@ -116,13 +116,19 @@ void MeshRenderer::renderShadows(const video::Camera& camera) {
 			}
 			video::ScopedBuffer scopedBuf(mesh.buffer);
 			_shadowMapShader.setModel(mesh.model);
-			video::drawElements<voxel::IndexType>(video::Primitive::Triangles, nIndices);
+			draw(mesh);
 		}
 		return true;
 	});
 	_shadowMapShader.deactivate();
 }
 
+void MeshRenderer::draw(const MeshInternal& mesh) const {
+	for (const voxel::IndexRange& range : mesh.ranges) {
+		video::drawElementsBaseVertex<voxel::IndexType>(video::Primitive::Triangles, range.numIndices, (int)range.firstIndex, (int)range.baseVertex);
+	}
+}
+
 void MeshRenderer::prepareShader(const video::Camera& camera) {
 	if (_voxelShader.isDirty()) {
 		_voxelShader.setMaterialblock(_materialBlock);
@@ -158,7 +164,7 @@ void MeshRenderer::render(int idx, const video::Camera& camera) {
 	_voxelShader.setModel(mesh.model);
 
 	video::ScopedBuffer scopedBuf(mesh.buffer);
-	video::drawElements<voxel::IndexType>(video::Primitive::Triangles, nIndices);
+	draw(mesh);
 }
 
 void MeshRenderer::renderAll(const video::Camera &camera) {
@@ -179,7 +185,7 @@ void MeshRenderer::renderAll(const video::Camera &camera) {
 		}
 		video::ScopedBuffer scopedBuf(mesh.buffer);
 		_voxelShader.setModel(mesh.model);
-		video::drawElements<voxel::IndexType>(video::Primitive::Triangles, nIndices);
+		draw(mesh);
 	}
 }
 
@@ -223,7 +229,9 @@ bool MeshRenderer::setMesh(int idx, const voxel::Mesh *mesh, const glm::mat4 &mo
 	entry.mesh = mesh;
 	entry.model = model;
 
+	entry.ranges.clear();
 	if (entry.mesh != nullptr) {
+		entry.ranges = entry.mesh->getIndexRanges();
 		const voxel::VoxelVertex* vertices = entry.mesh->getRawVertexData();
 		const size_t numVertices = entry.mesh->getNoOfVertices();
 		const voxel::IndexType* indices = entry.mesh->getRawIndexData();
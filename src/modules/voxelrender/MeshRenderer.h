@@ -9,17 +9,13 @@
 #include "RenderShaders.h"
 #include "render/Shadow.h"
 #include "core/GLM.h"
-#include "voxel/VoxelVertex.h"
+#include "voxel/Mesh.h"
 #include "core/collection/Array.h"
 
 namespace video {
 class Camera;
 }
 
-namespace voxel {
-class Mesh;
-}
-
 namespace voxelrender {
 
 /**
@@ -35,6 +31,7 @@ protected:
 		glm::mat4 model;
 		int32_t vbo = -1;
 		int32_t ibo = -1;
+		voxel::IndexRangeArray ranges;
 
 		inline uint32_t numIndices() const {
 			return buffer.elements(ibo, 1, sizeof(voxel::IndexType));
@@ -49,6 +46,10 @@ protected:
 
 	bool isEmpty() const;
 	bool update(int idx, const voxel::VoxelVertex* vertices, size_t numVertices, const voxel::IndexType* indices, size_t numIndices);
+	/**
+	 * @brief Draws the index ranges of the mesh with their base vertex
+	 */
+	void draw(const MeshInternal& mesh) const;
 	void prepareState();
 	void renderShadows(const video::Camera& camera);
 	void prepareShader(const video::Camera& camera);
@@ -24,6 +24,7 @@
 #include "core/Log.h"
 #include "core/Algorithm.h"
 #include "core/StandardLib.h"
+#include "core/TimeProvider.h"
 #include "VoxelShaderConstants.h"
 #include <SDL.h>
 #include <unordered_set>
@@ -84,6 +85,9 @@ bool RawVolumeRenderer::init() {
 			Log::error("Could not create the vertex buffer object for the indices");
 			return false;
 		}
+		// the blocks are patched into the buffers - see updateBlock()
+		_vertexBuffer[idx].setMode(_vertexBufferIndex[idx], video::BufferMode::Dynamic);
+		_vertexBuffer[idx].setMode(_indexBufferIndex[idx], video::BufferMode::Dynamic);
 	}
 
 	const int shaderMaterialColorsArraySize = lengthof(shader::VoxelData::MaterialblockData::materialcolor);
@@ -110,6 +114,7 @@ bool RawVolumeRenderer::init() {
 		Log::error("Failed to initialize the indirect draw buffer");
 		return false;
 	}
+	_multiDrawIndirect = video::hasFeature(video::Feature::MultiDrawIndirect);
 
 	render::ShadowParameters shadowParams;
 	shadowParams.maxDepthBuffers = shader::VoxelShaderConstants::getMaxDepthBuffers();
@@ -130,80 +135,165 @@ bool RawVolumeRenderer::init() {
 void RawVolumeRenderer::update() {
 	ExtractionCtx result;
 	int cnt = 0;
+	core::Array<bool, MAX_VOLUMES> dirty {{ false }};
 	while (_pendingQueue.pop(result)) {
 		Meshes& meshes = _meshes[result.mins];
 		if (meshes[result.idx] != nullptr) {
 			delete meshes[result.idx];
 		}
 		meshes[result.idx] = new voxel::Mesh(core::move(result.mesh));
-		if (!update(result.idx)) {
-			Log::error("Failed to update the mesh at index %i", result.idx);
+		dirty[result.idx] = true;
+		if (_volumeBuffers[result.idx].valid && !updateBlock(result.idx, result.mins)) {
+			// no space left - rebuild the whole buffer below
+			_volumeBuffers[result.idx].valid = false;
+		}
+		if (result.modified > 0u) {
+			_meshLatencyMillis = (double)(core::TimeProvider::highResTime() - result.modified) * 1000.0 / (double)core::TimeProvider::highResTimeResolution();
+			Log::debug("Mesh for idx %i is ready after %.2fms", result.idx, _meshLatencyMillis);
 		}
 		++cnt;
 	}
+	for (int idx = 0; idx < MAX_VOLUMES; ++idx) {
+		if (!dirty[idx]) {
+			continue;
+		}
+		if (!_volumeBuffers[idx].valid) {
+			if (!update(idx)) {
+				Log::error("Failed to update the mesh at index %i", idx);
+			}
+			continue;
+		}
+		updateDrawCommands(idx);
+	}
 	if (cnt > 0) {
 		Log::debug("Perform %i mesh updates in this frame", cnt);
 	}
 }
 
+bool RawVolumeRenderer::updateBlock(int idx, const glm::ivec3& mins) {
+	core_trace_scoped(RawVolumeRendererUpdateBlock);
+	VolumeBuffer& volumeBuffer = _volumeBuffers[idx];
+	const voxel::Mesh* mesh = _meshes[mins][idx];
+	const uint32_t vertices = (uint32_t)mesh->getNoOfVertices();
+	const uint32_t indices = (uint32_t)mesh->getNoOfIndices();
+
+	auto iter = volumeBuffer.slots.find(mins);
+	if (iter == volumeBuffer.slots.end() || iter->second.vertexCapacity < vertices || iter->second.indexCapacity < indices) {
+		// the old slot (if any) is lost until the next rebuild
+		const uint32_t vertexCapacity = slotCapacity(vertices);
+		const uint32_t indexCapacity = slotCapacity(indices);
+		if (volumeBuffer.usedVertices + vertexCapacity > volumeBuffer.vertexCapacity
+				|| volumeBuffer.usedIndices + indexCapacity > volumeBuffer.indexCapacity) {
+			return false;
+		}
+		BufferSlot slot;
+		slot.vertexOffset = volumeBuffer.usedVertices;
+		slot.vertexCapacity = vertexCapacity;
+		slot.indexOffset = volumeBuffer.usedIndices;
+		slot.indexCapacity = indexCapacity;
+		volumeBuffer.usedVertices += vertexCapacity;
+		volumeBuffer.usedIndices += indexCapacity;
+		iter = volumeBuffer.slots.insert_or_assign(mins, slot).first;
+	}
+	if (indices == 0u) {
+		return true;
+	}
+	const BufferSlot& slot = iter->second;
+	if (!_vertexBuffer[idx].update(_vertexBufferIndex[idx], slot.vertexOffset * sizeof(voxel::VoxelVertex), mesh->getRawVertexData(), vertices * sizeof(voxel::VoxelVertex))) {
+		Log::error("Failed to update the vertex buffer");
+		return false;
+	}
+	if (!_vertexBuffer[idx].update(_indexBufferIndex[idx], slot.indexOffset * sizeof(voxel::IndexType), mesh->getRawIndexData(), indices * sizeof(voxel::IndexType))) {
+		Log::error("Failed to update the index buffer");
+		return false;
+	}
+	return true;
+}
+
+void RawVolumeRenderer::updateDrawCommands(int idx) {
+	_volumeCommands[idx].clear();
+	for (const auto& i : _volumeBuffers[idx].slots) {
+		auto meshIter = _meshes.find(i.first);
+		if (meshIter == _meshes.end()) {
+			continue;
+		}
+		const voxel::Mesh* mesh = meshIter->second[idx];
+		if (mesh == nullptr) {
+			continue;
+		}
+		const BufferSlot& slot = i.second;
+		// the indices are uploaded as they are - each index range gets its own draw command with
+		// the offsets of the slot
+		for (const voxel::IndexRange& range : mesh->getIndexRanges()) {
+			video::DrawElementsIndirectCommand cmd;
+			cmd.count = range.numIndices;
+			cmd.instanceCount = 1u;
+			cmd.firstIndex = slot.indexOffset + range.firstIndex;
+			cmd.baseVertex = slot.vertexOffset + range.baseVertex;
+			cmd.baseInstance = 0u;
+			_volumeCommands[idx].push_back(cmd);
+		}
+	}
+}
+
 bool RawVolumeRenderer::update(int idx) {
 	if (idx < 0 || idx >= MAX_VOLUMES) {
 		return false;
 	}
 	core_trace_scoped(RawVolumeRendererUpdate);
 
-	size_t vertCount = 0u;
-	size_t indCount = 0u;
+	VolumeBuffer& volumeBuffer = _volumeBuffers[idx];
+	volumeBuffer.slots.clear();
+	volumeBuffer.usedVertices = 0u;
+	volumeBuffer.usedIndices = 0u;
+	volumeBuffer.valid = true;
+	_volumeCommands[idx].clear();
+
+	// every block gets a slot with some space to grow
 	for (auto& i : _meshes) {
-		const Meshes& meshes = i.second;
-		const voxel::Mesh* mesh = meshes[idx];
-		if (mesh == nullptr || mesh->getNoOfIndices() <= 0) {
+		const voxel::Mesh* mesh = i.second[idx];
+		if (mesh == nullptr) {
 			continue;
 		}
-		const voxel::VertexArray& vertexVector = mesh->getVertexVector();
-		const voxel::IndexArray& indexVector = mesh->getIndexVector();
-		vertCount += vertexVector.size();
-		indCount += indexVector.size();
-	}
-
-	if (indCount == 0u || vertCount == 0u) {
+		BufferSlot slot;
+		slot.vertexOffset = volumeBuffer.usedVertices;
+		slot.vertexCapacity = slotCapacity((uint32_t)mesh->getNoOfVertices());
+		slot.indexOffset = volumeBuffer.usedIndices;
+		slot.indexCapacity = slotCapacity((uint32_t)mesh->getNoOfIndices());
+		volumeBuffer.usedVertices += slot.vertexCapacity;
+		volumeBuffer.usedIndices += slot.indexCapacity;
+		volumeBuffer.slots.emplace(i.first, slot);
+	}
+
+	if (volumeBuffer.usedIndices == 0u || volumeBuffer.usedVertices == 0u) {
+		volumeBuffer.vertexCapacity = 0u;
+		volumeBuffer.indexCapacity = 0u;
 		_vertexBuffer[idx].update(_vertexBufferIndex[idx], nullptr, 0);
 		_vertexBuffer[idx].update(_indexBufferIndex[idx], nullptr, 0);
 		return true;
 	}
 
-	const size_t verticesBufSize = vertCount * sizeof(voxel::VoxelVertex);
+	// leave some space for new blocks at the end of the buffers
+	volumeBuffer.vertexCapacity = volumeBuffer.usedVertices + volumeBuffer.usedVertices / 4u;
+	volumeBuffer.indexCapacity = volumeBuffer.usedIndices + volumeBuffer.usedIndices / 4u;
+
+	const size_t verticesBufSize = volumeBuffer.vertexCapacity * sizeof(voxel::VoxelVertex);
 	voxel::VoxelVertex* verticesBuf = (voxel::VoxelVertex*)core_malloc(verticesBufSize);
-	const size_t indicesBufSize = indCount * sizeof(voxel::IndexType);
+	const size_t indicesBufSize = volumeBuffer.indexCapacity * sizeof(voxel::IndexType);
 	voxel::IndexType* indicesBuf = (voxel::IndexType*)core_malloc(indicesBufSize);
 
-	voxel::VoxelVertex* verticesPos = verticesBuf;
-	voxel::IndexType* indicesPos = indicesBuf;
-
-	voxel::IndexType offset = (voxel::IndexType)0;
-	for (auto& i : _meshes) {
-		const Meshes& meshes = i.second;
-		const voxel::Mesh* mesh = meshes[idx];
-		if (mesh == nullptr || mesh->getNoOfIndices() <= 0) {
-			continue;
-		}
-		const voxel::VertexArray& vertexVector = mesh->getVertexVector();
-		const voxel::IndexArray& indexVector = mesh->getIndexVector();
-		core_memcpy(verticesPos, &vertexVector[0], vertexVector.size() * sizeof(voxel::VoxelVertex));
-		core_memcpy(indicesPos, &indexVector[0], indexVector.size() * sizeof(voxel::IndexType));
-
-		for (size_t i = 0; i < indexVector.size(); ++i) {
-			*indicesPos++ += offset;
-		}
-
-		verticesPos += vertexVector.size();
-		offset += vertexVector.size();
+	for (const auto& i : volumeBuffer.slots) {
+		const voxel::Mesh* mesh = _meshes[i.first][idx];
+		const BufferSlot& slot = i.second;
+		core_memcpy(verticesBuf + slot.vertexOffset, mesh->getRawVertexData(), mesh->getNoOfVertices() * sizeof(voxel::VoxelVertex));
+		core_memcpy(indicesBuf + slot.indexOffset, mesh->getRawIndexData(), mesh->getNoOfIndices() * sizeof(voxel::IndexType));
 	}
 
 	if (!_vertexBuffer[idx].update(_vertexBufferIndex[idx], verticesBuf, verticesBufSize)) {
 		Log::error("Failed to update the vertex buffer");
 		core_free(indicesBuf);
 		core_free(verticesBuf);
+		volumeBuffer.valid = false;
 		return false;
 	}
 	core_free(verticesBuf);
@@ -211,33 +301,42 @@ bool RawVolumeRenderer::update(int idx) {
 	if (!_vertexBuffer[idx].update(_indexBufferIndex[idx], indicesBuf, indicesBufSize)) {
 		Log::error("Failed to update the index buffer");
 		core_free(indicesBuf);
+		volumeBuffer.valid = false;
 		return false;
 	}
 	core_free(indicesBuf);
+	updateDrawCommands(idx);
 	return true;
 }
 
-bool RawVolumeRenderer::update(int idx, const voxel::VertexArray& vertices, const voxel::IndexArray& indices) {
+bool RawVolumeRenderer::update(int idx, const voxel::VertexArray& vertices, const voxel::VertexIndexArray& indices) {
 	if (idx < 0 || idx >= MAX_VOLUMES) {
 		return false;
 	}
-	core_trace_scoped(RawVolumeRendererUpdate);
 
-	if (indices.empty() || vertices.empty()) {
-		_vertexBuffer[idx].update(_vertexBufferIndex[idx], nullptr, 0);
-		_vertexBuffer[idx].update(_indexBufferIndex[idx], nullptr, 0);
-		return true;
+	// split the indices into ranges that fit into the 16 bit index type
+	voxel::Mesh* mesh = new voxel::Mesh((int)vertices.size(), (int)indices.size(), true);
+	for (const voxel::VoxelVertex& vertex : vertices) {
+		mesh->addVertex(vertex);
 	}
-
-	if (!_vertexBuffer[idx].update(_vertexBufferIndex[idx], &vertices.front(), vertices.size() * sizeof(voxel::VertexArray::value_type))) {
-		Log::error("Failed to update the vertex buffer");
-		return false;
+	for (size_t i = 0u; i + 2u < indices.size(); i += 3u) {
+		mesh->addTriangle(indices[i], indices[i + 1], indices[i + 2]);
 	}
-	if (!_vertexBuffer[idx].update(_indexBufferIndex[idx], &indices.front(), indices.size() * sizeof(voxel::IndexArray::value_type))) {
-		Log::error("Failed to update the index buffer");
-		return false;
+	mesh->removeUnusedVertices();
+
+	deleteMeshes(idx);
+	_meshes[glm::ivec3(0)][idx] = mesh;
+	return update(idx);
+}
+
+void RawVolumeRenderer::deleteMeshes(int idx) {
+	for (auto& i : _meshes) {
+		Meshes& meshes = i.second;
+		delete meshes[idx];
+		meshes[idx] = nullptr;
 	}
-	return true;
+	// the buffer layout doesn't match the meshes anymore
+	_volumeBuffers[idx].valid = false;
 }
 
 void RawVolumeRenderer::setAmbientColor(const glm::vec3& color) {
@@ -332,14 +431,7 @@ bool RawVolumeRenderer::translate(int idx, const glm::ivec3& m) {
 		return false;
 	}
 	volume->translate(m);
-	for (auto& i : _meshes) {
-		Meshes& meshes = i.second;
-		if (meshes[idx] == nullptr) {
-			continue;
-		}
-		delete meshes[idx];
-		meshes[idx] = nullptr;
-	}
+	deleteMeshes(idx);
 	return true;
 }
 
@@ -349,7 +441,12 @@ voxel::Region RawVolumeRenderer::calculateExtractRegion(int x, int y, int z, con
 	return voxel::Region{mins, maxs};
 }
 
-bool RawVolumeRenderer::extractRegion(int idx, const voxel::Region& region) {
+static inline int floorDiv(int a, int b) {
+	const int d = a / b;
+	return (a % b != 0 && (a < 0) != (b < 0)) ? d - 1 : d;
+}
+
+bool RawVolumeRenderer::extractRegion(int idx, const voxel::Region& region, uint64_t modified) {
 	core_trace_scoped(RawVolumeRendererExtract);
 	if (idx < 0 || idx >= MAX_VOLUMES) {
 		return false;
@@ -358,17 +455,23 @@ bool RawVolumeRenderer::extractRegion(int idx, const voxel::Region& region) {
 	if (volume == nullptr) {
 		return false;
 	}
+	if (modified == 0u) {
+		modified = core::TimeProvider::highResTime();
+	}
 
 	const int s = _meshSize->intVal();
 	const glm::ivec3 meshSize(s);
-	const glm::ivec3 meshSizeMinusOne(s - 1);
 	const voxel::Region& completeRegion = volume->region();
 
-	// convert to step coordinates that are needed to extract
-	// the given region mesh size ranges
-	const glm::ivec3& l = (region.getLowerCorner() - meshSizeMinusOne) / meshSize;
-	const glm::ivec3& u = region.getUpperCorner() / meshSize;
+	// a block is extracted with one voxel of its upper neighbours - and the extractor looks at the direct
+	// neighbours of each voxel for the face culling and the ambient occlusion. So a modified voxel touches
+	// the blocks that contain the voxels from two below to one above of it.
+	const glm::ivec3& lower = region.getLowerCorner() - 2;
+	const glm::ivec3& upper = region.getUpperCorner() + 1;
+	const glm::ivec3 l(floorDiv(lower.x, s), floorDiv(lower.y, s), floorDiv(lower.z, s));
+	const glm::ivec3 u(floorDiv(upper.x, s), floorDiv(upper.y, s), floorDiv(upper.z, s));
 
+	bool deleted = false;
 	for (int x = l.x; x <= u.x; ++x) {
 		for (int y = l.y; y <= u.y; ++y) {
 			for (int z = l.z; z <= u.z; ++z) {
@@ -377,28 +480,34 @@ bool RawVolumeRenderer::extractRegion(int idx, const voxel::Region& region) {
 
 				if (!voxel::intersects(completeRegion, finalRegion)) {
 					auto i = _meshes.find(mins);
-					if (i != _meshes.end()) {
+					if (i != _meshes.end() && i->second[idx] != nullptr) {
 						Meshes& meshes = i->second;
 						delete meshes[idx];
 						meshes[idx] = nullptr;
+						deleted = true;
 					}
 					continue;
 				}
 
-				voxel::RawVolume copy(volume);
-				_threadPool.enqueue([movedCopy = core::move(copy), mins, idx, finalRegion, this] () {
+				// only copy the voxels the extractor is looking at
+				const voxel::Region copyRegion(mins - 1, finalRegion.getUpperCorner() + 2);
+				voxel::RawVolume copy(*volume, copyRegion);
+				_threadPool.schedule([movedCopy = core::move(copy), mins, idx, finalRegion, modified, this] () {
 					++_runningExtractorTasks;
 					voxel::Region reg = finalRegion;
 					reg.shiftUpperCorner(1, 1, 1);
 					voxel::Mesh mesh(65536, 65536, true);
 					voxel::extractCubicMesh(&movedCopy, reg, &mesh, raw::CustomIsQuadNeeded(), reg.getLowerCorner());
-					_pendingQueue.emplace(mins, idx, core::move(mesh));
+					_pendingQueue.emplace(mins, idx, core::move(mesh), modified);
 					Log::debug("Enqueue mesh for idx: %i", idx);
 					--_runningExtractorTasks;
 				});
 			}
 		}
 	}
+	if (deleted && _volumeBuffers[idx].valid) {
+		updateDrawCommands(idx);
+	}
 	return true;
 }
 
@@ -437,6 +546,20 @@ void RawVolumeRenderer::hide(int idx, bool hide) {
 	_hidden[idx] = hide;
 }
 
+void RawVolumeRenderer::draw(int idx) const {
+	const uint32_t offset = _drawCommandOffset[idx];
+	const uint32_t commands = drawCommands(idx);
+	if (_multiDrawIndirect) {
+		void* bufferOffset = (void*)(intptr_t)(offset * sizeof(video::DrawElementsIndirectCommand));
+		video::drawMultiElementsIndirect<voxel::IndexType>(video::Primitive::Triangles, bufferOffset, commands);
+		return;
+	}
+	for (uint32_t i = offset; i < offset + commands; ++i) {
+		void* bufferOffset = (void*)(intptr_t)(i * sizeof(video::DrawElementsIndirectCommand));
+		video::drawElementsIndirect<voxel::IndexType>(video::Primitive::Triangles, bufferOffset);
+	}
+}
+
 void RawVolumeRenderer::render(const video::Camera& camera, bool shadow) {
 	core_trace_scoped(RawVolumeRendererRender);
 
@@ -448,25 +571,22 @@ void RawVolumeRenderer::render(const video::Camera& camera, bool shadow) {
 		voxel::materialColorMarkClean();
 	}
 
-	core_memset(_drawCommands, 0, sizeof(_drawCommands));
-
-	uint32_t numIndices = 0u;
+	// upload the commands of the visible volumes - each volume has one command per index range
+	_drawCommands.clear();
 	for (int idx = 0; idx < MAX_VOLUMES; ++idx) {
+		_drawCommandOffset[idx] = (uint32_t)_drawCommands.size();
 		if (_hidden[idx]) {
 			continue;
 		}
-		const uint32_t nIndices = _vertexBuffer[idx].elements(_indexBufferIndex[idx], 1, sizeof(voxel::IndexType));
-		if (nIndices <= 0) {
-			continue;
+		for (const video::DrawElementsIndirectCommand& cmd : _volumeCommands[idx]) {
+			_drawCommands.push_back(cmd);
 		}
-		numIndices += nIndices;
-		_drawCommands[idx].count = nIndices;
-		_drawCommands[idx].instanceCount = 1;
 	}
-	if (numIndices == 0u) {
+	_drawCommandOffset[MAX_VOLUMES] = (uint32_t)_drawCommands.size();
+	if (_drawCommands.empty()) {
 		return;
 	}
-	core_assert_always(_indirectDrawBuffer.update(_drawCommands, sizeof(_drawCommands)));
+	core_assert_always(_indirectDrawBuffer.update(_drawCommands.data(), _drawCommands.size() * sizeof(video::DrawElementsIndirectCommand)));
 
 	video::ScopedState scopedDepth(video::State::DepthTest);
 	video::depthFunc(video::CompareFunc::LessEqual);
@@ -480,14 +600,12 @@ void RawVolumeRenderer::render(const video::Camera& camera, bool shadow) {
 			_shadow.render([this] (int i, const glm::mat4& lightViewProjection) {
 				_shadowMapShader.setLightviewprojection(lightViewProjection);
 				for (int idx = 0; idx < MAX_VOLUMES; ++idx) {
-					if (_drawCommands[idx].count <= 0u) {
+					if (drawCommands(idx) <= 0u) {
 						continue;
 					}
 					video::ScopedBuffer scopedBuf(_vertexBuffer[idx]);
 					_shadowMapShader.setModel(_model[idx]);
-					static_assert(sizeof(voxel::IndexType) == sizeof(uint32_t), "Index type doesn't match");
-					void* bufferOffset = (void*)(intptr_t)(idx * sizeof(_drawCommands[0]));
-					video::drawElementsIndirect<voxel::IndexType>(video::Primitive::Triangles, bufferOffset);
+					draw(idx);
 				}
 				return true;
 			}, true);
@@ -519,15 +637,14 @@ void RawVolumeRenderer::render(const video::Camera& camera, bool shadow) {
 	}
 
 	for (int idx = 0; idx < MAX_VOLUMES; ++idx) {
-		if (_drawCommands[idx].count <= 0u) {
+		if (drawCommands(idx) <= 0u) {
 			continue;
 		}
 		const glm::vec2 offset(-0.25f * idx, -0.5f * idx);
 		video::ScopedPolygonMode polygonMode(camera.polygonMode(), offset);
 		video::ScopedBuffer scopedBuf(_vertexBuffer[idx]);
 		_voxelShader.setModel(_model[idx]);
-		void* bufferOffset = (void*)(intptr_t)(idx * sizeof(_drawCommands[0]));
-		video::drawElementsIndirect<voxel::IndexType>(video::Primitive::Triangles, bufferOffset);
+		draw(idx);
 	}
 	_indirectDrawBuffer.unbind();
 }
@@ -569,11 +686,7 @@ voxel::RawVolume* RawVolumeRenderer::setVolume(int idx, voxel::RawVolume* volume
 	voxel::RawVolume* old = _rawVolume[idx];
 	_rawVolume[idx] = volume;
 	if (deleteMesh) {
-		for (auto& i : _meshes) {
-			Meshes& meshes = i.second;
-			delete meshes[idx];
-			meshes[idx] = nullptr;
-		}
+		deleteMeshes(idx);
 	}
 	return old;
 }
@@ -588,6 +701,7 @@ core::DynamicArray<voxel::RawVolume*> RawVolumeRenderer::shutdown() {
 	_shadowMapShader.shutdown();
 	_materialBlock.shutdown();
 	_indirectDrawBuffer.shutdown();
+	_drawCommands.clear();
 	for (auto& iter : _meshes) {
 		for (auto& mesh : iter.second) {
 			delete mesh;
@@ -599,6 +713,8 @@ core::DynamicArray<voxel::RawVolume*> RawVolumeRenderer::shutdown() {
 		_vertexBuffer[idx].shutdown();
 		_vertexBufferIndex[idx] = -1;
 		_indexBufferIndex[idx] = -1;
+		_volumeCommands[idx].clear();
+		_volumeBuffers[idx] = VolumeBuffer();
 		// hand over the ownership to the caller
 		old.push_back(_rawVolume[idx]);
 		_rawVolume[idx] = nullptr;
@@ -54,7 +54,57 @@ protected:
 	MeshesMap _meshes;
 
 	video::IndirectDrawBuffer _indirectDrawBuffer;
-	video::DrawElementsIndirectCommand _drawCommands[MAX_VOLUMES];
+	/**
+	 * The draw commands for the index ranges of the meshes of each volume
+	 */
+	core::DynamicArray<video::DrawElementsIndirectCommand> _volumeCommands[MAX_VOLUMES];
+	/**
+	 * The commands of the visible volumes that are uploaded to the indirect draw buffer - the commands
+	 * of a volume start at @c _drawCommandOffset
+	 */
+	core::DynamicArray<video::DrawElementsIndirectCommand> _drawCommands;
+	uint32_t _drawCommandOffset[MAX_VOLUMES + 1] {};
+	bool _multiDrawIndirect = false;
+
+	/**
+	 * @brief The part of the vertex and index buffer of a volume that belongs to one block mesh
+	 */
+	struct BufferSlot {
+		uint32_t vertexOffset = 0u;
+		uint32_t vertexCapacity = 0u;
+		uint32_t indexOffset = 0u;
+		uint32_t indexCapacity = 0u;
+	};
+	/**
+	 * @brief The block meshes are patched into their slots of the buffers of the volume. The
+	 * buffers are only rebuilt if a block doesn't fit into its slot or the space at the end of
+	 * the buffers anymore.
+	 */
+	struct VolumeBuffer {
+		std::unordered_map<glm::ivec3, BufferSlot> slots;
+		uint32_t usedVertices = 0u;
+		uint32_t usedIndices = 0u;
+		uint32_t vertexCapacity = 0u;
+		uint32_t indexCapacity = 0u;
+		/** @c false if the slots don't match the meshes anymore */
+		bool valid = false;
+	};
+	VolumeBuffer _volumeBuffers[MAX_VOLUMES];
+	/**
+	 * The time it took from the modification to the mesh upload of the last extracted block
+	 */
+	double _meshLatencyMillis = 0.0;
+
+	static constexpr uint32_t slotCapacity(uint32_t elements) {
+		return elements + elements / 4u;
+	}
+	inline uint32_t drawCommands(int idx) const {
+		return _drawCommandOffset[idx + 1] - _drawCommandOffset[idx];
+	}
+	void draw(int idx) const;
+	bool updateBlock(int idx, const glm::ivec3& mins);
+	void updateDrawCommands(int idx);
+	void deleteMeshes(int idx);
 
 	video::Buffer _vertexBuffer[MAX_VOLUMES];
 	shader::VoxelData _materialBlock;
@@ -70,12 +120,14 @@ protected:
 
 	struct ExtractionCtx {
 		ExtractionCtx() {}
-		ExtractionCtx(const glm::ivec3& _mins, int _idx, voxel::Mesh&& _mesh) :
-				mins(_mins), idx(_idx), mesh(_mesh) {
+		ExtractionCtx(const glm::ivec3& _mins, int _idx, voxel::Mesh&& _mesh, uint64_t _modified) :
+				mins(_mins), idx(_idx), mesh(core::move(_mesh)), modified(_modified) {
 		}
 		glm::ivec3 mins;
 		int idx;
 		voxel::Mesh mesh;
+		/** high resolution time of the modification that triggered the extraction */
+		uint64_t modified = 0u;
 
 		inline bool operator<(const ExtractionCtx &rhs) const {
 			return idx < rhs.idx;
@@ -101,14 +153,29 @@ public:
 	const render::Shadow& shadow() const;
 
 	/**
-	 * @brief Updates the vertex buffers manually
-	 * @sa extract()
+	 * @brief Rebuilds the vertex buffers of the volume from all of its block meshes
+	 * @sa extractRegion()
 	 */
 	bool update(int idx);
 
-	bool update(int idx, const voxel::VertexArray& vertices, const voxel::IndexArray& indices);
+	/**
+	 * @brief Replaces the meshes of the volume with the given vertices
+	 * @param indices The vertex indices - they are split into 16 bit index ranges if needed
+	 */
+	bool update(int idx, const voxel::VertexArray& vertices, const voxel::VertexIndexArray& indices);
 
-	bool extractRegion(int idx, const voxel::Region& region);
+	/**
+	 * @brief Schedules the extraction of the blocks that are touched by the given region. The meshes are
+	 * patched into the buffers in @c update()
+	 * @param modified The @c core::TimeProvider::highResTime() of the modification to measure the latency
+	 * until the mesh is ready - @c 0 means now
+	 * @sa meshLatencyMillis()
+	 */
+	bool extractRegion(int idx, const voxel::Region& region, uint64_t modified = 0u);
+	/**
+	 * @return The milliseconds between the modification and the upload of the last extracted block mesh
+	 */
+	double meshLatencyMillis() const;
 
 	bool translate(int idx, const glm::ivec3& m);
 
@@ -159,6 +226,10 @@ public:
 	core::DynamicArray<voxel::RawVolume*> shutdown();
 };
 
+inline double RawVolumeRenderer::meshLatencyMillis() const {
+	return _meshLatencyMillis;
+}
+
 inline render::Shadow& RawVolumeRenderer::shadow() {
 	return _shadow;
 }
@@ -36,7 +36,7 @@ private:
 	int32_t _vertexBufferIndexId = -1;
 	glm::mat4 _viewProjectionMatrix { 1.0f };
 	glm::mat4 _modelMatrix { 1.0f };
-	voxel::IndexArray _indices;
+	voxel::VertexIndexArray _indices;
 	VertexData _data;
 	const int _fontSize;
 	const int _depth;
@@ -44,7 +44,45 @@ FloorTraceResult findWalkableFloor(voxel::PagedVolume::Sampler *sampler, const g
 	return FloorTraceResult();
 }
 
+bool findWalkableFloor(const voxel::PagedVolume::ColumnSummary& column, int y, int maxDistanceUpwards, FloorTraceResult& result) {
+	if (y > column.highestSolid) {
+		if (column.highestSolid == -1) {
+			// no floor below - the trace returns the start voxel
+			return false;
+		}
+		result = FloorTraceResult(column.highestSolid + 1, column.solid);
+		return true;
+	}
+	if (column.firstWalkable == -1) {
+		result = FloorTraceResult();
+		return true;
+	}
+	if (y < column.firstWalkable) {
+		// everything below the lowest enterable voxel is solid
+		const int maxDistance = core_min(maxDistanceUpwards, voxel::MAX_HEIGHT - y);
+		if (column.firstWalkable - y <= maxDistance) {
+			result = FloorTraceResult(column.firstWalkable, column.walkable);
+		} else {
+			result = FloorTraceResult();
+		}
+		return true;
+	}
+	// between enterable voxels and solid voxels above them - overhang or cave
+	return false;
+}
+
 FloorTraceResult findWalkableFloor(voxel::PagedVolume* volume, const glm::ivec3& position, int maxDistanceUpwards) {
+	core_trace_scoped(FindWalkableFloorColumn);
+	const int sideLength = volume->chunkSideLength();
+	// the column summary heights are relative to the chunk - only use them if the chunk covers the whole height
+	if (sideLength > voxel::MAX_HEIGHT && position.y >= 0 && position.y <= voxel::MAX_HEIGHT) {
+		const voxel::PagedVolume::ChunkPtr& chunk = volume->chunk(position);
+		const int mask = sideLength - 1;
+		FloorTraceResult result;
+		if (findWalkableFloor(chunk->column(position.x & mask, position.z & mask), position.y, maxDistanceUpwards, result)) {
+			return result;
+		}
+	}
 	voxel::PagedVolume::Sampler sampler(volume);
 	return findWalkableFloor(&sampler, position, maxDistanceUpwards);
 }
@@ -10,6 +10,16 @@
 namespace voxelutil {
 
 extern FloorTraceResult findWalkableFloor(voxel::PagedVolume::Sampler *sampler, const glm::ivec3& position, int maxDistanceUpwards);
+/**
+ * @brief Uses the column summary of the chunk if the chunk covers the whole height and falls back
+ * to tracing the voxels otherwise.
+ */
 extern FloorTraceResult findWalkableFloor(voxel::PagedVolume* volume, const glm::ivec3& position, int maxDistanceUpwards);
+/**
+ * @brief Answers the floor query for the given height from the column summary without touching the voxels
+ * @return @c false if the summary is not enough to answer the query (e.g. for positions inside
+ * of overhangs) - the voxels have to be traced then.
+ */
+extern bool findWalkableFloor(const voxel::PagedVolume::ColumnSummary& column, int y, int maxDistanceUpwards, FloorTraceResult& result);
 
 }
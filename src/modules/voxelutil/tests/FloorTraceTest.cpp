@@ -0,0 +1,133 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/PagedVolume.h"
+#include "voxel/Constants.h"
+#include "voxelutil/FloorTrace.h"
+#include "math/Random.h"
+#include "core/ArrayLength.h"
+
+namespace voxelutil {
+
+class FloorTraceTest: public app::AbstractTest {
+protected:
+	static constexpr uint16_t ChunkSideLength = 256u;
+
+	/**
+	 * @brief Columns with different ground heights - some of them with water above the ground
+	 * and some with an overhang above an air gap
+	 */
+	class Pager: public voxel::PagedVolume::Pager {
+	public:
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			const glm::ivec3& mins = ctx.region.getLowerCorner();
+			const voxel::Voxel dirt = voxel::createVoxel(voxel::VoxelType::Dirt, 0);
+			const voxel::Voxel rock = voxel::createVoxel(voxel::VoxelType::Rock, 0);
+			const voxel::Voxel water = voxel::createVoxel(voxel::VoxelType::Water, 0);
+			for (int x = 0; x < ChunkSideLength; ++x) {
+				for (int z = 0; z < ChunkSideLength; ++z) {
+					const int worldX = glm::abs(mins.x + x);
+					const int worldZ = glm::abs(mins.z + z);
+					const int height = (worldX * 7 + worldZ * 13) % 100 + 1;
+					for (int y = 0; y < height; ++y) {
+						ctx.chunk->setVoxel(x, y, z, dirt);
+					}
+					if ((worldX + worldZ) % 5 == 0) {
+						for (int y = height + 5; y < height + 8; ++y) {
+							ctx.chunk->setVoxel(x, y, z, rock);
+						}
+					} else if (worldX % 7 == 0) {
+						for (int y = height; y < height + 3; ++y) {
+							ctx.chunk->setVoxel(x, y, z, water);
+						}
+					}
+				}
+			}
+			return true;
+		}
+
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+	void compare(voxel::PagedVolume& volume, const glm::ivec3& pos, int maxDistanceUpwards) {
+		voxel::PagedVolume::Sampler sampler(&volume);
+		const FloorTraceResult& expected = findWalkableFloor(&sampler, pos, maxDistanceUpwards);
+		const FloorTraceResult& result = findWalkableFloor(&volume, pos, maxDistanceUpwards);
+		ASSERT_EQ(expected.heightLevel, result.heightLevel) << "Position " << pos.x << ":" << pos.y << ":" << pos.z
+				<< " with max distance " << maxDistanceUpwards;
+		ASSERT_TRUE(expected.voxel.isSame(result.voxel)) << "Position " << pos.x << ":" << pos.y << ":" << pos.z
+				<< " with max distance " << maxDistanceUpwards;
+	}
+
+	void compareColumn(voxel::PagedVolume& volume, int x, int z) {
+		for (int y = 0; y <= voxel::MAX_HEIGHT; ++y) {
+			compare(volume, glm::ivec3(x, y, z), voxel::MAX_HEIGHT);
+			compare(volume, glm::ivec3(x, y, z), 2);
+		}
+	}
+};
+
+TEST_F(FloorTraceTest, testColumnSummary) {
+	Pager pager;
+	voxel::PagedVolume volume(&pager, 512 * 1024 * 1024, ChunkSideLength, voxel::PagedVolume::ChunkStorage::Palette);
+	const int maxDistances[] = {0, 1, 3, voxel::MAX_HEIGHT};
+	math::Random random(1);
+	for (int i = 0; i < 100000; ++i) {
+		// two chunks - to also cover negative coordinates
+		const glm::ivec3 pos(random.random(-ChunkSideLength, ChunkSideLength - 1), random.random(0, voxel::MAX_HEIGHT),
+				random.random(0, ChunkSideLength - 1));
+		compare(volume, pos, maxDistances[random.random(0, lengthof(maxDistances) - 1)]);
+		if (HasFatalFailure()) {
+			return;
+		}
+	}
+}
+
+TEST_F(FloorTraceTest, testColumnSummaryModification) {
+	Pager pager;
+	voxel::PagedVolume volume(&pager, 512 * 1024 * 1024, ChunkSideLength, voxel::PagedVolume::ChunkStorage::Palette);
+	const voxel::PagedVolume::ChunkPtr& chunk = volume.chunk(glm::ivec3(0));
+	const voxel::Voxel air;
+	const voxel::Voxel grass = voxel::createVoxel(voxel::VoxelType::Grass, 0);
+	const voxel::Voxel water = voxel::createVoxel(voxel::VoxelType::Water, 0);
+
+	// dig into the ground
+	const voxel::PagedVolume::ColumnSummary column = chunk->column(1, 1);
+	ASSERT_GE(column.highestSolid, 1);
+	chunk->setVoxel(1, column.highestSolid, 1, air);
+	EXPECT_EQ(column.highestSolid - 1, chunk->column(1, 1).highestSolid);
+	compareColumn(volume, 1, 1);
+
+	// build above the ground
+	chunk->setVoxel(2, 200, 1, grass);
+	EXPECT_EQ(200, chunk->column(2, 1).highestSolid);
+	EXPECT_TRUE(grass.isSame(chunk->column(2, 1).solid));
+	compareColumn(volume, 2, 1);
+
+	// create a cave
+	chunk->setVoxel(3, 0, 1, air);
+	EXPECT_EQ(0, chunk->column(3, 1).firstWalkable);
+	compareColumn(volume, 3, 1);
+	chunk->setVoxel(3, 0, 1, grass);
+	compareColumn(volume, 3, 1);
+
+	// flood the column and drain it again
+	const int waterLevel = chunk->column(4, 1).highestSolid + 3;
+	chunk->setVoxel(4, waterLevel, 1, water);
+	EXPECT_EQ(waterLevel, chunk->column(4, 1).waterLevel);
+	chunk->setVoxel(4, waterLevel, 1, air);
+	EXPECT_NE(waterLevel, chunk->column(4, 1).waterLevel);
+	compareColumn(volume, 4, 1);
+
+	// fill a whole column
+	for (int y = 0; y < ChunkSideLength; ++y) {
+		chunk->setVoxel(5, y, 1, grass);
+	}
+	EXPECT_EQ(-1, chunk->column(5, 1).firstWalkable);
+	compareColumn(volume, 5, 1);
+}
+
+}
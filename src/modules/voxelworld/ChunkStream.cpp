@@ -0,0 +1,100 @@
+/**
+ * @file
+ */
+
+#include "ChunkStream.h"
+#include "core/StringUtil.h"
+#include <SDL_endian.h>
+#include <SDL_stdinc.h>
+
+namespace voxelworld {
+
+core::String ChunkStream::formatPositions(const glm::ivec3* positions, int amount) {
+	core::String str;
+	for (int i = 0; i < amount; ++i) {
+		if (i > 0) {
+			str += ",";
+		}
+		str += core::string::format("%i,%i,%i", positions[i].x, positions[i].y, positions[i].z);
+	}
+	return str;
+}
+
+bool ChunkStream::parsePositions(const char* str, core::DynamicArray<glm::ivec3>& positions) {
+	int values[3];
+	int n = 0;
+	const char *p = str;
+	while (*p != '\0') {
+		char *end = nullptr;
+		const long value = SDL_strtol(p, &end, 10);
+		if (end == p) {
+			return false;
+		}
+		values[n++] = (int)value;
+		if (n == 3) {
+			if ((int)positions.size() >= MaxChunksPerRequest) {
+				return false;
+			}
+			positions.emplace_back(values[0], values[1], values[2]);
+			n = 0;
+		}
+		p = end;
+		if (*p == ',') {
+			++p;
+			if (*p == '\0') {
+				return false;
+			}
+		} else if (*p != '\0') {
+			return false;
+		}
+	}
+	return n == 0 && !positions.empty();
+}
+
+void ChunkStream::writeFrame(core::ByteStream& out, const glm::ivec3& pos, const uint8_t* data, uint32_t size) {
+	out.addInt(pos.x);
+	out.addInt(pos.y);
+	out.addInt(pos.z);
+	out.addInt((int32_t)size);
+	if (size > 0u) {
+		out.append(data, size);
+	}
+}
+
+static inline uint32_t readUInt32(const uint8_t* buf) {
+	uint32_t val;
+	SDL_memcpy(&val, buf, sizeof(val));
+	return SDL_SwapLE32(val);
+}
+
+bool ChunkStream::feed(const uint8_t* data, size_t size, const FrameCallback& callback) {
+	_buf.append(data, size);
+	size_t offset = 0u;
+	bool valid = true;
+	while (_buf.size() - offset >= FrameHeaderSize) {
+		const uint8_t* frame = _buf.data() + offset;
+		const glm::ivec3 pos((int32_t)readUInt32(frame), (int32_t)readUInt32(frame + 4), (int32_t)readUInt32(frame + 8));
+		const uint32_t dataSize = readUInt32(frame + 12);
+		if (dataSize > MaxFrameDataSize) {
+			valid = false;
+			break;
+		}
+		if (_buf.size() - offset < FrameHeaderSize + dataSize) {
+			break;
+		}
+		callback(pos, dataSize > 0u ? frame + FrameHeaderSize : nullptr, dataSize);
+		offset += FrameHeaderSize + dataSize;
+	}
+	if (!valid) {
+		reset();
+		return false;
+	}
+	_buf.erase(0, offset);
+	return true;
+}
+
+void ChunkStream::reset() {
+	_buf.clear();
+}
+
+}
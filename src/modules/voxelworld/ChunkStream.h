@@ -0,0 +1,56 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/GLM.h"
+#include "core/String.h"
+#include "core/ByteStream.h"
+#include "core/collection/DynamicArray.h"
+#include <functional>
+#include <stdint.h>
+
+namespace voxelworld {
+
+/**
+ * @brief The protocol for streaming the compressed chunks from the server to the client.
+ *
+ * The client requests a list of chunks by their world positions - given as comma separated list in the
+ * form @c x,y,z,x,y,z,... The server answers with one frame per chunk as soon as the chunk is available. A frame
+ * is the world position of the chunk (3 x int32), the size of the compressed data (uint32) and the data. A
+ * size of @c 0 means that the server doesn't have the chunk.
+ */
+class ChunkStream {
+public:
+	/**
+	 * @brief The max amount of chunks that can be requested at once
+	 */
+	static constexpr int MaxChunksPerRequest = 64;
+
+	static core::String formatPositions(const glm::ivec3* positions, int amount);
+	/**
+	 * @return @c false if the string is not a valid list of positions or contains more than
+	 * @c MaxChunksPerRequest positions
+	 */
+	static bool parsePositions(const char* str, core::DynamicArray<glm::ivec3>& positions);
+	static void writeFrame(core::ByteStream& out, const glm::ivec3& pos, const uint8_t* data, uint32_t size);
+
+	using FrameCallback = std::function<void(const glm::ivec3& pos, const uint8_t* data, uint32_t size)>;
+	/**
+	 * @brief Collects the received data and calls the callback for every complete frame
+	 * @return @c false if the data is not a valid frame
+	 */
+	bool feed(const uint8_t* data, size_t size, const FrameCallback& callback);
+	/**
+	 * @brief Drops the incomplete frame of an aborted stream
+	 */
+	void reset();
+
+private:
+	static constexpr uint32_t FrameHeaderSize = 4u * sizeof(uint32_t);
+	static constexpr uint32_t MaxFrameDataSize = 64u * 1024u * 1024u;
+	core::DynamicArray<uint8_t> _buf;
+};
+
+}
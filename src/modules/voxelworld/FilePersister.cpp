@@ -8,60 +8,204 @@
 #include "app/App.h"
 #include "io/Filesystem.h"
 #include "core/Common.h"
+#include "core/StandardLib.h"
 #include "core/StringUtil.h"
 #include "core/Trace.h"
 #include "core/ByteStream.h"
 #include "core/Zip.h"
 #include "core/Log.h"
+#include "core/collection/DynamicArray.h"
 
 namespace voxelworld {
 
-static core::String getWorldName(const glm::ivec3& chunkPos, unsigned int seed) {
-	return core::string::format("world_%u_%i_%i_%i.wld", seed, chunkPos.x, chunkPos.y, chunkPos.z);
+static core::String getRegionName(const glm::ivec3& regionPos, unsigned int seed) {
+	return core::string::format("world_%u_%i_%i_%i.region", seed, regionPos.x, regionPos.y, regionPos.z);
+}
+
+static inline glm::ivec4 key(const glm::ivec3& pos, unsigned int seed) {
+	return glm::ivec4(pos, (int)seed);
+}
+
+FilePersister::~FilePersister() {
+	shutdown();
+}
+
+void FilePersister::shutdown() {
+	flush();
+}
+
+RegionFile* FilePersister::regionFile(const glm::ivec3& chunkPos, unsigned int seed) {
+	const glm::ivec3& regionPos = RegionFile::region(chunkPos);
+	const glm::ivec4& k = key(regionPos, seed);
+	auto i = _regions.find(k);
+	if (i != _regions.end()) {
+		i->value.lastAccess = ++_accessCounter;
+		return i->value.file.get();
+	}
+	const io::FilesystemPtr& filesystem = io::filesystem();
+	filesystem->createDir(filesystem->homePath());
+	Region region;
+	region.file = core::make_shared<RegionFile>(filesystem, filesystem->writePath(getRegionName(regionPos, seed).c_str()));
+	region.lastAccess = ++_accessCounter;
+	_regions.put(k, region);
+	closeIdleRegions(k);
+	return region.file.get();
+}
+
+void FilePersister::closeIdleRegions(const glm::ivec4& keep) {
+	while ((int)_regions.size() > MaxOpenRegions) {
+		glm::ivec4 oldest;
+		uint64_t oldestAccess = UINT64_MAX;
+		for (auto iter = _regions.begin(); iter != _regions.end(); ++iter) {
+			if (iter->value.lastAccess >= oldestAccess || iter->key == keep) {
+				continue;
+			}
+			// the pending chunks are written in the next flush - which might happen without the filesystem
+			bool pending = false;
+			for (auto p = _pending.begin(); p != _pending.end(); ++p) {
+				if (key(RegionFile::region(glm::ivec3(p->key)), (unsigned int)p->key.w) == iter->key) {
+					pending = true;
+					break;
+				}
+			}
+			if (!pending) {
+				oldest = iter->key;
+				oldestAccess = iter->value.lastAccess;
+			}
+		}
+		if (oldestAccess == UINT64_MAX) {
+			return;
+		}
+		Log::debug("Close the idle region file %i:%i:%i", oldest.x, oldest.y, oldest.z);
+		_regions.remove(oldest);
+	}
+}
+
+int FilePersister::openRegionFiles() {
+	core::ScopedLock lock(_lock);
+	return (int)_regions.size();
+}
+
+void FilePersister::put(const glm::ivec4& k, const Entry& entry) {
+	// resolve the region file while the filesystem is available - the last flush might happen in the destructor
+	regionFile(glm::ivec3(k), (unsigned int)k.w);
+	Entry pending;
+	if (_pending.get(k, pending)) {
+		core_free(pending.data);
+	}
+	_pending.put(k, entry);
+	if ((int)_pending.size() >= BatchSize) {
+		flushPending();
+	}
 }
 
 void FilePersister::erase(const voxel::Region& region, unsigned int seed) {
 	core_trace_scoped(WorldPersisterErase);
-#if 0
-	voxel::PagedVolume::ChunkPtr chunk = ctx.getChunk();
-	const io::FilesystemPtr& filesystem = io::filesystem();
-	const voxel::Region& region = ctx.region;
-	const core::String& filename = getWorldName(region, seed);
-	// TODO: filesystem->remove(filename);
-#endif
+	// the region lower corner is always a multiple of the chunk size
+	const glm::ivec3& chunkPos = region.getLowerCorner() / region.getDimensionsInVoxels();
+	core::ScopedLock lock(_lock);
+	put(key(chunkPos, seed), Entry{nullptr, 0u});
 }
 
 bool FilePersister::load(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) {
 	core_trace_scoped(WorldPersisterLoad);
-	const io::FilesystemPtr& filesystem = io::filesystem();
-	const core::String& filename = getWorldName(chunk->chunkPos(), seed);
-	const io::FilePtr& f = filesystem->open(filename);
-	if (!f->exists()) {
-		return false;
+	const glm::ivec3& chunkPos = chunk->chunkPos();
+	core::DynamicArray<uint8_t> buf;
+	{
+		core::ScopedLock lock(_lock);
+		Entry entry;
+		const uint8_t* data;
+		uint32_t size;
+		if (_pending.get(key(chunkPos, seed), entry)) {
+			data = entry.data;
+			size = entry.size;
+		} else {
+			data = regionFile(chunkPos, seed)->data(RegionFile::slot(chunkPos), size);
+		}
+		if (data == nullptr || size == 0u) {
+			return false;
+		}
+		// the mapping might change with the next write - decompress a copy outside of the lock
+		buf.insert(buf.end(), data, data + size);
 	}
-	Log::trace("Try to load world %s", f->name().c_str());
-	uint8_t *fileBuf;
-	const int fileLen = f->read((void **) &fileBuf);
-	const bool success = loadCompressed(chunk, fileBuf, fileLen);
-	delete[] fileBuf;
-	return success;
+	return loadCompressed(chunk, buf.data(), buf.size());
 }
 
 bool FilePersister::save(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) {
-	core_trace_scoped(WorldPersisterLoad);
+	core_trace_scoped(WorldPersisterSave);
 	core::ByteStream final;
 	if (!saveCompressed(chunk, final)) {
 		return false;
 	}
-	const core::String& filename = getWorldName(chunk->chunkPos(), seed);
-	const io::FilesystemPtr& filesystem = io::filesystem();
+	Entry entry;
+	entry.size = (uint32_t)final.getSize();
+	entry.data = (uint8_t*)core_malloc(entry.size);
+	core_memcpy(entry.data, final.getBuffer(), entry.size);
+	core::ScopedLock lock(_lock);
+	put(key(chunk->chunkPos(), seed), entry);
+	return true;
+}
 
-	if (!filesystem->write(filename, final.getBuffer(), final.getSize())) {
-		Log::error("Failed to write file %s", filename.c_str());
+bool FilePersister::save(const glm::ivec3& chunkPos, unsigned int seed, const uint8_t* data, size_t size) {
+	if (data == nullptr || size == 0u) {
 		return false;
 	}
-	Log::debug("Wrote file %s (%i)", filename.c_str(), (int)final.getSize());
+	Entry entry;
+	entry.size = (uint32_t)size;
+	entry.data = (uint8_t*)core_malloc(entry.size);
+	core_memcpy(entry.data, data, entry.size);
+	core::ScopedLock lock(_lock);
+	put(key(chunkPos, seed), entry);
 	return true;
 }
 
+bool FilePersister::contains(const glm::ivec3& chunkPos, unsigned int seed) {
+	core::ScopedLock lock(_lock);
+	Entry entry;
+	if (_pending.get(key(chunkPos, seed), entry)) {
+		return entry.size > 0u;
+	}
+	uint32_t size;
+	return regionFile(chunkPos, seed)->data(RegionFile::slot(chunkPos), size) != nullptr;
+}
+
+bool FilePersister::flushPending() {
+	core_trace_scoped(WorldPersisterFlush);
+	if (_pending.empty()) {
+		return true;
+	}
+	// group the pending chunks by their region file
+	typedef core::DynamicArray<RegionFile::Write> Writes;
+	core::DynamicMap<glm::ivec4, Writes, 64, glm::hash<glm::ivec4>> regions;
+	for (auto iter = _pending.begin(); iter != _pending.end(); ++iter) {
+		const glm::ivec3 chunkPos(iter->key);
+		const glm::ivec4& k = key(RegionFile::region(chunkPos), (unsigned int)iter->key.w);
+		auto i = regions.find(k);
+		if (i == regions.end()) {
+			regions.put(k, Writes());
+			i = regions.find(k);
+		}
+		i->value.push_back(RegionFile::Write{RegionFile::slot(chunkPos), iter->value.data, iter->value.size});
+	}
+	bool success = true;
+	for (auto iter = regions.begin(); iter != regions.end(); ++iter) {
+		const glm::ivec3 regionPos(iter->key);
+		RegionFile* file = regionFile(regionPos * RegionFile::RegionChunks, (unsigned int)iter->key.w);
+		if (!file->write(iter->value.data(), (int)iter->value.size())) {
+			success = false;
+		}
+	}
+	Log::debug("Wrote %i chunks into %i region files", (int)_pending.size(), (int)regions.size());
+	for (auto iter = _pending.begin(); iter != _pending.end(); ++iter) {
+		core_free(iter->value.data);
+	}
+	_pending.clear();
+	return success;
+}
+
+bool FilePersister::flush() {
+	core::ScopedLock lock(_lock);
+	return flushPending();
+}
+
 }
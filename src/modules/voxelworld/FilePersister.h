@@ -5,6 +5,12 @@
 #pragma once
 
 #include "ChunkPersister.h"
+#include "RegionFile.h"
+#include "core/GLM.h"
+#include "core/SharedPtr.h"
+#include "core/Trace.h"
+#include "core/concurrent/Lock.h"
+#include "core/collection/DynamicMap.h"
 
 namespace voxel {
 class PagedVolumeWrapper;
@@ -12,13 +18,81 @@ class PagedVolumeWrapper;
 
 namespace voxelworld {
 
+/**
+ * @brief Persists the chunks in region files in the home directory of the application.
+ *
+ * Saved chunks are kept in memory until @c BatchSize chunks are pending or @c flush() is called. They
+ * are then written with one write per region file.
+ *
+ * @sa RegionFile
+ */
 class FilePersister : public ChunkPersister {
+private:
+	struct Entry {
+		// nullptr and size 0 for erased chunks
+		uint8_t* data;
+		uint32_t size;
+	};
+	// chunk position and seed
+	typedef core::DynamicMap<glm::ivec4, Entry, 64, glm::hash<glm::ivec4>> Entries;
+	struct Region {
+		core::SharedPtr<RegionFile> file;
+		// the value of the access counter when the region file was used the last time
+		uint64_t lastAccess;
+	};
+	// region position and seed
+	typedef core::DynamicMap<glm::ivec4, Region, 64, glm::hash<glm::ivec4>> Regions;
+
+	static constexpr int BatchSize = 64;
+
+	Entries _pending core_thread_guarded_by(_lock);
+	Regions _regions core_thread_guarded_by(_lock);
+	uint64_t _accessCounter core_thread_guarded_by(_lock) = 0u;
+	core_trace_mutex(core::Lock, _lock, "FilePersister");
+
+	RegionFile* regionFile(const glm::ivec3& chunkPos, unsigned int seed) core_thread_requires(_lock);
+	/**
+	 * @brief Closes the least recently used region files that have no pending chunks until at most
+	 * @c MaxOpenRegions region files are left open
+	 * @param[in] keep The key of the region file that is about to be used
+	 */
+	void closeIdleRegions(const glm::ivec4& keep) core_thread_requires(_lock);
+	void put(const glm::ivec4& key, const Entry& entry) core_thread_requires(_lock);
+	bool flushPending() core_thread_requires(_lock);
 public:
-	virtual ~FilePersister() {}
+	/**
+	 * @brief The amount of region files that are kept open - each of them keeps a mapping and a file handle
+	 */
+	static constexpr int MaxOpenRegions = 16;
+
+	virtual ~FilePersister();
+
+	/**
+	 * @brief Writes the pending chunks
+	 */
+	void shutdown() override;
 
 	bool load(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) override;
 	bool save(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) override;
+	/**
+	 * @brief Stores chunk data that was already compressed by @c saveCompressed()
+	 */
+	bool save(const glm::ivec3& chunkPos, unsigned int seed, const uint8_t* data, size_t size);
 	void erase(const voxel::Region& region, unsigned int seed) override;
+	/**
+	 * @return @c true if the chunk is stored - without loading it
+	 */
+	bool contains(const glm::ivec3& chunkPos, unsigned int seed);
+
+	/**
+	 * @brief Writes the pending chunks to their region files
+	 */
+	bool flush();
+
+	/**
+	 * @return The amount of region files that are currently open
+	 */
+	int openRegionFiles();
 };
 
 }
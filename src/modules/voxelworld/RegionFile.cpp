@@ -0,0 +1,205 @@
+/**
+ * @file
+ */
+
+#include "RegionFile.h"
+#include "core/Assert.h"
+#include "core/Common.h"
+#include "core/Log.h"
+#include "core/Trace.h"
+#include <SDL_endian.h>
+#include <SDL_rwops.h>
+
+namespace voxelworld {
+
+RegionFile::RegionFile(const io::FilesystemPtr& filesystem, const core::String& path) :
+		_filesystem(filesystem), _path(path) {
+}
+
+void RegionFile::reset() {
+	for (int i = 0; i < Slots; ++i) {
+		_slots[i] = Slot();
+	}
+	_end = HeaderSize;
+	_liveBytes = 0u;
+	_valid = false;
+}
+
+bool RegionFile::map() {
+	if (_file.isOpen()) {
+		return true;
+	}
+	return _file.open(_path);
+}
+
+bool RegionFile::load() {
+	if (_loaded) {
+		return _valid;
+	}
+	_loaded = true;
+	reset();
+	if (!map()) {
+		return false;
+	}
+	const size_t fileSize = _file.size();
+	if (fileSize < HeaderSize) {
+		Log::warn("Region file %s is truncated", _path.c_str());
+		return false;
+	}
+	const uint32_t* header = (const uint32_t*)_file.data();
+	if (SDL_SwapLE32(header[0]) != Magic || SDL_SwapLE32(header[1]) != Version) {
+		Log::warn("Region file %s has an invalid header", _path.c_str());
+		return false;
+	}
+	const uint32_t* table = header + 2;
+	for (int i = 0; i < Slots; ++i) {
+		Slot slot;
+		slot.offset = SDL_SwapLE32(table[i * 2 + 0]);
+		slot.size = SDL_SwapLE32(table[i * 2 + 1]);
+		if (slot.size == 0u) {
+			continue;
+		}
+		if (slot.offset < HeaderSize || (size_t)slot.offset + slot.size > fileSize) {
+			Log::warn("Region file %s has an invalid entry for slot %i", _path.c_str(), i);
+			continue;
+		}
+		_slots[i] = slot;
+		_liveBytes += slot.size;
+		_end = core_max(_end, slot.offset + slot.size);
+	}
+	_valid = true;
+	return true;
+}
+
+const uint8_t* RegionFile::data(int slot, uint32_t& size) {
+	core_assert(slot >= 0 && slot < Slots);
+	size = 0u;
+	if (!load()) {
+		return nullptr;
+	}
+	const Slot& s = _slots[slot];
+	if (s.size == 0u || !map()) {
+		return nullptr;
+	}
+	if ((size_t)s.offset + s.size > _file.size()) {
+		return nullptr;
+	}
+	size = s.size;
+	return _file.data() + s.offset;
+}
+
+bool RegionFile::writeHeader(io::File* file, const Slot* slots) {
+	uint32_t header[HeaderSize / sizeof(uint32_t)];
+	header[0] = SDL_SwapLE32(Magic);
+	header[1] = SDL_SwapLE32(Version);
+	for (int i = 0; i < Slots; ++i) {
+		header[2 + i * 2 + 0] = SDL_SwapLE32(slots[i].offset);
+		header[2 + i * 2 + 1] = SDL_SwapLE32(slots[i].size);
+	}
+	if (file->seek(0, RW_SEEK_SET) == -1) {
+		return false;
+	}
+	return file->write((const unsigned char*)header, sizeof(header)) == (long)sizeof(header);
+}
+
+bool RegionFile::write(const Write* writes, int amount) {
+	core_trace_scoped(RegionFileWrite);
+	load();
+	// the file is going to change - the mapping is recreated on the next read
+	_file.close();
+	const io::FilePtr& file = _filesystem->open(_path, _valid ? io::FileMode::SysUpdate : io::FileMode::SysWrite);
+	if (!file->validHandle()) {
+		Log::error("Failed to open region file %s for writing", _path.c_str());
+		return false;
+	}
+	bool success = file->seek(_end, RW_SEEK_SET) != -1;
+	for (int i = 0; success && i < amount; ++i) {
+		const Write& w = writes[i];
+		core_assert(w.slot >= 0 && w.slot < Slots);
+		Slot& slot = _slots[w.slot];
+		_liveBytes -= slot.size;
+		slot = Slot();
+		if (w.size == 0u) {
+			continue;
+		}
+		if (file->write(w.data, w.size) != (long)w.size) {
+			success = false;
+			break;
+		}
+		slot.offset = _end;
+		slot.size = w.size;
+		_end += w.size;
+		_liveBytes += w.size;
+	}
+	// the offset table is written after the data - it never references data that wasn't written
+	if (success) {
+		success = writeHeader(file.get(), _slots);
+	}
+	file->close();
+	if (!success) {
+		Log::error("Failed to write region file %s", _path.c_str());
+		// read the offset table from disk again
+		_loaded = false;
+		return false;
+	}
+	_valid = true;
+	if (staleBytes() > _liveBytes && staleBytes() > MinCompactBytes) {
+		compact();
+	}
+	return true;
+}
+
+bool RegionFile::compact() {
+	core_trace_scoped(RegionFileCompact);
+	if (!load() || !map()) {
+		return false;
+	}
+	const core::String tmpPath = _path + ".tmp";
+	const io::FilePtr& file = _filesystem->open(tmpPath, io::FileMode::SysWrite);
+	if (!file->validHandle()) {
+		Log::error("Failed to open region file %s for writing", tmpPath.c_str());
+		return false;
+	}
+	Slot packed[Slots];
+	uint32_t end = HeaderSize;
+	for (int i = 0; i < Slots; ++i) {
+		if (_slots[i].size == 0u) {
+			continue;
+		}
+		packed[i].offset = end;
+		packed[i].size = _slots[i].size;
+		end += _slots[i].size;
+	}
+	bool success = writeHeader(file.get(), packed);
+	for (int i = 0; success && i < Slots; ++i) {
+		if (_slots[i].size == 0u) {
+			continue;
+		}
+		success = file->write(_file.data() + _slots[i].offset, _slots[i].size) == (long)_slots[i].size;
+	}
+	// the seek flushes the buffered data - a failed write must be detected before the region file is replaced
+	if (success) {
+		success = file->seek(0, RW_SEEK_END) == (long)end;
+	}
+	file->close();
+	if (!success) {
+		Log::error("Failed to compact region file %s", _path.c_str());
+		_filesystem->removeFile(tmpPath);
+		return false;
+	}
+	_file.close();
+	// the rename replaces the region file atomically - if it fails, the old file and its offset table are still valid
+	if (!_filesystem->rename(tmpPath, _path)) {
+		Log::error("Failed to replace region file %s", _path.c_str());
+		_filesystem->removeFile(tmpPath);
+		return false;
+	}
+	Log::debug("Compacted region file %s from %u to %u bytes", _path.c_str(), _end, end);
+	for (int i = 0; i < Slots; ++i) {
+		_slots[i] = packed[i];
+	}
+	_end = end;
+	return true;
+}
+
+}
@@ -0,0 +1,123 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "io/MemoryMappedFile.h"
+#include "io/Filesystem.h"
+#include "core/GLM.h"
+#include "core/String.h"
+#include "core/NonCopyable.h"
+#include "core/FourCC.h"
+#include <stdint.h>
+
+namespace voxelworld {
+
+/**
+ * @brief Stores the compressed data of RegionChunks^3 chunks in one file.
+ *
+ * The file starts with a header that contains an offset table with one slot per chunk - the chunk data
+ * follows the header. Writes append the new data to the end of the file and update the offset table
+ * after the data was written. The space of replaced chunks is reclaimed by @c compact() once the file
+ * contains more stale than live data.
+ *
+ * Reads are served from a memory mapping of the file.
+ *
+ * @note Not thread safe
+ */
+class RegionFile : public core::NonCopyable {
+public:
+	static constexpr int RegionChunksPower = 3;
+	static constexpr int RegionChunks = 1 << RegionChunksPower;
+	static constexpr int Slots = RegionChunks * RegionChunks * RegionChunks;
+
+	/**
+	 * @brief A chunk to write. A size of @c 0 removes the chunk from the region.
+	 */
+	struct Write {
+		int slot;
+		const uint8_t* data;
+		uint32_t size;
+	};
+
+private:
+	static constexpr uint32_t Magic = FourCC('V', 'R', 'G', 'N');
+	static constexpr uint32_t Version = 1u;
+	static constexpr uint32_t HeaderSize = 2u * sizeof(uint32_t) + Slots * 2u * sizeof(uint32_t);
+	/**
+	 * @brief Don't compact small files - the stale data must at least exceed this amount of bytes
+	 */
+	static constexpr uint32_t MinCompactBytes = 64u * 1024u;
+
+	struct Slot {
+		uint32_t offset = 0u;
+		uint32_t size = 0u;
+	};
+
+	const io::FilesystemPtr _filesystem;
+	const core::String _path;
+	io::MemoryMappedFile _file;
+	Slot _slots[Slots];
+	// the offset where the next chunk is appended
+	uint32_t _end = HeaderSize;
+	uint32_t _liveBytes = 0u;
+	// the offset table was read from disk - or the file doesn't exist yet
+	bool _loaded = false;
+	// the file exists and has a valid header
+	bool _valid = false;
+
+	bool load();
+	bool map();
+	void reset();
+	static bool writeHeader(io::File* file, const Slot* slots);
+public:
+	RegionFile(const io::FilesystemPtr& filesystem, const core::String& path);
+
+	/**
+	 * @param[in] chunkPos The chunk position - not the world position of the chunk.
+	 * @return The position of the region that contains the given chunk
+	 */
+	static glm::ivec3 region(const glm::ivec3& chunkPos);
+	/**
+	 * @return The slot of the given chunk in its region
+	 */
+	static int slot(const glm::ivec3& chunkPos);
+
+	/**
+	 * @param[out] size The size of the chunk data
+	 * @return Pointer into the mapped file or @c nullptr if the slot is empty. The pointer is
+	 * invalidated by the next @c write() or @c compact().
+	 */
+	const uint8_t* data(int slot, uint32_t& size);
+	bool write(const Write* writes, int amount);
+	/**
+	 * @brief Rewrites the file without the stale data
+	 */
+	bool compact();
+
+	/**
+	 * @brief The bytes in the file that are not referenced by the offset table anymore
+	 */
+	uint32_t staleBytes() const;
+	const core::String& path() const;
+};
+
+inline glm::ivec3 RegionFile::region(const glm::ivec3& chunkPos) {
+	return glm::ivec3(chunkPos.x >> RegionChunksPower, chunkPos.y >> RegionChunksPower, chunkPos.z >> RegionChunksPower);
+}
+
+inline int RegionFile::slot(const glm::ivec3& chunkPos) {
+	const int mask = RegionChunks - 1;
+	return ((chunkPos.y & mask) * RegionChunks + (chunkPos.z & mask)) * RegionChunks + (chunkPos.x & mask);
+}
+
+inline uint32_t RegionFile::staleBytes() const {
+	return _end - HeaderSize - _liveBytes;
+}
+
+inline const core::String& RegionFile::path() const {
+	return _path;
+}
+
+}
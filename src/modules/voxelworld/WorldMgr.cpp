@@ -52,7 +52,7 @@ voxel::PagedVolume::Sampler WorldMgr::sampler() {
 }
 
 bool WorldMgr::init(uint32_t volumeMemoryMegaBytes, uint16_t chunkSideLength) {
-	_volumeData = new voxel::PagedVolume(_pager.get(), volumeMemoryMegaBytes * 1024 * 1024, chunkSideLength);
+	_volumeData = new voxel::PagedVolume(_pager.get(), volumeMemoryMegaBytes * 1024 * 1024, chunkSideLength, voxel::PagedVolume::ChunkStorage::Palette);
 	return true;
 }
 
@@ -63,8 +63,7 @@ void WorldMgr::shutdown() {
 
 voxelutil::FloorTraceResult WorldMgr::findWalkableFloor(const glm::ivec3& position, int maxDistanceUpwards) const {
 	core_assert_msg(_volumeData != nullptr, "WorldMgr is not initialized");
-	voxel::PagedVolume::Sampler sampler(_volumeData);
-	return voxelutil::findWalkableFloor(&sampler, position, maxDistanceUpwards);
+	return voxelutil::findWalkableFloor(_volumeData, position, maxDistanceUpwards);
 }
 
 }
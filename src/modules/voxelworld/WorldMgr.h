@@ -44,6 +44,7 @@ public:
 	/**
 	 * @sa voxelutil::FloorTraceResult
 	 * @return The y component for the given x and z coordinates that is walkable - or @c NO_FLOOR_FOUND.
+	 * @note Uses the column summary of the chunk - the voxels are only traced for positions below overhangs.
 	 */
 	voxelutil::FloorTraceResult findWalkableFloor(const glm::ivec3& position, int maxDistanceUpwards = voxel::MAX_HEIGHT) const;
 
@@ -7,14 +7,16 @@
 #include "voxel/PagedVolumeWrapper.h"
 #include "voxelutil/Raycast.h"
 #include "noise/Simplex.h"
+#include "noise/SimplexBatch.h"
 #include "core/Common.h"
 #include "core/StringUtil.h"
 #include "core/collection/Array.h"
+#include "core/concurrent/Concurrency.h"
 
 namespace voxelworld {
 
 WorldPager::WorldPager(const voxelformat::VolumeCachePtr& volumeCache, const ChunkPersisterPtr& chunkPersister) :
-		_volumeCache(volumeCache), _chunkPersister(chunkPersister) {
+		_volumeCache(volumeCache), _chunkPersister(chunkPersister), _threadPool(core::halfcpus(), "WorldPager") {
 }
 
 void WorldPager::erase(const voxel::Region& region) {
@@ -40,6 +42,49 @@ bool WorldPager::pageIn(voxel::PagedVolume::PagerContext& pctx) {
 	return true;
 }
 
+void WorldPager::prefetch(const glm::ivec3& worldPos, int radius) {
+	core_assert(_volumeData != nullptr);
+	const int sideLength = (int)_volumeData->chunkSideLength();
+	const glm::ivec3& center = _volumeData->chunkPos(worldPos);
+	const int chunksY = (voxel::MAX_HEIGHT + sideLength) / sideLength;
+	for (int z = center.z - radius; z <= center.z + radius; ++z) {
+		for (int x = center.x - radius; x <= center.x + radius; ++x) {
+			for (int y = 0; y < chunksY; ++y) {
+				const glm::ivec3 chunkPos(x, y, z);
+				{
+					core::ScopedLock lock(_prefetchLock);
+					if (_prefetches.hasKey(chunkPos)) {
+						continue;
+					}
+					_prefetches.put(chunkPos, true);
+				}
+				// the helpers of the chunks that are paged in right now are executed before the prefetches
+				const bool scheduled = _threadPool.schedule([this, chunkPos, sideLength] () {
+					core_trace_scoped(PrefetchChunk);
+					// already loaded chunks are just marked as accessed
+					_volumeData->chunk(chunkPos * sideLength);
+					{
+						core::ScopedLock lock(_prefetchLock);
+						_prefetches.remove(chunkPos);
+					}
+					_prefetchCondition.notify_all();
+				}, core::TaskPriority::Low);
+				if (!scheduled) {
+					core::ScopedLock lock(_prefetchLock);
+					_prefetches.remove(chunkPos);
+				}
+			}
+		}
+	}
+}
+
+void WorldPager::waitForPrefetches() {
+	core::ScopedLock lock(_prefetchLock);
+	while (!_prefetches.empty()) {
+		_prefetchCondition.wait(_prefetchLock);
+	}
+}
+
 void WorldPager::pageOut(voxel::PagedVolume::Chunk* chunk) {
 	// currently chunks are not modifiable and are saved directly after creating the chunk
 }
@@ -67,10 +112,19 @@ bool WorldPager::init(voxel::PagedVolume *volumeData, const core::String& worldP
 		return false;
 	}
 	_volumeData = volumeData;
+	_threadPool.init();
 	return _volumeData != nullptr;
 }
 
 void WorldPager::shutdown() {
+	// drop the queued prefetches - but let the current page ins finish
+	_threadPool.abort();
+	_threadPool.shutdown(true);
+	{
+		core::ScopedLock lock(_prefetchLock);
+		_prefetches.clear();
+	}
+	_prefetchCondition.notify_all();
 	if (_volumeData != nullptr) {
 		_volumeData->flushAll();
 	}
@@ -82,7 +136,7 @@ void WorldPager::shutdown() {
 }
 
 // use a 2d noise to switch between different noises - to generate steep mountains
-void WorldPager::createWorld(voxel::PagedVolumeWrapper& volume) const {
+void WorldPager::createWorld(voxel::PagedVolumeWrapper& volume) {
 	core_trace_scoped(WorldGeneration);
 	const voxel::Region& region = volume.region();
 	Log::debug("Create new chunk at %i:%i:%i", region.getLowerX(), region.getLowerY(), region.getLowerZ());
@@ -93,17 +147,21 @@ void WorldPager::createWorld(voxel::PagedVolumeWrapper& volume) const {
 	const int lowerZ = region.getLowerZ();
 	core_assert(region.getLowerY() >= 0);
 
-	// TODO: store voxel data in local buffer and transfer in one step into the volume to reduce locking
 	const int size = 2;
 	core_assert(depth % size == 0);
 	core_assert(width % size == 0);
-	for (int z = lowerZ; z < lowerZ + depth; z += size) {
+
+	// the rows of columns are filled by this thread and the idle pool workers - this is also called from the
+	// pool workers for the prefetches
+	_threadPool.parallelFor(0, depth / size, [this, &volume, lowerX, lowerZ, width, minsY, size] (int row) {
+		const int z = lowerZ + row * size;
 		for (int x = lowerX; x < lowerX + width; x += size) {
 			voxel::Voxel voxels[voxel::MAX_TERRAIN_HEIGHT];
 			const int ni = fillVoxels(x, minsY, z, voxels);
+			// the columns of the rows don't overlap - no locking needed here
 			volume.setVoxels(x, minsY, z, size, size, voxels, ni);
 		}
-	}
+	});
 }
 
 float WorldPager::getNoiseValue(float x, float z) const {
@@ -131,13 +189,27 @@ float WorldPager::getDensity(float x, float y, float z, float n) const {
 	return finalDensity;
 }
 
+void WorldPager::getDensities(int x, int fromY, int toY, int z, float n, float* densities) const {
+	core_trace_scoped(DensityValues);
+	glm::vec3 noisePositions[voxel::MAX_TERRAIN_HEIGHT];
+	const int amount = toY - fromY;
+	core_assert(amount <= voxel::MAX_TERRAIN_HEIGHT);
+	for (int i = 0; i < amount; ++i) {
+		const glm::vec3 noisePos3d(_noiseSeedOffset.x + x, fromY + i, _noiseSeedOffset.y + z);
+		noisePositions[i] = noisePos3d * _worldCtx.caveNoiseFrequency;
+	}
+	noise::fBm(noisePositions, densities, amount, _worldCtx.caveNoiseOctaves, _worldCtx.caveNoiseLacunarity, _worldCtx.caveNoiseGain);
+	for (int i = 0; i < amount; ++i) {
+		densities[i] = n + noise::norm(densities[i]);
+	}
+}
+
 int WorldPager::terrainHeight(int x, int y, int z) const {
 	const float n = getNoiseValue(x, z);
 	return terrainHeight(x, y, z, n);
 }
 
-int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
-	core_trace_scoped(TerrainHeight);
+int WorldPager::baseTerrainHeight(int x, int z, float n) const {
 	const int maxHeight = voxel::MAX_TERRAIN_HEIGHT - 1;
 	int centerHeight;
 	// the center of a city should make the terrain more even
@@ -149,6 +221,12 @@ int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
 	} else {
 		ni = n * maxHeight;
 	}
+	return ni;
+}
+
+int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
+	core_trace_scoped(TerrainHeight);
+	int ni = baseTerrainHeight(x, z, n);
 	for (int y = ni - 1; y >= minsY + 1; --y) {
 		const float density = getDensity(x, y, z, n);
 		if (density > _worldCtx.caveDensityThreshold) {
@@ -162,7 +240,19 @@ int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
 int WorldPager::fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const {
 	core_trace_scoped(FillVoxels);
 	const float n = getNoiseValue(x, z);
-	const int ni = terrainHeight(x, minsY, z, n);
+	// the densities of the column are needed for the height and for the voxels - evaluate them all at once
+	const int fromY = minsY + 1;
+	int ni = baseTerrainHeight(x, z, n);
+	float densities[voxel::MAX_TERRAIN_HEIGHT];
+	if (ni > fromY) {
+		getDensities(x, fromY, ni, z, n, densities);
+	}
+	for (int y = ni - 1; y >= fromY; --y) {
+		if (densities[y - fromY] > _worldCtx.caveDensityThreshold) {
+			break;
+		}
+		--ni;
+	}
 	if (ni < minsY) {
 		return 0;
 	}
@@ -173,8 +263,8 @@ int WorldPager::fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const
 
 	voxels[0] = dirt;
 	glm::ivec3 pos(x, 0, z);
-	for (int y = ni - 1; y >= minsY + 1; --y) {
-		const float density = getDensity(x, y, z, n);
+	for (int y = ni - 1; y >= fromY; --y) {
+		const float density = densities[y - fromY];
 		if (density > _worldCtx.caveDensityThreshold) {
 			const bool cave = y < ni - 1;
 			pos.y = y;
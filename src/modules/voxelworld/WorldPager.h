@@ -12,6 +12,10 @@
 #include "noise/Noise.h"
 #include "BiomeManager.h"
 #include "core/SharedPtr.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/Lock.h"
+#include "core/concurrent/ConditionVariable.h"
+#include "core/collection/DynamicMap.h"
 #include "ChunkPersister.h"
 #include "TreeVolumeCache.h"
 #include "voxelutil/RawVolumeRotateWrapper.h"
@@ -32,7 +36,7 @@ namespace voxelworld {
 class WorldPager: public voxel::PagedVolume::Pager {
 private:
 	unsigned int _seed = 0l;
-	glm::vec2 _noiseSeedOffset;
+	glm::vec2 _noiseSeedOffset { 0.0f };
 
 	voxel::PagedVolume *_volumeData = nullptr;
 	BiomeManager _biomeManager;
@@ -41,12 +45,27 @@ private:
 	TreeVolumeCache _volumeCache;
 	ChunkPersisterPtr _chunkPersister;
 
-	void createWorld(voxel::PagedVolumeWrapper& volume) const;
+	/**
+	 * @brief The chunk positions that are queued or currently paged in because of a @c prefetch() call
+	 */
+	core::DynamicMap<glm::ivec3, bool, 64, glm::hash<glm::ivec3>> _prefetches core_thread_guarded_by(_prefetchLock);
+	core_trace_mutex(core::Lock, _prefetchLock, "WorldPagerPrefetch");
+	core::ConditionVariable _prefetchCondition;
+	/**
+	 * @brief Runs the prefetches and helps out with filling the columns of the chunks that are currently generated
+	 */
+	core::ThreadPool _threadPool;
+
+	void createWorld(voxel::PagedVolumeWrapper& volume);
 	void placeTrees(voxel::PagedVolume::PagerContext& pagerCtx);
 	void addVolumeToPosition(voxel::PagedVolumeWrapper& target, const voxelutil::RawVolumeRotateWrapper& source, const glm::ivec3& pos);
 
 	int terrainHeight(int x, int minsY, int z) const;
 	int terrainHeight(int x, int minsY, int z, float n) const;
+	/**
+	 * @return The height of the terrain before the caves are carved into it
+	 */
+	int baseTerrainHeight(int x, int z, float n) const;
 	int fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const;
 
 	/**
@@ -54,6 +73,11 @@ private:
 	 */
 	float getNoiseValue(float x, float z) const;
 	float getDensity(float x, float y, float z, float n) const;
+	/**
+	 * @brief Same as @c getDensity() for the column at the given position - but all values are evaluated at once
+	 * @param[out] densities Receives the density for each y in [fromY, toY)
+	 */
+	void getDensities(int x, int fromY, int toY, int z, float n, float* densities) const;
 
 public:
 	WorldPager(const voxelformat::VolumeCachePtr& volumeCache, const ChunkPersisterPtr& chunkPersister);
@@ -81,6 +105,19 @@ public:
 	void setNoiseOffset(const glm::vec2& noiseOffset);
 
 	void erase(const voxel::Region& region);
+
+	/**
+	 * @brief Schedules the generation of all chunks in the given radius around the given world position
+	 * in the background. The chunks are put into the volume once they are completely generated - threads
+	 * that need the chunk before that are waiting for exactly this chunk.
+	 * @param radius The radius in chunks - 0 means only the chunk that contains the given position
+	 */
+	void prefetch(const glm::ivec3& worldPos, int radius = 1);
+	/**
+	 * @brief Blocks until all scheduled prefetches are done
+	 */
+	void waitForPrefetches();
+
 	/**
 	 * @return @c true if the chunk was modified (created), @c false if it was just loaded
 	 */
@@ -8,6 +8,7 @@
 #include "voxelworld/BiomeManager.h"
 #include "voxel/Constants.h"
 #include "voxelformat/VolumeCache.h"
+#include "voxelutil/FloorTrace.h"
 
 class PagedVolumeBenchmark: public app::AbstractBenchmark {
 protected:
@@ -43,6 +44,111 @@ BENCHMARK_DEFINE_F(PagedVolumeBenchmark, pageIn) (benchmark::State& state) {
 	}
 }
 
+BENCHMARK_DEFINE_F(PagedVolumeBenchmark, prefetch) (benchmark::State& state) {
+	voxelworld::WorldPager pager(_volumeCache, std::make_shared<voxelworld::ChunkPersister>());
+	pager.setSeed(0l);
+	int chunkSize = 256;
+	voxel::PagedVolume volumeData(&pager, 1024 * 1024 * 1024, chunkSize);
+	const io::FilesystemPtr& filesystem = io::filesystem();
+	const core::String& luaParameters = filesystem->load("worldparams.lua");
+	const core::String& luaBiomes = filesystem->load("biomes.lua");
+	pager.init(&volumeData, luaParameters, luaBiomes);
+	int i = 0;
+	while (state.KeepRunning()) {
+		// 3x3 chunks around the position
+		pager.prefetch(glm::ivec3(chunkSize * 3 * i, 0, 0), 1);
+		pager.waitForPrefetches();
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations() * 9);
+	pager.shutdown();
+}
+
+/**
+ * @brief Floor queries at random positions of a generated chunk - the first argument
+ * selects whether the column summary (1) or the voxel trace (0) is used
+ */
+BENCHMARK_DEFINE_F(PagedVolumeBenchmark, findWalkableFloor) (benchmark::State& state) {
+	voxelworld::WorldPager pager(_volumeCache, std::make_shared<voxelworld::ChunkPersister>());
+	pager.setSeed(0l);
+	const int chunkSize = 256;
+	voxel::PagedVolume volumeData(&pager, 1024 * 1024 * 1024, chunkSize, voxel::PagedVolume::ChunkStorage::Palette);
+	const io::FilesystemPtr& filesystem = io::filesystem();
+	const core::String& luaParameters = filesystem->load("worldparams.lua");
+	const core::String& luaBiomes = filesystem->load("biomes.lua");
+	pager.init(&volumeData, luaParameters, luaBiomes);
+	const voxel::PagedVolume::ChunkPtr& chunk = volumeData.chunk(glm::ivec3(0));
+	// the column summary is built by the first floor query of a chunk - keep this out of the timed loop
+	chunk->column(0, 0);
+	const bool column = state.range(0) != 0;
+	voxel::PagedVolume::Sampler sampler(&volumeData);
+	uint32_t seed = 1u;
+	for (auto _ : state) {
+		// xorshift to not measure the random number generator
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		const glm::ivec3 pos((int)(seed % chunkSize), (int)((seed >> 8) % voxel::MAX_HEIGHT), (int)((seed >> 16) % chunkSize));
+		if (column) {
+			benchmark::DoNotOptimize(voxelutil::findWalkableFloor(&volumeData, pos, voxel::MAX_HEIGHT));
+		} else {
+			benchmark::DoNotOptimize(voxelutil::findWalkableFloor(&sampler, pos, voxel::MAX_HEIGHT));
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+	pager.shutdown();
+}
+
 BENCHMARK_REGISTER_F(PagedVolumeBenchmark, pageIn);
+BENCHMARK_REGISTER_F(PagedVolumeBenchmark, prefetch)->UseRealTime();
+BENCHMARK_REGISTER_F(PagedVolumeBenchmark, findWalkableFloor)->Arg(0)->Arg(1);
+
+class ReadBenchmarkPager: public voxel::PagedVolume::Pager {
+public:
+	bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+		return false;
+	}
+
+	void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+	}
+};
+
+static constexpr int ReadBenchmarkChunkSize = 32;
+static constexpr int ReadBenchmarkChunks = 16;
+static ReadBenchmarkPager readBenchmarkPager;
+static voxel::PagedVolume* readBenchmarkVolume = nullptr;
+
+/**
+ * @brief Concurrent voxel lookups in already paged in chunks. The throughput should scale with
+ * the amount of threads as long as no chunk has to be created.
+ */
+static void PagedVolumeConcurrentRead(benchmark::State& state) {
+	constexpr int size = ReadBenchmarkChunkSize * ReadBenchmarkChunks;
+	if (state.thread_index == 0) {
+		readBenchmarkVolume = new voxel::PagedVolume(&readBenchmarkPager, 256 * 1024 * 1024, ReadBenchmarkChunkSize);
+		for (int x = 0; x < size; x += ReadBenchmarkChunkSize) {
+			for (int z = 0; z < size; z += ReadBenchmarkChunkSize) {
+				readBenchmarkVolume->voxel(x, 0, z);
+			}
+		}
+	}
+	uint32_t seed = 1u + (uint32_t)state.thread_index;
+	for (auto _ : state) {
+		// xorshift to not measure a locked random number generator
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		const int x = (int)(seed % size);
+		const int z = (int)((seed >> 12) % size);
+		benchmark::DoNotOptimize(readBenchmarkVolume->voxel(x, (int)(seed & (ReadBenchmarkChunkSize - 1)), z));
+	}
+	state.SetItemsProcessed(state.iterations());
+	if (state.thread_index == 0) {
+		delete readBenchmarkVolume;
+		readBenchmarkVolume = nullptr;
+	}
+}
+
+BENCHMARK(PagedVolumeConcurrentRead)->ThreadRange(1, 16)->UseRealTime();
 
 BENCHMARK_MAIN();
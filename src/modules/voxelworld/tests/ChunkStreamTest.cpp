@@ -0,0 +1,64 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxelworld/ChunkStream.h"
+
+namespace voxelworld {
+
+class ChunkStreamTest: public app::AbstractTest {
+};
+
+TEST_F(ChunkStreamTest, testFrames) {
+	const uint8_t data[] = { 1, 2, 3, 4, 5 };
+	core::ByteStream stream;
+	ChunkStream::writeFrame(stream, glm::ivec3(0, 32, -64), data, sizeof(data));
+	ChunkStream::writeFrame(stream, glm::ivec3(-32, 0, 96), nullptr, 0u);
+
+	ChunkStream chunkStream;
+	int frames = 0;
+	// the frames might be split at any position
+	for (size_t i = 0; i < stream.getSize(); ++i) {
+		ASSERT_TRUE(chunkStream.feed(stream.getBuffer() + i, 1u, [&] (const glm::ivec3& pos, const uint8_t* frameData, uint32_t size) {
+			if (frames == 0) {
+				EXPECT_EQ(glm::ivec3(0, 32, -64), pos);
+				ASSERT_EQ(sizeof(data), size);
+				EXPECT_EQ(0, memcmp(data, frameData, size));
+			} else {
+				EXPECT_EQ(glm::ivec3(-32, 0, 96), pos);
+				EXPECT_EQ(0u, size);
+				EXPECT_EQ(nullptr, frameData);
+			}
+			++frames;
+		}));
+	}
+	EXPECT_EQ(2, frames);
+}
+
+TEST_F(ChunkStreamTest, testPositions) {
+	const glm::ivec3 positions[] = { glm::ivec3(0, 32, -64), glm::ivec3(-32, 0, 96) };
+	const core::String& str = ChunkStream::formatPositions(positions, 2);
+	EXPECT_EQ("0,32,-64,-32,0,96", str);
+	core::DynamicArray<glm::ivec3> parsed;
+	ASSERT_TRUE(ChunkStream::parsePositions(str.c_str(), parsed));
+	ASSERT_EQ(2u, parsed.size());
+	EXPECT_EQ(positions[0], parsed[0]);
+	EXPECT_EQ(positions[1], parsed[1]);
+}
+
+TEST_F(ChunkStreamTest, testInvalidPositions) {
+	const char *invalid[] = { "", "1,2", "1,2,3,", "1,2,3,4", "1,a,3", "1;2;3" };
+	for (const char *str : invalid) {
+		core::DynamicArray<glm::ivec3> parsed;
+		EXPECT_FALSE(ChunkStream::parsePositions(str, parsed)) << str;
+	}
+	core::String tooMany;
+	for (int i = 0; i <= ChunkStream::MaxChunksPerRequest; ++i) {
+		tooMany += i == 0 ? "0,0,0" : ",0,0,0";
+	}
+	core::DynamicArray<glm::ivec3> parsed;
+	EXPECT_FALSE(ChunkStream::parsePositions(tooMany.c_str(), parsed));
+}
+
+}
@@ -3,20 +3,137 @@
  */
 
 #include "voxelworld/FilePersister.h"
+#include "voxelworld/RegionFile.h"
+#include "io/Filesystem.h"
+#include "core/ArrayLength.h"
+#include "core/StringUtil.h"
 
 #include "AbstractVoxelTest.h"
+#include <stdio.h>
 
 namespace voxelworld {
 
 class WorldPersisterTest: public AbstractVoxelTest {
+protected:
+	// remove the region file of the previous test runs
+	core::String regionFile(const glm::ivec3& regionPos, unsigned int seed) const {
+		const core::String& name = core::string::format("world_%u_%i_%i_%i.region", seed, regionPos.x, regionPos.y, regionPos.z);
+		const core::String& path = io::filesystem()->writePath(name.c_str());
+		remove(path.c_str());
+		return path;
+	}
+
+	void mark(const voxel::PagedVolume::ChunkPtr& chunk, voxel::VoxelType type) {
+		chunk->setVoxel(1, 1, 1, voxel::createVoxel(type, 0));
+	}
+
+	voxel::VoxelType marker(const voxel::PagedVolume::ChunkPtr& chunk) const {
+		return chunk->voxel(1, 1, 1).getMaterial();
+	}
 };
 
 TEST_F(WorldPersisterTest, testSaveLoad) {
-	FilePersister persister;
-	ASSERT_TRUE(persister.save(_ctx.chunk(), _seed)) << "Could not save volume chunk";
+	regionFile(glm::ivec3(0), _seed);
+	{
+		FilePersister persister;
+		ASSERT_TRUE(persister.save(_ctx.chunk(), _seed)) << "Could not save volume chunk";
+		_volData.flushAll();
+		ASSERT_TRUE(persister.load(_ctx.chunk(), _seed)) << "Could not load volume chunk";
+		ASSERT_EQ(voxel::VoxelType::Grass, _volData.voxel(32, 32, 32).getMaterial());
+	}
+	// the persister was flushed on destruction
 	_volData.flushAll();
-	ASSERT_TRUE(persister.load(_ctx.chunk(), _seed)) << "Could not load volume chunk";
+	FilePersister persister;
+	ASSERT_TRUE(persister.load(_ctx.chunk(), _seed)) << "Could not load volume chunk from the region file";
 	ASSERT_EQ(voxel::VoxelType::Grass, _volData.voxel(32, 32, 32).getMaterial());
 }
 
+TEST_F(WorldPersisterTest, testRegion) {
+	const unsigned int seed = 1u;
+	regionFile(glm::ivec3(0), seed);
+	const glm::ivec3 positions[] = { glm::ivec3(0, 0, 0), glm::ivec3(64, 0, 0), glm::ivec3(0, 64, 64) };
+	const voxel::VoxelType types[] = { voxel::VoxelType::Wood, voxel::VoxelType::Leaf, voxel::VoxelType::Flower };
+	{
+		FilePersister persister;
+		for (int i = 0; i < lengthof(positions); ++i) {
+			const voxel::PagedVolume::ChunkPtr& chunk = _volData.chunk(positions[i]);
+			mark(chunk, types[i]);
+			ASSERT_TRUE(persister.save(chunk, seed));
+		}
+		ASSERT_TRUE(persister.flush());
+	}
+	_volData.flushAll();
+	FilePersister persister;
+	for (int i = 0; i < lengthof(positions); ++i) {
+		const voxel::PagedVolume::ChunkPtr& chunk = _volData.chunk(positions[i]);
+		ASSERT_NE(types[i], marker(chunk));
+		ASSERT_TRUE(persister.load(chunk, seed)) << "Could not load chunk " << i;
+		EXPECT_EQ(types[i], marker(chunk)) << "Unexpected data for chunk " << i;
+	}
+	const voxel::PagedVolume::ChunkPtr& chunk = _volData.chunk(glm::ivec3(64, 64, 64));
+	EXPECT_FALSE(persister.load(chunk, seed)) << "The chunk was never saved";
+}
+
+TEST_F(WorldPersisterTest, testErase) {
+	const unsigned int seed = 2u;
+	regionFile(glm::ivec3(0), seed);
+	FilePersister persister;
+	ASSERT_TRUE(persister.save(_ctx.chunk(), seed));
+	ASSERT_TRUE(persister.flush());
+	persister.erase(_region, seed);
+	EXPECT_FALSE(persister.load(_ctx.chunk(), seed)) << "The erased chunk is still pending";
+	ASSERT_TRUE(persister.flush());
+	FilePersister reloaded;
+	EXPECT_FALSE(reloaded.load(_ctx.chunk(), seed)) << "The erased chunk is still in the region file";
+}
+
+TEST_F(WorldPersisterTest, testRegionFileCompact) {
+	const unsigned int seed = 3u;
+	const core::String& path = regionFile(glm::ivec3(0), seed);
+	const int slot = RegionFile::slot(glm::ivec3(1, 2, 3));
+	uint8_t buf[4096];
+	RegionFile region(io::filesystem(), path);
+	for (int i = 0; i < 256; ++i) {
+		memset(buf, i, sizeof(buf));
+		const RegionFile::Write w { slot, buf, sizeof(buf) };
+		ASSERT_TRUE(region.write(&w, 1));
+		// the stale data must not exceed the live data by much
+		ASSERT_LE(region.staleBytes(), 64u * 1024u + sizeof(buf)) << "Region file was not compacted at write " << i;
+	}
+	RegionFile reloaded(io::filesystem(), path);
+	uint32_t size = 0u;
+	const uint8_t* data = reloaded.data(slot, size);
+	ASSERT_NE(nullptr, data);
+	ASSERT_EQ(sizeof(buf), size);
+	EXPECT_EQ(255, data[0]);
+	EXPECT_EQ(255, data[sizeof(buf) - 1]);
+	uint32_t emptySize = 0u;
+	EXPECT_EQ(nullptr, reloaded.data(slot + 1, emptySize));
+}
+
+TEST_F(WorldPersisterTest, testCloseIdleRegions) {
+	const unsigned int seed = 3u;
+	const int regions = FilePersister::MaxOpenRegions * 2;
+	for (int i = 0; i < regions; ++i) {
+		regionFile(glm::ivec3(i, 0, 0), seed);
+	}
+	const uint8_t data[] = {1, 2, 3, 4};
+	{
+		FilePersister persister;
+		for (int i = 0; i < regions; ++i) {
+			ASSERT_TRUE(persister.save(glm::ivec3(i * RegionFile::RegionChunks, 0, 0), seed, data, sizeof(data)));
+			ASSERT_TRUE(persister.flush());
+			EXPECT_LE(persister.openRegionFiles(), FilePersister::MaxOpenRegions);
+		}
+		// the closed region files are opened again
+		for (int i = 0; i < regions; ++i) {
+			EXPECT_TRUE(persister.contains(glm::ivec3(i * RegionFile::RegionChunks, 0, 0), seed)) << "Region " << i;
+		}
+		EXPECT_LE(persister.openRegionFiles(), FilePersister::MaxOpenRegions);
+	}
+	for (int i = 0; i < regions; ++i) {
+		regionFile(glm::ivec3(i, 0, 0), seed);
+	}
+}
+
 }
@@ -0,0 +1,70 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxelworld/WorldPager.h"
+#include "voxel/MaterialColor.h"
+#include "voxel/Constants.h"
+#include "io/Filesystem.h"
+
+namespace voxelworld {
+
+class WorldPagerTest: public app::AbstractTest {
+protected:
+	static constexpr uint16_t ChunkSideLength = 256u;
+	voxelformat::VolumeCachePtr _volumeCache;
+
+	bool initPager(WorldPager& pager, voxel::PagedVolume& volume) {
+		pager.setSeed(1u);
+		const io::FilesystemPtr& filesystem = io::filesystem();
+		return pager.init(&volume, filesystem->load("worldparams.lua"), filesystem->load("biomes.lua"));
+	}
+
+public:
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		ASSERT_TRUE(voxel::initDefaultMaterialColors());
+		_volumeCache = std::make_shared<voxelformat::VolumeCache>();
+		ASSERT_TRUE(_volumeCache->init());
+	}
+
+	void TearDown() override {
+		_volumeCache->shutdown();
+		app::AbstractTest::TearDown();
+	}
+};
+
+TEST_F(WorldPagerTest, testPrefetch) {
+	WorldPager pager(_volumeCache, std::make_shared<ChunkPersister>());
+	voxel::PagedVolume volume(&pager, 512 * 1024 * 1024, ChunkSideLength);
+	ASSERT_TRUE(initPager(pager, volume));
+	pager.prefetch(glm::ivec3(0), 0);
+	pager.waitForPrefetches();
+	EXPECT_EQ(1, volume.metrics().pagedIn);
+	const voxel::PagedVolume::ChunkPtr& chunk = volume.chunk(glm::ivec3(0));
+	EXPECT_EQ(1, volume.metrics().pagedIn) << "The prefetched chunk was paged in again";
+
+	// the columns are filled by several threads - the result must be the same
+	WorldPager referencePager(_volumeCache, std::make_shared<ChunkPersister>());
+	voxel::PagedVolume referenceVolume(&referencePager, 512 * 1024 * 1024, ChunkSideLength);
+	ASSERT_TRUE(initPager(referencePager, referenceVolume));
+	const voxel::PagedVolume::ChunkPtr& referenceChunk = referenceVolume.chunk(glm::ivec3(0));
+	int solid = 0;
+	for (int x = 0; x < ChunkSideLength; ++x) {
+		for (int z = 0; z < ChunkSideLength; ++z) {
+			for (int y = 0; y < ChunkSideLength; ++y) {
+				const voxel::Voxel& v = chunk->voxel(x, y, z);
+				ASSERT_TRUE(v.isSame(referenceChunk->voxel(x, y, z))) << "Voxel " << x << ":" << y << ":" << z << " differs";
+				if (!voxel::isAir(v.getMaterial())) {
+					++solid;
+				}
+			}
+		}
+	}
+	EXPECT_GT(solid, 0);
+	referencePager.shutdown();
+	pager.shutdown();
+}
+
+}
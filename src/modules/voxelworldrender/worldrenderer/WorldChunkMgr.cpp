@@ -99,6 +99,7 @@ void WorldChunkMgr::handleMeshQueue() {
 		return;
 	}
 	freeChunkBuffer->_compressedIndexSize = mesh.compressedIndexSize();
+	freeChunkBuffer->_ranges = mesh.getIndexRanges();
 
 	const voxel::VertexArray& vertices = mesh.getVertexVector();
 	const uint8_t* indices = mesh.compressedIndices();
@@ -211,8 +212,15 @@ int WorldChunkMgr::renderTerrain() {
 			const glm::mat4& model = glm::scale(size);
 			_worldShader->setModel(model);
 		}
-		video::drawElements(video::Primitive::Triangles, numIndices, chunkBuffer._compressedIndexSize);
-		++drawCalls;
+		if (chunkBuffer._ranges.size() == 1u && chunkBuffer._ranges[0].baseVertex == 0u) {
+			video::drawElements(video::Primitive::Triangles, numIndices, chunkBuffer._compressedIndexSize);
+			++drawCalls;
+			continue;
+		}
+		for (const voxel::IndexRange& range : chunkBuffer._ranges) {
+			video::drawElementsBaseVertex(video::Primitive::Triangles, range.numIndices, chunkBuffer._compressedIndexSize, (int)range.firstIndex, (int)range.baseVertex);
+			++drawCalls;
+		}
 	}
 	return drawCalls;
 }
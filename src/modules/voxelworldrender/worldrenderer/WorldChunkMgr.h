@@ -22,6 +22,10 @@ protected:
 		double scaleSeconds = 0.0;
 		math::AABB<int> _aabb = {glm::ivec3(0), glm::ivec3(0)};
 		size_t _compressedIndexSize = 0;
+		/**
+		 * The index ranges of the mesh - the indices are relative to the base vertex of their range
+		 */
+		voxel::IndexRangeArray _ranges;
 
 		video::Buffer _buffer;
 		int32_t _vbo = -1;
@@ -35,6 +39,7 @@ protected:
 			_buffer.shutdown();
 			_vbo = -1;
 			_ibo = -1;
+			_ranges.clear();
 			inuse = false;
 		}
 
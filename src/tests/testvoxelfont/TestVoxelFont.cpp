@@ -61,7 +61,7 @@ bool TestVoxelFont::changeFontSize(int delta) {
 	}
 
 	voxel::VertexArray vertices;
-	voxel::IndexArray indices;
+	voxel::VertexIndexArray indices;
 
 	const char* str = "Hello world!\nNext Line";
 	const int renderedChars = _voxelFont.render(str, vertices, indices);
@@ -22,6 +22,7 @@
 #include "network/IMsgProtocolHandler.h"
 #include "network/ProtocolHandlerRegistry.h"
 #include "ui/imgui/IconsFontAwesome5.h"
+#include <float.h>
 
 namespace priv {
 
@@ -134,22 +135,103 @@ bool AIDebug::addToHistory(const core::String& host, int port) {
 	return false;
 }
 
-void AIDebug::onMessage(const ai::StateWorld *, const uint8_t *rawData, size_t rawDataLength) {
-	core_assert(lengthof(_stateWorldBuf) > rawDataLength);
-	core_memcpy(_stateWorldBuf, rawData, rawDataLength);
-	const ai::AIRootMessage *rootMsg = ai::GetAIRootMessage(_stateWorldBuf);
-	_stateWorldMsg = (ai::StateWorld *)rootMsg->data();
-	_entityStates.clear();
+void AIDebug::applyState(const ai::State *s) {
+	EntityState &state = _entityStates.find(s->character_id())->value;
+	state.id = s->character_id();
+	state.position = glm::vec3(s->position()->x(), s->position()->y(), s->position()->z());
+	state.homePosition = glm::vec3(s->home_position()->x(), s->home_position()->y(), s->home_position()->z());
+	state.targetPosition = glm::vec3(s->target_position()->x(), s->target_position()->y(), s->target_position()->z());
+	state.orientation = s->orientation();
+	state.name = "Unknown";
+	state.metaAttributeKeys.clear();
+	state.metaAttributeValues.clear();
+	for (const auto &a : *s->meta_attributes()) {
+		const char *value = a->value() == nullptr ? "" : a->value()->c_str();
+		if (!SDL_strcmp(ai::attributes::NAME, a->key()->c_str())) {
+			state.name = value;
+		}
+		state.metaAttributeKeys.push_back(a->key()->c_str());
+		state.metaAttributeValues.push_back(value);
+	}
+	state.attribCurrent.fill(0.0);
+	state.attribMax.fill(0.0);
+	for (const auto &a : *s->attrib()) {
+		if (a->key() < 0 || a->key() >= (int)state.attribCurrent.size()) {
+			continue;
+		}
+		state.attribCurrent[a->key()] = a->current();
+		state.attribMax[a->key()] = a->max();
+	}
+}
+
+void AIDebug::onMessage(const ai::StateWorld *msg, const uint8_t *, size_t rawDataLength) {
 	_stateWorldSize += rawDataLength;
-	if (!_stateWorldMsg->states()) {
+	const uint32_t sequence = msg->sequence();
+	if (msg->base() == 0u) {
+		_entityStates.clear();
+	} else if (sequence <= _stateWorldSequence) {
+		return;
+	}
+	if (msg->removed() != nullptr) {
+		for (ai::CharacterId id : *msg->removed()) {
+			_entityStates.remove(id);
+		}
+	}
+	if (msg->states() != nullptr) {
+		for (const auto &s : *msg->states()) {
+			if (!_entityStates.hasKey(s->character_id())) {
+				_entityStates.put(s->character_id(), EntityState());
+			}
+			applyState(s);
+		}
+	}
+	_stateWorldSequence = sequence;
+	ack();
+}
+
+void AIDebug::applyNode_r(const ai::StateNode *node) {
+	NodeState state;
+	state.condition = node->condition()->c_str();
+	state.conditionState = node->condition_state();
+	state.lastRun = node->last_run();
+	state.status = node->status();
+	_treeNodeStates.put(node->node_id(), state);
+	if (node->children() == nullptr) {
 		return;
 	}
-	for (const auto &s : *_stateWorldMsg->states()) {
-		_entityStates.put(s->character_id(), s);
+	for (const auto &c : *node->children()) {
+		applyNode_r(c);
+	}
+}
+
+void AIDebug::applyAggro(const flatbuffers::Vector<flatbuffers::Offset<ai::StateAggroEntry>> *aggro) {
+	_aggro.clear();
+	for (const auto &e : *aggro) {
+		_aggro.push_back({e->character_id(), e->aggro()});
 	}
 }
 
-void AIDebug::onMessage(const ai::CharacterDetails *, const uint8_t *rawData, size_t rawDataLength) {
+void AIDebug::onMessage(const ai::CharacterDetails *msg, const uint8_t *rawData, size_t rawDataLength) {
+	_characterDetailsSize += rawDataLength;
+	const uint32_t sequence = msg->sequence();
+	if (msg->base() != 0u) {
+		// a delta to a state we have already applied
+		if (_chrDetailsMsg == nullptr || _chrDetailsMsg->character_id() != msg->character_id()
+				|| sequence <= _characterDetailsSequence) {
+			return;
+		}
+		if (msg->nodes() != nullptr) {
+			for (const auto &n : *msg->nodes()) {
+				applyNode_r(n);
+			}
+		}
+		if (msg->aggro() != nullptr) {
+			applyAggro(msg->aggro());
+		}
+		_characterDetailsSequence = sequence;
+		ack();
+		return;
+	}
 	const auto oldCharacterId = _chrDetailsMsg == nullptr ? 0 : _chrDetailsMsg->character_id();
 	core_assert(lengthof(_chrDetailsBuf) > rawDataLength);
 	core_memcpy(_chrDetailsBuf, rawData, rawDataLength);
@@ -159,7 +241,16 @@ void AIDebug::onMessage(const ai::CharacterDetails *, const uint8_t *rawData, si
 		_centerOnSelection = true;
 	}
 	_chrDetailsMsg = chrDetailsMsg;
-	_characterDetailsSize += rawDataLength;
+	_treeNodeStates.clear();
+	if (_chrDetailsMsg->root() != nullptr) {
+		applyNode_r(_chrDetailsMsg->root());
+	}
+	_aggro.clear();
+	if (_chrDetailsMsg->aggro() != nullptr) {
+		applyAggro(_chrDetailsMsg->aggro());
+	}
+	_characterDetailsSequence = sequence;
+	ack();
 }
 
 void AIDebug::onMessage(const ai::CharacterStatic *, const uint8_t *rawData, size_t rawDataLength) {
@@ -184,7 +275,7 @@ void AIDebug::onMessage(const ai::Names *, const uint8_t *rawData, size_t rawDat
 	_namesMsg = (ai::Names *)rootMsg->data();
 	_state = State::Debugging;
 	_namesSize += rawDataLength;
-	if (_stateWorldMsg != nullptr) {
+	if (_stateWorldSequence != 0u) {
 		return;
 	}
 	if (_namesMsg->names()->size() > 0) {
@@ -221,12 +312,45 @@ void AIDebug::step() const {
 	_messageSender->sendMessage(fbb, ai::MsgType::Step, ai::CreateStep(fbb, millis).Union());
 }
 
+void AIDebug::ack() const {
+	static flatbuffers::FlatBufferBuilder fbb;
+	_messageSender->sendMessage(fbb, ai::MsgType::Ack,
+			ai::CreateAck(fbb, _stateWorldSequence, _characterDetailsSequence).Union());
+}
+
+void AIDebug::subscribe(const glm::ivec2& mins, const glm::ivec2& maxs) {
+	static flatbuffers::FlatBufferBuilder fbb;
+	_subscribedMins = mins;
+	_subscribedMaxs = maxs;
+	_subscribed = true;
+	// the map is a top down view - the height doesn't matter
+	const ai::Vec3 areaMins((float)mins.x, -FLT_MAX, (float)mins.y);
+	const ai::Vec3 areaMaxs((float)maxs.x, FLT_MAX, (float)maxs.y);
+	_messageSender->sendMessage(fbb, ai::MsgType::Subscribe,
+			ai::CreateSubscribe(fbb, &areaMins, &areaMaxs, (uint32_t)_sampleRateMillis).Union());
+}
+
+void AIDebug::updateSubscription(const glm::ivec2& mapMins, const glm::ivec2& mapMaxs) {
+	const glm::ivec2& visibleMins = _map.mapToEntPos((float)mapMins.x, (float)mapMins.y);
+	const glm::ivec2& visibleMaxs = _map.mapToEntPos((float)mapMaxs.x, (float)mapMaxs.y);
+	if (_subscribed && visibleMins.x >= _subscribedMins.x && visibleMins.y >= _subscribedMins.y
+			&& visibleMaxs.x <= _subscribedMaxs.x && visibleMaxs.y <= _subscribedMaxs.y) {
+		return;
+	}
+	// subscribe to a larger area to not resubscribe with every scroll step
+	const glm::ivec2 margin = (visibleMaxs - visibleMins) / 2;
+	subscribe(visibleMins - margin, visibleMaxs + margin);
+}
+
 void AIDebug::changeZone(const char *zoneId) {
 	Log::info("Change zone to %s", zoneId);
 	static flatbuffers::FlatBufferBuilder fbb;
 	_chrDetailsMsg = nullptr;
 	_chrStaticMsg = nullptr;
-	_stateWorldMsg = nullptr;
+	_entityStates.clear();
+	_stateWorldSequence = 0u;
+	_characterDetailsSequence = 0u;
+	_subscribed = false;
 	_zoneId = zoneId;
 	_messageSender->sendMessage(fbb, ai::MsgType::ChangeZone,
 								ai::CreateChangeZone(fbb, fbb.CreateString(zoneId)).Union());
@@ -271,14 +395,16 @@ bool AIDebug::isSelected(ai::CharacterId entityId) const {
 	return _chrDetailsMsg->character_id() == entityId;
 }
 
-const ai::State *AIDebug::entityState() const {
+const AIDebug::EntityState *AIDebug::entityState() const {
 	if (!hasDetails()) {
 		return nullptr;
 	}
 
-	const ai::State *state = nullptr;
-	_entityStates.get(_chrDetailsMsg->character_id(), state);
-	return state;
+	auto i = _entityStates.find(_chrDetailsMsg->character_id());
+	if (i == _entityStates.end()) {
+		return nullptr;
+	}
+	return &i->value;
 }
 
 bool AIDebug::dbgConnect() {
@@ -329,7 +455,7 @@ bool AIDebug::dbgConnect() {
 }
 
 void AIDebug::dbgAttributes() {
-	const ai::State *state = entityState();
+	const EntityState *state = entityState();
 	if (state == nullptr) {
 		return;
 	}
@@ -340,14 +466,14 @@ void AIDebug::dbgAttributes() {
 			ImGui::TableSetupColumn("Current", ImGuiTableColumnFlags_WidthStretch);
 			ImGui::TableSetupColumn("Max", ImGuiTableColumnFlags_WidthStretch);
 			ImGui::TableHeadersRow();
-			for (const auto &a : *state->attrib()) {
+			for (int i = 0; i < (int)attrib::Type::MAX; ++i) {
 				ImGui::TableNextColumn();
-				const attrib::Type attribType = (attrib::Type)a->key();
+				const attrib::Type attribType = (attrib::Type)i;
 				ImGui::TextUnformatted(network::EnumNameAttribType(attribType));
 				ImGui::TableNextColumn();
-				ImGui::Text("%.2f", a->current());
+				ImGui::Text("%.2f", state->attribCurrent[i]);
 				ImGui::TableNextColumn();
-				ImGui::Text("%.2f", a->max());
+				ImGui::Text("%.2f", state->attribMax[i]);
 			}
 			ImGui::EndTable();
 		}
@@ -356,7 +482,7 @@ void AIDebug::dbgAttributes() {
 }
 
 void AIDebug::dbgMetaAttributes() {
-	const ai::State *state = entityState();
+	const EntityState *state = entityState();
 	if (state == nullptr) {
 		return;
 	}
@@ -367,11 +493,11 @@ void AIDebug::dbgMetaAttributes() {
 			ImGui::TableSetupColumn("Value", ImGuiTableColumnFlags_WidthStretch);
 			ImGui::TableHeadersRow();
 
-			for (const auto &a : *state->meta_attributes()) {
+			for (size_t i = 0u; i < state->metaAttributeKeys.size(); ++i) {
 				ImGui::TableNextColumn();
-				ImGui::TextUnformatted(a->key()->c_str());
+				ImGui::TextUnformatted(state->metaAttributeKeys[i].c_str());
 				ImGui::TableNextColumn();
-				ImGui::TextUnformatted(a->value()->c_str());
+				ImGui::TextUnformatted(state->metaAttributeValues[i].c_str());
 			}
 			ImGui::EndTable();
 		}
@@ -383,21 +509,17 @@ void AIDebug::dbgAggro() {
 	if (!hasDetails()) {
 		return;
 	}
-	auto *aggrolist = _chrDetailsMsg->aggro();
-	if (aggrolist == nullptr) {
-		return;
-	}
 	ImGui::SetNextWindowSize(ImVec2(200, 200), ImGuiCond_FirstUseEver);
 	if (ImGui::Begin("Aggro")) {
 		if (ImGui::BeginTable("##aggrolist", 2, priv::TableFlags)) {
 			ImGui::TableSetupColumn("Id", ImGuiTableColumnFlags_WidthStretch);
 			ImGui::TableSetupColumn("Aggro", ImGuiTableColumnFlags_WidthStretch);
 			ImGui::TableHeadersRow();
-			for (const auto &e : *aggrolist) {
+			for (const AggroEntry &e : _aggro) {
 				ImGui::TableNextColumn();
-				ImGui::Text("%" PRIChrId, e->character_id());
+				ImGui::Text("%" PRIChrId, e.id);
 				ImGui::TableNextColumn();
-				ImGui::Text("%.2f", e->aggro());
+				ImGui::Text("%.2f", e.aggro);
 			}
 			ImGui::EndTable();
 		}
@@ -414,8 +536,12 @@ void AIDebug::dbgStats() {
 		if (_namesMsg != nullptr) {
 			ImGui::Text("Zones: %i", (int)_namesMsg->names()->size());
 		}
-		if (_stateWorldMsg != nullptr) {
-			ImGui::Text("Entities: %i", (int)_stateWorldMsg->states()->size());
+		ImGui::Text("Entities: %i", (int)_entityStates.size());
+		if (ImGui::InputInt("Sample rate (ms)", &_sampleRateMillis, 10, 100, ImGuiInputTextFlags_EnterReturnsTrue)) {
+			_sampleRateMillis = core_max(0, _sampleRateMillis);
+			if (_subscribed) {
+				subscribe(_subscribedMins, _subscribedMaxs);
+			}
 		}
 		ImGui::Separator();
 		if (ImGui::BeginTable("Network traffic", 2, priv::TableFlags)) {
@@ -446,35 +572,29 @@ void AIDebug::dbgEntities() {
 				ImGui::EndCombo();
 			}
 		}
-		if (_stateWorldMsg != nullptr) {
+		if (_stateWorldSequence != 0u) {
 			ImGui::InputText(ICON_FA_SEARCH_LOCATION " Filter", _entityListFilter, sizeof(_entityListFilter));
 			if (ImGui::BeginTable("##entitylist", 2, priv::TableFlags)) {
 				ImGui::TableSetupColumn("Id", ImGuiTableColumnFlags_WidthStretch);
 				ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
 				ImGui::TableHeadersRow();
-				for (const auto &e : *_stateWorldMsg->states()) {
-					core::String name = "Unknown";
-					for (const auto &a : *e->meta_attributes()) {
-						if (!SDL_strcmp(ai::attributes::NAME, a->key()->c_str())) {
-							name = a->value()->c_str();
-							break;
-						}
-					}
+				for (auto iter = _entityStates.begin(); iter != _entityStates.end(); ++iter) {
+					const EntityState &e = iter->value;
 					if (_entityListFilter[0] != '\0') {
-						if (SDL_strstr(name.c_str(), _entityListFilter) == nullptr) {
+						if (SDL_strstr(e.name.c_str(), _entityListFilter) == nullptr) {
 							char buf[32];
-							SDL_snprintf(buf, sizeof(buf), "%" PRIChrId, e->character_id());
+							SDL_snprintf(buf, sizeof(buf), "%" PRIChrId, e.id);
 							if (SDL_strstr(buf, _entityListFilter) == nullptr) {
 								continue;
 							}
 						}
 					}
 					ImGui::TableNextColumn();
-					ImGui::Text("%" PRIChrId, e->character_id());
+					ImGui::Text("%" PRIChrId, e.id);
 					ImGui::TableNextColumn();
-					if (ImGui::Selectable(name.c_str(), isSelected(e->character_id()),
+					if (ImGui::Selectable(e.name.c_str(), isSelected(e.id),
 										  ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick)) {
-						selectEntity(e->character_id());
+						selectEntity(e.id);
 					}
 				}
 				ImGui::EndTable();
@@ -494,8 +614,10 @@ void AIDebug::dbgTreeNode_r(const ai::StateNode *node, int level) {
 	const char *nodeName = staticNodeDetails->name()->c_str();
 	const char *nodeType = staticNodeDetails->type()->c_str();
 	const char *nodeParameters = staticNodeDetails->parameters()->c_str();
-	const char *conditionName = node->condition()->c_str();
-	const bool hasChildren = (node->children()->size() > 0);
+	NodeState nodeState;
+	_treeNodeStates.get(node->node_id(), nodeState);
+	const char *conditionName = nodeState.condition.c_str();
+	const bool hasChildren = node->children() != nullptr && node->children()->size() > 0;
 
 	bool open = false;
 	if (hasChildren) {
@@ -524,15 +646,15 @@ void AIDebug::dbgTreeNode_r(const ai::StateNode *node, int level) {
 
 	ImGui::TextUnformatted(nodeParameters); ImGui::TableNextColumn();
 	ImGui::TextUnformatted(nodeType); ImGui::TableNextColumn();
-	if (node->condition_state()) {
+	if (nodeState.conditionState) {
 		ImGui::PushStyleColor(ImGuiCol_Text, core::Color::Green);
 	} else {
 		ImGui::PushStyleColor(ImGuiCol_Text, core::Color::Red);
 	}
 	ImGui::TextUnformatted(conditionName); ImGui::TableNextColumn();
 	ImGui::PopStyleColor(1);
-	ImGui::Text("%s", ai::EnumNameTreeNodeStatus(node->status())); ImGui::TableNextColumn();
-	ImGui::Text("%li", node->last_run());
+	ImGui::Text("%s", ai::EnumNameTreeNodeStatus(nodeState.status)); ImGui::TableNextColumn();
+	ImGui::Text("%li", nodeState.lastRun);
 	if (open) {
 		for (const auto &c : *node->children()) {
 			dbgTreeNode_r(c, level + 1);
@@ -566,16 +688,13 @@ void AIDebug::dbgTree() {
 }
 
 void AIDebug::dbgMap() {
-	if (_stateWorldMsg == nullptr || _stateWorldMsg->states() == nullptr) {
+	if (_stateWorldSequence == 0u) {
 		return;
 	}
 	if (_centerOnSelection) {
-		for (const auto &e : *_stateWorldMsg->states()) {
-			const bool selected = isSelected(e->character_id());
-			if (selected) {
-				_map.centerAtEntPos(e->position()->x(), e->position()->z());
-				break;
-			}
+		const EntityState *e = entityState();
+		if (e != nullptr) {
+			_map.centerAtEntPos(e->position.x, e->position.z);
 		}
 		_centerOnSelection = false;
 	}
@@ -594,6 +713,7 @@ void AIDebug::dbgMap() {
 	const ImVec2 mapMins(0.0f, 0.0f);
 	const ImVec2 mapMaxs(_frameBufferDimension.x, _frameBufferDimension.y);
 	_map.setMinsMaxs(mapMins, mapMaxs);
+	updateSubscription(mapMins, mapMaxs);
 	if (ImGui::Begin("##map", nullptr, ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoScrollWithMouse | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoDocking)) {
 		dbgBar();
 
@@ -609,31 +729,26 @@ void AIDebug::dbgMap() {
 		clipRectMaxs.x += clipRectMins.x;
 		clipRectMaxs.y += clipRectMins.y;
 		draw->PushClipRect(clipRectMins, clipRectMaxs, true);
-		for (const auto &e : *_stateWorldMsg->states()) {
-			const ImVec2& entPos = _map.entPosToMap(e->position()->x(), e->position()->z());
+		for (auto iter = _entityStates.begin(); iter != _entityStates.end(); ++iter) {
+			const EntityState &e = iter->value;
+			const ImVec2& entPos = _map.entPosToMap(e.position.x, e.position.z);
 			if (!_map.isVisible(entPos, mapMins, mapMaxs)) {
 				continue;
 			}
-			const float orientation = e->orientation();
+			const float orientation = e.orientation;
 			const glm::vec2 dir(glm::cos(orientation), glm::sin(orientation));
 			ImGui::SetCursorScreenPos({entPos.x - radius, entPos.y - radius});
-			const bool selected = isSelected(e->character_id());
+			const bool selected = isSelected(e.id);
 			ImGui::PushStyleColor(ImGuiCol_HeaderActive, ImGui::GetColorU32(ImGuiCol_HeaderActive, 0.0f));
 			ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImGui::GetColorU32(ImGuiCol_HeaderHovered, 0.0f));
 			ImGui::PushStyleColor(ImGuiCol_Header, ImGui::GetColorU32(ImGuiCol_Header, 0.0f));
 			if (ImGui::Selectable("##ent", selected, ImGuiSelectableFlags_AllowDoubleClick, entSize)) {
-				selectEntity(e->character_id());
+				selectEntity(e.id);
 			}
 			ImGui::PopStyleColor(3);
 
-			attrib::Values attribCurrent;
-			attrib::Values attribMax;
-			attribCurrent.fill(0.0);
-			attribMax.fill(0.0);
-			for (const auto& a : *e->attrib()) {
-				attribCurrent[a->key()] = a->current();
-				attribMax[a->key()] = a->max();
-			}
+			const attrib::Values& attribCurrent = e.attribCurrent;
+			const attrib::Values& attribMax = e.attribMax;
 
 			const bool hover = ImGui::TooltipText(
 					"ID: %" PRIChrId "\n"
@@ -641,10 +756,10 @@ void AIDebug::dbgMap() {
 					"Home: %f:%f:%f\n"
 					"Target: %f:%f:%f\n"
 					"Strength: %.2f/%.2f",
-					e->character_id(),
-					e->position()->x(), e->position()->y(), e->position()->z(),
-					e->home_position()->x(), e->home_position()->y(), e->home_position()->z(),
-					e->target_position()->x(), e->target_position()->y(), e->target_position()->z(),
+					e.id,
+					e.position.x, e.position.y, e.position.z,
+					e.homePosition.x, e.homePosition.y, e.homePosition.z,
+					e.targetPosition.x, e.targetPosition.y, e.targetPosition.z,
 					attribCurrent[core::enumVal(attrib::Type::STRENGTH)], attribMax[core::enumVal(attrib::Type::STRENGTH)]);
 
 			uint32_t col = entityColor;
@@ -656,8 +771,8 @@ void AIDebug::dbgMap() {
 			draw->AddCircle(entPos, radius, col, 12, 1.0f);
 			draw->AddLine(entPos, {entPos.x + dir.x * radius * 2.0f, entPos.y + dir.y * radius * 2.0f}, col, 1.0f);
 			if (selected) {
-				const ImVec2& homePos = _map.entPosToMap(e->home_position()->x(), e->home_position()->z());
-				const ImVec2& targetPos = _map.entPosToMap(e->target_position()->x(), e->target_position()->z());
+				const ImVec2& homePos = _map.entPosToMap(e.homePosition.x, e.homePosition.z);
+				const ImVec2& targetPos = _map.entPosToMap(e.targetPosition.x, e.targetPosition.z);
 				draw->AddLine(entPos, homePos, homecol, 1.0f);
 				draw->AddLine(entPos, targetPos, targetcol, 1.0f);
 			}
@@ -780,10 +895,14 @@ void AIDebug::onEvent(const network::DisconnectEvent &event) {
 	_state = State::Connect;
 	_entityStates.clear();
 	_nodeStates.clear();
+	_treeNodeStates.clear();
+	_aggro.clear();
 	_chrDetailsMsg = nullptr;
 	_chrStaticMsg = nullptr;
-	_stateWorldMsg = nullptr;
 	_namesMsg = nullptr;
+	_stateWorldSequence = 0u;
+	_characterDetailsSequence = 0u;
+	_subscribed = false;
 	_map.reset();
 	_pause = false;
 	_centerOnSelection = false;
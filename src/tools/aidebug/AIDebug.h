@@ -6,8 +6,10 @@
 
 #include "AIMessages_generated.h"
 #include "ai-shared/common/CharacterId.h"
+#include "attrib/ContainerValues.h"
 #include "attrib/ShadowAttributes.h"
 #include "core/collection/DynamicArray.h"
+#include "core/collection/DynamicMap.h"
 #include "network/AINetwork.h"
 #include "network/MessageSender.h"
 #include "network/NetworkEvents.h"
@@ -46,20 +48,60 @@ private:
 	size_t _characterStaticSize = 0u;
 	size_t _namesSize = 0u;
 	bool _showStats = false;
+	int _sampleRateMillis = 0;
+
+	/**
+	 * @brief The state of an entity - updated by the delta encoded @c ai::StateWorld messages
+	 */
+	struct EntityState {
+		ai::CharacterId id = 0;
+		glm::vec3 position { 0.0f };
+		glm::vec3 homePosition { 0.0f };
+		glm::vec3 targetPosition { 0.0f };
+		float orientation = 0.0f;
+		core::String name;
+		core::DynamicArray<core::String> metaAttributeKeys;
+		core::DynamicArray<core::String> metaAttributeValues;
+		attrib::Values attribCurrent;
+		attrib::Values attribMax;
+	};
+
+	/**
+	 * @brief The runtime state of a behaviour tree node of the selected entity
+	 */
+	struct NodeState {
+		core::String condition;
+		bool conditionState = false;
+		int64_t lastRun = 0;
+		ai::TreeNodeStatus status = ai::TreeNodeStatus::UNKNOWN;
+	};
 
+	struct AggroEntry {
+		ai::CharacterId id;
+		float aggro;
+	};
+
+	// the last full character details message - only the tree structure is used
 	uint8_t _chrDetailsBuf[32768];
 	ai::CharacterDetails *_chrDetailsMsg = nullptr;
 
 	uint8_t _chrStaticBuf[32768];
 	ai::CharacterStatic *_chrStaticMsg = nullptr;
 
-	uint8_t _stateWorldBuf[262144];
-	ai::StateWorld *_stateWorldMsg = nullptr;
-
 	uint8_t _namesBuf[32768];
 	ai::Names *_namesMsg = nullptr;
 
-	core::Map<ai::CharacterId, const ai::State*> _entityStates;
+	// the last applied sequences - they are acknowledged to the server
+	uint32_t _stateWorldSequence = 0u;
+	uint32_t _characterDetailsSequence = 0u;
+	// the area of the map the entities are received for
+	glm::ivec2 _subscribedMins { 0 };
+	glm::ivec2 _subscribedMaxs { 0 };
+	bool _subscribed = false;
+
+	core::DynamicMap<ai::CharacterId, EntityState, 1024> _entityStates;
+	core::DynamicMap<int, NodeState, 64> _treeNodeStates;
+	core::DynamicArray<AggroEntry> _aggro;
 	core::Map<int, const ai::StateNodeStatic*> _nodeStates;
 
 	struct Server {
@@ -88,9 +130,15 @@ private:
 	void updateNode(int nodeId, ai::CharacterId entityId, const core::String& nodeName, const core::String& nodeType, const core::String& condition);
 	void addNode(int parentNodeId, ai::CharacterId entityId, const core::String& nodeName, const core::String& nodeType, const core::String& condition);
 	void deleteNode(int nodeId, ai::CharacterId entityId);
+	void ack() const;
+	void subscribe(const glm::ivec2& mins, const glm::ivec2& maxs);
+	void updateSubscription(const glm::ivec2& mapMins, const glm::ivec2& mapMaxs);
+	void applyState(const ai::State* state);
+	void applyNode_r(const ai::StateNode* node);
+	void applyAggro(const flatbuffers::Vector<flatbuffers::Offset<ai::StateAggroEntry>>* aggro);
 
 	bool hasDetails() const;
-	const ai::State* entityState() const;
+	const EntityState* entityState() const;
 	bool isSelected(ai::CharacterId entityId) const;
 
 	bool dbgConnect();
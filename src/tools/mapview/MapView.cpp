@@ -256,6 +256,12 @@ void MapView::beforeUI() {
 
 	if (_updateWorld) {
 		core_trace_scoped(UpdateWorld);
+		const glm::ivec3 entityPos(_entity->position());
+		const glm::ivec3& chunkPos = _worldMgr->volumeData()->chunkPos(entityPos);
+		if (chunkPos != _prefetchChunkPos) {
+			_prefetchChunkPos = chunkPos;
+			_worldPager->prefetch(entityPos);
+		}
 		if (!_singlePosExtraction) {
 			_worldRenderer.extractMeshes(camera);
 		}
@@ -24,6 +24,7 @@
 #include "stock/Stock.h"
 #include "stock/StockDataProvider.h"
 #include "testcore/DepthBufferRenderer.h"
+#include <limits>
 
 /**
  * @brief This is the map viewer
@@ -61,6 +62,8 @@ protected:
 	core::VarPtr _meshSize;
 
 	glm::ivec3 _singleExtractionPoint = glm::zero<glm::ivec3>();
+	// the chunk the entity was in when the surrounding chunks were prefetched the last time
+	glm::ivec3 _prefetchChunkPos { std::numeric_limits<int>::min() };
 	/**
 	 * @brief Used for debugging a single position mesh extraction in the world
 	 */
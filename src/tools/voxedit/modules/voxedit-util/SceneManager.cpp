@@ -334,7 +334,7 @@ void SceneManager::queueRegionExtraction(int layerId, const voxel::Region& regio
 		}
 	}
 	if (addNew) {
-		_extractRegions.push_back({region, layerId});
+		_extractRegions.push_back({region, layerId, core::TimeProvider::highResTime()});
 	}
 }
 
@@ -1734,7 +1734,7 @@ bool SceneManager::extractVolume() {
 	Log::debug("Extract the meshes for %i regions", (int)n);
 	for (size_t i = 0; i < n; ++i) {
 		const voxel::Region& region = _extractRegions[i].region;
-		if (!_volumeRenderer.extractRegion(_extractRegions[i].layer, region)) {
+		if (!_volumeRenderer.extractRegion(_extractRegions[i].layer, region, _extractRegions[i].modified)) {
 			Log::error("Failed to extract the model mesh");
 		}
 		Log::debug("Extract layer %i", _extractRegions[i].layer);
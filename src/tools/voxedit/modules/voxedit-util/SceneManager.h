@@ -117,6 +117,8 @@ private:
 	struct DirtyRegion {
 		voxel::Region region;
 		int layer;
+		/** the high resolution time of the modification */
+		uint64_t modified;
 	};
 	using RegionQueue = core::DynamicArray<DirtyRegion>;
 	RegionQueue _extractRegions;